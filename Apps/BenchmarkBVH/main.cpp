@@ -0,0 +1,160 @@
+#include "ShapeModelTri.hpp"
+#include "ShapeModelImporter.hpp"
+#include "KDTreeShape.hpp"
+#include "BVHShape.hpp"
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+
+#include <chrono>
+
+// Benchmark settings
+#define DEFAULT_SHAPE "../../RayTracing/itokawa_64.obj"
+#define GRID_RESOLUTION 256 // rays are cast from a GRID_RESOLUTION x GRID_RESOLUTION grid
+#define N_VIEWS 4 // number of viewing directions
+#define RANGE_FACTOR 3 // distance to the shape center, in circumscribing radii
+
+int main(int argc, char ** argv){
+
+	std::string path = argc > 1 ? argv[1] : DEFAULT_SHAPE;
+
+	FrameGraph frame_graph;
+	frame_graph.add_frame("B");
+
+	ShapeModelTri<ControlPoint> shape("B", &frame_graph);
+	ShapeModelImporter::load_obj_shape_model(path, 1, false, shape);
+
+	std::vector<int> element_indices;
+	for (unsigned int e = 0; e < shape.get_NElements(); ++e){
+		element_indices.push_back(e);
+	}
+
+	// Build times
+	auto start = std::chrono::system_clock::now();
+	std::shared_ptr<KDTreeShape> kd_tree = std::make_shared<KDTreeShape>(KDTreeShape(&shape));
+	kd_tree -> build(element_indices, 0);
+	auto end = std::chrono::system_clock::now();
+	std::chrono::duration<double> kd_tree_build_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	BVHShape bvh(&shape);
+	bvh.build(element_indices);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> bvh_build_time = end - start;
+
+	// Rays are cast from grids facing the shape along several directions
+	double radius = shape.get_circumscribing_radius();
+	std::vector<std::shared_ptr<Ray> > kd_tree_rays;
+	std::vector<std::shared_ptr<Ray> > bvh_rays;
+
+	for (unsigned int view = 0; view < N_VIEWS; ++view){
+
+		double angle = 2 * arma::datum::pi * view / N_VIEWS;
+		arma::vec::fixed<3> u = {std::cos(angle), std::sin(angle), 0.2};
+		u = arma::normalise(u);
+
+		arma::vec::fixed<3> e_1 = arma::normalise(arma::cross(u, arma::vec({0,0,1})));
+		arma::vec::fixed<3> e_2 = arma::cross(u, e_1);
+
+		for (unsigned int i = 0; i < GRID_RESOLUTION; ++i){
+			for (unsigned int j = 0; j < GRID_RESOLUTION; ++j){
+
+				double a = radius * (2. * i / (GRID_RESOLUTION - 1) - 1);
+				double b = radius * (2. * j / (GRID_RESOLUTION - 1) - 1);
+
+				arma::vec::fixed<3> origin = shape.get_center_of_mass() - RANGE_FACTOR * radius * u + a * e_1 + b * e_2;
+
+				kd_tree_rays.push_back(std::make_shared<Ray>(Ray(origin, u)));
+				bvh_rays.push_back(std::make_shared<Ray>(Ray(origin, u)));
+			}
+		}
+	}
+
+	// Tracing
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < kd_tree_rays.size(); ++i){
+		kd_tree -> hit(kd_tree, kd_tree_rays[i].get());
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> kd_tree_trace_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < bvh_rays.size(); ++i){
+		bvh.hit(bvh_rays[i].get());
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> bvh_trace_time = end - start;
+
+	// Consistency check between both structures
+	unsigned int hits = 0;
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < bvh_rays.size(); ++i){
+		if (bvh_rays[i] -> get_hit_element() != -1){
+			++hits;
+		}
+		if (std::abs(bvh_rays[i] -> get_true_range() - kd_tree_rays[i] -> get_true_range()) > 1e-8 * radius){
+			++mismatches;
+		}
+	}
+
+	// Packet tracing. Packets are formed by 4 x 2 tiles of the ray grids
+	std::vector<RayPacket::Kernel> kernels = {RayPacket::SCALAR,RayPacket::SSE2,RayPacket::AVX};
+	std::vector<std::string> kernel_names = {"scalar","SSE2","AVX"};
+	std::vector<double> packet_trace_times(kernels.size(),-1);
+	std::vector<unsigned int> packet_mismatches(kernels.size(),0);
+
+	for (unsigned int k = 0; k < kernels.size(); ++k){
+
+		if (!RayPacket::is_supported(kernels[k])){
+			continue;
+		}
+
+		// The rays used with the kd tree are recycled
+		for (unsigned int i = 0; i < bvh_rays.size(); ++i){
+			kd_tree_rays[i] -> set_true_range(std::numeric_limits<double>::infinity());
+			kd_tree_rays[i] -> set_hit_element(-1);
+		}
+
+		start = std::chrono::system_clock::now();
+		for (unsigned int view = 0; view < N_VIEWS; ++view){
+			for (unsigned int i = 0; i < GRID_RESOLUTION; i += 2){
+				for (unsigned int j = 0; j < GRID_RESOLUTION; j += 4){
+
+					RayPacket packet(kernels[k]);
+
+					for (unsigned int a = i; a < std::min(i + 2,(unsigned int)(GRID_RESOLUTION)); ++a){
+						for (unsigned int b = j; b < std::min(j + 4,(unsigned int)(GRID_RESOLUTION)); ++b){
+							packet.add_ray(kd_tree_rays[view * GRID_RESOLUTION * GRID_RESOLUTION + a * GRID_RESOLUTION + b].get());
+						}
+					}
+
+					bvh.hit_packet(packet);
+				}
+			}
+		}
+		end = std::chrono::system_clock::now();
+		packet_trace_times[k] = std::chrono::duration<double>(end - start).count();
+
+		for (unsigned int i = 0; i < bvh_rays.size(); ++i){
+			if (std::abs(bvh_rays[i] -> get_true_range() - kd_tree_rays[i] -> get_true_range()) > 1e-8 * radius){
+				++packet_mismatches[k];
+			}
+		}
+	}
+
+	std::cout << "\n- Shape: " << path << " (" << shape.get_NElements() << " facets)\n";
+	std::cout << "- Rays: " << bvh_rays.size() << ", hits: " << hits << ", range mismatches: " << mismatches << std::endl;
+	std::cout << "\n\t\tBuild (s)\tTrace (s)\tRays/s\n";
+	std::cout << "- KDTreeShape\t" << kd_tree_build_time.count() << "\t" << kd_tree_trace_time.count() << "\t" << kd_tree_rays.size() / kd_tree_trace_time.count() << std::endl;
+	std::cout << "- BVHShape\t" << bvh_build_time.count() << "\t" << bvh_trace_time.count() << "\t" << bvh_rays.size() / bvh_trace_time.count() << std::endl;
+	for (unsigned int k = 0; k < kernels.size(); ++k){
+		if (packet_trace_times[k] < 0){
+			std::cout << "- BVH packets (" << kernel_names[k] << ") not supported on this CPU\n";
+			continue;
+		}
+		std::cout << "- BVH packets (" << kernel_names[k] << ")\t-\t" << packet_trace_times[k] << "\t" << bvh_rays.size() / packet_trace_times[k];
+		std::cout << "\t(range mismatches: " << packet_mismatches[k] << ")" << std::endl;
+	}
+	std::cout << "- BVH nodes: " << bvh.get_NNodes() << ", depth: " << bvh.get_depth() << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "FrameGraph.hpp"
+
+#include <chrono>
+
+// Benchmark settings
+#define N_CONVERSIONS 1000000 // number of conversions per test
+#define UPDATE_PERIOD 1000 // number of conversions between two attitude updates in the last test
+
+int main(){
+
+	// Graph mimicking the lidar/target setup of the ray-tracer.
+	// Converting from L to B requires going through N
+	FrameGraph frame_graph;
+	frame_graph.add_frame("N");
+	frame_graph.add_frame("L");
+	frame_graph.add_frame("B");
+	frame_graph.add_frame("E");
+
+	frame_graph.add_transform("N","L");
+	frame_graph.add_transform("N","B");
+	frame_graph.add_transform("N","E");
+
+	frame_graph.set_transform_origin("N","L",arma::vec({1,2,3}));
+	frame_graph.set_transform_mrp("N","L",arma::vec({0.1,-0.2,0.3}));
+	frame_graph.set_transform_mrp("N","B",arma::vec({-0.3,0.1,0.2}));
+
+	int L = frame_graph.get_frame_handle("L");
+	int B = frame_graph.get_frame_handle("B");
+
+	arma::vec input = {0.3,0.4,0.5};
+	arma::vec output;
+	arma::vec accumulated = arma::zeros<arma::vec>(3);
+
+	// Uncached conversions: the path is searched and composed on every call
+	frame_graph.set_use_transform_cache(false);
+	arma::vec uncached_output = frame_graph.convert(input,"L","B");
+
+	auto start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_CONVERSIONS; ++i){
+		output = frame_graph.convert(input,"L","B");
+		accumulated += output;
+	}
+	auto end = std::chrono::system_clock::now();
+	std::chrono::duration<double> uncached_time = end - start;
+
+	// Cached conversions, frames designated by name
+	frame_graph.set_use_transform_cache(true);
+	arma::vec cached_output = frame_graph.convert(input,"L","B");
+
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_CONVERSIONS; ++i){
+		output = frame_graph.convert(input,"L","B");
+		accumulated += output;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> cached_time = end - start;
+
+	// Cached conversions, frames designated by handle
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_CONVERSIONS; ++i){
+		output = frame_graph.convert(input,L,B);
+		accumulated += output;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> handle_time = end - start;
+
+	// Cached conversions with periodic attitude updates, forcing recompilations
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_CONVERSIONS; ++i){
+		if (i % UPDATE_PERIOD == 0){
+			frame_graph.set_transform_mrp("N","B",arma::vec({-0.3,0.1,0.2 + 1e-9 * i}));
+		}
+		output = frame_graph.convert(input,L,B);
+		accumulated += output;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> update_time = end - start;
+
+	// Edits made directly to a frame must be picked up as well
+	frame_graph.get_frame("B") -> set_mrp_from_parent(arma::vec({0.2,0.2,0.2}));
+	arma::vec direct_edit_cached = frame_graph.convert(input,L,B);
+	frame_graph.set_use_transform_cache(false);
+	arma::vec direct_edit_uncached = frame_graph.convert(input,L,B);
+
+	std::cout << "\n- Conversions per test: " << N_CONVERSIONS << std::endl;
+	std::cout << "- Cached/uncached discrepancy: " << arma::norm(cached_output - uncached_output) << std::endl;
+	std::cout << "- Cached/uncached discrepancy after direct frame edit: " << arma::norm(direct_edit_cached - direct_edit_uncached) << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\tConversions/s\n";
+	std::cout << "- Uncached (names)\t\t" << uncached_time.count() << "\t" << N_CONVERSIONS / uncached_time.count() << std::endl;
+	std::cout << "- Cached (names)\t\t" << cached_time.count() << "\t" << N_CONVERSIONS / cached_time.count() << std::endl;
+	std::cout << "- Cached (handles)\t\t" << handle_time.count() << "\t" << N_CONVERSIONS / handle_time.count() << std::endl;
+	std::cout << "- Cached (handles, updates)\t" << update_time.count() << "\t" << N_CONVERSIONS / update_time.count() << std::endl;
+
+	// Prevents the conversions from being optimized away
+	std::cout << "\n(checksum: " << arma::accu(accumulated) << ")\n";
+
+	return 0;
+}
@@ -9,10 +9,12 @@
 #include <PointCloudIO.hpp>
 
 #include <PointNormal.hpp>
+#include <PointNeighborhoods.hpp>
 #include <EstimationNormals.hpp>
 #include <EstimationPFH.hpp>
 #include <EstimationFPFH.hpp>
 #include <FeatureMatching.hpp>
+#include <DescriptorIndex.hpp>
 
 #include <IterativeClosestPoint.hpp>
 #include <IterativeClosestPointToPlane.hpp>
@@ -44,8 +46,22 @@ int main() {
 	normal_estimator_1.set_los_dir(los_1);
 	normal_estimator_2.set_los_dir(los_2);
 
-	normal_estimator_1.estimate(8);
-	normal_estimator_2.estimate(8);
+	// The normals are estimated from the 8 nearest neighbors of each point, which a radius search
+	// cannot provide for the sparse points
+	PointNeighborhoods restricted_neighborhoods_1;
+	PointNeighborhoods restricted_neighborhoods_2;
+	point_pc_1.compute_neighborhoods_N(8,restricted_neighborhoods_1);
+	point_pc_2.compute_neighborhoods_N(8,restricted_neighborhoods_2);
+
+	normal_estimator_1.estimate(restricted_neighborhoods_1);
+	normal_estimator_2.estimate(restricted_neighborhoods_2);
+
+	// The FPFH neighborhoods of each cloud are searched once, at the largest scale used below,
+	// and the smaller scale is drawn from them
+	PointNeighborhoods neighborhoods_1;
+	PointNeighborhoods neighborhoods_2;
+	point_pc_1.compute_neighborhoods_radius(1e-2,neighborhoods_1);
+	point_pc_2.compute_neighborhoods_radius(1e-2,neighborhoods_2);
 	
 	// point_pc_2.transform(RBK::mrp_to_dcm(mrp),x);
 	// point_pc_2.build_kdtree();
@@ -62,16 +78,38 @@ int main() {
 	EstimationFPFH<PointNormal,PointDescriptor > fpfh_estimator_2(point_pc_2,descriptor_pc_2);
 	fpfh_estimator_2.set_scale_distance(true);
 
-	fpfh_estimator_1.estimate(2.5e-3);
-	fpfh_estimator_2.estimate(2.5e-3);
+	neighborhoods_1.restrict_to_radius(2.5e-3,restricted_neighborhoods_1);
+	neighborhoods_2.restrict_to_radius(2.5e-3,restricted_neighborhoods_2);
+
+	fpfh_estimator_1.estimate(restricted_neighborhoods_1);
+	fpfh_estimator_2.estimate(restricted_neighborhoods_2);
 	fpfh_estimator_1.prune(1);
 	fpfh_estimator_2.prune(1);
 
-	fpfh_estimator_1.estimate(1e-2);
-	fpfh_estimator_2.estimate(1e-2);
+	fpfh_estimator_1.estimate(neighborhoods_1);
+	fpfh_estimator_2.estimate(neighborhoods_2);
 	fpfh_estimator_1.prune(1.);
 	fpfh_estimator_2.prune(1.);
 
+	// FPFH re-estimation benchmark: once the cache is filled, re-estimating the features of an unchanged
+	// cloud only reads the cache, and the features disabled by the pruning stay disabled
+	fpfh_estimator_1.set_use_cache(true);
+
+	auto cache_start = std::chrono::system_clock::now();
+	fpfh_estimator_1.estimate(neighborhoods_1);
+	auto cache_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> cache_fill_time = cache_end - cache_start;
+	unsigned int N_filled = fpfh_estimator_1.get_N_computed_features();
+
+	cache_start = std::chrono::system_clock::now();
+	fpfh_estimator_1.estimate(neighborhoods_1);
+	cache_end = std::chrono::system_clock::now();
+	std::chrono::duration<double> cache_hit_time = cache_end - cache_start;
+
+	std::cout << "\n\t\t\tTime (s)\tComputed FPFH\n";
+	std::cout << "- FPFH, empty cache\t" << cache_fill_time.count() << "\t" << N_filled << std::endl;
+	std::cout << "- FPFH, filled cache\t" << cache_hit_time.count() << "\t" << fpfh_estimator_1.get_N_computed_features() << std::endl;
+
 	// fpfh_estimator_1.estimate(7.5e-3);
 	// fpfh_estimator_2.estimate(7.5e-3);
 	// fpfh_estimator_1.prune(1.);
@@ -88,6 +126,74 @@ int main() {
 
 	std::cout << "matching features\n";
 
+	// Descriptor matching benchmark: exact search against the KD Tree and the approximate index
+	const unsigned int N_matching_neighbors = 5;
+	std::vector<int> closest_indices(N_matching_neighbors);
+	std::vector<double> closest_distances(N_matching_neighbors);
+	std::vector<double> histogram(descriptor_pc_1.get_points().get_descriptor_size());
+	std::vector<std::vector<int> > exact_matches(descriptor_pc_1.size());
+	unsigned int N_valid_features = 0;
+
+	DescriptorIndex exact_index(DESCRIPTOR_INDEX_N_TREES,0);
+	exact_index.build(descriptor_pc_2);
+
+	auto start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < descriptor_pc_1.size(); ++i){
+		if (descriptor_pc_1.get_point(i).get_is_valid_feature()){
+			descriptor_pc_1.get_point(i).copy_histogram(histogram.data());
+			unsigned int N_found = exact_index.closest_N_point_search(histogram.data(),
+				N_matching_neighbors,closest_indices.data(),closest_distances.data());
+			exact_matches[i].assign(closest_indices.begin(),closest_indices.begin() + N_found);
+			++N_valid_features;
+		}
+	}
+	auto end = std::chrono::system_clock::now();
+	std::chrono::duration<double> exact_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	descriptor_pc_2.build_kdtree(false);
+	for (unsigned int i = 0; i < descriptor_pc_1.size(); ++i){
+		if (descriptor_pc_1.get_point(i).get_is_valid_feature()){
+			descriptor_pc_2.get_closest_N_points(descriptor_pc_1.get_point(i).get_histogram(),
+				N_matching_neighbors,closest_indices.data(),closest_distances.data());
+		}
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> kd_tree_time = end - start;
+
+	std::cout << "\n- Valid features queried: " << N_valid_features << std::endl;
+	std::cout << "\n\t\t\tTime (s)\tRecall\n";
+	std::cout << "- Exact\t\t\t" << exact_time.count() << "\t1" << std::endl;
+	std::cout << "- KD Tree\t\t" << kd_tree_time.count() << "\t-" << std::endl;
+
+	for (unsigned int max_checks : {32,128,512,2048}){
+
+		start = std::chrono::system_clock::now();
+		DescriptorIndex index(DESCRIPTOR_INDEX_N_TREES,max_checks);
+		index.build(descriptor_pc_2);
+
+		unsigned int N_recalled = 0;
+		unsigned int N_exact = 0;
+		for (unsigned int i = 0; i < descriptor_pc_1.size(); ++i){
+			if (descriptor_pc_1.get_point(i).get_is_valid_feature()){
+				descriptor_pc_1.get_point(i).copy_histogram(histogram.data());
+				unsigned int N_found = index.closest_N_point_search(histogram.data(),
+					N_matching_neighbors,closest_indices.data(),closest_distances.data());
+				for (unsigned int k = 0; k < exact_matches[i].size(); ++k){
+					if (std::find(closest_indices.begin(),closest_indices.begin() + N_found,exact_matches[i][k]) != closest_indices.begin() + N_found){
+						++N_recalled;
+					}
+				}
+				N_exact += exact_matches[i].size();
+			}
+		}
+		end = std::chrono::system_clock::now();
+		std::chrono::duration<double> index_time = end - start;
+
+		std::cout << "- Index (" << max_checks << " checks)\t" << index_time.count() << "\t" << double(N_recalled) / N_exact << std::endl;
+	}
+	std::cout << std::endl;
+
 
 	PointCloudIO<PointNormal>::save_to_obj(point_pc_1,"point_pc_1.obj");
 	PointCloudIO<PointNormal>::save_to_obj(point_pc_2,"point_pc_2.obj");
@@ -0,0 +1,468 @@
+#include "PointCloud.hpp"
+#include "PointNormal.hpp"
+#include "PointNormalColumns.hpp"
+#include "SPFH.hpp"
+#include "PointNeighborhoods.hpp"
+#include "PointCloudIO.hpp"
+#include "EstimationNormals.hpp"
+#include "Lidar.hpp"
+#include "FrameGraph.hpp"
+
+#include <chrono>
+
+// Benchmark settings
+#define N_POINTS 1000000 // number of points in the cloud
+#define N_QUERIES 200000 // number of queries per test
+#define N_NEIGHBORS 16 // number of neighbors per query
+#define RADIUS 0.015 // neighborhood radius, about N_NEIGHBORS points on average
+#define N_BATCHES 20 // number of batches in which the growing clouds receive their points
+#define N_DOWNSAMPLED 100000 // number of points kept by the downsamplings
+#define FLASH_RESOLUTION 512 // number of pixel rows and columns of the lidar flash
+
+// Layout of the points before PointCloud<PointNormal> stored them in columns: a record holding its
+// coordinates in arma::vec members, along with the descriptor and bookkeeping members it used to carry
+struct BaselinePointNormal {
+	arma::vec point;
+	arma::vec normal = {0,0,0};
+	int inclusion_counter = 0;
+	int match = -1;
+	PointDescriptor descriptor;
+	SPFH spfh;
+	int global_index = 0;
+	std::map<double , int > neighborhood;
+};
+
+int main(){
+
+	arma::arma_rng::set_seed(0);
+
+	// Points uniformly drawn in a unit cube
+	arma::mat points = arma::randu<arma::mat>(3,N_POINTS);
+	PointCloud<PointNormal> pc;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		pc.push_back(PointNormal(points.col(i),i));
+	}
+
+	auto start = std::chrono::system_clock::now();
+	pc.build_kdtree(false);
+	auto end = std::chrono::system_clock::now();
+	std::chrono::duration<double> build_time = end - start;
+
+	arma::mat queries = arma::randu<arma::mat>(3,N_QUERIES);
+	double checksum = 0;
+
+	// kNN returned as std::map
+	start = std::chrono::system_clock::now();
+	for (unsigned int q = 0; q < N_QUERIES; ++q){
+		std::map<double,int> closest_points = pc.get_closest_N_points(queries.col(q),N_NEIGHBORS);
+		checksum += (--closest_points.end()) -> first;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> map_time = end - start;
+
+	// kNN written to caller-provided buffers
+	std::vector<int> closest_indices(N_NEIGHBORS);
+	std::vector<double> closest_distances(N_NEIGHBORS);
+	unsigned int N_mismatches = 0;
+
+	start = std::chrono::system_clock::now();
+	for (unsigned int q = 0; q < N_QUERIES; ++q){
+		unsigned int N_found = pc.get_closest_N_points(queries.col(q),N_NEIGHBORS,
+			closest_indices.data(),closest_distances.data());
+		checksum += std::sqrt(closest_distances[N_found - 1]);
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> buffer_time = end - start;
+
+	// Both paths must return the same neighbors
+	for (unsigned int q = 0; q < N_QUERIES; q += 100){
+		std::map<double,int> closest_points = pc.get_closest_N_points(queries.col(q),N_NEIGHBORS);
+		pc.get_closest_N_points(queries.col(q),N_NEIGHBORS,closest_indices.data(),closest_distances.data());
+		unsigned int k = 0;
+		for (auto it = closest_points.begin(); it != closest_points.end(); ++it, ++k){
+			if (it -> second != closest_indices[k]){
+				++N_mismatches;
+				break;
+			}
+		}
+	}
+
+	// Radius neighborhoods of all the points, one query at a time
+	start = std::chrono::system_clock::now();
+	std::vector<std::vector<int> > all_neighborhoods(N_POINTS);
+	#pragma omp parallel for
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		all_neighborhoods[i] = pc.get_nearest_neighbors_radius(pc.get_point_coordinates(i),RADIUS);
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> per_point_time = end - start;
+
+	// Radius neighborhoods of all the points, in a single batch
+	PointNeighborhoods neighborhoods;
+	start = std::chrono::system_clock::now();
+	pc.compute_neighborhoods_radius(RADIUS,neighborhoods);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> batch_time = end - start;
+
+	// Recomputing into the same neighborhoods reuses their memory
+	start = std::chrono::system_clock::now();
+	pc.compute_neighborhoods_radius(RADIUS,neighborhoods);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> batch_reuse_time = end - start;
+
+	unsigned int N_edges = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		N_edges += all_neighborhoods[i].size();
+	}
+
+	// Clouds growing by batches, their KD Tree being rebuilt or updated after each batch
+	PointCloud<PointNormal> rebuilt_pc;
+	PointCloud<PointNormal> updated_pc;
+	unsigned int batch_size = N_POINTS / N_BATCHES;
+	std::chrono::duration<double> rebuild_time(0);
+	std::chrono::duration<double> update_time(0);
+
+	for (unsigned int b = 0; b < N_BATCHES; ++b){
+
+		for (unsigned int i = b * batch_size; i < (b + 1) * batch_size; ++i){
+			rebuilt_pc.push_back(PointNormal(points.col(i),i));
+			updated_pc.push_back(PointNormal(points.col(i),i));
+		}
+
+		start = std::chrono::system_clock::now();
+		rebuilt_pc.build_kdtree(false);
+		end = std::chrono::system_clock::now();
+		rebuild_time += end - start;
+
+		start = std::chrono::system_clock::now();
+		updated_pc.update_kdtree();
+		end = std::chrono::system_clock::now();
+		update_time += end - start;
+
+	}
+
+	// Both trees must return the same closest points
+	unsigned int N_growing_mismatches = 0;
+	for (unsigned int q = 0; q < N_QUERIES; q += 100){
+		if (rebuilt_pc.get_closest_point(queries.col(q)) != updated_pc.get_closest_point(queries.col(q))){
+			++N_growing_mismatches;
+		}
+	}
+
+	// Lidar-like cloud: points on a unit sphere, with a radius giving about N_NEIGHBORS neighbors
+	arma::mat surface_points = arma::normalise(arma::randn<arma::mat>(3,N_POINTS));
+	double surface_radius = std::sqrt(4. * N_NEIGHBORS / N_POINTS);
+	PointCloud<PointNormal> surface_pc;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		surface_pc.push_back(PointNormal(surface_points.col(i),i));
+	}
+	surface_pc.build_kdtree(false);
+
+	PointNeighborhoods kdtree_neighborhoods;
+	start = std::chrono::system_clock::now();
+	surface_pc.compute_neighborhoods_radius(surface_radius,kdtree_neighborhoods);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> kdtree_batch_time = end - start;
+
+	std::vector<unsigned int> kdtree_neighborhood_sizes(N_QUERIES);
+	start = std::chrono::system_clock::now();
+	#pragma omp parallel for
+	for (unsigned int q = 0; q < N_QUERIES; ++q){
+		kdtree_neighborhood_sizes[q] = surface_pc.get_nearest_neighbors_radius(surface_pc.get_point_coordinates(q),surface_radius).size();
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> kdtree_per_point_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	surface_pc.build_voxel_grid(surface_radius);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> grid_build_time = end - start;
+
+	PointNeighborhoods grid_neighborhoods;
+	start = std::chrono::system_clock::now();
+	surface_pc.compute_neighborhoods_radius(surface_radius,grid_neighborhoods);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> grid_batch_time = end - start;
+
+	std::vector<unsigned int> grid_neighborhood_sizes(N_QUERIES);
+	start = std::chrono::system_clock::now();
+	#pragma omp parallel for
+	for (unsigned int q = 0; q < N_QUERIES; ++q){
+		grid_neighborhood_sizes[q] = surface_pc.get_nearest_neighbors_radius(surface_pc.get_point_coordinates(q),surface_radius).size();
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> grid_per_point_time = end - start;
+
+	// Both indices must find the same neighborhoods
+	unsigned int N_grid_mismatches = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		if (kdtree_neighborhoods.get_N_neighbors(i) != grid_neighborhoods.get_N_neighbors(i)){
+			++N_grid_mismatches;
+		}
+	}
+	for (unsigned int q = 0; q < N_QUERIES; ++q){
+		if (kdtree_neighborhood_sizes[q] != grid_neighborhood_sizes[q]){
+			++N_grid_mismatches;
+		}
+	}
+
+	// ICP-like pairing: each point of a slightly moved copy of the cloud is paired with its
+	// closest point in the cloud, then a point-to-plane residual is formed from the stored coordinates
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		pc.get_point(i).set_normal_coordinates(arma::normalise(points.col(i) - 0.5));
+	}
+	arma::mat moved_points = points + 1e-3 * arma::randn<arma::mat>(3,N_POINTS);
+
+	start = std::chrono::system_clock::now();
+	double J_res = 0;
+	#pragma omp parallel for reduction(+:J_res)
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		int closest_index = pc.get_closest_point(moved_points.col(i));
+		double residual = arma::dot(pc.get_normal_coordinates(closest_index),
+			moved_points.col(i) - pc.get_point_coordinates(closest_index));
+		J_res += residual * residual;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> pairing_time = end - start;
+	checksum += J_res;
+
+	// Point layouts: the same points stored as baseline records, as the fixed-size PointNormal records
+	// and in the columns of PointCloud<PointNormal>. The pairs are found once, so that the timings only
+	// measure the residuals formed from each layout and a rigid transform of all the points
+	PointCloud<PointNormal> layout_pc;
+	std::vector<BaselinePointNormal> baseline_points(N_POINTS);
+	std::vector<PointNormal> record_points;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		arma::vec::fixed<3> normal = arma::normalise(points.col(i) - 0.5);
+		layout_pc.push_back(PointNormal(points.col(i),normal,i));
+		record_points.push_back(PointNormal(points.col(i),normal,i));
+		baseline_points[i].point = points.col(i);
+		baseline_points[i].normal = normal;
+		baseline_points[i].global_index = i;
+	}
+	layout_pc.build_kdtree(false);
+
+	std::vector<int> layout_pairs(N_POINTS);
+	#pragma omp parallel for
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		layout_pairs[i] = layout_pc.get_closest_point(moved_points.col(i));
+	}
+
+	start = std::chrono::system_clock::now();
+	double J_baseline = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		const BaselinePointNormal & p = baseline_points[layout_pairs[i]];
+		double residual = arma::dot(p.normal,moved_points.col(i) - p.point);
+		J_baseline += residual * residual;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> baseline_residuals_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	double J_records = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		const PointNormal & p = record_points[layout_pairs[i]];
+		double residual = arma::dot(p.get_normal_coordinates(),moved_points.col(i) - p.get_point_coordinates());
+		J_records += residual * residual;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> records_residuals_time = end - start;
+
+	const PointNormalColumns & columns = layout_pc.get_points();
+	start = std::chrono::system_clock::now();
+	double J_columns = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		int k = layout_pairs[i];
+		double residual = 0;
+		for (unsigned int axis = 0; axis < 3; ++axis){
+			residual += columns.get_normal_column(axis)[k] * (moved_points(axis,i) - columns.get_point_column(axis)[k]);
+		}
+		J_columns += residual * residual;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> columns_residuals_time = end - start;
+
+	unsigned int N_layout_mismatches = 0;
+	if (std::abs(J_records - J_baseline) > 1e-10 * J_baseline || std::abs(J_columns - J_baseline) > 1e-10 * J_baseline){
+		++N_layout_mismatches;
+	}
+	checksum += J_baseline + J_records + J_columns;
+
+	arma::mat::fixed<3,3> layout_dcm = {{std::cos(0.3),-std::sin(0.3),0},{std::sin(0.3),std::cos(0.3),0},{0,0,1}};
+	arma::vec::fixed<3> layout_x = {1,2,3};
+
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		baseline_points[i].point = layout_dcm * baseline_points[i].point + layout_x;
+		baseline_points[i].normal = layout_dcm * baseline_points[i].normal;
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> baseline_transform_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		PointNormal & p = record_points[i];
+		p.set_point_coordinates(layout_dcm * p.get_point_coordinates() + layout_x);
+		p.set_normal_coordinates(layout_dcm * p.get_normal_coordinates());
+	}
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> records_transform_time = end - start;
+
+	PointNormalColumns transformed_columns = columns;
+	start = std::chrono::system_clock::now();
+	transformed_columns.transform(layout_dcm,layout_x);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> columns_transform_time = end - start;
+
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		if (arma::norm(transformed_columns.get_point_coordinates(i) - baseline_points[i].point) > 1e-12
+			|| arma::norm(record_points[i].get_point_coordinates() - baseline_points[i].point) > 1e-12){
+			++N_layout_mismatches;
+		}
+	}
+
+	// Downsamplings of the surface cloud to a target count
+	PointCloud<PointNormal> voxel_pc;
+	start = std::chrono::system_clock::now();
+	double voxel_size = surface_pc.downsample_voxel_grid_to_count(N_DOWNSAMPLED,voxel_pc);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> voxel_time = end - start;
+
+	PointCloud<PointNormal> poisson_pc;
+	start = std::chrono::system_clock::now();
+	double poisson_spacing = surface_pc.downsample_poisson_disk_to_count(N_DOWNSAMPLED,poisson_pc);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> poisson_time = end - start;
+
+	// Lidar flash of a sphere of radius 500 m centered 1 km ahead of the lidar
+	FrameGraph frame_graph;
+	frame_graph.add_frame("L");
+	Lidar lidar(&frame_graph,"L",10,10,FLASH_RESOLUTION,FLASH_RESOLUTION,1e-2,0,0);
+
+	arma::vec::fixed<3> sphere_center = {1000,0,0};
+	double sphere_radius = 500;
+	std::vector<std::shared_ptr<Ray> > * focal_plane = lidar.get_focal_plane();
+	for (unsigned int i = 0; i < focal_plane -> size(); ++i){
+		const arma::vec::fixed<3> & direction = focal_plane -> at(i) -> get_direction();
+		double b = arma::dot(direction,sphere_center);
+		focal_plane -> at(i) -> set_true_range(b - std::sqrt(b * b - arma::dot(sphere_center,sphere_center) + sphere_radius * sphere_radius));
+		focal_plane -> at(i) -> set_hit_element(0);
+	}
+
+	PointCloud<PointNormal> flash_pc(focal_plane);
+	arma::vec::fixed<3> los = {1,0,0};
+
+	// Normals from the 9 closest points, or from the 3x3 pixel windows
+	start = std::chrono::system_clock::now();
+	flash_pc.build_kdtree(false);
+	EstimationNormals<PointNormal,PointNormal> knn_normals(flash_pc,flash_pc);
+	knn_normals.set_los_dir(los);
+	knn_normals.estimate(9);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> knn_normals_time = end - start;
+
+	std::vector<arma::vec::fixed<3> > flash_knn_normals(flash_pc.size());
+	for (unsigned int i = 0; i < flash_pc.size(); ++i){
+		flash_knn_normals[i] = flash_pc.get_normal_coordinates(i);
+	}
+
+	start = std::chrono::system_clock::now();
+	EstimationNormals<PointNormal,PointNormal> organized_normals(flash_pc,flash_pc);
+	organized_normals.set_los_dir(los);
+	organized_normals.estimate_organized(1);
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> organized_normals_time = end - start;
+
+	double knn_normals_error = 0;
+	double organized_normals_error = 0;
+	for (unsigned int i = 0; i < flash_pc.size(); ++i){
+		arma::vec::fixed<3> true_normal = arma::normalise(flash_pc.get_point_coordinates(i) - sphere_center);
+		knn_normals_error += std::acos(std::min(1.,std::abs(arma::dot(true_normal,flash_knn_normals[i])))) / flash_pc.size();
+		organized_normals_error += std::acos(std::min(1.,std::abs(arma::dot(true_normal,flash_pc.get_normal_coordinates(i))))) / flash_pc.size();
+	}
+
+	// Reading the cloud back from text and from the binary format
+	PointCloudIO<PointNormal>::save_to_obj(pc,"benchmark_pc.obj");
+	PointCloudIO<PointNormal>::save_to_binary(pc,"benchmark_pc.bin");
+
+	start = std::chrono::system_clock::now();
+	PointCloud<PointNormal> obj_pc("benchmark_pc.obj");
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> obj_load_time = end - start;
+
+	start = std::chrono::system_clock::now();
+	PointCloud<PointNormal> binary_pc("benchmark_pc.bin");
+	end = std::chrono::system_clock::now();
+	std::chrono::duration<double> binary_load_time = end - start;
+
+	unsigned int N_load_mismatches = 0;
+	for (unsigned int i = 0; i < N_POINTS; ++i){
+		if (arma::norm(binary_pc.get_point_coordinates(i) - pc.get_point_coordinates(i)) > 0
+			|| arma::norm(binary_pc.get_normal_coordinates(i) - pc.get_normal_coordinates(i)) > 0){
+			++N_load_mismatches;
+		}
+	}
+
+	std::cout << "\n- Points: " << N_POINTS << std::endl;
+	std::cout << "- ICP pairing and residuals (s): " << pairing_time.count() << "\t" << N_POINTS / pairing_time.count() << " pairs/s" << std::endl;
+
+	std::cout << "\n- Point layouts: " << N_POINTS << " points, layout/baseline mismatches: " << N_layout_mismatches << std::endl;
+	std::cout << "\n\t\t\tBytes/point\tResiduals/s\tTransformed points/s\n";
+	std::cout << "- Baseline records\t" << sizeof(BaselinePointNormal) << "\t\t" << N_POINTS / baseline_residuals_time.count()
+	<< "\t" << N_POINTS / baseline_transform_time.count() << std::endl;
+	std::cout << "- PointNormal records\t" << sizeof(PointNormal) << "\t\t" << N_POINTS / records_residuals_time.count()
+	<< "\t" << N_POINTS / records_transform_time.count() << std::endl;
+	std::cout << "- Columns\t\t" << double(columns.get_memory_size()) / N_POINTS << "\t\t" << N_POINTS / columns_residuals_time.count()
+	<< "\t" << N_POINTS / columns_transform_time.count() << std::endl;
+	std::cout << "- Point storage of the " << N_POINTS << "-point cloud (MB): " << double(pc.get_points().get_memory_size()) / (1 << 20)
+	<< " (baseline: " << double(N_POINTS * sizeof(BaselinePointNormal)) / (1 << 20) << ")" << std::endl;
+	std::cout << "- Neighbors per query: " << N_NEIGHBORS << std::endl;
+	std::cout << "- KD tree build time (s): " << build_time.count() << std::endl;
+	std::cout << "- Mismatching queries: " << N_mismatches << std::endl;
+	std::cout << "\n\t\t\tTime (s)\tQueries/s\n";
+	std::cout << "- kNN (std::map)\t" << map_time.count() << "\t" << N_QUERIES / map_time.count() << std::endl;
+	std::cout << "- kNN (buffers)\t\t" << buffer_time.count() << "\t" << N_QUERIES / buffer_time.count() << std::endl;
+
+	std::cout << "\n- Neighbors per point (radius): " << double(neighborhoods.get_N_edges()) / N_POINTS << std::endl;
+	std::cout << "- Per-point/batch neighbor count discrepancy: " << int(N_edges) - int(neighborhoods.get_N_edges()) << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\tPoints/s\n";
+	std::cout << "- Neighborhoods (per point)\t" << per_point_time.count() << "\t" << N_POINTS / per_point_time.count() << std::endl;
+	std::cout << "- Neighborhoods (batch)\t\t" << batch_time.count() << "\t" << N_POINTS / batch_time.count() << std::endl;
+	std::cout << "- Neighborhoods (batch, reused)\t" << batch_reuse_time.count() << "\t" << N_POINTS / batch_reuse_time.count() << std::endl;
+
+	std::cout << "\n- Growing clouds: " << N_BATCHES << " batches of " << batch_size << " points" << std::endl;
+	std::cout << "- Rebuilt/updated KD tree mismatching queries: " << N_growing_mismatches << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\n";
+	std::cout << "- KD tree rebuilt after each batch\t" << rebuild_time.count() << std::endl;
+	std::cout << "- KD tree updated after each batch\t" << update_time.count() << std::endl;
+
+	std::cout << "\n- Binary/original point mismatches: " << N_load_mismatches << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\n";
+	std::cout << "- Load from obj\t\t\t" << obj_load_time.count() << " (" << obj_pc.size() << " points)" << std::endl;
+	std::cout << "- Load from binary\t\t" << binary_load_time.count() << " (" << binary_pc.size() << " points)" << std::endl;
+
+	std::cout << "\n- Surface cloud radius: " << surface_radius << std::endl;
+	std::cout << "- Neighbors per point (surface): " << double(grid_neighborhoods.get_N_edges()) / N_POINTS << std::endl;
+	std::cout << "- Voxel grid build time (s): " << grid_build_time.count() << std::endl;
+	std::cout << "- KD tree/voxel grid mismatching neighborhoods: " << N_grid_mismatches << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\tPoints/s\n";
+	std::cout << "- KD tree (per point)\t\t" << kdtree_per_point_time.count() << "\t" << N_QUERIES / kdtree_per_point_time.count() << std::endl;
+	std::cout << "- Voxel grid (per point)\t" << grid_per_point_time.count() << "\t" << N_QUERIES / grid_per_point_time.count() << std::endl;
+	std::cout << "- KD tree (batch)\t\t" << kdtree_batch_time.count() << "\t" << N_POINTS / kdtree_batch_time.count() << std::endl;
+	std::cout << "- Voxel grid (batch)\t\t" << grid_batch_time.count() << "\t" << N_POINTS / grid_batch_time.count() << std::endl;
+
+	std::cout << "\n- Downsampling target: " << N_DOWNSAMPLED << " points" << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\tPoints kept\tSpacing\n";
+	std::cout << "- Voxel grid (centroids)\t" << voxel_time.count() << "\t" << voxel_pc.size() << "\t" << voxel_size << std::endl;
+	std::cout << "- Poisson disk\t\t\t" << poisson_time.count() << "\t" << poisson_pc.size() << "\t" << poisson_spacing << std::endl;
+
+	std::cout << "\n- Flash points: " << flash_pc.size() << std::endl;
+	std::cout << "\n\t\t\t\tTime (s)\tMean normal error (rad)\n";
+	std::cout << "- Normals (KD tree, 9 points)\t" << knn_normals_time.count() << "\t" << knn_normals_error << std::endl;
+	std::cout << "- Normals (3x3 pixels)\t\t" << organized_normals_time.count() << "\t" << organized_normals_error << std::endl;
+
+	// Prevents the queries from being optimized away
+	std::cout << "\n(checksum: " << checksum << ")\n";
+
+	return 0;
+}
@@ -32,6 +32,12 @@
 // Instrument specs
 #define FOCAL_LENGTH 1e1 // meters
 #define SKIP_FACTOR 1 // between 0 and 1 . Determines the focal plane fraction that will be kept during the navigation phase (as a fraction of ROW_RESOLUTION)
+#define USE_LIDAR_COHERENCE false // If true, each pixel first tests the facets it hit during the previous flash
+
+// Eclipses
+#define USE_SHADOW_CACHE false // If true, eclipses of the true shape are memoized on a grid of positions and sun directions, which approximates the truth dynamics near shadow boundaries
+#define SHADOW_CACHE_POSITION_RESOLUTION 1. // meters
+#define SHADOW_CACHE_DIRECTION_RESOLUTION 1e-3 // unit vector components
 
 // Noise
 #define LOS_NOISE_FRACTION_MES_TRUTH 0.
@@ -188,10 +194,20 @@ int main(int argc, char **argv) {
 		LOS_NOISE_SD_BASELINE,
 		LOS_NOISE_FRACTION_MES_TRUTH);
 
+	lidar.set_use_coherence(USE_LIDAR_COHERENCE);
+
+	// The true shape is never modified, so its eclipses can be cached
+	ShadowCache shadow_cache_truth(&true_shape_model,
+		SHADOW_CACHE_POSITION_RESOLUTION,
+		SHADOW_CACHE_DIRECTION_RESOLUTION);
+
 	// Integrator extra arguments
 	Args args;
 	args.set_frame_graph(&frame_graph);
 	args.set_true_shape_model(&true_shape_model);
+	if (USE_SHADOW_CACHE){
+		args.set_shadow_cache_truth(&shadow_cache_truth);
+	}
 	args.set_mu_truth(arma::datum::G * true_shape_model . get_volume() * DENSITY);
 	args.set_mass_truth(true_shape_model . get_volume() * DENSITY);
 	args.set_lidar(&lidar);
@@ -0,0 +1,206 @@
+#include "ShapeModelTri.hpp"
+#include "ShapeModelBezier.hpp"
+#include "ShapeModelImporter.hpp"
+#include "Ray.hpp"
+
+#include <chrono>
+#include <fstream>
+
+// Regression test of the patch intersector of BVHShape (BezierPatchStore::intersect) against
+// the legacy patch-by-patch ray casting (Ray::single_patch_ray_casting), on degree-3 shapes
+#define DEGREE 3 // degree of the tested patches, reached by elevating the degree-1 shape
+#define PERTURBATION 5e-3 // standard deviation of the control point perturbation, in circumscribing radii
+#define N_RAYS 2000 // number of rays cast at each shape
+#define RANGE_FACTOR 3 // distance of the ray origins to the shape center, in circumscribing radii
+#define RANGE_TOL 1e-4 // tolerance on the ranges, in circumscribing radii
+#define EDGE_TOL 1e-4 // impacts whose smallest barycentric coordinate is below this are edge cases
+
+int main(int argc, char ** argv){
+
+	std::vector<std::string> paths;
+
+	if (argc > 1){
+		for (int i = 1; i < argc; ++i){
+			paths.push_back(argv[i]);
+		}
+	}
+	else{
+		paths.push_back("../../../resources/shape_models/itokawa_64_scaled_aligned.obj");
+		paths.push_back("../../RayTracing/itokawa_64.obj");
+	}
+
+	arma::arma_rng::set_seed(0);
+
+	unsigned int N_failures = 0;
+	unsigned int N_tested_shapes = 0;
+
+	for (unsigned int s = 0; s < paths.size(); ++s){
+
+		if (!std::ifstream(paths[s]).good()){
+			std::cout << "- Skipping " << paths[s] << " (not found)\n";
+			continue;
+		}
+
+		FrameGraph frame_graph;
+		frame_graph.add_frame("B");
+
+		ShapeModelTri<ControlPoint> tri_shape("B", &frame_graph);
+		ShapeModelImporter::load_obj_shape_model(paths[s], 1, false, tri_shape);
+		tri_shape.construct_kd_tree_shape();
+
+		double radius = tri_shape.get_circumscribing_radius();
+		arma::vec::fixed<3> center = tri_shape.get_center_of_mass();
+
+		// The elevated patches are flat until their control points are moved. Shared control
+		// points are moved together, so the perturbed shape stays closed
+		ShapeModelBezier<ControlPoint> shape(tri_shape,"B",&frame_graph);
+		for (unsigned int d = 1; d < DEGREE; ++d){
+			shape.elevate_degree();
+		}
+		for (unsigned int i = 0; i < shape.get_NControlPoints(); ++i){
+			ControlPoint & point = shape.get_point(i);
+			point.set_point_coordinates(point.get_point_coordinates() + PERTURBATION * radius * arma::randn<arma::vec>(3));
+		}
+		shape.construct_kd_tree_shape();
+
+		// Smallest barycentric coordinate of the impact of a ray on its patch
+		auto min_barycentric = [](Ray & r){
+			if (r.get_hit_element() == -1){
+				return std::numeric_limits<double>::infinity();
+			}
+			double u,v;
+			r.get_impact_coords(u,v);
+			return std::min(std::min(u,v),1 - u - v);
+		};
+
+		std::vector<Ray> rays;
+		std::vector<Ray> legacy_rays;
+		for (unsigned int i = 0; i < N_RAYS; ++i){
+
+			// Rays are cast from a sphere around the shape towards
+			// a random point within its circumscribing sphere
+			arma::vec::fixed<3> u = arma::normalise(arma::randn<arma::vec>(3));
+			arma::vec::fixed<3> origin = center + RANGE_FACTOR * radius * u;
+			arma::vec::fixed<3> target = center + radius * (2 * arma::randu<arma::vec>(3) - 1);
+			arma::vec::fixed<3> direction = arma::normalise(target - origin);
+
+			rays.push_back(Ray(origin,direction));
+			legacy_rays.push_back(Ray(origin,direction));
+		}
+
+		// The legacy path has no hierarchy to guess the impact from, so each patch is searched from its center.
+		// Both paths only accept hits on the outward face of the patches
+		auto start = std::chrono::system_clock::now();
+		for (unsigned int i = 0; i < N_RAYS; ++i){
+			rays[i].set_true_range(std::numeric_limits<double>::infinity());
+			rays[i].set_hit_element(-1);
+			shape.ray_trace(&rays[i],true);
+		}
+		auto end = std::chrono::system_clock::now();
+		std::chrono::duration<double> bvh_time = end - start;
+
+		start = std::chrono::system_clock::now();
+		for (unsigned int i = 0; i < N_RAYS; ++i){
+			legacy_rays[i].set_true_range(std::numeric_limits<double>::infinity());
+			legacy_rays[i].set_hit_element(-1);
+			for (unsigned int e = 0; e < shape.get_NElements(); ++e){
+				double u,v;
+				legacy_rays[i].single_patch_ray_casting(shape.get_element(e),u,v,false);
+			}
+		}
+		end = std::chrono::system_clock::now();
+		std::chrono::duration<double> legacy_time = end - start;
+
+		unsigned int hits = 0;
+		unsigned int legacy_hits = 0;
+		unsigned int misses = 0;
+		unsigned int legacy_misses = 0;
+		unsigned int range_mismatches = 0;
+		unsigned int element_mismatches = 0;
+		unsigned int edge_cases = 0;
+
+		for (unsigned int i = 0; i < N_RAYS; ++i){
+
+			Ray & ray = rays[i];
+			Ray & legacy_ray = legacy_rays[i];
+
+			bool hit = ray.get_hit_element() != -1;
+			bool legacy_hit = legacy_ray.get_hit_element() != -1;
+			bool edge_case = min_barycentric(ray) < EDGE_TOL || min_barycentric(legacy_ray) < EDGE_TOL;
+
+			hits += hit;
+			legacy_hits += legacy_hit;
+
+			// Hits found by one path only. A miss of the patch intersector is a failure,
+			// while the legacy search may not converge from the patch center
+			if (legacy_hit && !hit){
+				if (edge_case){
+					++edge_cases;
+				}
+				else{
+					++misses;
+				}
+				continue;
+			}
+			if (hit && !legacy_hit){
+				++legacy_misses;
+				continue;
+			}
+			if (!hit){
+				continue;
+			}
+
+			// A legacy hit further than the BVH hit means the legacy search missed the closest patch
+			double range_error = legacy_ray.get_true_range() - ray.get_true_range();
+			if (range_error > RANGE_TOL * radius){
+				++legacy_misses;
+			}
+			else if (std::abs(range_error) > RANGE_TOL * radius){
+				if (edge_case){
+					++edge_cases;
+				}
+				else{
+					++range_mismatches;
+				}
+			}
+			else if (ray.get_hit_element() != legacy_ray.get_hit_element()){
+				if (edge_case){
+					++edge_cases;
+				}
+				else{
+					++element_mismatches;
+				}
+			}
+
+		}
+
+		++N_tested_shapes;
+
+		std::cout << "- Shape: " << paths[s] << " (" << shape.get_NElements() << " patches of degree " << shape.get_degree() << ")\n";
+		std::cout << "\t Rays: " << N_RAYS << ", hits: " << hits << " (legacy: " << legacy_hits << ")" << std::endl;
+		std::cout << "\t Misses: " << misses << " (legacy: " << legacy_misses << ")" << std::endl;
+		std::cout << "\t Range mismatches: " << range_mismatches << std::endl;
+		std::cout << "\t Hit element mismatches: " << element_mismatches << std::endl;
+		std::cout << "\t Edge cases: " << edge_cases << std::endl;
+		std::cout << "\t Time (s): " << bvh_time.count() << " (legacy: " << legacy_time.count() << ")" << std::endl;
+		std::cout << "\t Rays per second: " << N_RAYS / bvh_time.count() << " (legacy: " << N_RAYS / legacy_time.count() << ")" << std::endl;
+
+		if (misses > 0 || range_mismatches > 0 || element_mismatches > 0){
+			++N_failures;
+		}
+
+	}
+
+	if (N_tested_shapes == 0){
+		std::cout << "No shape could be loaded\n";
+		return 1;
+	}
+
+	if (N_failures > 0){
+		std::cout << "FAILED on " << N_failures << " shape(s)\n";
+		return 1;
+	}
+
+	std::cout << "PASSED\n";
+	return 0;
+}
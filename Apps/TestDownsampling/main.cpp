@@ -0,0 +1,149 @@
+#include "PointCloud.hpp"
+#include "PointNormal.hpp"
+
+#include <armadillo>
+
+// Regression test of the downsamplings of PointCloud<PointNormal>, on a regular lattice
+// whose voxel-grid downsampling is known and on a random cloud for the downsamplings to a count
+#define LATTICE_SIZE 10 // number of points along each axis of the lattice
+#define LATTICE_OFFSET 0.25 // offset of the lattice, keeping its points away from the voxel boundaries
+#define VOXEL_SIZE 2. // voxel size of the voxel-grid downsampling, in lattice spacings
+#define POISSON_SPACING 1.5 // spacing of the Poisson-disk downsampling, in lattice spacings
+#define N_RANDOM_POINTS 5000 // number of points of the random cloud, drawn in a cube of side LATTICE_SIZE
+#define N_TARGET 500 // number of points requested from the downsamplings to a count
+#define COUNT_TOL 0.1 // relative tolerance on the number of points kept by the downsamplings to a count
+
+// Checks that the global indices of the points of a point cloud are their indices
+bool check_global_indices(const PointCloud<PointNormal> & pc){
+	for (unsigned int i = 0; i < pc.size(); ++i){
+		if (pc.get_point(i).get_global_index() != int(i)){
+			return false;
+		}
+	}
+	return true;
+}
+
+// Checks that the points of a Poisson-disk downsampling are at least spacing apart,
+// and that all the input points are closer than spacing to one of them
+bool check_poisson_disk(const PointCloud<PointNormal> & pc,const PointCloud<PointNormal> & downsampled_pc,double spacing){
+
+	for (unsigned int i = 0; i < downsampled_pc.size(); ++i){
+		for (unsigned int j = i + 1; j < downsampled_pc.size(); ++j){
+			if (arma::norm(downsampled_pc.get_point_coordinates(i) - downsampled_pc.get_point_coordinates(j)) < spacing){
+				return false;
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < pc.size(); ++i){
+		bool covered = false;
+		for (unsigned int j = 0; j < downsampled_pc.size() && !covered; ++j){
+			covered = arma::norm(pc.get_point_coordinates(i) - downsampled_pc.get_point_coordinates(j)) <= spacing;
+		}
+		if (!covered){
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Prints the outcome of a check and counts the failures
+void report(const std::string & name,bool passed,unsigned int & N_failures){
+	std::cout << "- " << name << ": " << (passed ? "passed" : "FAILED") << std::endl;
+	if (!passed){
+		++N_failures;
+	}
+}
+
+int main(){
+
+	// Lattice whose global indices are scrambled, so that the downsamplings must reindex their output
+	std::vector<PointNormal> points;
+	for (int i = 0; i < LATTICE_SIZE; ++i){
+		for (int j = 0; j < LATTICE_SIZE; ++j){
+			for (int k = 0; k < LATTICE_SIZE; ++k){
+				arma::vec point = {i + LATTICE_OFFSET,j + LATTICE_OFFSET,k + LATTICE_OFFSET};
+				arma::vec normal = {0,0,1};
+				points.push_back(PointNormal(point,normal,7 * int(points.size()) + 3));
+			}
+		}
+	}
+
+	unsigned int N_failures = 0;
+
+	PointCloud<PointNormal> pc(points);
+	report("constructor from points, size",pc.size() == points.size(),N_failures);
+	report("constructor from points, global indices",check_global_indices(pc),N_failures);
+
+	// Each voxel holds a 2 x 2 x 2 block of the lattice
+	unsigned int N_voxels = std::pow(std::ceil(LATTICE_SIZE / VOXEL_SIZE),3);
+
+	for (int use_centroids = 0; use_centroids < 2; ++use_centroids){
+
+		PointCloud<PointNormal> voxel_pc;
+		pc.downsample_voxel_grid(VOXEL_SIZE,voxel_pc,use_centroids);
+
+		std::string name = std::string("voxel grid") + (use_centroids ? ", centroids" : ", closest points");
+		std::cout << "-- kept points: " << voxel_pc.size() << " (expected " << N_voxels << ")\n";
+		report(name + ", size",voxel_pc.size() == N_voxels,N_failures);
+		report(name + ", global indices",check_global_indices(voxel_pc),N_failures);
+	}
+
+	PointCloud<PointNormal> poisson_pc;
+	pc.downsample_poisson_disk(POISSON_SPACING,poisson_pc);
+	std::cout << "-- kept points: " << poisson_pc.size() << std::endl;
+	report("Poisson disk, spacing and coverage",check_poisson_disk(pc,poisson_pc,POISSON_SPACING),N_failures);
+	report("Poisson disk, global indices",check_global_indices(poisson_pc),N_failures);
+
+	// The downsampled counts of the lattice only take a few values, so the searches run on a random cloud
+	arma::arma_rng::set_seed(0);
+	std::vector<PointNormal> random_points;
+	for (unsigned int i = 0; i < N_RANDOM_POINTS; ++i){
+		arma::vec point = LATTICE_SIZE * arma::randu<arma::vec>(3);
+		arma::vec normal = arma::normalise(arma::randn<arma::vec>(3));
+		random_points.push_back(PointNormal(point,normal,i));
+	}
+	PointCloud<PointNormal> random_pc(random_points);
+
+	PointCloud<PointNormal> voxel_count_pc;
+	random_pc.downsample_voxel_grid_to_count(N_TARGET,voxel_count_pc);
+	std::cout << "-- kept points: " << voxel_count_pc.size() << " (requested " << N_TARGET << ")\n";
+	report("voxel grid to count, size",std::abs(double(voxel_count_pc.size()) - N_TARGET) <= COUNT_TOL * N_TARGET,N_failures);
+	report("voxel grid to count, global indices",check_global_indices(voxel_count_pc),N_failures);
+
+	PointCloud<PointNormal> poisson_count_pc;
+	double spacing = random_pc.downsample_poisson_disk_to_count(N_TARGET,poisson_count_pc);
+	std::cout << "-- kept points: " << poisson_count_pc.size() << " (requested " << N_TARGET << ")\n";
+	report("Poisson disk to count, size",std::abs(double(poisson_count_pc.size()) - N_TARGET) <= COUNT_TOL * N_TARGET,N_failures);
+	report("Poisson disk to count, spacing and coverage",check_poisson_disk(random_pc,poisson_count_pc,spacing),N_failures);
+	report("Poisson disk to count, global indices",check_global_indices(poisson_count_pc),N_failures);
+
+	// Requesting more points than available keeps them all
+	PointCloud<PointNormal> all_pc;
+	pc.downsample_poisson_disk_to_count(2 * pc.size(),all_pc);
+	report("Poisson disk to count, all points kept",all_pc.size() == pc.size() && check_global_indices(all_pc),N_failures);
+
+	// Coincident points are downsampled to a single one, and keeping no point is rejected
+	arma::vec coincident_point = {1,2,3};
+	arma::vec coincident_normal = {0,0,1};
+	std::vector<PointNormal> coincident_points(N_TARGET + 1,PointNormal(coincident_point,coincident_normal));
+	PointCloud<PointNormal> coincident_pc(coincident_points);
+	PointCloud<PointNormal> single_voxel_pc;
+	PointCloud<PointNormal> single_poisson_pc;
+	coincident_pc.downsample_voxel_grid_to_count(N_TARGET,single_voxel_pc);
+	coincident_pc.downsample_poisson_disk_to_count(N_TARGET,single_poisson_pc);
+	report("voxel grid to count, coincident points",single_voxel_pc.size() == 1 && check_global_indices(single_voxel_pc),N_failures);
+	report("Poisson disk to count, coincident points",single_poisson_pc.size() == 1 && check_global_indices(single_poisson_pc),N_failures);
+
+	bool rejected_zero_count = false;
+	try{
+		random_pc.downsample_poisson_disk_to_count(0,poisson_count_pc);
+	}
+	catch(const std::runtime_error & error){
+		rejected_zero_count = true;
+	}
+	report("Poisson disk to count, no point requested",rejected_zero_count,N_failures);
+
+	return N_failures == 0 ? 0 : 1;
+}
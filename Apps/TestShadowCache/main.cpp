@@ -0,0 +1,77 @@
+#include "ShapeModelTri.hpp"
+#include "ShapeModelImporter.hpp"
+#include "ShadowCache.hpp"
+#include "Ray.hpp"
+
+#include <fstream>
+
+// Bounds the error of the eclipse cache against uncached shadowing. The cache answers each query
+// with the occlusion seen from the center of its cell, so it can only be wrong on queries closer
+// to the shadow boundary than the size of their cell
+#define N_QUERIES 20000 // number of queries per resolution
+#define RANGE_FACTOR 3 // distance of the queries to the shape center, in circumscribing radii
+#define SUN_SPREAD 0.3 // spread of the sun directions around the anti-radial direction, so that about half the queries are in shadow
+#define MAX_ERROR_RATE 0.01 // largest accepted fraction of wrong answers at the resolutions of ShapeReconstruction
+#define POSITION_RESOLUTION 1. // position resolution of ShapeReconstruction (m)
+#define DIRECTION_RESOLUTION 1e-3 // direction resolution of ShapeReconstruction
+
+int main(int argc, char ** argv){
+
+	std::string path = argc > 1 ? argv[1] : "../../../resources/shape_models/itokawa_64_scaled_aligned.obj";
+
+	if (!std::ifstream(path).good()){
+		std::cout << "Could not load " << path << std::endl;
+		return 1;
+	}
+
+	FrameGraph frame_graph;
+	frame_graph.add_frame("B");
+
+	ShapeModelTri<ControlPoint> shape("B", &frame_graph);
+	ShapeModelImporter::load_obj_shape_model(path, 1, false, shape);
+	shape.construct_kd_tree_shape();
+
+	double radius = shape.get_circumscribing_radius();
+
+	arma::arma_rng::set_seed(0);
+
+	std::vector<arma::vec::fixed<3> > positions(N_QUERIES);
+	std::vector<arma::vec::fixed<3> > sun_directions(N_QUERIES);
+	std::vector<bool> in_shadow(N_QUERIES);
+	unsigned int N_in_shadow = 0;
+
+	for (unsigned int i = 0; i < N_QUERIES; ++i){
+		arma::vec::fixed<3> u = arma::normalise(arma::randn<arma::vec>(3));
+		positions[i] = shape.get_center_of_mass() + RANGE_FACTOR * radius * u;
+		sun_directions[i] = arma::normalise(- u + SUN_SPREAD * arma::randn<arma::vec>(3));
+
+		Ray ray(positions[i],sun_directions[i]);
+		in_shadow[i] = shape.ray_trace_any(&ray);
+		N_in_shadow += in_shadow[i];
+	}
+
+	std::cout << "- Queries: " << N_QUERIES << ", in shadow: " << N_in_shadow << std::endl;
+	std::cout << "\nPosition res. (m)\tDirection res.\tError rate\tHit rate\n";
+
+	double error_rate = 0;
+
+	// The resolutions are refined down to those of ShapeReconstruction, at which the error is bounded
+	for (double factor : {16.,4.,1.}){
+
+		ShadowCache cache(&shape,factor * POSITION_RESOLUTION,factor * DIRECTION_RESOLUTION);
+
+		unsigned int N_errors = 0;
+		for (unsigned int i = 0; i < N_QUERIES; ++i){
+			N_errors += (cache.is_in_shadow(positions[i],sun_directions[i]) != in_shadow[i]);
+		}
+
+		error_rate = double(N_errors) / N_QUERIES;
+		std::cout << factor * POSITION_RESOLUTION << "\t\t\t" << factor * DIRECTION_RESOLUTION << "\t\t"
+		<< error_rate << "\t\t" << cache.get_hit_rate() << std::endl;
+	}
+
+	bool passed = error_rate <= MAX_ERROR_RATE;
+
+	std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "SymmetricEigenSolver.hpp"
+
+#include <armadillo>
+#include <chrono>
+
+// Test settings
+#define N_MATRICES 1000000 // number of matrices per spectrum type
+#define TOLERANCE 1e-12 // largest accepted error, relative to the largest eigenvalue in magnitude
+
+// Types of spectra the matrices are drawn with
+enum Spectrum { RANDOM, NEAR_DEGENERATE, PLANAR, DIAGONAL, SCALED, N_SPECTRA };
+
+// Draws a symmetric matrix of the provided spectrum type, stored by its upper-triangular coefficients
+void draw_matrix(Spectrum spectrum,double * matrix){
+
+	arma::vec eigenvalues = arma::randn<arma::vec>(3);
+
+	if (spectrum == NEAR_DEGENERATE){
+		// Two eigenvalues equal up to about 1e-9
+		eigenvalues = {1e-3 * eigenvalues(0),1 + 1e-9 * eigenvalues(1),1};
+	}
+	else if (spectrum == PLANAR){
+		// Covariance of points lying close to a plane, as in normal estimation
+		eigenvalues = arma::square(eigenvalues);
+		eigenvalues(0) *= 1e-8;
+	}
+	else if (spectrum == SCALED){
+		eigenvalues *= std::pow(10.,200 * arma::randu() - 100);
+	}
+
+	arma::mat Q,R;
+	arma::qr(Q,R,arma::randn<arma::mat>(3,3));
+
+	arma::mat A = Q * arma::diagmat(eigenvalues) * Q.t();
+
+	if (spectrum == DIAGONAL){
+		A = arma::diagmat(eigenvalues);
+	}
+
+	matrix[0] = A(0,0);
+	matrix[1] = A(0,1);
+	matrix[2] = A(0,2);
+	matrix[3] = A(1,1);
+	matrix[4] = A(1,2);
+	matrix[5] = A(2,2);
+
+}
+
+int main(){
+
+	arma::arma_rng::set_seed(0);
+
+	const std::string spectrum_names[N_SPECTRA] = {"random","near-degenerate","planar","diagonal","scaled"};
+	bool passed = true;
+
+	for (int s = 0; s < N_SPECTRA; ++s){
+
+		std::vector<double> matrices(6 * N_MATRICES);
+		for (unsigned int i = 0; i < N_MATRICES; ++i){
+			draw_matrix(Spectrum(s),matrices.data() + 6 * i);
+		}
+
+		std::vector<arma::mat::fixed<3,3> > full_matrices(N_MATRICES);
+		for (unsigned int i = 0; i < N_MATRICES; ++i){
+			const double * m = matrices.data() + 6 * i;
+			full_matrices[i] = {{m[0],m[1],m[2]},{m[1],m[3],m[4]},{m[2],m[4],m[5]}};
+		}
+
+		// Reference decomposition
+		std::vector<arma::vec> reference_eigenvalues(N_MATRICES);
+		arma::mat reference_eigenvectors;
+
+		auto start = std::chrono::system_clock::now();
+		for (unsigned int i = 0; i < N_MATRICES; ++i){
+			arma::eig_sym(reference_eigenvalues[i],reference_eigenvectors,full_matrices[i]);
+		}
+		auto end = std::chrono::system_clock::now();
+		std::chrono::duration<double> reference_time = end - start;
+
+		// Closed-form decomposition, one matrix at a time
+		std::vector<double> eigenvalues(3 * N_MATRICES);
+		std::vector<double> eigenvectors(9 * N_MATRICES);
+
+		start = std::chrono::system_clock::now();
+		for (unsigned int i = 0; i < N_MATRICES; ++i){
+			SymmetricEigenSolver::compute(matrices.data() + 6 * i,eigenvalues.data() + 3 * i,eigenvectors.data() + 9 * i);
+		}
+		end = std::chrono::system_clock::now();
+		std::chrono::duration<double> single_time = end - start;
+
+		// Closed-form decomposition, batched
+		std::vector<double> batch_eigenvalues(3 * N_MATRICES);
+		std::vector<double> batch_eigenvectors(9 * N_MATRICES);
+
+		start = std::chrono::system_clock::now();
+		SymmetricEigenSolver::compute(N_MATRICES,matrices.data(),batch_eigenvalues.data(),batch_eigenvectors.data());
+		end = std::chrono::system_clock::now();
+		std::chrono::duration<double> batch_time = end - start;
+
+		bool spectrum_passed = true;
+
+		// Both closed-form outputs are checked against the reference. The eigenvectors are not compared directly,
+		// as those of close eigenvalues are only defined up to a rotation
+		for (int batched = 0; batched < 2; ++batched){
+
+			const std::vector<double> & lambdas = batched ? batch_eigenvalues : eigenvalues;
+			const std::vector<double> & vectors = batched ? batch_eigenvectors : eigenvectors;
+
+			double eigenvalue_error = 0;
+			double residual = 0;
+			double orthonormality_error = 0;
+			unsigned int N_left_handed = 0;
+
+			for (unsigned int i = 0; i < N_MATRICES; ++i){
+
+				arma::vec::fixed<3> lambda(lambdas.data() + 3 * i);
+				arma::mat::fixed<3,3> V(vectors.data() + 9 * i);
+
+				double norm = arma::abs(reference_eigenvalues[i]).max();
+				if (norm == 0){
+					norm = 1;
+				}
+
+				eigenvalue_error = std::max(eigenvalue_error,arma::abs(lambda - reference_eigenvalues[i]).max() / norm);
+				residual = std::max(residual,arma::abs(full_matrices[i] * V - V * arma::diagmat(lambda)).max() / norm);
+				orthonormality_error = std::max(orthonormality_error,arma::abs(V.t() * V - arma::eye<arma::mat>(3,3)).max());
+
+				if (arma::det(V) < 0){
+					++N_left_handed;
+				}
+			}
+
+			bool output_passed = (eigenvalue_error < TOLERANCE && residual < TOLERANCE
+				&& orthonormality_error < TOLERANCE && N_left_handed == 0);
+			spectrum_passed = spectrum_passed && output_passed;
+
+			std::cout << "- " << spectrum_names[s] << " spectra, " << (batched ? "batched" : "single") << ": "
+			<< (output_passed ? "passed" : "FAILED") << std::endl;
+			std::cout << "-- eigenvalue error: " << eigenvalue_error << std::endl;
+			std::cout << "-- eigenvector residual: " << residual << std::endl;
+			std::cout << "-- orthonormality error: " << orthonormality_error << std::endl;
+			std::cout << "-- left-handed bases: " << N_left_handed << std::endl;
+		}
+
+		passed = passed && spectrum_passed;
+
+		std::cout << "-- eig_sym (s): " << reference_time.count() << std::endl;
+		std::cout << "-- closed form (s): " << single_time.count() << std::endl;
+		std::cout << "-- closed form, batched (s): " << batch_time.count() << std::endl;
+
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include "ShapeModelTri.hpp"
+#include "ShapeModelImporter.hpp"
+#include "Ray.hpp"
+
+#include <fstream>
+
+// Regression test of the packed triangle path of BVHShape against
+// the legacy facet-by-facet ray casting (Ray::single_facet_ray_casting)
+#define N_RAYS 2000 // number of rays cast at each shape
+#define RANGE_FACTOR 3 // distance of the ray origins to the shape center, in circumscribing radii
+#define RANGE_TOL 1e-8 // relative tolerance on the ranges
+#define INCIDENCE_TOL 1e-6 // tolerance on the incidence angles (degrees)
+#define EDGE_TOL 1e-5 // impacts whose smallest barycentric coordinate is below this are edge cases
+
+int main(int argc, char ** argv){
+
+	std::vector<std::string> paths;
+
+	if (argc > 1){
+		for (int i = 1; i < argc; ++i){
+			paths.push_back(argv[i]);
+		}
+	}
+	else{
+		paths.push_back("../../../resources/shape_models/itokawa_64_scaled_aligned.obj");
+		paths.push_back("../../../resources/shape_models/itokawa_128_scaled_aligned.obj");
+		paths.push_back("../../RayTracing/itokawa_64.obj");
+	}
+
+	arma::arma_rng::set_seed(0);
+
+	unsigned int N_failures = 0;
+	unsigned int N_tested_shapes = 0;
+
+	for (unsigned int s = 0; s < paths.size(); ++s){
+
+		if (!std::ifstream(paths[s]).good()){
+			std::cout << "- Skipping " << paths[s] << " (not found)\n";
+			continue;
+		}
+
+		FrameGraph frame_graph;
+		frame_graph.add_frame("B");
+
+		ShapeModelTri<ControlPoint> shape("B", &frame_graph);
+		ShapeModelImporter::load_obj_shape_model(paths[s], 1, false, shape);
+		shape.construct_kd_tree_shape();
+
+		double radius = shape.get_circumscribing_radius();
+
+		// Smallest barycentric coordinate of the impact of a ray on a facet. The legacy
+		// inside test uses an absolute area tolerance, so rays grazing an edge
+		// may legitimately be attributed to either facet, or missed by one path only
+		auto min_barycentric = [&](Ray & r){
+			if (r.get_hit_element() == -1){
+				return std::numeric_limits<double>::infinity();
+			}
+			const std::vector<int> & vertices = shape.get_element_control_points(r.get_hit_element());
+			const arma::vec::fixed<3> & P0 = shape.get_point_coordinates(vertices[0]);
+			arma::vec::fixed<3> E1 = shape.get_point_coordinates(vertices[1]) - P0;
+			arma::vec::fixed<3> E2 = shape.get_point_coordinates(vertices[2]) - P0;
+			arma::vec::fixed<3> H = r.get_origin_target_frame() + r.get_true_range() * r.get_direction_target_frame() - P0;
+			arma::mat::fixed<2,2> G = {{arma::dot(E1,E1),arma::dot(E1,E2)},{arma::dot(E1,E2),arma::dot(E2,E2)}};
+			arma::vec::fixed<2> uv = arma::solve(G,arma::vec({arma::dot(E1,H),arma::dot(E2,H)}));
+			return std::min(std::min(uv(0),uv(1)),1 - uv(0) - uv(1));
+		};
+
+		unsigned int hits = 0;
+		unsigned int range_mismatches = 0;
+		unsigned int element_mismatches = 0;
+		unsigned int edge_cases = 0;
+		unsigned int incidence_mismatches = 0;
+		unsigned int coherent_mismatches = 0;
+		unsigned int coherent_fast_paths = 0;
+
+		for (unsigned int i = 0; i < N_RAYS; ++i){
+
+			// Rays are cast from a sphere around the shape towards
+			// a random point within its circumscribing sphere
+			arma::vec::fixed<3> u = arma::normalise(arma::randn<arma::vec>(3));
+			arma::vec::fixed<3> origin = shape.get_center_of_mass() + RANGE_FACTOR * radius * u;
+			arma::vec::fixed<3> target = shape.get_center_of_mass() + radius * (2 * arma::randu<arma::vec>(3) - 1);
+			arma::vec::fixed<3> direction = arma::normalise(target - origin);
+
+			Ray ray(origin,direction);
+			Ray legacy_ray(origin,direction);
+
+			for (bool outside : {true,false}){
+
+				ray.set_true_range(std::numeric_limits<double>::infinity());
+				ray.set_hit_element(-1);
+				legacy_ray.set_true_range(std::numeric_limits<double>::infinity());
+				legacy_ray.set_hit_element(-1);
+
+				shape.ray_trace(&ray,outside);
+
+				// The coherent path must find the same hit, whether guessing the hit facet or an unrelated one.
+				// Rays through a shared edge may be attributed to either facet, at the same range
+				for (int random_guess = 0; random_guess < 2; ++random_guess){
+
+					int guess = ray.get_hit_element();
+					if (random_guess){
+						guess = arma::randi<arma::ivec>(1,arma::distr_param(0,int(shape.get_NElements()) - 1))(0);
+					}
+
+					Ray coherent_ray(origin,direction);
+					coherent_ray.set_guess(guess);
+					bool fast_path;
+					shape.ray_trace_coherent(&coherent_ray,outside,fast_path);
+					coherent_fast_paths += fast_path;
+
+					if ((coherent_ray.get_hit_element() == -1) != (ray.get_hit_element() == -1)
+						|| (ray.get_hit_element() != -1 && std::abs(coherent_ray.get_true_range() - ray.get_true_range()) > RANGE_TOL * radius)){
+						++coherent_mismatches;
+					}
+				}
+
+				for (unsigned int e = 0; e < shape.get_NElements(); ++e){
+					legacy_ray.single_facet_ray_casting(shape.get_element(e),true,outside);
+				}
+
+				if (legacy_ray.get_hit_element() != -1){
+					++hits;
+				}
+
+				bool edge_case = min_barycentric(ray) < EDGE_TOL || min_barycentric(legacy_ray) < EDGE_TOL;
+
+				if (ray.get_hit_element() != legacy_ray.get_hit_element()){
+					if (edge_case){
+						++edge_cases;
+					}
+					else{
+						++element_mismatches;
+					}
+				}
+
+				if (std::abs(ray.get_true_range() - legacy_ray.get_true_range()) > RANGE_TOL * radius
+					|| (ray.get_hit_element() == -1) != (legacy_ray.get_hit_element() == -1)){
+					if (!edge_case){
+						++range_mismatches;
+					}
+				}
+				else if (ray.get_hit_element() != -1 && ray.get_hit_element() == legacy_ray.get_hit_element()
+					&& std::abs(ray.get_incidence_angle() - legacy_ray.get_incidence_angle()) > INCIDENCE_TOL){
+					++incidence_mismatches;
+				}
+
+			}
+
+		}
+
+		++N_tested_shapes;
+
+		std::cout << "- Shape: " << paths[s] << " (" << shape.get_NElements() << " facets)\n";
+		std::cout << "\t Rays: " << 2 * N_RAYS << ", hits: " << hits << std::endl;
+		std::cout << "\t Range mismatches: " << range_mismatches << std::endl;
+		std::cout << "\t Hit element mismatches: " << element_mismatches << std::endl;
+		std::cout << "\t Edge cases: " << edge_cases << std::endl;
+		std::cout << "\t Incidence mismatches: " << incidence_mismatches << std::endl;
+		std::cout << "\t Coherent mismatches: " << coherent_mismatches << " (fast paths: " << coherent_fast_paths << ")" << std::endl;
+
+		if (range_mismatches > 0 || element_mismatches > 0 || incidence_mismatches > 0 || coherent_mismatches > 0){
+			++N_failures;
+		}
+
+	}
+
+	if (N_tested_shapes == 0){
+		std::cout << "No shape could be loaded\n";
+		return 1;
+	}
+
+	if (N_failures > 0){
+		std::cout << "FAILED on " << N_failures << " shape(s)\n";
+		return 1;
+	}
+
+	std::cout << "PASSED\n";
+	return 0;
+}
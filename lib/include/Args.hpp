@@ -3,6 +3,7 @@
 
 #include "FrameGraph.hpp"
 #include "Lidar.hpp"
+#include "ShadowCache.hpp"
 #include <SBGATSphericalHarmo.hpp>
 #include <ShapeModelBezier.hpp>
 #include <OrbitConversions.hpp>
@@ -218,6 +219,22 @@ public:
 		this -> coords_station = coords_station;
 	}
 
+	void set_shadow_cache_truth(ShadowCache * shadow_cache){
+		this -> shadow_cache_truth = shadow_cache;
+	}
+
+	ShadowCache * get_shadow_cache_truth() const{
+		return this -> shadow_cache_truth;
+	}
+
+	void set_shadow_cache_estimate(ShadowCache * shadow_cache){
+		this -> shadow_cache_estimate = shadow_cache;
+	}
+
+	ShadowCache * get_shadow_cache_estimate() const{
+		return this -> shadow_cache_estimate;
+	}
+
 	void set_lidar(Lidar * lidar){
 		this -> lidar = lidar;
 	}
@@ -436,6 +453,10 @@ protected:
 	ShapeModelTri<ControlPoint> * true_shape_model;
 	Lidar * lidar;
 
+	// Optional eclipse caches used in the SRP dynamics (nullptr if unused)
+	ShadowCache * shadow_cache_truth = nullptr;
+	ShadowCache * shadow_cache_estimate = nullptr;
+
 	arma::vec constant_omega;
 	arma::vec coords_station;
 
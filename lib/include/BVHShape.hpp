@@ -0,0 +1,210 @@
+#ifndef HEADER_BVHShape
+#define HEADER_BVHShape
+
+#include <vector>
+#include <memory>
+#include <armadillo>
+
+#include "TriangleStore.hpp"
+#include "BezierPatchStore.hpp"
+
+class Ray;
+class RayPacket;
+class ControlPoint;
+template <class PointType> class ShapeModel;
+template <class PointType> class ShapeModelTri;
+template <class PointType> class ShapeModelBezier;
+
+
+/**
+Declaration of the BVHShape class, a bounding volume hierarchy
+used to accelerate ray-casting against the elements of a shape model.
+The bounded elements are either the facets of a triangular shape or the patches
+of a Bezier shape, in which case the bounds of each patch are those of its control points.
+The hierarchy is built top-down with binned surface-area-heuristic (SAH) splits.
+Contrary to KDTreeShape, every element is referenced by exactly one leaf and
+the whole tree is stored in a single contiguous node array. Each leaf
+stores a range into a single permuted buffer of element indices.
+*/
+class BVHShape {
+
+public:
+
+	/**
+	Node of the hierarchy. Nodes are stored in depth-first order, so the left child
+	of an internal node always immediately follows its parent in the node array
+	*/
+	struct Node {
+
+		// Axis-aligned bounds of the node
+		double bbox_min[3];
+		double bbox_max[3];
+
+		// Leaf: index of the first element in the permuted index buffer
+		// Internal node: index of the right child in the node array
+		int offset;
+
+		// Number of elements in the leaf (0 for an internal node)
+		int count;
+
+		// Axis along which the node was split (internal nodes only)
+		int axis;
+
+		bool is_leaf() const {return this -> count > 0;}
+
+	};
+
+	/**
+	Constructor
+	@param owning_shape pointer to the triangular shape model whose facets will be bounded
+	*/
+	BVHShape(ShapeModelTri<ControlPoint> * owning_shape);
+
+	/**
+	Constructor
+	@param owning_shape pointer to the Bezier shape model whose patches will be bounded
+	*/
+	BVHShape(ShapeModelBezier<ControlPoint> * owning_shape);
+
+	/**
+	Builds the hierarchy over the prescribed elements of the owning shape
+	@param elements indices of the elements of the owning shape to insert in the hierarchy
+	*/
+	void build(const std::vector<int> & elements);
+
+	/**
+	Finds the closest intersect between the provided ray and the bounded elements.
+	The ray's internal state is updated if a closer hit is found
+	@param ray pointer to ray
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@return true if the ray hit an element, false otherwise
+	*/
+	bool hit(Ray * ray, bool outside = true) const;
+
+	/**
+	Finds the closest intersect between the provided ray and the bounded triangles,
+	exploiting a guess of the hit triangle (e.g. the one hit by the same pixel during the
+	previous flash). The guessed triangle and its neighbors are tested first.
+	If the closest of them lies on the convex hull of the shape and is hit from the front of its plane,
+	nothing can occlude it and it is returned without traversing the hierarchy.
+	If another of them is hit, the hierarchy is only searched for closer occluders, the traversal
+	being pruned at the range of this first hit. Otherwise, a full traversal is performed.
+	Bezier shapes always perform a full traversal
+	@param ray pointer to ray
+	@param guess guessed hit element (-1 if none)
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@param fast_path set to true if the closest hit was found among the guessed triangles
+	@return true if the ray hit an element, false otherwise
+	*/
+	bool hit_coherent(Ray * ray,
+		int guess,
+		bool outside,
+		bool & fast_path) const;
+
+	/**
+	Determines whether the provided ray hits any of the bounded elements before its current range.
+	The traversal stops at the first intersect found, which need not be the closest one.
+	The ray's internal state is left untouched
+	@param ray pointer to ray
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@return true if the ray hit an element, false otherwise
+	*/
+	bool hit_any(Ray * ray, bool outside = true) const;
+
+	/**
+	Finds the closest intersects between the rays of a coherent packet and the bounded triangles.
+	The hierarchy is traversed once for the whole packet and the state of every ray
+	that hit a triangle is updated. The rays are traced one at a time on Bezier shapes
+	@param packet ray packet
+	@param outside if true, will only accept the rays if they are cast from the outside of the shape
+	@return true if at least one ray hit an element, false otherwise
+	*/
+	bool hit_packet(RayPacket & packet, bool outside = true) const;
+
+	/**
+	Returns the number of nodes in the hierarchy
+	@return number of nodes
+	*/
+	unsigned int get_NNodes() const;
+
+	/**
+	Returns the depth of the hierarchy
+	@return depth (0 if the hierarchy consists of a single leaf)
+	*/
+	int get_depth() const;
+
+	/**
+	Returns the node array
+	@return node array, root node first
+	*/
+	const std::vector<Node> & get_nodes() const;
+
+	/**
+	Returns the permuted element index buffer leaves point into
+	@return permuted element indices
+	*/
+	const std::vector<int> & get_element_indices() const;
+
+	/**
+	Returns the packed triangles, stored in the order of the permuted element index buffer
+	@return triangle store
+	*/
+	const TriangleStore & get_triangles() const;
+
+	/**
+	Sets the maximum number of elements a leaf can hold
+	@param max_leaf_size maximum number of elements per leaf
+	*/
+	void set_max_leaf_size(unsigned int max_leaf_size);
+
+protected:
+
+	int build_node(int start, int end, int depth);
+
+	bool hit_triangles(Ray * ray, bool outside, double closest_range, int closest_slot) const;
+
+	bool hit_patches(Ray * ray, bool outside) const;
+
+	void compute_supporting_triangles();
+
+	bool is_supporting_triangle(int slot,double tolerance) const;
+
+	bool hit_node_bbox(const Node & node,
+		const arma::vec::fixed<3> & origin,
+		const double * inv_dir,
+		double max_range,
+		double & t_entry) const;
+
+	std::vector<Node> nodes;
+	std::vector<int> element_indices;
+
+	// Packed geometry of the bounded elements, in the order of element_indices.
+	// Only one of them is populated depending on the type of the owning shape
+	TriangleStore triangles;
+	BezierPatchStore patches;
+
+	// Whether each stored triangle lies on the convex hull of the shape, i.e. whether all the
+	// bounded triangles lie behind its plane. Nothing can occlude a hit on the front face of such a triangle
+	std::vector<char> supporting_triangles;
+
+	// Per-element bounds and centroids, only populated during the build
+	std::vector<double> element_bbox_min;
+	std::vector<double> element_bbox_max;
+	std::vector<double> element_centroids;
+
+	int depth = 0;
+
+	unsigned int max_leaf_size = 4;
+	unsigned int n_bins = 16;
+
+	// Relative cost of a node traversal step compared to a ray/element test
+	double traversal_cost = 1.;
+
+	ShapeModel<ControlPoint> * owning_shape;
+	ShapeModelTri<ControlPoint> * owning_shape_tri = nullptr;
+	ShapeModelBezier<ControlPoint> * owning_shape_bezier = nullptr;
+
+};
+
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef HEADER_BEZIERPATCHSTORE
+#define HEADER_BEZIERPATCHSTORE
+
+#include <vector>
+#include <armadillo>
+
+// Maximum degree of the stored patches
+#define BEZIER_PATCH_STORE_MAX_DEGREE 15
+
+// Distance between the ray and the patch point below which the Newton search has converged
+#define BEZIER_PATCH_STORE_TOL 1e-5
+
+// Maximum number of Newton iterations per initial guess
+#define BEZIER_PATCH_STORE_MAX_ITER 20
+
+// Tolerance on the barycentric coordinates of a converged intersect
+#define BEZIER_PATCH_STORE_EDGE_TOL 1e-10
+
+class ControlPoint;
+template <class PointType> class ShapeModelBezier;
+
+
+/**
+Declaration of the BezierPatchStore class. Packs the control points of a set of Bezier patches
+contiguously along with their axis-aligned bounds and the multinomial coefficients of their
+Bernstein polynomials, so that the Newton search for a ray/patch intersect evaluates the patch and its
+partials in a single pass without going through the owning shape.
+Patches are stored in the order they are provided with, which for a BVHShape is the
+order of its permuted element index buffer
+*/
+class BezierPatchStore {
+
+public:
+
+	/**
+	Constructor
+	*/
+	BezierPatchStore();
+
+	/**
+	Packs the prescribed patches of a shape model
+	@param shape pointer to the shape owning the patches
+	@param elements patches to store, in storage order
+	*/
+	void build(ShapeModelBezier<ControlPoint> * shape, const std::vector<int> & elements);
+
+	/**
+	Returns the number of stored patches
+	@return number of patches
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the index of the patch stored at the provided slot
+	@param slot storage slot
+	@return patch global index
+	*/
+	int get_element(unsigned int slot) const;
+
+	/**
+	Tests a ray against the bounds of a stored patch. The bounds are those of the
+	control points, which enclose the patch by virtue of the convex hull property
+	@param slot storage slot
+	@param origin ray origin
+	@param inv_dir component-wise inverse of the ray direction
+	@param max_range ranges beyond which hits are discarded
+	@return true if the ray enters the bounds before max_range
+	*/
+	bool hit_bbox(unsigned int slot, const double * origin, const double * inv_dir, double max_range) const;
+
+	/**
+	Evaluates a stored patch and its partial derivatives
+	@param slot storage slot
+	@param u first barycentric coordinate
+	@param v second barycentric coordinate
+	@param P evaluated point
+	@param P_u partial derivative with respect to u
+	@param P_v partial derivative with respect to v
+	*/
+	void evaluate(unsigned int slot, double u, double v, double * P, double * P_u, double * P_v) const;
+
+	/**
+	Finds the intersect between a ray and a stored patch with a Gauss-Newton search.
+	The search is started from the projection of the ray on the plane of the patch corners,
+	then from the patch center if the first attempt fails
+	@param slot storage slot
+	@param origin ray origin
+	@param direction ray unit direction
+	@param outside if true, only hits on the outward face of the patch are accepted
+	@param max_range ranges beyond which hits are discarded
+	@param t range to the intersect, if any
+	@param u first barycentric coordinate of the intersect, if any
+	@param v second barycentric coordinate of the intersect, if any
+	@return true if the ray hits the patch at a range in (0,max_range)
+	*/
+	bool intersect(unsigned int slot,
+		const double * origin,
+		const double * direction,
+		bool outside,
+		double max_range,
+		double & t,
+		double & u,
+		double & v) const;
+
+	/**
+	Returns the incidence angle of a ray hitting a stored patch
+	@param slot storage slot
+	@param u first barycentric coordinate of the intersect
+	@param v second barycentric coordinate of the intersect
+	@param direction unit direction of the ray
+	@return incidence angle (degrees)
+	*/
+	double get_incidence_angle(unsigned int slot, double u, double v, const double * direction) const;
+
+protected:
+
+	bool newton_search(unsigned int slot,
+		const double * origin,
+		const double * direction,
+		bool outside,
+		double max_range,
+		double & t,
+		double & u,
+		double & v) const;
+
+	// Degree of each patch and offset of its first control point
+	std::vector<int> degrees;
+	std::vector<int> offsets;
+
+	// Control point coordinates (x,y,z interleaved), in the local order of each patch
+	std::vector<double> control_points;
+
+	// Bounds of the control points of each patch
+	std::vector<double> bbox_min;
+	std::vector<double> bbox_max;
+
+	// Exponents of u, v and w = 1 - u - v and multinomial coefficients of
+	// the Bernstein polynomials, indexed by degree then by local control point index
+	std::vector<std::vector<int> > exponents;
+	std::vector<std::vector<double> > coefficients;
+
+	// Local indices of the corner control points (u = 1, v = 1, w = 1), indexed by degree
+	std::vector<std::vector<int> > corners;
+
+	std::vector<int> elements;
+
+};
+
+
+#endif
@@ -88,6 +88,14 @@ protected:
 		bool prune_overlaps = true) const;
 	void save_local_bundle();
 
+	/**
+	Returns the index of the random stream used to sample the points of a point-cloud pair
+	@param S_k global index of the source point cloud
+	@param D_k global index of the destination point cloud
+	@return stream index
+	*/
+	unsigned int get_sampling_stream(int S_k,int D_k) const;
+
 	void assemble_subproblem(arma::mat & Lambda_k,arma::vec & N_k,
 		const PointCloudPair & point_cloud_pair,
 		const std::map<int,arma::mat::fixed<3,3> > & M_pcs,
@@ -135,6 +143,9 @@ protected:
 	int N_iter;
 	int cluster_size = 4;
 
+	// Number of pair formations so far, used to key the random sampling of the points
+	unsigned int N_pairings = 0;
+
 	std::string dir;
 	double sigma_rho;
 
@@ -0,0 +1,161 @@
+#ifndef HEADER_DESCRIPTOR_INDEX
+#define HEADER_DESCRIPTOR_INDEX
+
+#include <vector>
+#include <armadillo>
+
+// Default number of randomized trees in the forest
+#define DESCRIPTOR_INDEX_N_TREES 4
+
+// Default maximum number of descriptors compared per query. 0 forces an exact search
+#define DESCRIPTOR_INDEX_MAX_CHECKS 512
+
+// Maximum number of descriptors in a leaf
+#define DESCRIPTOR_INDEX_LEAF_SIZE 8
+
+// The split axis of a node is drawn among this many bins of highest variance
+#define DESCRIPTOR_INDEX_N_CANDIDATE_AXES 5
+
+// Number of descriptors used to estimate the bin variances of a node
+#define DESCRIPTOR_INDEX_VARIANCE_SAMPLES 100
+
+template <class PointType> class PointCloud;
+class PointDescriptor;
+
+/**
+Approximate nearest-neighbor index over the descriptors of a point cloud, for high-dimensional
+histograms in which an exact KD Tree search degrades to a brute-force search.
+The index is a forest of randomized KD Trees: each node splits its descriptors at the mean of a bin
+drawn among the bins of highest variance. A query descends all the trees, then keeps exploring
+the most promising of the branches left aside in any tree until a prescribed number of descriptors
+has been compared (priority search). This number is the recall/speed knob of the index.
+Distances are the descriptor distances of PointDescriptor::distance_to_descriptor.
+Branches are ranked by a lower bound of this distance, so the search is exact if it is let to run until completion
+*/
+class DescriptorIndex {
+
+public:
+
+	/**
+	Constructor
+	@param N_trees number of randomized trees
+	@param max_checks maximum number of descriptors compared per query. 0 forces an exact (brute-force) search
+	*/
+	DescriptorIndex(unsigned int N_trees = DESCRIPTOR_INDEX_N_TREES,unsigned int max_checks = DESCRIPTOR_INDEX_MAX_CHECKS);
+
+	/**
+	Builds the index over the valid descriptors of the provided point cloud.
+	The trees are randomized with the library-wide Philox seed, so the index is reproducible.
+	In exact mode, only the descriptors are copied: the trees are built if an approximate search is later set
+	@param pc descriptor point cloud
+	*/
+	void build(const PointCloud<PointDescriptor> & pc);
+
+	/**
+	Finds the N descriptors in the index closest to the provided histogram. Does not allocate in exact mode
+	@param histogram query histogram
+	@param N number of descriptors to find
+	@param closest_indices buffer of at least N elements receiving the indices of the closest descriptors
+	in the point cloud, sorted by increasing distance
+	@param closest_distances buffer of at least N elements receiving the descriptor distances
+	@return number of descriptors found. Less than N only if the index holds fewer descriptors
+	*/
+	unsigned int closest_N_point_search(const arma::vec & histogram,
+		unsigned int N,
+		int * closest_indices,
+		double * closest_distances) const;
+
+	/**
+	Finds the N descriptors in the index closest to the provided histogram. Does not allocate in exact mode
+	@param histogram pointer to the bins of the query histogram, as many as the indexed descriptors
+	@param N number of descriptors to find
+	@param closest_indices buffer of at least N elements receiving the indices of the closest descriptors
+	in the point cloud, sorted by increasing distance
+	@param closest_distances buffer of at least N elements receiving the descriptor distances
+	@return number of descriptors found. Less than N only if the index holds fewer descriptors
+	*/
+	unsigned int closest_N_point_search(const double * histogram,
+		unsigned int N,
+		int * closest_indices,
+		double * closest_distances) const;
+
+	/**
+	Sets the maximum number of descriptors compared per query.
+	Larger values increase recall at the expense of speed. Builds the trees if the index was built in exact mode
+	@param max_checks maximum number of descriptors compared per query. 0 forces an exact (brute-force) search
+	*/
+	void set_max_checks(unsigned int max_checks);
+
+	/**
+	Returns the maximum number of descriptors compared per query
+	@return maximum number of descriptors compared per query
+	*/
+	unsigned int get_max_checks() const;
+
+	/**
+	Returns the number of descriptors in the index
+	@return number of descriptors in the index
+	*/
+	unsigned int size() const;
+
+protected:
+
+	struct Node {
+
+		// Split bin and value. Leaves have a negative axis
+		int axis = -1;
+		double value = 0;
+
+		// Children of forks, range of the tree's permutation for leaves
+		int left = 0;
+		int right = 0;
+	};
+
+	struct Branch {
+
+		// Lower bound of the distance between the query and the descriptors of the branch
+		double bound;
+		unsigned int tree;
+		int node;
+
+		// Orders a heap so that the branch of smallest bound is on top
+		bool operator<(const Branch & other) const {return this -> bound > other.bound;}
+	};
+
+	double distance(const double * descriptor_in_index,const double * histogram) const;
+
+	double plane_bound(double offset,double query_value) const;
+
+	void build_trees();
+
+	int build_node(unsigned int tree,int begin,int end);
+
+	void search_branch(unsigned int tree,int node_index,double bound,
+		const double * histogram,
+		unsigned int N,
+		int * closest_indices,
+		double * closest_distances,
+		unsigned int & N_found,
+		unsigned int & N_checks,
+		std::vector<Branch> & branches) const;
+
+	// Nodes of each tree. The root is the first node
+	std::vector<std::vector<Node> > trees;
+
+	// Order of the descriptors in the leaves of each tree
+	std::vector<std::vector<int> > permutations;
+
+	// Histograms of the descriptors, stored one after the other
+	std::vector<double> descriptors;
+
+	// Index in the point cloud of each descriptor
+	std::vector<int> indices;
+
+	unsigned int dimension = 0;
+	unsigned int N_trees;
+	unsigned int max_checks;
+
+};
+
+
+#endif
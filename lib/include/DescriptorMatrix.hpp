@@ -0,0 +1,231 @@
+#ifndef HEADER_DESCRIPTOR_MATRIX
+#define HEADER_DESCRIPTOR_MATRIX
+
+#include <armadillo>
+#include <vector>
+#include <cstdint>
+
+#include <PointDescriptor.hpp>
+
+/**
+Storage of the descriptors of a PointCloud<PointDescriptor>. The histograms are stored in a single row-major
+matrix of floats, one row per descriptor, along with a bitmap of the validity of the descriptors and their
+global indices and types. A descriptor of N bins thus takes 4 * N bytes plus a few bytes of metadata,
+instead of an arma::vec header and a heap-allocated array of doubles.
+
+The matrix mimics the part of the std::vector interface PointCloud relies on: its elements are read through
+DescriptorMatrix::ConstReference, which converts to PointDescriptor, and written through DescriptorMatrix::Reference. All the descriptors of a matrix have the same size, set by
+set_descriptor_size or by the first descriptor written to an empty matrix.
+Different descriptors can be written to from concurrent threads, as long as the descriptor size is already set
+*/
+class DescriptorMatrix {
+
+public:
+
+	/**
+	Reference to a descriptor stored in a matrix, with the interface of PointDescriptor
+	*/
+	class Reference {
+
+	public:
+
+		Reference(DescriptorMatrix * matrix,unsigned int index);
+
+		/**
+		Overwrites the referenced descriptor
+		@param descriptor descriptor whose histogram, type, global index and validity are copied
+		@return reference
+		*/
+		Reference & operator=(const PointDescriptor & descriptor);
+
+		/**
+		Overwrites the referenced descriptor with another stored descriptor
+		@param other referenced descriptor to copy
+		@return reference
+		*/
+		Reference & operator=(const Reference & other);
+
+		operator PointDescriptor() const;
+
+		arma::vec get_histogram() const;
+		unsigned int get_histogram_size() const;
+		double get_histogram_value(int bin_index) const;
+
+		/**
+		Copies the histogram of the referenced descriptor without allocating
+		@param histogram buffer of at least get_histogram_size() elements receiving the histogram
+		*/
+		void copy_histogram(double * histogram) const;
+
+		double distance_to_descriptor(const PointDescriptor & descriptor) const;
+		double distance_to_descriptor(const arma::vec & histogram) const;
+
+		int get_type() const;
+
+		int get_global_index() const;
+		void set_global_index(int index);
+
+		bool get_is_valid_feature() const;
+		void set_is_valid_feature(bool valid_feature);
+
+	protected:
+
+		DescriptorMatrix * matrix;
+		unsigned int index;
+
+	};
+
+	/**
+	Read-only reference to a descriptor stored in a matrix, with the const interface of PointDescriptor.
+	Unlike a PointDescriptor copy, it does not allocate a histogram
+	*/
+	class ConstReference {
+
+	public:
+
+		ConstReference(const DescriptorMatrix * matrix,unsigned int index);
+
+		operator PointDescriptor() const;
+
+		/**
+		Returns the histogram of the referenced descriptor. Allocates, prefer get_histogram_data or copy_histogram in loops
+		@return histogram
+		*/
+		arma::vec get_histogram() const;
+		unsigned int get_histogram_size() const;
+		double get_histogram_value(int bin_index) const;
+
+		/**
+		Returns the histogram of the referenced descriptor
+		@return pointer to the get_histogram_size() bins of the histogram
+		*/
+		const float * get_histogram_data() const;
+
+		/**
+		Copies the histogram of the referenced descriptor without allocating
+		@param histogram buffer of at least get_histogram_size() elements receiving the histogram
+		*/
+		void copy_histogram(double * histogram) const;
+
+		double distance_to_descriptor(const PointDescriptor & descriptor) const;
+		double distance_to_descriptor(const arma::vec & histogram) const;
+
+		int get_type() const;
+		int get_global_index() const;
+		bool get_is_valid_feature() const;
+
+	protected:
+
+		const DescriptorMatrix * matrix;
+		unsigned int index;
+
+	};
+
+	/**
+	Returns the number of descriptors
+	@return number of descriptors
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the number of bins of the descriptors
+	@return descriptor size, 0 if not set yet
+	*/
+	unsigned int get_descriptor_size() const;
+
+	/**
+	Sets the number of bins of the descriptors. The histograms are zeroed if the size changes
+	@param descriptor_size number of bins
+	*/
+	void set_descriptor_size(unsigned int descriptor_size);
+
+	/**
+	Resizes the matrix. New descriptors have zero histograms and are valid
+	@param N new number of descriptors
+	*/
+	void resize(unsigned int N);
+
+	/**
+	Removes all the descriptors, keeping the descriptor size
+	*/
+	void clear();
+
+	/**
+	Appends a descriptor. Throws if its size differs from that of the matrix
+	@param descriptor appended descriptor
+	*/
+	void push_back(const PointDescriptor & descriptor);
+
+	ConstReference operator[](unsigned int i) const;
+	Reference operator[](unsigned int i);
+	Reference back();
+
+	/**
+	Returns the histogram of a descriptor
+	@param i descriptor index
+	@return pointer to the get_descriptor_size() bins of the histogram
+	*/
+	const float * get_histogram_data(unsigned int i) const;
+
+	/**
+	Returns the histogram of a descriptor
+	@param i descriptor index
+	@return histogram
+	*/
+	arma::vec get_histogram(unsigned int i) const;
+
+	/**
+	Overwrites a descriptor. Throws if its size differs from that of the matrix
+	@param i descriptor index
+	@param descriptor descriptor whose histogram, type, global index and validity are copied
+	*/
+	void set(unsigned int i,const PointDescriptor & descriptor);
+
+	bool get_is_valid_feature(unsigned int i) const;
+	void set_is_valid_feature(unsigned int i,bool valid_feature);
+
+	int get_global_index(unsigned int i) const;
+	void set_global_index(unsigned int i,int index);
+
+	int get_type(unsigned int i) const;
+
+	/**
+	Computes the distance of PointDescriptor::distance_to_descriptor between a descriptor and a histogram
+	@param i descriptor index
+	@param histogram pointer to the get_descriptor_size() bins of the histogram
+	@return distance
+	*/
+	double distance(unsigned int i,const double * histogram) const;
+
+	/**
+	Computes the distances of PointDescriptor::distance_to_descriptor between all the descriptors and a histogram,
+	in parallel over the descriptors
+	@param histogram histogram
+	@param distances distances, resized to size()
+	*/
+	void compute_distances(const arma::vec & histogram,arma::vec & distances) const;
+
+	/**
+	Computes the mean of the histograms of all the descriptors
+	@return mean histogram
+	*/
+	arma::vec compute_mean() const;
+
+protected:
+
+	unsigned int N = 0;
+	unsigned int descriptor_size = 0;
+
+	// Histograms, stored descriptor after descriptor
+	std::vector<float> histograms;
+
+	// Validity of descriptor i in bit i % 64 of valid_bits[i / 64]
+	std::vector<std::uint64_t> valid_bits;
+
+	std::vector<int> global_indices;
+	std::vector<unsigned char> types;
+
+};
+
+
+#endif
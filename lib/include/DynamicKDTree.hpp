@@ -0,0 +1,130 @@
+#ifndef HEADER_DYNAMIC_KDTREE
+#define HEADER_DYNAMIC_KDTREE
+
+#include <vector>
+#include <map>
+#include <armadillo>
+
+#include <KDTree.hpp>
+
+// A new batch of points absorbs the existing trees holding at most this many times its own number of points
+#define DYNAMIC_KDTREE_MERGE_RATIO 2
+
+/**
+KD Tree over a growing set of points, implemented with the logarithmic method: the points
+are spread over a forest of static KD Trees whose sizes decrease geometrically. Inserting a batch of points
+builds a single tree over the batch and the smallest trees of the forest it absorbs,
+so each point is only ever rebuilt O(log N) times and inserting a batch costs time proportional
+to its size (amortized). Queries run on each tree in turn, sharing their pruning bound.
+*/
+template <template<class> class ContainerType, class PointType>  class DynamicKDTree {
+
+public:
+
+	/**
+	Builds the forest as a single tree, discarding the points inserted so far
+	@param indices indices of the points of the owner to be stored in the tree
+	@param owner pointer to the container holding the points. Only accessed during the build
+	*/
+	void build(const std::vector< int > & indices,const ContainerType<PointType> * owner) ;
+
+	/**
+	Inserts a batch of points in the forest
+	@param indices indices of the new points in their owner
+	@param coordinates coordinates of the new points, stored point after point in the order of indices.
+	Must be expressed in the same frame as the points already in the forest
+	*/
+	void insert(const std::vector< int > & indices,const std::vector< double > & coordinates) ;
+
+	/**
+	Finds the point in the forest closest to the test point
+	@param test_point query point
+	@param best_guess_index index of the closest point. Left unchanged if no point
+	was found closer than the input distance
+	@param distance input: search bound, output: distance to the closest point
+	*/
+	void closest_point_search(const arma::vec & test_point,
+		int & best_guess_index,
+		double & distance) const;
+
+	/**
+	Finds the N points in the forest closest to the test point.
+	Wrapper around the allocation-free overload, which should be preferred. Points at exactly the same
+	distance from the test point overwrite each other in the map
+	@param test_point query point
+	@param N_points number of points to find
+	@param distance input: search bound, output: distance to the N-th closest point once N points were found
+	@param closest_points map of (distance, index) pairs of the closest points found
+	*/
+	void closest_N_point_search(const arma::vec & test_point,
+		const unsigned int & N_points,
+		double & distance,
+		std::map<double, int > & closest_points) const;
+
+	/**
+	Finds the N points in the forest closest to the test point. Does not allocate, and
+	keeps points found at the same distance from the test point
+	@param test_point pointer to the coordinates of the query point
+	@param N_points number of points to find
+	@param closest_indices buffer of at least N_points elements receiving the indices of
+	the closest points, sorted by increasing distance
+	@param closest_distances buffer of at least N_points elements receiving the squared distances
+	to the closest points (the descriptor distances if the forest holds descriptors)
+	@return number of points found. Less than N_points only if the forest holds fewer points
+	*/
+	unsigned int closest_N_point_search(const double * test_point,
+		unsigned int N_points,
+		int * closest_indices,
+		double * closest_distances) const;
+
+	/**
+	Finds all the points in the forest strictly closer to the test point than the provided distance
+	@param test_point query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	*/
+	void radius_point_search(const arma::vec & test_point,
+		const double & distance,
+		std::vector< int > & closest_points) const;
+
+	/**
+	Finds all the points in the forest strictly closer to the test point than the provided distance
+	@param test_point pointer to the coordinates of the query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	@param closest_distances squared distances to the points found (the descriptor distances
+	if the forest holds descriptors), appended to
+	*/
+	void radius_point_search(const double * test_point,
+		const double & distance,
+		std::vector< int > & closest_points,
+		std::vector< double > & closest_distances) const;
+
+	/**
+	Returns the number of points in the forest
+	@return number of points
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the number of static trees in the forest
+	@return number of trees
+	*/
+	unsigned int get_N_trees() const;
+
+	/**
+	Returns one of the static trees of the forest. The trees are sorted by decreasing size
+	@param tree_index index of the tree
+	@return tree
+	*/
+	const KDTree<ContainerType,PointType> & get_tree(unsigned int tree_index) const;
+
+protected:
+
+	// Static trees, sorted by decreasing size
+	std::vector< KDTree<ContainerType,PointType> > trees;
+
+};
+
+
+#endif
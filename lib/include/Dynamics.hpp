@@ -27,6 +27,20 @@ namespace Dynamics{
 	arma::mat identity_33(double t,const arma::vec & X, const Args & args) ;
 
 
+	/**
+	Determines whether the sun is occluded by the shape model. The shadow cache is used
+	if provided, otherwise an any-hit ray is cast towards the sun
+	@param shape_model pointer to the occluding shape model
+	@param shadow_cache pointer to the eclipse cache of this shape model (nullptr if not used)
+	@param position_body_frame position of the spacecraft in the body frame
+	@param sun_direction_body_frame unit vector directed from the spacecraft to the sun, in the body frame
+	@return true if the spacecraft is in the shadow of the shape model
+	*/
+	bool is_in_shadow(ShapeModel<ControlPoint> * shape_model,
+		ShadowCache * shadow_cache,
+		const arma::vec::fixed<3> & position_body_frame,
+		const arma::vec::fixed<3> & sun_direction_body_frame);
+
 	/**
 	Evaluates the acceleration due to SRP at the provided point using a cannonball model assuming constant solar flux
 	checks for eclipses with true shape model
@@ -4,6 +4,18 @@
 #include <EstimationFeature.hpp>
 #include <FPFH.hpp>
 
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+// Coordinates and normal of a point, identifying it in the cache of EstimationFPFH.
+// These are absolute coordinates: a rigidly transformed point has a different key
+typedef std::array<double,6> FPFHCacheKey;
+
+struct FPFHCacheKeyHash {
+	std::size_t operator()(const FPFHCacheKey & key) const;
+};
+
 
 template <class T,class U> class EstimationFPFH : public EstimationFeature<T,U>{
 
@@ -12,6 +24,7 @@ public:
 	EstimationFPFH(const PointCloud<T> & input_pc,PointCloud<U> & output_pc);
 	virtual void estimate(double radius_neighbors,bool force_use_previous = false);
 	virtual	void estimate(int N_neighbors,bool force_use_previous = false);
+	virtual	void estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous = false);
 
 	/**
 	Toggles normalization of spfh
@@ -26,15 +39,51 @@ public:
 	*/
 	void set_N_bins(int N_bins);
 
-	
+	/**
+	Toggles the caching of the SPFH and FPFH of each point from one call to estimate to the next.
+	A cached SPFH is reused as long as the point, its normal and the points and normals of its neighbors
+	are unchanged, and a cached FPFH as long as its own SPFH and those of its neighbors are. Re-estimating the
+	descriptors of a cloud after points were added to it, removed from it or had their normals updated
+	then only recomputes the histograms of the affected points. Points that are no longer in the cloud are dropped
+	from the cache. Points are identified by their absolute coordinates and normals, so the cache only helps
+	repeated estimates in the same frame: after any rigid transform of the cloud, all the histograms are recomputed.
+	Off by default, as the cache holds two histograms per point
+	@param use_cache true if the histograms should be cached
+	*/
+	void set_use_cache(bool use_cache);
+
+	/**
+	Empties the cache of histograms
+	*/
+	void clear_cache();
+
+	/**
+	Returns the number of FPFH computed by the last call to estimate, the others having been found in the cache
+	@return number of computed FPFH
+	*/
+	unsigned int get_N_computed_features() const;
 
 
 
 protected:
+
+	struct CacheEntry {
+		// Order-independent hash of the keys of the neighbors of the point
+		std::uint64_t neighborhood_signature;
+		SPFH spfh;
+		FPFH fpfh;
+	};
+
+	static FPFHCacheKey get_cache_key(const PointCloud<T> & pc,unsigned int i);
+
 	bool scale_distance = false;
 	int N_bins = 11;
 	double beta = 1.5;
 
+	bool use_cache = false;
+	std::unordered_map<FPFHCacheKey,CacheEntry,FPFHCacheKeyHash> cache;
+	unsigned int N_computed_features = 0;
+
 };
 
 
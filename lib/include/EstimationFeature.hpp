@@ -3,6 +3,7 @@
 
 #include <PointCloud.hpp>
 #include <PointDescriptor.hpp>
+#include <PointNeighborhoods.hpp>
 
 template <class T,class U> class EstimationFeature{
 
@@ -12,6 +13,14 @@ public:
 	virtual void estimate(double radius_neighbors,bool force_use_previous = false) = 0; 
 	virtual	void estimate(int N_neighbors,bool force_use_previous = false) = 0;
 
+	/**
+	Estimates the features from neighborhoods computed beforehand over the input point cloud,
+	so that the same neighborhoods can be shared by several estimators
+	@param neighborhoods neighborhoods of all the points of the input point cloud
+	@param force_use_previous see the radius and N-neighbors overloads
+	*/
+	virtual	void estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous = false) = 0;
+
 
 	static arma::vec compute_distances_to_center(const arma::vec & center , const PointCloud<U> & pc);
 	arma::vec compute_distances_to_center();
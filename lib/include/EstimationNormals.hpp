@@ -10,11 +10,31 @@ public:
 	EstimationNormals(const PointCloud<T> & input_pc,PointCloud<U> & output_pc);
 	virtual	void estimate(double radius_neighbors,bool force_use_previous = false);
 	virtual	void estimate(int N_neighbors,bool force_use_previous = false);
+	virtual	void estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous = false);
+
+	/**
+	Estimates the normals of an organized point cloud (built from the focal plane of a lidar),
+	the neighborhood of each point being made of the points measured by the pixels in a square window around its own.
+	The covariances of all the windows are obtained in constant time per point from integral images of
+	the first and second moments of the points, and decomposed in closed form.
+	Points measured in the same window but across a depth discontinuity are not told apart.
+	Points whose window holds fewer than 3 points (edges of the target, dropouts) fall back to the
+	(2 * half_window + 1)^2 points closest to them, which requires the KD Tree of the point cloud to be built
+	@param half_window half size of the windows, in pixels. The windows span (2 * half_window + 1)^2 pixels
+	@param force_use_previous if true, the normals are oriented consistently with the normals
+	previously held by the output point cloud, otherwise towards the line of sight
+	*/
+	void estimate_organized(unsigned int half_window,bool force_use_previous = false);
 
 	void set_los_dir(const arma::vec::fixed<3> & los_dir);
 
 
 protected:
+
+	// Sets the normal of a point of the output point cloud, flipped so as to face the line of sight
+	// or to be consistent with its previous normal
+	void set_oriented_normal(unsigned int i,const arma::vec::fixed<3> & n,bool force_use_previous);
+
 	arma::vec::fixed<3> los_dir = {0,0,0};
 	
 };
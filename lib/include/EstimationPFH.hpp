@@ -11,6 +11,7 @@ public:
 	EstimationPFH(const PointCloud<T> & input_pc,PointCloud<U> & output_pc);
 	virtual void estimate(double radius_neighbors,bool force_use_previous = false);
 	virtual	void estimate(int N_neighbors,bool force_use_previous = false);
+	virtual	void estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous = false);
 
 	void set_N_bins(int N_bins);
 
@@ -11,7 +11,7 @@ public:
 	FPFH();
 
 	FPFH(const int & query_point,
-		const std::vector<std::vector<int> >  & points,
+		const PointNeighborhoods & neighborhoods,
 		const std::vector<SPFH> & spfhs,
 		const PointCloud<PointNormal> & pc,
 		bool scale_distance,
@@ -4,7 +4,11 @@
 
 #include <PointCloud.hpp>
 #include <PointDescriptor.hpp>
+#include <DescriptorIndex.hpp>
 
+// Default maximum number of features of pc2 compared to each feature of pc1. 0 forces an exact search,
+// so the correspondences are the true nearest neighbors unless an approximate search is requested
+#define FEATURE_MATCHING_MAX_CHECKS 0
 
 
 
@@ -18,13 +22,23 @@ public:
 	/**
 	Constructor
 	@param pc1 Reference to first descriptor point cloud . The features in pc1 will be associated with their nearest neighbors in pc2
-	@param pc2 Reference to second descriptor point cloud. Will have its kd tree computed/recomputed.
+	@param pc2 Reference to second descriptor point cloud. Its features are indexed by a DescriptorIndex,
+	searched exactly unless set_max_checks requests an approximate search
 	@param N number of closest neighbors in feature space to search
 	*/	
 	FeatureMatching(const PointCloud<T> & pc1, PointCloud<T> & pc2);
 	void match(std::map<int, std::vector< int > > & matches,const int & N); 
 	void match(std::vector< PointPair > & matches,const int & N);
 
+	/**
+	Sets the maximum number of features of pc2 compared to each feature of pc1, making the search approximate.
+	The matches are then no longer guaranteed to be the nearest neighbors: BenchmarkICP reports the recall
+	of the index against the exact search for several values
+	@param max_checks maximum number of comparisons. Larger values increase recall at the expense of speed.
+	0 (the default) forces an exact search
+	*/
+	void set_max_checks(unsigned int max_checks);
+
 
 	static void greedy_pairing(
 		int N_potential_correspondances, 
@@ -33,7 +47,8 @@ public:
 		const PointCloud<PointNormal> & point_pc2,
 		const PointCloud<T> & descriptor_pc1,
 		PointCloud<T> & descriptor_pc2,
-		std::vector< PointPair > & matches);
+		std::vector< PointPair > & matches,
+		unsigned int max_checks = FEATURE_MATCHING_MAX_CHECKS);
 
 
 
@@ -46,6 +61,7 @@ public:
 protected:
 	const PointCloud<T> & pc1;
 	PointCloud<T> & pc2;
+	unsigned int max_checks = FEATURE_MATCHING_MAX_CHECKS;
 
 
 	static double find_best_q_indices(
@@ -4,6 +4,8 @@
 #include "RefFrame.hpp"
 #include <memory>
 #include "Adjacency_List.hpp"
+#include <vector>
+#include <map>
 
 
 class FrameGraph {
@@ -40,6 +42,82 @@ public:
 	                  std::string to, bool is_unit_vector = false);
 
 
+	/**
+	Converts the coordinates of the provided vector from frame
+	$from to frame $to, designated by their integer handles.
+	This skips the frame name lookups of the string-based overload
+	@param input Vector to convert
+	@param from Handle of reference frame to convert from
+	@param to Handle of reference frame to convert to
+	@param is_unit_vector True if the provided coordinates are
+	that of a unit vector. This will disable the translational part
+	of the transform
+	@return converted coordinates
+	*/
+	arma::vec convert(const arma::vec & input, int from,
+	                  int to, bool is_unit_vector = false);
+
+
+	/**
+	Converts the coordinates of a batch of vectors from frame
+	$from to frame $to. The path between the two frames is only resolved once
+	@param input Vectors to convert, stored column-wise (3 x N)
+	@param from Name of reference frame to convert from
+	@param to Name of reference frame to convert to
+	@param is_unit_vector True if the provided coordinates are
+	that of unit vectors. This will disable the translational part
+	of the transform
+	@return converted coordinates (3 x N)
+	*/
+	arma::mat convert_batch(const arma::mat & input, std::string from,
+	                        std::string to, bool is_unit_vector = false);
+
+
+	/**
+	Computes the composite transform between frame $from and frame $to,
+	such that x_to = dcm * x_from + origin
+	@param from Name of reference frame to convert from
+	@param to Name of reference frame to convert to
+	@param dcm Composite direction cosine matrix [to <- from]
+	@param origin Origin of frame $from expressed in frame $to
+	*/
+	void get_transform(std::string from, std::string to,
+	                   arma::mat::fixed<3, 3> & dcm,
+	                   arma::vec::fixed<3> & origin);
+
+
+	/**
+	Computes the composite transform between frame $from and frame $to,
+	designated by their integer handles, such that x_to = dcm * x_from + origin
+	@param from Handle of reference frame to convert from
+	@param to Handle of reference frame to convert to
+	@param dcm Composite direction cosine matrix [to <- from]
+	@param origin Origin of frame $from expressed in frame $to
+	*/
+	void get_transform(int from, int to,
+	                   arma::mat::fixed<3, 3> & dcm,
+	                   arma::vec::fixed<3> & origin);
+
+
+	/**
+	Returns the integer handle of a frame. Handles are stable
+	for the lifetime of the graph and can be used in lieu of frame names
+	in the hot paths. An exception is thrown if the frame is not in the graph
+	@param frame_name Name of reference frame
+	@return frame handle
+	*/
+	int get_frame_handle(std::string frame_name) const;
+
+
+	/**
+	Enables/disables the caching of the composite transforms between pairs of frames.
+	A cached transform is recompiled when one of the transforms along its path
+	is modified, or when the graph topology changes
+	@param use_transform_cache true if the transforms should be cached
+	*/
+	void set_use_transform_cache(bool use_transform_cache);
+
+
 	/**
 	Sets the mrp of the transform to the one provided as argument
 	@param parent_name Name of parent frame
@@ -97,8 +175,35 @@ public:
 
 
 protected:
+
+	/**
+	Composite transform between two frames, compiled from the
+	sequence of parent/child transforms along the path connecting them.
+	The revisions of the traversed frames are recorded so that
+	a modification of any of them can be detected
+	*/
+	struct TransformChain {
+		arma::mat::fixed<3, 3> dcm;
+		arma::vec::fixed<3> origin;
+		std::vector<RefFrame *> frames;
+		std::vector<unsigned int> revisions;
+		bool compiled = false;
+	};
+
 	Adjacency_List<std::shared_ptr <RefFrame> , std::pair< std::string, std::string > > adjacency_list;
 	std::map< std::string , std::shared_ptr <RefFrame> > ref_names_to_ref_ptrs;
+	std::map< std::string , int > ref_names_to_handles;
+	std::vector< std::shared_ptr <RefFrame> > handles_to_ref_ptrs;
+
+	// Compiled chains, indexed by from * N_frames + to
+	std::vector<TransformChain> transform_chains;
+	bool use_transform_cache = true;
+
+	const TransformChain & get_transform_chain(int from, int to);
+	void compile_transform_chain(int from, int to, TransformChain & chain);
+	bool is_transform_chain_current(const TransformChain & chain) const;
+	void invalidate_transform_chains(const RefFrame * ref_frame);
+	void invalidate_transform_chains();
 
 
 	void convert_to_parent_of_provided_child_frame(arma::vec & coords, RefFrame * ref_frame,
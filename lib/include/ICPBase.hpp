@@ -9,6 +9,7 @@
 #include <OMP_flags.hpp>
 #include <DebugFlags.hpp>
 #include <RigidBodyKinematics.hpp>
+#include <Philox.hpp>
 
 
 typedef PointCloud<PointNormal> PC;
@@ -147,6 +148,9 @@ protected:
 	unsigned int minimum_h = 0;
 	unsigned int maximum_h = 7;
 	unsigned int N_bins = 3;
+
+	// Number of pair formations so far, used to key the random sampling of the points
+	unsigned int N_pairings = 0;
 	
 	bool use_true_pairs = false;
 	bool keep_correlations = true;
@@ -5,6 +5,10 @@
 
 #define IOFLAGS_run_iod 1
 
+// Lidar flashes are appended to a single binary range-image file per run
+// instead of being saved as one text file per flash
+#define IOFLAGS_binary_range_images 1
+
 
 #endif
 
@@ -9,6 +9,21 @@ public:
 
 	IterativeClosestPointToPlane() ;
 
+	/**
+	Forms point pairs between two point clouds from a random subset of the points of one of them.
+	The subset is drawn from the Philox stream (sampling_iteration,sampling_stream), so
+	that it is reproducible regardless of the calling thread
+	@param source_pc source point cloud
+	@param destination_pc destination point cloud
+	@param point_pairs formed point pairs
+	@param h hierarchical level. About 2^(-h) of the points are sampled
+	@param dcm_S attitude of the source point cloud
+	@param x_S position of the source point cloud
+	@param dcm_D attitude of the destination point cloud
+	@param x_D position of the destination point cloud
+	@param sampling_iteration first index of the sampling stream (e.g. iteration)
+	@param sampling_stream second index of the sampling stream (e.g. point-cloud pair)
+	*/
 	static void compute_pairs(
 		const PC & source_pc,
 		const PC & destination_pc,
@@ -17,7 +32,9 @@ public:
 		const arma::mat::fixed<3,3> & dcm_S = arma::eye<arma::mat>(3, 3),
 		const arma::vec::fixed<3> & x_S = arma::zeros<arma::vec>(3),
 		const arma::mat::fixed<3,3> & dcm_D = arma::eye<arma::mat>(3, 3),
-		const arma::vec::fixed<3> & x_D = arma::zeros<arma::vec>(3));
+		const arma::vec::fixed<3> & x_D = arma::zeros<arma::vec>(3),
+		unsigned int sampling_iteration = 0,
+		unsigned int sampling_stream = 0);
 
 
 	virtual double compute_distance(
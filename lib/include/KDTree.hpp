@@ -3,92 +3,190 @@
 
 #include <memory>
 #include <vector>
+#include <map>
 #include <armadillo>
 
-// template <class T> class PointCloud;
-
+// Maximum number of points stored in a leaf bucket
+#define KDTREE_LEAF_SIZE 16
+
+/**
+Pointer-free KD tree over the points of a container (point cloud, shape model...).
+The tree is balanced: every fork splits its points at the median coordinate along the axis
+of largest spread, and all the leaves lie at the same depth. The nodes are therefore stored in a single
+array where the children of node i are nodes 2i+1 and 2i+2.
+The coordinates of the points are copied once at construction in a contiguous buffer, reordered
+so that the points of each leaf bucket are adjacent, so queries never go back to the owning container.
+Memory is O(N) in the number of points.
+*/
 template <template<class> class ContainerType, class PointType>  class KDTree {
 
 public:
-	std::shared_ptr<KDTree> left;
-	std::shared_ptr<KDTree> right;
-	std::vector<int> indices;
-
-	// KDTree();
-
-
-	void build(const std::vector< int > & indices, int depth,const ContainerType<PointType> * owner) ;
 
+	/**
+	Builds the tree
+	@param indices indices of the points of the owner to be stored in the tree
+	@param owner pointer to the container holding the points. Only accessed during the build
+	*/
+	void build(const std::vector< int > & indices,const ContainerType<PointType> * owner) ;
+
+	/**
+	Builds the tree from coordinates provided by the caller
+	@param indices indices of the points in their owner
+	@param coordinates coordinates of the points, stored point after point in the order of indices
+	*/
+	void build(const std::vector< int > & indices,const std::vector< double > & coordinates) ;
+
+	/**
+	Finds the point in the tree closest to the test point
+	@param test_point query point
+	@param best_guess_index index of the closest point. Left unchanged if no point
+	was found closer than the input distance
+	@param distance input: search bound, output: distance to the closest point
+	*/
 	void closest_point_search(const arma::vec & test_point,
-		const std::shared_ptr<KDTree> & node,
 		int & best_guess_index,
-		double & distance,
-		const ContainerType<PointType> * owner) const;
-
+		double & distance) const;
+
+	/**
+	Finds the N points in the tree closest to the test point.
+	Wrapper around the allocation-free overload, which should be preferred. Points at exactly the same
+	distance from the test point overwrite each other in the map
+	@param test_point query point
+	@param N_points number of points to find
+	@param distance input: search bound, output: distance to the N-th closest point once N points were found
+	@param closest_points map of (distance, index) pairs of the closest points found
+	*/
 	void closest_N_point_search(const arma::vec & test_point,
 		const unsigned int & N_points,
-		const std::shared_ptr<KDTree> & node,
 		double & distance,
-		std::map<double, int > & closest_points,
-		const ContainerType<PointType> * owner) const;
-
+		std::map<double, int > & closest_points) const;
+
+	/**
+	Finds the N points in the tree closest to the test point. Does not allocate, and
+	keeps points found at the same distance from the test point
+	@param test_point pointer to the coordinates of the query point
+	@param N_points number of points to find
+	@param closest_indices buffer of at least N_points elements receiving the indices of
+	the closest points, sorted by increasing distance
+	@param closest_distances buffer of at least N_points elements receiving the squared distances
+	to the closest points (the descriptor distances if the tree holds descriptors)
+	@param N_found number of points already held in the buffers, found by a previous search
+	over other points. Used to carry a search across several trees
+	@return number of points held in the buffers. Less than N_points only if fewer points were searched
+	*/
+	unsigned int closest_N_point_search(const double * test_point,
+		unsigned int N_points,
+		int * closest_indices,
+		double * closest_distances,
+		unsigned int N_found = 0) const;
+
+	/**
+	Finds all the points in the tree strictly closer to the test point than the provided distance
+	@param test_point query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	*/
 	void radius_point_search(const arma::vec & test_point,
-		const std::shared_ptr<KDTree> & node,
+		const double & distance,
+		std::vector< int > & closest_points) const;
+
+	/**
+	Finds all the points in the tree strictly closer to the test point than the provided distance
+	@param test_point pointer to the coordinates of the query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	@param closest_distances squared distances to the points found (the descriptor distances
+	if the tree holds descriptors), appended to
+	*/
+	void radius_point_search(const double * test_point,
 		const double & distance,
 		std::vector< int > & closest_points,
-		const ContainerType<PointType> * owner);
-
-	int get_depth() const;
-	void set_depth(int depth);
-
+		std::vector< double > & closest_distances) const;
+
+	/**
+	Returns the indices of the points in the tree, in the order of the leaf buckets.
+	Consecutive points in this order are spatially close, which makes it a
+	cache-friendly order in which to run queries over all the points
+	@return indices of the points in leaf order
+	*/
+	const std::vector<int> & get_indices() const;
+
+	/**
+	Returns the coordinates of the points in the tree, in the order of the leaf buckets
+	and in the frame the owner's points were in when the tree was built
+	@return coordinates of the points, stored point after point
+	*/
+	const std::vector<double> & get_coordinates() const;
+
+	/**
+	Returns the number of points in the tree
+	@return number of points
+	*/
 	unsigned int size() const;
 
-	double get_value() const;
-	unsigned int get_axis() const;
+	/**
+	Returns the depth of the leaves
+	@return depth of the leaves (0 if the root is a leaf)
+	*/
+	int get_depth() const;
 
-	void set_value(double value) ;
-	void set_axis(unsigned int axis);
+protected:
 
-	void set_max_depth(int max_depth);
-	int get_max_depth() const;
+	struct Node {
+		// Split value and axis (forks only)
+		double value = 0;
+		int axis = 0;
 
+		// Range of the node's points in the reordered buffers
+		int begin = 0;
+		int end = 0;
+	};
 
-	void set_min_indices_per_node(int min_indices_per_node);
-	int get_min_indices_per_node() const;
+	// Squared distance between points, descriptor distance between descriptors
+	double metric(const double * point_in_tree, const double * point) const;
 
+	// True if the metric is the squared euclidean distance
+	bool is_euclidean() const;
 
+	// Metric between the test point and a split plane, used to prune the far side of forks
+	double plane_metric(double offset) const;
 
-protected:
+	double distance_to_metric(double distance) const;
+	double metric_to_distance(double metric) const;
 
-	double distance(const PointType & point_in_pc, const arma::vec & point) const;
+	void closest_point_search(int node_index,
+		const double * test_point,
+		int & best_guess_index,
+		double & bound) const;
+
+	void closest_N_point_search(int node_index,
+		const double * test_point,
+		unsigned int N_points,
+		int * closest_indices,
+		double * closest_distances,
+		unsigned int & N_found) const;
+
+	void radius_point_search(int node_index,
+		const double * test_point,
+		const double & bound,
+		std::vector< int > & closest_points,
+		std::vector< double > * closest_distances) const;
 
-	void search_node(const arma::vec & test_point,
-		const unsigned int & N_points,
-		const std::shared_ptr<KDTree> & node,
-		double & distance,
-		std::map<double,int > & closest_points,
-		const ContainerType<PointType> * owner) const;
+	bool is_leaf(int node_index) const;
 
-	void search_node(const arma::vec & test_point,
-		const std::shared_ptr<KDTree> & node,
-		const double & distance,
-		std::vector< int > & closest_points_indices,
-		const ContainerType<PointType> * owner) const;
+	std::vector<Node> nodes;
 
-	void search_node(const arma::vec & test_point,
-		const std::shared_ptr<KDTree> & node,
-		int & best_guess_index,
-		double & distance,
-		const ContainerType<PointType> * owner) const;
+	// Coordinates of the points, reordered by leaf and stored point after point
+	std::vector<double> coordinates;
 
-	int depth;
-	int max_depth = 25;
-	int min_indices_per_node = -1;
+	// Index in the owner of each point in the reordered buffer
+	std::vector<int> indices;
 
-	double value;
-	unsigned int axis = 0;
+	int dimension = 0;
+	int depth = 0;
+	int first_leaf = 0;
 
 };
 
 
-#endif
\ No newline at end of file
+#endif
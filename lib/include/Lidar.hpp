@@ -2,11 +2,13 @@
 #define HEADER_LIDAR
 
 #include "OMP_flags.hpp"
+#include "RayPacket.hpp"
 #include <PointCloud.hpp>
 #include <assert.h>
 #include <string>
 #include <utility>
 #include <map>
+#include <set>
 #include <vector>
 #include <memory>
 #include <armadillo>
@@ -15,6 +17,10 @@
 
 
 
+// Magic number ("RIMG") and version of the binary range-image records
+#define LIDAR_RANGE_IMAGE_MAGIC 0x474d4952
+#define LIDAR_RANGE_IMAGE_VERSION 1
+
 class Ray;
 class ControlPoint;
 template<class PointType> class ShapeModel;
@@ -22,6 +28,26 @@ class FrameGraph;
 class Facet;
 
 
+/**
+State of the lidar and of the observed shape at the time of a flash.
+Poses are given relative to the parent frames of the lidar and shape reference frames
+*/
+struct FlashPose{
+
+	// Time of the flash (s), only carried along to identify the flash
+	double time;
+
+	// Origin and attitude of the lidar frame relative to its parent
+	arma::vec::fixed<3> lidar_origin;
+	arma::vec::fixed<3> lidar_mrp;
+
+	// Origin and attitude of the shape frame relative to its parent
+	arma::vec::fixed<3> shape_origin;
+	arma::vec::fixed<3> shape_mrp;
+
+};
+
+
 class Lidar {
 
 public:
@@ -151,6 +177,29 @@ public:
 
 	void send_flash(ShapeModel<ControlPoint> * shape_model,bool add_noise,double skip_factor = 1) ;
 
+	/**
+	Sends a series of laser flashes to the targeted shape model as a single job.
+	The lidar-to-target transform of every flash is resolved first, then the active pixels
+	of all the flashes are split into (flash,tile) tasks that are dynamically scheduled
+	across threads, so that short or unbalanced flashes do not leave threads idle.
+	The flashes are traced in the same mode as send_flash (coherence, packets or single rays).
+	In coherence mode, each tile of pixels is traced through the flashes in order, so that every flash uses
+	the facets hit during the previous one, and the tasks are the tiles only.
+	The state of the focal-plane rays is left untouched, except for the coherence guesses which hold
+	the facets hit during the last flash. The lidar and shape frames are restored to their state before the call
+	@param shape_model Pointer to the shape model being observed
+	@param poses lidar and shape poses at each flash
+	@param add_noise if true, range noise is added to each hit
+	@param skip_factor determines the number of pixels skipped between two active pixels. 
+	default is skip_factor == 1 (all pixels are used)
+	@return range images of each flash, of size z_res x y_res. Pixels that were skipped
+	or did not hit the target are set to infinity
+	*/
+	std::vector<arma::mat> send_flashes(ShapeModel<ControlPoint> * shape_model,
+		const std::vector<FlashPose> & poses,
+		bool add_noise,
+		double skip_factor = 1) ;
+
 
 	/**
 	Saves the range residuals associated with each facet to
@@ -187,8 +236,59 @@ public:
 
 	void save(std::string path,bool conserve_format = false)  ;
 
+	/**
+	Writes the ranges and incidence angles collected during the last flash
+	as a binary record. The first record written by this instrument to a given path
+	overwrites the file, subsequent ones are appended to it so that a run produces a single file.
+	Each record is made of a header followed by two float32 images of size y_res x z_res
+	(ranges, then incidence angles), stored row-major with the same orientation as the
+	formatted text output of save(). Pixels that did not hit the target have an infinite range
+	and a NaN incidence angle.
+	The header holds, in this order:
+	- the magic number LIDAR_RANGE_IMAGE_MAGIC (uint32)
+	- the format version LIDAR_RANGE_IMAGE_VERSION (uint32)
+	- the number of rows and columns of the images (2 x uint32)
+	- the time of the flash (float64)
+	- the position of the lidar in the target frame (3 x float64)
+	- the row-major dcm from the lidar frame to the target frame (9 x float64)
+	Since all the records of a file share the same size, the file can be memory-mapped as an array of records
+	@param path Path to the file
+	@param time time of the flash (s)
+	*/
+	void save_range_image(std::string path,double time) ;
+
 	std::vector<std::shared_ptr<Ray> > * get_focal_plane() ;
 
+	/**
+	Enables/disables packet ray-tracing. When enabled, the focal plane is partitioned
+	into tiles of coherent rays that are traced together through the shape model
+	@param use_packets true if packets should be used, false if rays are traced one at a time
+	*/
+	void set_use_packets(bool use_packets);
+
+	/**
+	Enables/disables the temporal-coherence mode. When enabled, each pixel first tests the facet
+	it hit during the previous flash and its neighbors, and the shape's hierarchy is only searched for
+	closer occluders. A full traversal is performed on a miss. Takes precedence over packet ray-tracing
+	@param use_coherence true if the coherence mode should be used
+	*/
+	void set_use_coherence(bool use_coherence);
+
+	/**
+	Returns the fraction of the hits of the last flash that were found
+	among the facets hit during the previous flash (coherence mode only)
+	@return fast-path hit rate, between 0 and 1
+	*/
+	double get_coherence_hit_rate() const;
+
+	/**
+	Sets the SIMD kernel used in packet ray-tracing. Falls back on the best
+	supported kernel if the requested one cannot run on this CPU
+	@param kernel kernel to use
+	*/
+	void set_packet_kernel(RayPacket::Kernel kernel);
+
+
 
 
 protected:
@@ -207,8 +307,33 @@ protected:
 	ShapeModel<ControlPoint> * shape_model = nullptr;
 	std::vector<std::shared_ptr<Ray> > focal_plane;
 
+	// Directions of the focal-plane rays in the lidar frame, stored column-wise
+	arma::mat focal_plane_directions;
+
 	std::vector<arma::vec> surface_measurements;
 
+	// Paths already written to by save_range_image
+	std::set<std::string> range_image_paths;
+
+	bool use_packets = false;
+	bool use_coherence = false;
+	double coherence_hit_rate = 0;
+	RayPacket::Kernel packet_kernel = RayPacket::get_best_kernel();
+
+	// Number of flashes sent so far, used to key the range noise
+	unsigned int flash_index = 0;
+
+	void add_range_noise(Ray * ray,unsigned int flash,unsigned int pixel) const;
+
+	std::vector<int> get_active_pixel_indices(double skip_factor) const;
+
+	/**
+	Sorts the active pixels by focal-plane tile and splits them into packets
+	@param active_pixel_indices active pixels, sorted in place
+	@return position of the first pixel of each packet in active_pixel_indices, followed by the number of active pixels
+	*/
+	std::vector<unsigned int> get_packet_starts(std::vector<int> & active_pixel_indices) const;
+
 
 
 
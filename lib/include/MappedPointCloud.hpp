@@ -0,0 +1,201 @@
+#ifndef HEADER_MAPPED_POINT_CLOUD
+#define HEADER_MAPPED_POINT_CLOUD
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <armadillo>
+
+#include <PointCloud.hpp>
+
+class PointNormal;
+class PointDescriptor;
+
+// Leading bytes of the files in the binary point cloud format
+#define POINT_CLOUD_BINARY_MAGIC "ASPENPC"
+
+// Version of the binary point cloud format written by PointCloudIO
+#define POINT_CLOUD_BINARY_VERSION 2
+
+// Byte order mark of the file header, stored in the byte order of the machine that wrote the file
+#define POINT_CLOUD_BINARY_BYTE_ORDER 0x01020304u
+
+// Flags of the file header
+#define POINT_CLOUD_BINARY_NORMALS 1u
+#define POINT_CLOUD_BINARY_SINGLE_PRECISION 2u
+
+/**
+Read-only view of a point cloud saved in the binary format of PointCloudIO.
+The file is memory-mapped rather than parsed, so opening it costs no copy and only
+the pages that are accessed are ever read from disk.
+
+The file holds a FileHeader followed by one block per save or append. A block holds a BlockHeader
+followed by the arrays of its points, each padded to a multiple of 8 bytes:
+- positions: 3 scalars per point, stored point after point
+- normals (if the file has normals): 3 scalars per point, stored point after point
+- global indices: one int32 per point
+- descriptors (if the descriptor size is not zero): descriptor_size scalars per point, stored point after point
+The scalars are float64, or float32 if the file was saved in single precision. All values are
+stored in the native byte order of the machine that wrote the file, recorded in the header by a byte order mark:
+files written with another byte order are rejected rather than read as garbage.
+*/
+class MappedPointCloud {
+
+public:
+
+	struct FileHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t flags;
+		std::uint32_t descriptor_size;
+		std::uint32_t N_blocks;
+		std::uint64_t N_points;
+		double bbox_min[3];
+		double bbox_max[3];
+	};
+
+	struct BlockHeader {
+		std::uint64_t N_points;
+		double bbox_min[3];
+		double bbox_max[3];
+	};
+
+	/**
+	Arrays of the points of a block, pointing into the mapped file.
+	The scalars are float if the file is in single precision, double otherwise
+	*/
+	struct Block {
+		unsigned int N_points = 0;
+		const void * positions = nullptr;
+		const void * normals = nullptr;
+		const std::int32_t * indices = nullptr;
+		const void * descriptors = nullptr;
+	};
+
+	/**
+	Maps a binary point cloud file in memory and checks its layout
+	@param path path to the file
+	*/
+	MappedPointCloud(std::string path);
+
+	~MappedPointCloud();
+
+	MappedPointCloud(const MappedPointCloud &) = delete;
+	MappedPointCloud & operator=(const MappedPointCloud &) = delete;
+
+	/**
+	Checks whether a file is in the binary point cloud format
+	@param path path to the file
+	@return true if the file starts with the magic bytes of the format
+	*/
+	static bool is_binary(std::string path);
+
+	/**
+	Checks that a file header can be read on this machine. Throws if its magic bytes, version or byte order do not match
+	@param header header of the file
+	@param path path to the file, reported in the errors
+	*/
+	static void check_header(const FileHeader & header,std::string path);
+
+	/**
+	Returns the number of bytes of a block of the provided number of points, header included
+	@param header header of the file holding the block
+	@param N_points number of points in the block
+	@return size of the block in bytes
+	*/
+	static std::size_t get_block_size(const FileHeader & header,std::uint64_t N_points);
+
+	/**
+	Returns the number of points in the file
+	@return number of points
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the number of blocks in the file
+	@return number of blocks
+	*/
+	unsigned int get_N_blocks() const;
+
+	/**
+	Returns one of the blocks of the file
+	@param block_index index of the block
+	@return arrays of the block
+	*/
+	const Block & get_block(unsigned int block_index) const;
+
+	bool has_normals() const;
+	bool is_single_precision() const;
+	unsigned int get_descriptor_size() const;
+
+	/**
+	Returns the corners of the bounding box of the points
+	@return corner of the bounding box
+	*/
+	arma::vec::fixed<3> get_bbox_min() const;
+	arma::vec::fixed<3> get_bbox_max() const;
+
+	/**
+	Returns the coordinates of a point
+	@param index index of the point in the file
+	@return coordinates
+	*/
+	arma::vec::fixed<3> get_point_coordinates(unsigned int index) const;
+
+	/**
+	Returns the normal of a point. Zero if the file has no normals
+	@param index index of the point in the file
+	@return normal
+	*/
+	arma::vec::fixed<3> get_normal_coordinates(unsigned int index) const;
+
+	/**
+	Returns the global index of a point
+	@param index index of the point in the file
+	@return global index
+	*/
+	int get_global_index(unsigned int index) const;
+
+	/**
+	Returns the descriptor of a point
+	@param index index of the point in the file
+	@return descriptor, empty if the file has no descriptors
+	*/
+	arma::vec get_descriptor(unsigned int index) const;
+
+	/**
+	Copies the points of the file into a point cloud, replacing its content
+	@param pc point cloud
+	*/
+	void load(PointCloud<PointNormal> & pc) const;
+
+	/**
+	Copies the descriptors of the file into a point cloud, replacing its content.
+	Throws if the file has no descriptors
+	@param pc point cloud
+	*/
+	void load(PointCloud<PointDescriptor> & pc) const;
+
+protected:
+
+	// Finds the block holding a point and the index of the point in it
+	const Block & find_block(unsigned int index,unsigned int & local_index) const;
+
+	double get_scalar(const void * array,std::size_t k) const;
+
+	const FileHeader * header = nullptr;
+
+	std::vector<Block> blocks;
+
+	// Index in the file of the first point of each block
+	std::vector<unsigned int> blocks_begin;
+
+	void * data = nullptr;
+	std::size_t data_size = 0;
+
+};
+
+
+#endif
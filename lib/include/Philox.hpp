@@ -0,0 +1,127 @@
+#ifndef HEADER_PHILOX
+#define HEADER_PHILOX
+
+#include <cstdint>
+#include <cmath>
+#include <utility>
+
+// Domains separating the random streams of the library's users
+#define PHILOX_DOMAIN_LIDAR_NOISE 1
+#define PHILOX_DOMAIN_ICP_SAMPLING 2
+#define PHILOX_DOMAIN_DESCRIPTOR_INDEX 3
+#define PHILOX_DOMAIN_DOWNSAMPLING 4
+
+// Number of rounds of the Philox4x32 bijection
+#define PHILOX_ROUNDS 10
+
+
+/**
+Declaration of the Philox class, a counter-based random number generator (Philox4x32-10).
+The n-th random block of a stream is a bijection of the counter (n, stream_0, stream_1, domain)
+keyed by the library-wide seed. Drawing numbers therefore needs no shared state: a generator
+can be instantiated wherever numbers are needed (e.g. one per pixel or per sample) and
+the numbers it produces do not depend on the number of threads or on the order in which
+the streams are consumed
+*/
+class Philox {
+
+public:
+
+	/**
+	Constructor. The generator is keyed by the library-wide seed
+	@param domain domain of the stream (one of the PHILOX_DOMAIN_* flags)
+	@param stream_0 first stream index (e.g. flash index, iteration)
+	@param stream_1 second stream index (e.g. pixel index, sample set)
+	*/
+	Philox(uint32_t domain, uint32_t stream_0, uint32_t stream_1);
+
+	/**
+	Constructor
+	@param seed seed of the generator
+	@param domain domain of the stream (one of the PHILOX_DOMAIN_* flags)
+	@param stream_0 first stream index (e.g. flash index, iteration)
+	@param stream_1 second stream index (e.g. pixel index, sample set)
+	*/
+	Philox(uint64_t seed, uint32_t domain, uint32_t stream_0, uint32_t stream_1);
+
+	/**
+	Sets the library-wide seed used by generators constructed without an explicit seed
+	@param seed new seed
+	*/
+	static void set_seed(uint64_t seed);
+
+	/**
+	Returns the library-wide seed
+	@return seed
+	*/
+	static uint64_t get_seed();
+
+	/**
+	Applies the Philox4x32-10 bijection to a counter
+	@param counter counter (4 words)
+	@param key key (2 words)
+	@param output random block (4 words)
+	*/
+	static void generate(const uint32_t * counter, const uint32_t * key, uint32_t * output);
+
+	/**
+	Returns the next 32 random bits of the stream
+	@return uniformly distributed integer
+	*/
+	inline uint32_t next_uint(){
+		if (this -> block_index == 4){
+			Philox::generate(this -> counter,this -> key,this -> block);
+			++this -> counter[0];
+			this -> block_index = 0;
+		}
+		return this -> block[this -> block_index++];
+	}
+
+	/**
+	Draws a uniformly distributed number with 53 random bits
+	@return number in (0,1)
+	*/
+	inline double uniform(){
+		uint32_t a = this -> next_uint() >> 5;
+		uint32_t b = this -> next_uint() >> 6;
+		return (a * 67108864. + b + 0.5) / 9007199254740992.;
+	}
+
+	/**
+	Draws a uniformly distributed integer
+	@param n number of possible values
+	@return integer in [0,n - 1]
+	*/
+	inline unsigned int uniform_int(unsigned int n){
+		return (unsigned int)((uint64_t(this -> next_uint()) * n) >> 32);
+	}
+
+	/**
+	Draws a standard normal number (Box-Muller)
+	@return normally distributed number of zero mean and unit variance
+	*/
+	double normal();
+
+	/**
+	Shuffles the entries of a vector (Fisher-Yates)
+	@param v vector to shuffle. Must provide n_elem and operator()
+	*/
+	template <class V> void shuffle(V & v){
+		for (unsigned int i = v.n_elem; i > 1; --i){
+			unsigned int j = this -> uniform_int(i);
+			std::swap(v(i - 1),v(j));
+		}
+	}
+
+protected:
+
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t block[4];
+	unsigned int block_index = 4;
+
+	static uint64_t seed;
+
+};
+
+#endif
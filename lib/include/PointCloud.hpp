@@ -5,7 +5,13 @@
 #include <memory>
 #include <cassert>
 
-template <template<class> class ContainerType, class PointType>  class KDTree ;
+#include <DescriptorMatrix.hpp>
+#include <PointNormalColumns.hpp>
+
+template <template<class> class ContainerType, class PointType>  class DynamicKDTree ;
+class PointNeighborhoods;
+class VoxelHashGrid;
+class PointNormal;
 
 
 typedef typename std::pair<int, int > PointPair ;
@@ -13,6 +19,44 @@ typedef typename std::pair<int, int > PointPair ;
 
 class Ray;
 
+/**
+Type returned by the coordinate accessors of PointCloud<PointType>. PointNormal stores its
+coordinates in fixed-size arrays and returns them by value, and descriptors return a copy of their histogram
+in double precision
+*/
+template <class PointType> struct PointCoordinates {
+	typedef arma::vec type;
+};
+
+template <> struct PointCoordinates<PointNormal> {
+	typedef arma::vec::fixed<3> type;
+};
+
+/**
+Storage of the points of PointCloud<PointType>, and types returned by its point accessors.
+Points are stored in a vector and accessed by reference, except points with normals, which are stored
+in the columns of a PointNormalColumns, and descriptors, which are stored in a DescriptorMatrix.
+Points with normals are read by value, descriptors through a DescriptorMatrix::ConstReference,
+and both are written through the Reference of their storage
+*/
+template <class PointType> struct PointStorage {
+	typedef std::vector<PointType> type;
+	typedef PointType & reference;
+	typedef const PointType & const_reference;
+};
+
+template <> struct PointStorage<PointNormal> {
+	typedef PointNormalColumns type;
+	typedef PointNormalColumns::Reference reference;
+	typedef PointNormal const_reference;
+};
+
+template <> struct PointStorage<PointDescriptor> {
+	typedef DescriptorMatrix type;
+	typedef DescriptorMatrix::Reference reference;
+	typedef DescriptorMatrix::ConstReference const_reference;
+};
+
 template <class PointType> 
 class PointCloud {
 
@@ -24,6 +68,12 @@ public:
 
 	PointCloud(const std::vector<PointType> & points);
 	PointCloud(std::vector< std::shared_ptr< PointCloud < PointType> > > & pcs,int points_retained);
+	/**
+	Reads a point cloud from a file. Files in the binary format of PointCloudIO are
+	detected from their first bytes and memory-mapped, other files are parsed as obj or txt
+	@param filename path to the file
+	@param is_txt if true, a text file is parsed as rows of coordinates rather than as obj
+	*/
 	PointCloud(std::string filename,bool is_txt = false);
 
 	/**
@@ -37,16 +87,31 @@ public:
 	/**
 	Returns queried point
 	@param index Index of the queried point
-	@return queried point
+	@return queried point (a copy for PointCloud<PointNormal>, a read-only view for PointCloud<PointDescriptor>)
 	*/
-	const PointType & get_point(unsigned int index) const;
+	typename PointStorage<PointType>::const_reference get_point(unsigned int index) const;
 
 	/**
 	Returns queried point
 	@param index Index of the queried point
 	@return queried point
 	*/
-	PointType & get_point(unsigned int index) ;
+	typename PointStorage<PointType>::reference get_point(unsigned int index) ;
+
+	/**
+	Returns the storage of the points, a PointNormalColumns for PointCloud<PointNormal> and
+	a DescriptorMatrix for PointCloud<PointDescriptor>, for the kernels running over all the points at once
+	@return storage of the points
+	*/
+	const typename PointStorage<PointType>::type & get_points() const;
+
+	/**
+	Sets the number of bins of the descriptors, zeroing them if it changes.
+	Must be called before descriptors are written to a point cloud from concurrent threads.
+	Only defined for PointCloud<PointDescriptor>
+	@param descriptor_size number of bins
+	*/
+	void set_descriptor_size(unsigned int descriptor_size);
 
 
 	/**
@@ -56,11 +121,22 @@ public:
 	unsigned int size() const;
 
 	/**
-	Applies rigid transform to point cloud
+	Applies rigid transform to point cloud. The transform is composed with the pending one
+	and only applied to the points when they are next accessed (see apply_transform).
+	The KD Tree is not rebuilt: it is built once if missing, and queries are then mapped
+	through the inverse of the transforms applied since its construction
+	Only defined for PointCloud<PointNormal>
 	@param dcm dcm directing the rotational component of the rigid transform the rigid transform
 	@param x translational component of the rigid transform
 	*/
 	void transform(const arma::mat::fixed<3,3> & dcm = arma::eye<arma::mat>(3,3),const arma::vec::fixed<3> & x = arma::zeros<arma::vec>(3));
+
+	/**
+	Applies the pending rigid transform, if any, to the points and normals.
+	Called by every accessor to the points, so only needs to be called explicitly to
+	control when the cost of rewriting the points is paid. Safe to call from concurrent threads
+	*/
+	void apply_transform() const;
 	
 	/**
 	Returns a map to the closest N PointType-s whose coordinates are closest to the provided test_point
@@ -71,31 +147,68 @@ public:
 	std::map<double,int > get_closest_N_points(const arma::vec & test_point, const unsigned int & N) const;
 
 	/**
-	Returns a constant reference to the coordinates of the queried point at the provided index
+	Finds the N PointType-s whose coordinates are closest to the provided test_point
+	using the KD Tree search. Does not allocate, so should be preferred in loops
+	@param test_point query point
+	@param N number of points to find
+	@param closest_indices buffer of at least N elements receiving the indices of the closest points,
+	sorted by increasing distance
+	@param closest_distances buffer of at least N elements receiving the squared distances to the closest points
+	(the descriptor distances for PointCloud<PointDescriptor>)
+	@return number of points found. Less than N only if the point cloud holds fewer valid points
+	*/
+	unsigned int get_closest_N_points(const arma::vec & test_point, unsigned int N,
+		int * closest_indices,double * closest_distances) const;
+
+	/**
+	Returns the coordinates of the queried point at the provided index
+	(by value for PointCloud<PointNormal>, by constant reference otherwise)
 	@param index
 	@return vector of coordinates
 	*/
-	const arma::vec & get_point_coordinates(int i) const;
+	typename PointCoordinates<PointType>::type get_point_coordinates(int i) const;
 
 	/**
-	Returns a constant reference to the coordinates of the queried point's normal at the provided index
+	Returns the coordinates of the queried point's normal at the provided index
 	Only defined for PointCloud<PointNormal>
 	@param index
 	@return vector of coordinates
 	*/
-	const arma::vec & get_normal_coordinates(int i) const;
+	typename PointCoordinates<PointType>::type get_normal_coordinates(int i) const;
 
 	/**
-	Returns the points of $this that are within the sphere of specified radius centered at $test_point
+	Returns the points of $this that are within the sphere of specified radius centered at $test_point.
+	Uses the voxel grid if one was built, the KD Tree otherwise
 	@param test_point query point
 	@param radius non-negative search radius
 	@return vector of indices of points in $this that satisfy || test_point - point_in_$this ||  < radius
 	*/
 	std::vector<int> get_nearest_neighbors_radius(const arma::vec & test_point, const double & radius) const;
 
+	/**
+	Computes the neighborhoods of all the points of $this within the specified radius, in a single parallel pass.
+	The queries are run in the leaf order of the KD Tree, so that consecutive queries visit the same nodes.
+	Uses the voxel grid if one was built, the KD Tree otherwise.
+	Points that are not in the KD Tree (invalid descriptors) get empty neighborhoods
+	@param radius non-negative search radius
+	@param neighborhoods neighborhoods of all the points of $this. Each neighborhood includes the point itself
+	*/
+	void compute_neighborhoods_radius(const double & radius,PointNeighborhoods & neighborhoods) const;
+
+	/**
+	Computes the neighborhoods of all the points of $this made of their N closest points, in a single parallel pass.
+	The queries are run in the leaf order of the KD Tree, so that consecutive queries visit the same nodes.
+	Points that are not in the KD Tree (invalid descriptors) get empty neighborhoods
+	@param N number of points in each neighborhood
+	@param neighborhoods neighborhoods of all the points of $this, sorted by increasing distance.
+	Each neighborhood includes the point itself
+	*/
+	void compute_neighborhoods_N(const unsigned int & N,PointNeighborhoods & neighborhoods) const;
+
 
 	/**
-	Adds an element to the point cloud
+	Adds an element to the point cloud. The point is only searched by the queries
+	once inserted in the KD Tree by update_kdtree or build_kdtree
 	*/
 	void push_back(const PointType & point);
 
@@ -105,10 +218,104 @@ public:
 	*/
 	void build_kdtree(bool verbose);
 
+	/**
+	Checks whether the KD Tree has been built, so that the closest point queries can be run
+	@return true if the KD Tree has been built
+	*/
+	bool has_kdtree() const;
+
+	/**
+	Inserts the points added to the point cloud since the KD Tree was last built or updated.
+	Costs time proportional to the number of new points (amortized), so should be preferred to build_kdtree
+	when a point cloud grows by successive batches. Builds the KD Tree if missing
+	*/
+	void update_kdtree();
+
+	/**
+	Builds a sparse voxel grid over the points of the KD Tree. Until removed, the grid answers
+	the radius queries in place of the KD Tree, which is faster for repeated queries of a fixed radius.
+	The grid follows the KD Tree through transform, build_kdtree and update_kdtree.
+	Only defined for PointCloud<PointNormal>
+	@param cell_size voxel size, best set to the radius of the queries. A non-positive value
+	removes the grid, so that the KD Tree answers the radius queries again
+	*/
+	void build_voxel_grid(const double & cell_size);
+
+	/**
+	Downsamples the point cloud on a grid of cubic voxels, keeping one point per occupied voxel.
+	Only defined for PointCloud<PointNormal>
+	@param cell_size voxel size. Must be positive
+	@param downsampled_pc point cloud receiving the kept points, replacing its content.
+	Their global indices are their indices in downsampled_pc
+	@param use_centroids if true, the points of each voxel are replaced by their centroid and their normalized mean normal.
+	Otherwise, the point of each voxel closest to their centroid is kept as is
+	*/
+	void downsample_voxel_grid(const double & cell_size,PointCloud<PointType> & downsampled_pc,bool use_centroids = true) const;
+
+	/**
+	Downsamples the point cloud on a grid of cubic voxels whose size is searched so as to keep about N_points points.
+	Only defined for PointCloud<PointNormal>
+	@param N_points number of points to keep, positive. All the points are kept if the point cloud holds no more,
+	and a single one if they all coincide
+	@param downsampled_pc point cloud receiving the kept points, replacing its content
+	@param use_centroids see downsample_voxel_grid
+	@return voxel size used, 0 if all the points or a single coincident point were kept
+	*/
+	double downsample_voxel_grid_to_count(unsigned int N_points,PointCloud<PointType> & downsampled_pc,bool use_centroids = true) const;
+
+	/**
+	Downsamples the point cloud with a Poisson-disk sampling: points are kept in random order
+	as long as they are at least spacing away from all the points kept so far, until all the remaining points are
+	closer than spacing to a kept point. Runs in parallel over a grid of voxels of diagonal spacing,
+	processing at the same time voxels too far apart to hold conflicting points.
+	The random order only depends on the seed of Philox. Only defined for PointCloud<PointNormal>
+	@param spacing minimum distance between kept points. Must be positive
+	@param downsampled_pc point cloud receiving the kept points, replacing its content.
+	Their global indices are their indices in downsampled_pc
+	*/
+	void downsample_poisson_disk(const double & spacing,PointCloud<PointType> & downsampled_pc) const;
+
+	/**
+	Downsamples the point cloud with a Poisson-disk sampling whose spacing is searched so as to keep about N_points points.
+	Only defined for PointCloud<PointNormal>
+	@param N_points number of points to keep, positive. All the points are kept if the point cloud holds no more,
+	and a single one if they all coincide
+	@param downsampled_pc point cloud receiving the kept points, replacing its content
+	@return spacing used, 0 if all the points or a single coincident point were kept
+	*/
+	double downsample_poisson_disk_to_count(unsigned int N_points,PointCloud<PointType> & downsampled_pc) const;
+
+	/**
+	Checks whether the point cloud is organized, i.e. was built from the focal plane of a lidar and
+	remembers the pixel each of its points was measured by
+	@return true if the point cloud is organized
+	*/
+	bool is_organized() const;
+
+	/**
+	Returns the number of pixel rows of an organized point cloud (see Ray)
+	@return number of rows, 0 if the point cloud is not organized
+	*/
+	unsigned int get_organized_rows() const;
+
+	/**
+	Returns the number of pixel columns of an organized point cloud (see Ray)
+	@return number of columns, 0 if the point cloud is not organized
+	*/
+	unsigned int get_organized_cols() const;
+
+	/**
+	Returns the point measured by a pixel of an organized point cloud
+	@param row_index row index of the pixel
+	@param col_index column index of the pixel
+	@return index of the point, -1 if the pixel measured no point
+	*/
+	int get_organized_index(unsigned int row_index,unsigned int col_index) const;
+
 	/**
 	Subscript operator accessing the underlying point vector
 	*/
-	PointType & operator[] (const int index);
+	typename PointStorage<PointType>::reference operator[] (const int index);
 
 	/**
 	Checks if indexed point has been deemed value. 
@@ -121,15 +328,51 @@ public:
 	/**
 	Empties the point cloud and kd tree
 	*/
-	void clear(){this -> points.clear(); this -> kdt = nullptr;}
+	void clear(){this -> points.clear(); this -> kdt = nullptr; this -> voxel_grid = nullptr; this -> kdt_end = 0; this -> pending_transform = 0;
+		this -> organized_indices.clear(); this -> organized_rows = 0; this -> organized_cols = 0;}
 
 
 protected:
 
-	std::vector<PointType> points;
-	std::shared_ptr< KDTree< PointCloud, PointType> > kdt;
+	// Maps a query point from the frame of the points to the frame the KD Tree was built in.
+	// Returns test_point itself if the two frames coincide, buffer otherwise
+	const arma::vec & to_kdtree_frame(const arma::vec & test_point,arma::vec::fixed<3> & buffer) const;
+
+	// Gathers the indices and coordinates of the points in the KD Tree, in leaf order
+	void get_kdtree_queries(std::vector<int> & query_order,std::vector<const double *> & query_points) const;
+
+	// Rewrites the points with the pending transform. Only defined for PointCloud<PointNormal>
+	void transform_points() const;
+
+	// The points are mutable since applying the pending transform does not change
+	// the state of $this as seen from outside
+	mutable typename PointStorage<PointType>::type points;
+	std::shared_ptr< DynamicKDTree< PointCloud, PointType> > kdt;
+
+	// Optional index answering the radius queries, in the frame of the KD Tree
+	std::shared_ptr< VoxelHashGrid > voxel_grid;
 	arma::vec mean_feature_histogram;
 
+	// Number of leading points of $this already considered for insertion in the KD Tree
+	unsigned int kdt_end = 0;
+
+	// Rigid transform yet to be applied to the points.
+	// pending_transform is an int so as to be read/written atomically
+	mutable arma::mat::fixed<3,3> pending_dcm = arma::eye<arma::mat>(3,3);
+	mutable arma::vec::fixed<3> pending_x = arma::zeros<arma::vec>(3);
+	mutable int pending_transform = 0;
+
+	// Point measured by each pixel of the focal plane the point cloud was built from (-1 if none),
+	// stored column after column. Empty if the point cloud is not organized
+	std::vector<int> organized_indices;
+	unsigned int organized_rows = 0;
+	unsigned int organized_cols = 0;
+
+	// Rigid transform from the frame the KD Tree was built in to the frame of the points
+	arma::mat::fixed<3,3> kdt_dcm = arma::eye<arma::mat>(3,3);
+	arma::vec::fixed<3> kdt_x = arma::zeros<arma::vec>(3);
+	bool kdt_transformed = false;
+
 
 };
 
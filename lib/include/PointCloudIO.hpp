@@ -4,6 +4,7 @@
 #include <PointCloud.hpp>
 #include <PointNormal.hpp>
 #include <PointDescriptor.hpp>
+#include <MappedPointCloud.hpp>
 
 
 template <class T> 
@@ -21,6 +22,36 @@ public:
 		const arma::mat::fixed<3,3> & dcm = arma::eye<arma::mat>(3,3), 
 		const arma::vec::fixed<3> & x = arma::zeros<arma::vec>(3));
 
+	/**
+	Saves the point cloud in the binary format read by MappedPointCloud, overwriting the file
+	@param pc point cloud
+	@param savepath path to the file
+	@param dcm rotation applied to the points and normals before saving
+	@param x translation applied to the points before saving
+	@param single_precision if true, the coordinates and descriptors are stored as float32
+	@param pc_features if provided, descriptors of the points, saved along them. Must have as many points as pc
+	*/
+	static void save_to_binary(const PointCloud<T> & pc, std::string savepath,
+		const arma::mat::fixed<3,3> & dcm = arma::eye<arma::mat>(3,3), 
+		const arma::vec::fixed<3> & x = arma::zeros<arma::vec>(3),
+		bool single_precision = false,
+		const PointCloud<PointDescriptor> * pc_features = nullptr);
+
+	/**
+	Appends the point cloud to a file in the binary format read by MappedPointCloud, as a new block.
+	Creates the file in double precision if it does not exist
+	@param pc point cloud
+	@param savepath path to the file
+	@param dcm rotation applied to the points and normals before saving
+	@param x translation applied to the points before saving
+	@param pc_features descriptors of the points, saved along them. Must be provided
+	if and only if the file holds descriptors
+	*/
+	static void append_to_binary(const PointCloud<T> & pc, std::string savepath,
+		const arma::mat::fixed<3,3> & dcm = arma::eye<arma::mat>(3,3), 
+		const arma::vec::fixed<3> & x = arma::zeros<arma::vec>(3),
+		const PointCloud<PointDescriptor> * pc_features = nullptr);
+
 	static void save_active_features_positions(
 		const PointCloud<PointNormal> & pc_points,
 		const PointCloud<PointDescriptor> & pc_features, 
@@ -28,7 +28,25 @@ public:
 	static void compute_darboux_frames_local_hist( int & alpha_bin_index,int & phi_bin_index,int & theta_bin_index, const int & N_bins,
 		const arma::vec::fixed<3> & p_i,const arma::vec::fixed<3> & n_i,const arma::vec::fixed<3> & p_j,const arma::vec::fixed<3> & n_j);
 
+	/**
+	Bins the Darboux frame angles of a point paired with each point of a contiguous block of neighbors.
+	The kernel is free of branches and runs as a SIMD loop over the pairs
+	@param N_pairs number of neighbors in the block
+	@param p_i coordinates of the query point (3 coefficients)
+	@param n_i normal of the query point (3 coefficients)
+	@param p_j coordinates of the neighbors, stored point after point (3 * N_pairs coefficients)
+	@param n_j normals of the neighbors, stored point after point (3 * N_pairs coefficients)
+	@param N_bins number of bins per angle
+	@param alpha_bin_indices alpha bin of each pair, in [0,N_bins - 1]
+	@param phi_bin_indices phi bin of each pair, in [0,N_bins - 1]
+	@param theta_bin_indices theta bin of each pair, in [0,N_bins - 1]
+	*/
+	static void compute_darboux_bins(unsigned int N_pairs,
+		const double * p_i,const double * n_i,const double * p_j,const double * n_j,int N_bins,
+		int * alpha_bin_indices,int * phi_bin_indices,int * theta_bin_indices);
+
 	int get_type() const;
+	void set_type(int type);
 	enum Type{PFHDescriptor,FPFHDescriptor};
 
 	int get_global_index() const;
@@ -43,8 +61,8 @@ protected:
 	
 	arma::vec histogram;
 
-	int type;
-	int global_index;
+	int type = 0;
+	int global_index = 0;
 	bool is_valid_feature = true;
 
 
@@ -0,0 +1,90 @@
+#ifndef HEADER_POINT_NEIGHBORHOODS
+#define HEADER_POINT_NEIGHBORHOODS
+
+#include <vector>
+
+template <class PointType> class PointCloud;
+
+/**
+Neighborhoods of all the points of a point cloud, stored as a compressed sparse row adjacency.
+The neighbors of point i are the get_N_neighbors(i) consecutive entries starting at get_neighbors(i).
+Neighborhoods are computed in a single pass by PointCloud::compute_neighborhoods_radius
+or PointCloud::compute_neighborhoods_N, and can then be shared by all the consumers of the same
+neighborhoods (normal estimation, descriptors, coverage...). Computing neighborhoods again into the same instance
+reuses its memory
+*/
+class PointNeighborhoods {
+
+	template <class PointType> friend class PointCloud;
+
+public:
+
+	/**
+	Returns the number of points whose neighborhoods are stored
+	@return number of points
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the number of neighbors of the queried point
+	@param i point index
+	@return number of neighbors, including the point itself
+	*/
+	unsigned int get_N_neighbors(unsigned int i) const;
+
+	/**
+	Returns a pointer to the indices of the neighbors of the queried point.
+	kNN neighborhoods are sorted by increasing distance, radius neighborhoods are not sorted
+	@param i point index
+	@return pointer to the first of get_N_neighbors(i) indices
+	*/
+	const int * get_neighbors(unsigned int i) const;
+
+	/**
+	Returns a pointer to the squared distances between the queried point and its neighbors
+	(the descriptor distances for neighborhoods computed over PointCloud<PointDescriptor>)
+	@param i point index
+	@return pointer to the first of get_N_neighbors(i) squared distances
+	*/
+	const double * get_squared_distances(unsigned int i) const;
+
+	/**
+	Returns the total number of neighbors stored
+	@return sum of the neighborhood sizes
+	*/
+	unsigned int get_N_edges() const;
+
+	/**
+	Extracts the neighbors of each point that lie strictly within a smaller radius,
+	so that the neighborhoods of several scales can be derived from a single search at the largest one.
+	The relative order of the kept neighbors is preserved
+	@param radius radius of the extracted neighborhoods, no larger than the radius these neighborhoods were computed with
+	@param restricted_neighborhoods extracted neighborhoods. Must be a different instance than $this
+	*/
+	void restrict_to_radius(double radius,PointNeighborhoods & restricted_neighborhoods) const;
+
+	/**
+	Extracts the N closest neighbors of each point, so that kNN neighborhoods can be derived from
+	radius neighborhoods without searching again. Points with fewer than N neighbors keep all of them,
+	so the result only matches compute_neighborhoods_N where the radius neighborhoods hold at least N points
+	@param N maximum number of neighbors in each extracted neighborhood
+	@param restricted_neighborhoods extracted neighborhoods, sorted by increasing distance. Must be a different instance than $this
+	*/
+	void restrict_to_N(unsigned int N,PointNeighborhoods & restricted_neighborhoods) const;
+
+	/**
+	Empties the neighborhoods, keeping the allocated memory
+	*/
+	void clear();
+
+protected:
+
+	// Neighborhood i spans [offsets[i],offsets[i + 1]) in indices and squared_distances
+	std::vector<unsigned int> offsets = {0};
+	std::vector<int> indices;
+	std::vector<double> squared_distances;
+
+};
+
+
+#endif
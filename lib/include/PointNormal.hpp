@@ -7,76 +7,49 @@
 #include "PointDescriptor.hpp"
 #include "SPFH.hpp"
 
+/**
+Point of a point cloud, with its normal.
+Coordinates are stored in fixed-size arrays rather than in arma::vec members, so that a point holds
+no heap memory and is cheap to pass by value. PointCloud<PointNormal> does not store PointNormal-s but
+the columns of a PointNormalColumns, which it reads and writes points from.
+Descriptors are stored separately, in PointCloud<PointDescriptor>
+*/
 class PointNormal {
 
 public:	
 
 	PointNormal();
-	PointNormal(arma::vec point,int index = 0);
-	PointNormal(arma::vec point, arma::vec normal,int index = 0);
+	PointNormal(const arma::vec & point,int index = 0);
+	PointNormal(const arma::vec & point,const arma::vec & normal,int index = 0);
 
 
 	double distance(const std::shared_ptr<PointNormal> & other_point) const;
 	double distance(PointNormal * other_point) const ;
 
-	const arma::vec & get_point_coordinates() const;
-	const arma::vec & get_normal_coordinates() const;
+	/**
+	Returns the coordinates of the point
+	@return coordinates of the point, by value
+	*/
+	arma::vec::fixed<3> get_point_coordinates() const;
 
-	void set_normal_coordinates(arma::vec normal) ;
-	void set_point_coordinates(arma::vec point) ;
-	void set_descriptor(const PointDescriptor & descriptor) ;
-	
-	PointDescriptor get_descriptor() const;
-	const PointDescriptor * get_descriptor_ptr() const;
+	/**
+	Returns the coordinates of the normal
+	@return coordinates of the normal, by value. Zero if the normal was not set
+	*/
+	arma::vec::fixed<3> get_normal_coordinates() const;
 
-	arma::vec get_descriptor_histogram() const;
-	arma::vec get_spfh_histogram() const;
-
-	unsigned int get_histogram_size() const;
-	double get_histogram_value(int index) const;
-
-	void decrement_inclusion_counter();
-
-	int get_inclusion_counter() const;
-
-	double features_similarity_distance(std::shared_ptr<PointNormal> other_point) const;
-	double features_similarity_distance(const arma::vec & histogram) const;
-
-
-	void set_SPFH(SPFH spfh);
-
-	SPFH * get_SPFH();
-
-
-	bool get_is_matched() const;
-	void set_is_matched(bool value);
-
-
-	int get_match() const;
-	void set_match(int match);
-
-	void set_neighborhood(const std::vector<std::shared_ptr<PointNormal> > & neighborhood);
-	void set_neighborhood(const std::vector<PointNormal * > & neighborhood);
+	void set_normal_coordinates(const arma::vec & normal) ;
+	void set_point_coordinates(const arma::vec & point) ;
 
 	int get_global_index() const;
 	void set_global_index (int global_index);
 
-	std::vector<int> get_neighborhood(double radius) const;
-
-
 
 protected:
 
-	arma::vec point;
-	arma::vec normal = {0,0,0};
-
-	int inclusion_counter = 0;
-	int match = -1;
-	PointDescriptor descriptor;
-	SPFH spfh;
-	int global_index;
-
-	std::map<double , int > neighborhood;
+	double point[3] = {0,0,0};
+	double normal[3] = {0,0,0};
+	int global_index = 0;
 
 };
 
@@ -0,0 +1,151 @@
+#ifndef HEADER_POINT_NORMAL_COLUMNS
+#define HEADER_POINT_NORMAL_COLUMNS
+
+#include <armadillo>
+#include <vector>
+
+class PointNormal;
+
+/**
+Storage of the points of a PointCloud<PointNormal>, as a structure of arrays. Each coordinate of the points
+and of their normals is stored in its own contiguous column, along with a column of global indices,
+so that the kernels running over all the points (rigid transforms, residuals, bounding boxes) read
+unit-stride arrays of doubles.
+
+The columns mimic the part of the std::vector interface PointCloud relies on: their elements are read as PointNormal values,
+and written through PointNormalColumns::Reference.
+Different points can be written to from concurrent threads, as long as the number of points does not change
+*/
+class PointNormalColumns {
+
+public:
+
+	/**
+	Reference to a point stored in the columns, with the interface of PointNormal
+	*/
+	class Reference {
+
+	public:
+
+		Reference(PointNormalColumns * columns,unsigned int index);
+
+		/**
+		Overwrites the referenced point
+		@param point point whose coordinates, normal and global index are copied
+		@return reference
+		*/
+		Reference & operator=(const PointNormal & point);
+
+		/**
+		Overwrites the referenced point with another stored point
+		@param other referenced point to copy
+		@return reference
+		*/
+		Reference & operator=(const Reference & other);
+
+		operator PointNormal() const;
+
+		arma::vec::fixed<3> get_point_coordinates() const;
+		arma::vec::fixed<3> get_normal_coordinates() const;
+
+		void set_point_coordinates(const arma::vec & point);
+		void set_normal_coordinates(const arma::vec & normal);
+
+		int get_global_index() const;
+		void set_global_index(int global_index);
+
+	protected:
+
+		PointNormalColumns * columns;
+		unsigned int index;
+
+	};
+
+	/**
+	Returns the number of points
+	@return number of points
+	*/
+	unsigned int size() const;
+
+	/**
+	Resizes the columns. New points are at the origin, with a zero normal and a zero global index
+	@param N new number of points
+	*/
+	void resize(unsigned int N);
+
+	/**
+	Reserves memory for the provided number of points
+	@param N number of points
+	*/
+	void reserve(unsigned int N);
+
+	/**
+	Removes all the points
+	*/
+	void clear();
+
+	/**
+	Appends a point
+	@param point appended point
+	*/
+	void push_back(const PointNormal & point);
+
+	PointNormal operator[](unsigned int i) const;
+	Reference operator[](unsigned int i);
+	Reference back();
+
+	arma::vec::fixed<3> get_point_coordinates(unsigned int i) const;
+	arma::vec::fixed<3> get_normal_coordinates(unsigned int i) const;
+
+	void set_point_coordinates(unsigned int i,const arma::vec & point);
+	void set_normal_coordinates(unsigned int i,const arma::vec & normal);
+
+	int get_global_index(unsigned int i) const;
+	void set_global_index(unsigned int i,int global_index);
+
+	/**
+	Returns one of the coordinate columns of the points
+	@param axis coordinate index (0, 1 or 2)
+	@return pointer to the size() values of this coordinate
+	*/
+	const double * get_point_column(unsigned int axis) const;
+
+	/**
+	Returns one of the coordinate columns of the normals
+	@param axis coordinate index (0, 1 or 2)
+	@return pointer to the size() values of this coordinate
+	*/
+	const double * get_normal_column(unsigned int axis) const;
+
+	/**
+	Applies a rigid transform to all the points and normals, in parallel over the points
+	@param dcm rotational component of the transform
+	@param x translational component of the transform, not applied to the normals
+	*/
+	void transform(const arma::mat::fixed<3,3> & dcm,const arma::vec::fixed<3> & x);
+
+	/**
+	Computes the corners of the bounding box of the points
+	@param bbox_min receives the smallest coordinates
+	@param bbox_max receives the largest coordinates
+	*/
+	void get_bounding_box(arma::vec::fixed<3> & bbox_min,arma::vec::fixed<3> & bbox_max) const;
+
+	/**
+	Returns the number of bytes used by the columns
+	@return number of bytes, capacity included
+	*/
+	std::size_t get_memory_size() const;
+
+protected:
+
+	// Coordinate columns of the points and of the normals
+	std::vector<double> point_columns[3];
+	std::vector<double> normal_columns[3];
+
+	std::vector<int> global_indices;
+
+};
+
+
+#endif
@@ -64,6 +64,16 @@ public:
 	*/
 	void reset(ShapeModel<ControlPoint> * shape_model) ;
 
+	/**
+	Sets the corresponding measurement ray
+	to a default state, given its origin and direction already
+	expressed in the frame of the target
+	@param origin_target_frame origin of the ray in the target frame
+	@param direction_target_frame direction of the ray in the target frame
+	*/
+	void reset(const arma::vec::fixed<3> & origin_target_frame,
+		const arma::vec::fixed<3> & direction_target_frame) ;
+
 
 	/**
 	Return pointer to the unit vector directing the ray,
@@ -141,6 +151,11 @@ public:
 	int get_guess() const;
 	int get_super_element() const;
 
+	/**
+	Sets the element this ray is expected to hit, used
+	by the coherent ray-tracing mode
+	@param guess guessed element (-1 if none)
+	*/
 	void set_guess (int guess);
 
 	arma::vec::fixed<3> get_KD_impact() const;
@@ -151,19 +166,37 @@ public:
 	*/
 	Lidar * get_lidar();
 
+	/**
+	Index of the row the pixel of this ray lies on
+	@return row index
+	*/
+	unsigned int get_row_index() const;
+
+	/**
+	Index of the column the pixel of this ray lies on
+	@return column index
+	*/
+	unsigned int get_col_index() const;
+
 	/**		
 	Get this ray's incidence angle at impact
 	@return incidence angle
 	*/
 	double get_incidence_angle() const;
 
+	/**
+	Set this ray's incidence angle at impact
+	@param incidence_angle incidence angle (degrees)
+	*/
+	void set_incidence_angle(double incidence_angle);
+
 	void set_impact_coords(const double & u,const double & v);
 
 	void get_impact_coords(double & u_t, double & v_t);
 
 protected:
 
-	Lidar * lidar;
+	Lidar * lidar = nullptr;
 
 	arma::vec::fixed<3> origin;
 	arma::vec::fixed<3> direction;
@@ -171,12 +204,12 @@ protected:
 	arma::vec::fixed<3> origin_target_frame;
 	arma::vec::fixed<3> direction_target_frame;
 
-	unsigned int row_index;
-	unsigned int col_index;
+	unsigned int row_index = 0;
+	unsigned int col_index = 0;
 
 	int hit_element = -1;
 	int super_element = -1;
-	int guess;
+	int guess = -1;
 
 	double incidence_angle;
 	double u;
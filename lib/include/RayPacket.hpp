@@ -0,0 +1,153 @@
+#ifndef HEADER_RAYPACKET
+#define HEADER_RAYPACKET
+
+#include <armadillo>
+
+// Maximum number of rays traced together
+#define RAY_PACKET_SIZE 8
+
+class Ray;
+
+/**
+Declaration of the RayPacket class. Stores a small group of coherent rays
+(typically a tile of the lidar focal plane) in structure-of-arrays form so that
+bounding boxes and triangles can be tested against all of them at once.
+Lanes are processed four (AVX), two (SSE2) or one (scalar fallback) at a time,
+the kernel being selected at runtime depending on what the CPU supports.
+*/
+class RayPacket {
+
+public:
+
+	/**
+	Kernels available to test the packet against bounding boxes and triangles
+	*/
+	enum Kernel {SCALAR,SSE2,AVX};
+
+	/**
+	Constructor. Uses the best kernel supported by the CPU
+	*/
+	RayPacket();
+
+	/**
+	Constructor
+	@param kernel kernel to use. Falls back on the best supported kernel
+	if the CPU does not support the requested one
+	*/
+	RayPacket(Kernel kernel);
+
+	/**
+	Removes all rays from the packet
+	*/
+	void clear();
+
+	/**
+	Adds a ray to the packet. The ray's origin and direction in the target
+	frame and its current range are loaded
+	@param ray pointer to ray. Must have been reset beforehand
+	*/
+	void add_ray(Ray * ray);
+
+	/**
+	Returns the number of rays in the packet
+	@return number of rays
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns a pointer to the i-th ray of the packet
+	@param i ray index
+	@return pointer to ray
+	*/
+	Ray * get_ray(unsigned int i) const;
+
+	/**
+	Returns the range of the closest hit found so far along the i-th ray
+	@param i ray index
+	@return closest hit range (infinity if no hit was found)
+	*/
+	double get_range(unsigned int i) const;
+
+	/**
+	Returns the element hit by the i-th ray
+	@param i ray index
+	@return hit element (-1 if no hit was found)
+	*/
+	int get_hit_element(unsigned int i) const;
+
+	/**
+	Returns the sign of the direction component of the first ray along the given axis
+	@param axis axis index
+	@return true if the component is negative
+	*/
+	bool is_direction_negative(unsigned int axis) const;
+
+	/**
+	Tests the packet against an axis-aligned bounding box
+	@param bbox_min lower corner of the box
+	@param bbox_max upper corner of the box
+	@return bit mask of the rays hitting the box before their current closest hit
+	*/
+	unsigned int hit_bbox(const double * bbox_min, const double * bbox_max) const;
+
+	/**
+	Tests the packet against a triangle with the Moller-Trumbore algorithm.
+	Closer hits are recorded in the packet
+	@param P0 first vertex of the triangle
+	@param E1 first edge of the triangle (P1 - P0)
+	@param E2 second edge of the triangle (P2 - P0)
+	@param element index of the triangle
+	@param outside if true, only hits on the outward face of the triangle are accepted
+	@param mask bit mask of the rays to test
+	*/
+	void hit_triangle(const double * P0, const double * E1, const double * E2,
+		int element, bool outside, unsigned int mask);
+
+	/**
+	Returns the kernel used by this packet
+	@return kernel
+	*/
+	Kernel get_kernel() const;
+
+	/**
+	Returns the most efficient kernel supported by the CPU
+	@return kernel
+	*/
+	static Kernel get_best_kernel();
+
+	/**
+	Checks whether the provided kernel can run on this CPU
+	@param kernel kernel to check
+	@return true if supported
+	*/
+	static bool is_supported(Kernel kernel);
+
+protected:
+
+	// Lanes are padded to a multiple of the widest kernel
+	alignas(32) double origin[3][RAY_PACKET_SIZE];
+	alignas(32) double direction[3][RAY_PACKET_SIZE];
+	alignas(32) double inv_direction[3][RAY_PACKET_SIZE];
+	alignas(32) double range[RAY_PACKET_SIZE];
+
+	int hit_elements[RAY_PACKET_SIZE];
+	Ray * rays[RAY_PACKET_SIZE];
+
+	unsigned int N_rays = 0;
+	Kernel kernel;
+
+	unsigned int hit_bbox_scalar(const double * bbox_min, const double * bbox_max) const;
+	unsigned int hit_bbox_sse2(const double * bbox_min, const double * bbox_max) const;
+	unsigned int hit_bbox_avx(const double * bbox_min, const double * bbox_max) const;
+
+	void hit_triangle_scalar(const double * P0, const double * E1, const double * E2,
+		int element, bool outside, unsigned int mask);
+	void hit_triangle_sse2(const double * P0, const double * E1, const double * E2,
+		int element, bool outside, unsigned int mask);
+	void hit_triangle_avx(const double * P0, const double * E1, const double * E2,
+		int element, bool outside, unsigned int mask);
+
+};
+
+
+#endif
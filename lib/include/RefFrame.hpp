@@ -77,6 +77,13 @@ public:
 	*/
 	arma::vec * get_origin_from_parent();
 
+	/**
+	Returns the revision of the transform relating $this to its parent.
+	The revision is incremented every time the mrp or the origin is set
+	@return revision counter
+	*/
+	unsigned int get_revision() const;
+
 
 protected:
 
@@ -86,6 +93,8 @@ protected:
 	std::shared_ptr<arma::vec> origin_from_parent;
 	std::shared_ptr<arma::mat> dcm_from_parent;
 
+	unsigned int revision = 0;
+
 
 
 };
@@ -3,6 +3,7 @@
 
 #include "PointDescriptor.hpp"
 #include "PointCloud.hpp"
+#include "PointNeighborhoods.hpp"
 
 class SPFH : public PointDescriptor{
 
@@ -12,8 +13,15 @@ public:
 	SPFH();
 
 
+	/**
+	Constructor
+	@param query_point index of the point whose histogram is computed
+	@param neighborhoods neighborhoods of all the points of pc
+	@param N_bins number of bins per angle
+	@param pc point cloud
+	*/
 	SPFH(const int & query_point,
-		const std::vector<int > & points,int N_bins,
+		const PointNeighborhoods & neighborhoods,int N_bins,
 		const PointCloud<PointNormal> & pc);
 
 
@@ -0,0 +1,77 @@
+#ifndef HEADER_SHADOWCACHE
+#define HEADER_SHADOWCACHE
+
+#include <map>
+#include <array>
+#include <armadillo>
+
+// Number of entries past which the cache is flushed
+#define SHADOW_CACHE_MAX_SIZE 1000000
+
+class ControlPoint;
+template <class PointType> class ShapeModel;
+
+
+/**
+Declaration of the ShadowCache class. Memoizes the occlusion of the sun as seen from a point
+in the vicinity of a shape model. Queries are keyed on the position of the point and on the
+direction to the sun, both expressed in the body frame and quantized at the prescribed resolutions.
+The occlusion of a key is found by casting an any-hit ray from the center of its cell,
+so the answer to a query does not depend on the order of the queries. 
+The cache must be cleared whenever the shape model is modified
+*/
+class ShadowCache {
+
+public:
+
+	/**
+	Constructor
+	@param shape_model pointer to the occluding shape model
+	@param position_resolution size of the position cells (m)
+	@param direction_resolution size of the sun direction cells, applied to each component of the unit vector
+	*/
+	ShadowCache(ShapeModel<ControlPoint> * shape_model,
+		double position_resolution,
+		double direction_resolution);
+
+	/**
+	Determines whether the sun is occluded by the shape model
+	@param position_body_frame position of the observer in the body frame
+	@param sun_direction_body_frame unit vector directed from the observer to the sun, in the body frame
+	@return true if the observer is in the shadow of the shape model
+	*/
+	bool is_in_shadow(const arma::vec::fixed<3> & position_body_frame,
+		const arma::vec::fixed<3> & sun_direction_body_frame);
+
+	/**
+	Removes all the cached entries
+	*/
+	void clear();
+
+	/**
+	Returns the number of cached entries
+	@return number of entries
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the fraction of queries that were answered from the cache since the last clear
+	@return cache hit rate, between 0 and 1
+	*/
+	double get_hit_rate() const;
+
+protected:
+
+	ShapeModel<ControlPoint> * shape_model;
+
+	double position_resolution;
+	double direction_resolution;
+
+	std::map<std::array<int,6>,bool> entries;
+
+	unsigned int N_queries = 0;
+	unsigned int N_cache_hits = 0;
+
+};
+
+#endif
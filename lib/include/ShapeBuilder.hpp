@@ -379,6 +379,10 @@ protected:
 	int destination_pc_index = -1;
 	int source_pc_index = -1;
 
+	// Number of source point clouds archived in registered_pcs.bin during this run.
+	// The first one recreates the archive, so that it never holds the blocks of a previous run
+	int N_archived_pcs = 0;
+
 
 	std::vector< std::shared_ptr<PointNormal> > concatenated_pc_vector;
 	std::vector< PointCloud < PointNormal > > all_registered_pc;
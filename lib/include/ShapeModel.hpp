@@ -15,8 +15,9 @@
 
 
 class Ray ;
+class RayPacket;
 class Element;
-class KDTreeShape;
+class BVHShape;
 template <template<class> class ContainerType, class PointType>  class KDTree ;
 
 /**
@@ -67,10 +68,10 @@ public:
 
 	
 	/**
-	Returns pointer to KDTreeShape member.
-	@return pointer to KDTreeShape
+	Returns pointer to the bounding volume hierarchy used for ray-tracing.
+	@return pointer to BVHShape
 	*/
-	std::shared_ptr<KDTreeShape> get_KDTreeShape() const ;
+	std::shared_ptr<BVHShape> get_BVHShape() const ;
 
 
 	/**
@@ -202,6 +203,34 @@ public:
 	*/
 	virtual bool ray_trace(Ray * ray,bool outside = true) = 0;
 
+	/**
+	Finds the intersects between the rays of a coherent packet and the shape model.
+	Shapes without a packet-tracing path trace each ray of the packet individually
+	@param packet ray packet. The internal state of each ray that hits the shape is updated
+	@param outside if true, will only accept the rays if they are cast from the outside of the shape
+	*/
+	virtual void ray_trace_packet(RayPacket & packet,bool outside = true);
+
+	/**
+	Finds the intersect between the provided ray and the shape model, first testing
+	the element stored as the ray's guess (see Ray::set_guess) and its neighbors.
+	Shapes without a coherent path perform a regular ray-trace
+	@param ray pointer to ray. If a hit is found, the ray's internal is changed to store the range to the hit point
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@param fast_path set to true if the hit was found among the guessed elements
+	@return true if the ray hit the shape
+	*/
+	virtual bool ray_trace_coherent(Ray * ray,bool outside,bool & fast_path);
+
+	/**
+	Determines whether the provided ray hits the shape model at all, as needed by
+	occlusion queries. Shapes without an any-hit path perform a regular ray-trace
+	@param ray pointer to ray. Its internal state is not guaranteed to reflect the closest hit
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@return true if the ray hit the shape
+	*/
+	virtual bool ray_trace_any(Ray * ray,bool outside = true);
+
 
 
 	/**
@@ -314,7 +343,7 @@ protected:
 	std::vector<std::set<int> > edges;
 	std::vector<PointType> control_points;
 	std::shared_ptr<KDTree<ShapeModel,PointType> > kdt_control_points = nullptr;
-	std::shared_ptr<KDTreeShape> kdt_facet = nullptr;
+	std::shared_ptr<BVHShape> bvh_facet = nullptr;
 
 	std::map<std::shared_ptr<PointType> ,unsigned int> pointer_to_global_index;
 
@@ -119,6 +119,15 @@ public:
 	*/
 	virtual bool ray_trace(Ray * ray,bool outside = true);
 
+	/**
+	Determines whether the provided ray hits any patch of the shape model.
+	The search stops at the first hit found
+	@param ray pointer to ray. Its internal state is left untouched
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@return true if the ray hit the shape
+	*/
+	virtual bool ray_trace_any(Ray * ray,bool outside = true);
+
 	void save_both(std::string partial_path);
 
 
@@ -412,7 +421,6 @@ protected:
 	std::vector<std::map<  std::array<int, 8>,arma::mat::fixed<12,3> > > elements_to_cm_mapping_matrices;
 	std::vector<std::map<  std::array<int, 10>,arma::mat::fixed<6,15> > > elements_to_inertia_mapping_matrices;
 
-	std::shared_ptr<ShapeModelTri<ControlPoint>> enclosing_polyhedron;
 
 
 
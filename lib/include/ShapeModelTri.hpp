@@ -43,9 +43,7 @@ public:
 		const std::vector<PointType> & control_points);
 
 	/**
-	Constructs the KDTree holding the shape model for ray-casting purposes
-	@param verbose true will save the bounding boxes to a file and display
-	kd tree construction details
+	Constructs the bounding volume hierarchy holding the shape model for ray-casting purposes
 	*/
 	virtual void construct_kd_tree_shape();
 
@@ -146,6 +144,33 @@ public:
 	*/
 	virtual bool ray_trace(Ray * ray,bool outside = true);
 
+	/**
+	Finds the intersects between the rays of a coherent packet and the shape model
+	with SIMD kernels
+	@param packet ray packet. The internal state of each ray that hits the shape is updated
+	@param outside if true, will only accept the rays if they are cast from the outside of the shape
+	*/
+	virtual void ray_trace_packet(RayPacket & packet,bool outside = true);
+
+	/**
+	Finds the intersect between the provided ray and the shape model, first testing
+	the facet stored as the ray's guess and its neighbors
+	@param ray pointer to ray. If a hit is found, the ray's internal is changed to store the range to the hit point
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@param fast_path set to true if the hit was found among the guessed facets
+	@return true if the ray hit the shape
+	*/
+	virtual bool ray_trace_coherent(Ray * ray,bool outside,bool & fast_path);
+
+	/**
+	Determines whether the provided ray hits any facet of the shape model.
+	The search stops at the first hit found
+	@param ray pointer to ray. Its internal state is left untouched
+	@param outside if true, will only accept the ray if it is cast from the outside of the shape
+	@return true if the ray hit the shape
+	*/
+	virtual bool ray_trace_any(Ray * ray,bool outside = true);
+
 
 	virtual const std::vector<int> & get_element_control_points(int e) const;
 	virtual arma::vec::fixed<3> get_point_normal_coordinates(unsigned int i) const;
@@ -0,0 +1,66 @@
+#ifndef HEADER_SYMMETRIC_EIGEN_SOLVER
+#define HEADER_SYMMETRIC_EIGEN_SOLVER
+
+#include <armadillo>
+
+// Number of matrices whose eigenvalues are estimated together by the batched solver
+#define SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE 64
+
+/**
+Closed-form eigen decomposition of 3x3 symmetric matrices, avoiding the per-call overhead of LAPACK
+on such small problems. The eigenvalues are first estimated as the roots of the characteristic polynomial,
+with the trigonometric solution of the cubic. The eigenvector of the eigenvalue furthest from the other two is
+found as the largest cross-product of two rows of the shifted matrix, the second one by diagonalizing
+the matrix in the plane orthogonal to it with a rotation, and the third one completes the basis.
+The eigenvalues are then recomputed from the eigenvectors, which keeps them accurate to the machine precision
+even when two of them are close.
+The matrices are passed by their 6 upper-triangular coefficients, in the order (xx,xy,xz,yy,yz,zz)
+
+The estimation of the eigenvalues is free of branches, so the batched version runs it as a SIMD loop
+over blocks of matrices before resolving their eigenvectors one by one
+*/
+class SymmetricEigenSolver {
+
+public:
+
+	/**
+	Computes the eigenvalues and eigenvectors of a symmetric matrix
+	@param matrix the 6 upper-triangular coefficients of the matrix
+	@param eigenvalues the 3 eigenvalues, in ascending order
+	@param eigenvectors the 3 unit eigenvectors stored column-wise in the order of the eigenvalues,
+	forming a right-handed basis (9 coefficients, column-major as in Armadillo)
+	*/
+	static void compute(const double * matrix,double * eigenvalues,double * eigenvectors);
+
+	/**
+	Computes the eigenvalues and eigenvectors of an array of symmetric matrices.
+	Runs on the calling thread, so that it can be called on chunks of a larger array from a parallel loop
+	@param N number of matrices
+	@param matrices the 6 upper-triangular coefficients of each matrix, stored matrix after matrix (6 * N coefficients)
+	@param eigenvalues the 3 eigenvalues of each matrix in ascending order, stored matrix after matrix (3 * N coefficients)
+	@param eigenvectors the 9 coefficients of the eigenvectors of each matrix, laid out as in the
+	single-matrix version and stored matrix after matrix (9 * N coefficients)
+	*/
+	static void compute(unsigned int N,const double * matrices,double * eigenvalues,double * eigenvectors);
+
+	/**
+	Computes the eigenvalues and eigenvectors of a symmetric matrix
+	@param matrix symmetric matrix. Only its upper triangular part is read
+	@param eigenvalues eigenvalues, in ascending order
+	@param eigenvectors unit eigenvectors stored column-wise in the order of the eigenvalues
+	*/
+	static void compute(const arma::mat::fixed<3,3> & matrix,
+		arma::vec::fixed<3> & eigenvalues,
+		arma::mat::fixed<3,3> & eigenvectors);
+
+	/**
+	Computes the eigenvalues of a symmetric matrix
+	@param matrix symmetric matrix. Only its upper triangular part is read
+	@return eigenvalues, in ascending order
+	*/
+	static arma::vec::fixed<3> compute_eigenvalues(const arma::mat::fixed<3,3> & matrix);
+
+};
+
+
+#endif
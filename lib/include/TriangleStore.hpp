@@ -0,0 +1,202 @@
+#ifndef HEADER_TRIANGLESTORE
+#define HEADER_TRIANGLESTORE
+
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <armadillo>
+
+// Tolerance on the barycentric coordinates of an intersect. Slightly
+// enlarging the triangles guarantees that rays hitting a shared edge
+// are never rejected by both neighbors
+#define TRIANGLE_STORE_EDGE_TOL 1e-10
+
+// Alignment of the triangle arrays (bytes)
+#define TRIANGLE_STORE_ALIGNMENT 64
+
+class ControlPoint;
+template <class PointType> class ShapeModelTri;
+
+
+/**
+Minimal allocator returning cache-line aligned memory,
+used to store the triangle arrays
+*/
+template <class T>
+struct CacheAlignedAllocator {
+
+	typedef T value_type;
+
+	CacheAlignedAllocator() {}
+	template <class U> CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+	T * allocate(std::size_t n){
+		void * ptr = nullptr;
+		if (posix_memalign(&ptr,TRIANGLE_STORE_ALIGNMENT,n * sizeof(T)) != 0){
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(ptr);
+	}
+
+	void deallocate(T * ptr, std::size_t){
+		std::free(ptr);
+	}
+
+	template <class U> bool operator==(const CacheAlignedAllocator<U> &) const {return true;}
+	template <class U> bool operator!=(const CacheAlignedAllocator<U> &) const {return false;}
+
+};
+
+
+/**
+Declaration of the TriangleStore class. Packs the geometry needed to ray-trace a set of
+triangular facets (first vertex, edges and unit normal) in structure-of-arrays form.
+Triangles are stored in the order they are provided with, which for a BVHShape is the
+order of its permuted element index buffer so that the triangles of a leaf are contiguous
+*/
+class TriangleStore {
+
+public:
+
+	/**
+	Constructor
+	*/
+	TriangleStore();
+
+	/**
+	Packs the prescribed facets of a shape model
+	@param shape pointer to the shape owning the facets
+	@param elements facets to store, in storage order
+	*/
+	void build(ShapeModelTri<ControlPoint> * shape, const std::vector<int> & elements);
+
+	/**
+	Returns the number of stored triangles
+	@return number of triangles
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the index of the facet stored at the provided slot
+	@param slot storage slot
+	@return facet global index
+	*/
+	int get_element(unsigned int slot) const;
+
+	/**
+	Returns the storage slot of the provided facet
+	@param element facet global index
+	@return storage slot, or -1 if the facet is not stored
+	*/
+	int get_slot(int element) const;
+
+	/**
+	Returns the slots of the stored triangles sharing at least one vertex with
+	the triangle at the provided slot (the triangle itself excluded)
+	@param slot storage slot
+	@param N_neighbors number of neighbors
+	@return pointer to the first neighbor slot
+	*/
+	const int * get_neighbor_slots(unsigned int slot, unsigned int & N_neighbors) const;
+
+	/**
+	Returns the first vertex, first edge and second edge of a stored triangle
+	@param slot storage slot
+	@param P0 first vertex
+	@param E1 first edge
+	@param E2 second edge
+	*/
+	void get_triangle(unsigned int slot, double * P0, double * E1, double * E2) const;
+
+	/**
+	Returns the incidence angle of a ray hitting a stored triangle
+	@param slot storage slot
+	@param direction unit direction of the ray
+	@return incidence angle (degrees)
+	*/
+	double get_incidence_angle(unsigned int slot, const double * direction) const;
+
+	/**
+	Intersects a ray with a stored triangle (Moller-Trumbore)
+	@param slot storage slot
+	@param origin ray origin
+	@param direction ray direction
+	@param outside if true, only hits on the outward face of the triangle are accepted
+	@param t range to the intersect, if any
+	@return true if the ray hits the triangle with a positive range
+	*/
+	inline bool intersect(unsigned int slot,
+		const double * origin,
+		const double * direction,
+		bool outside,
+		double & t) const {
+
+		const double e1x = this -> E1[0][slot];
+		const double e1y = this -> E1[1][slot];
+		const double e1z = this -> E1[2][slot];
+
+		const double e2x = this -> E2[0][slot];
+		const double e2y = this -> E2[1][slot];
+		const double e2z = this -> E2[2][slot];
+
+		// P = d x E2
+		const double px = direction[1] * e2z - direction[2] * e2y;
+		const double py = direction[2] * e2x - direction[0] * e2z;
+		const double pz = direction[0] * e2y - direction[1] * e2x;
+
+		// det > 0 if the ray travels against the triangle normal
+		const double det = e1x * px + e1y * py + e1z * pz;
+
+		if (outside ? !(det > 0) : det == 0){
+			return false;
+		}
+
+		const double inv_det = 1. / det;
+
+		const double sx = origin[0] - this -> P0[0][slot];
+		const double sy = origin[1] - this -> P0[1][slot];
+		const double sz = origin[2] - this -> P0[2][slot];
+
+		const double u = (sx * px + sy * py + sz * pz) * inv_det;
+
+		if (u < - TRIANGLE_STORE_EDGE_TOL || u > 1 + TRIANGLE_STORE_EDGE_TOL){
+			return false;
+		}
+
+		// Q = S x E1
+		const double qx = sy * e1z - sz * e1y;
+		const double qy = sz * e1x - sx * e1z;
+		const double qz = sx * e1y - sy * e1x;
+
+		const double v = (direction[0] * qx + direction[1] * qy + direction[2] * qz) * inv_det;
+
+		if (v < - TRIANGLE_STORE_EDGE_TOL || u + v > 1 + TRIANGLE_STORE_EDGE_TOL){
+			return false;
+		}
+
+		t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+		return t > 0;
+
+	}
+
+protected:
+
+	typedef std::vector<double,CacheAlignedAllocator<double> > AlignedArray;
+
+	AlignedArray P0[3];
+	AlignedArray E1[3];
+	AlignedArray E2[3];
+	AlignedArray N[3];
+
+	std::vector<int> elements;
+	std::vector<int> slots;
+
+	// Vertex-sharing neighbors of each slot, in compressed row form
+	std::vector<int> neighbor_offsets;
+	std::vector<int> neighbor_slots;
+
+};
+
+
+#endif
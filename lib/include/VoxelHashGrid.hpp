@@ -0,0 +1,121 @@
+#ifndef HEADER_VOXEL_HASH_GRID
+#define HEADER_VOXEL_HASH_GRID
+
+#include <vector>
+#include <cstdint>
+#include <armadillo>
+
+/**
+Sparse grid of cubic voxels over 3D points, only storing the occupied voxels.
+The voxels are grouped in columns along the last axis, and only the occupied columns are stored,
+in an open-addressing hash table. The points are sorted by column then by voxel, so that the points
+of consecutive voxels of a column are contiguous.
+A radius query scans the voxels overlapping the cube circumscribing the search sphere. When the radius
+does not exceed the voxel size, these are at most 8 of the 27 voxels surrounding the voxel of the test point,
+found with at most 4 lookups in the hash table.
+For fixed-radius searches, the voxel size should therefore be set to the search radius.
+Memory is O(N) in the number of points
+*/
+class VoxelHashGrid {
+
+public:
+
+	/**
+	Builds the grid
+	@param indices indices of the points in their owner
+	@param coordinates coordinates of the points, stored point after point in the order of indices
+	@param cell_size edge length of the voxels. Must be positive
+	*/
+	void build(const std::vector< int > & indices,const std::vector< double > & coordinates,double cell_size);
+
+	/**
+	Finds all the points in the grid strictly closer to the test point than the provided distance
+	@param test_point query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	*/
+	void radius_point_search(const arma::vec & test_point,
+		const double & distance,
+		std::vector< int > & closest_points) const;
+
+	/**
+	Finds all the points in the grid strictly closer to the test point than the provided distance
+	@param test_point pointer to the coordinates of the query point
+	@param distance search radius
+	@param closest_points indices of the points found, appended to
+	@param closest_distances squared distances to the points found, appended to
+	*/
+	void radius_point_search(const double * test_point,
+		const double & distance,
+		std::vector< int > & closest_points,
+		std::vector< double > & closest_distances) const;
+
+	/**
+	Returns the number of points in the grid
+	@return number of points
+	*/
+	unsigned int size() const;
+
+	/**
+	Returns the number of occupied voxels
+	@return number of occupied voxels
+	*/
+	unsigned int get_N_cells() const;
+
+	/**
+	Returns the edge length of the voxels
+	@return voxel size
+	*/
+	double get_cell_size() const;
+
+protected:
+
+	struct Column {
+		std::uint64_t key;
+
+		// Range of the column's voxels in the voxel buffer
+		int begin = 0;
+		int end = 0;
+	};
+
+	struct Cell {
+		// Integer coordinate of the voxel along the last axis
+		std::int64_t k = 0;
+
+		// Range of the voxel's points in the reordered buffers
+		int begin = 0;
+		int end = 0;
+	};
+
+	// Packs the integer coordinates of a column into its key
+	static std::uint64_t get_key(std::int64_t i,std::int64_t j);
+
+	// Returns the slot of the hash table where the search for a key starts
+	std::uint64_t get_slot(std::uint64_t key) const;
+
+	// Returns the occupied column of provided key, nullptr if the column is empty
+	const Column * find_column(std::uint64_t key) const;
+
+	void radius_point_search(const double * test_point,
+		const double & distance,
+		std::vector< int > & closest_points,
+		std::vector< double > * closest_distances) const;
+
+	// Hash table of the occupied columns, of size a power of two
+	std::vector<Column> table;
+
+	// Occupied voxels, sorted by column then along the last axis
+	std::vector<Cell> cells;
+
+	// Coordinates of the points, reordered by voxel and stored point after point
+	std::vector<double> coordinates;
+
+	// Index in the owner of each point in the reordered buffer
+	std::vector<int> indices;
+
+	double cell_size = 0;
+
+};
+
+
+#endif
@@ -0,0 +1,807 @@
+#include "BVHShape.hpp"
+#include "ShapeModelBezier.hpp"
+#include "ShapeModelTri.hpp"
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+
+#include <algorithm>
+
+#include "DebugFlags.hpp"
+#define BVH_SHAPE_BUILD_DEBUG 0
+
+// Traversal stack size. The build forces a leaf past this depth
+#define BVH_SHAPE_MAX_DEPTH 100
+#define BVH_SHAPE_STACK_SIZE (BVH_SHAPE_MAX_DEPTH + 2)
+
+// Distance a vertex may lie in front of the plane of a triangle on the convex hull,
+// relative to the diagonal of the bounding box of the shape
+#define BVH_SHAPE_SUPPORT_TOL 1e-9
+
+
+BVHShape::BVHShape(ShapeModelTri<ControlPoint> * owning_shape) {
+	this -> owning_shape = owning_shape;
+	this -> owning_shape_tri = owning_shape;
+}
+
+BVHShape::BVHShape(ShapeModelBezier<ControlPoint> * owning_shape) {
+	this -> owning_shape = owning_shape;
+	this -> owning_shape_bezier = owning_shape;
+}
+
+void BVHShape::set_max_leaf_size(unsigned int max_leaf_size){
+	this -> max_leaf_size = std::max(max_leaf_size,(unsigned int)(1));
+}
+
+unsigned int BVHShape::get_NNodes() const{
+	return this -> nodes.size();
+}
+
+int BVHShape::get_depth() const{
+	return this -> depth;
+}
+
+const std::vector<BVHShape::Node> & BVHShape::get_nodes() const{
+	return this -> nodes;
+}
+
+const std::vector<int> & BVHShape::get_element_indices() const{
+	return this -> element_indices;
+}
+
+const TriangleStore & BVHShape::get_triangles() const{
+	return this -> triangles;
+}
+
+void BVHShape::build(const std::vector<int> & elements) {
+
+	this -> element_indices = elements;
+	this -> nodes.clear();
+	this -> supporting_triangles.clear();
+	this -> depth = 0;
+
+	if (elements.size() == 0){
+		return;
+	}
+
+	// The bounds and centroids of each element are computed once
+	// and indexed by the global index of the element
+	unsigned int N_elements = this -> owning_shape -> get_NElements();
+
+	this -> element_bbox_min.resize(3 * N_elements);
+	this -> element_bbox_max.resize(3 * N_elements);
+	this -> element_centroids.resize(3 * N_elements);
+
+	for (unsigned int i = 0; i < elements.size(); ++i){
+
+		int e = elements[i];
+		const std::vector<int> & control_points = this -> owning_shape -> get_element_control_points(e);
+
+		for (unsigned int k = 0; k < 3; ++k){
+			this -> element_bbox_min[3 * e + k] = std::numeric_limits<double>::infinity();
+			this -> element_bbox_max[3 * e + k] = - std::numeric_limits<double>::infinity();
+		}
+
+		for (unsigned int v = 0; v < control_points.size(); ++v){
+			const arma::vec::fixed<3> & coords = this -> owning_shape -> get_point_coordinates(control_points[v]);
+			for (unsigned int k = 0; k < 3; ++k){
+				this -> element_bbox_min[3 * e + k] = std::min(this -> element_bbox_min[3 * e + k],coords(k));
+				this -> element_bbox_max[3 * e + k] = std::max(this -> element_bbox_max[3 * e + k],coords(k));
+			}
+		}
+
+		for (unsigned int k = 0; k < 3; ++k){
+			this -> element_centroids[3 * e + k] = 0.5 * (this -> element_bbox_min[3 * e + k] + this -> element_bbox_max[3 * e + k]);
+		}
+
+	}
+
+	// A binary tree over N leaves has at most 2N - 1 nodes. Reserving
+	// them upfront guarantees that the node array is never reallocated
+	this -> nodes.reserve(2 * elements.size());
+	this -> build_node(0,elements.size(),0);
+
+	// The elements are packed in leaf order so that
+	// the elements of a leaf are contiguous in memory
+	if (this -> owning_shape_bezier != nullptr){
+		this -> patches.build(this -> owning_shape_bezier,this -> element_indices);
+	}
+	else{
+		this -> triangles.build(this -> owning_shape_tri,this -> element_indices);
+		this -> compute_supporting_triangles();
+	}
+
+	#if BVH_SHAPE_BUILD_DEBUG
+	std::cout << "BVH built over " << elements.size() << " elements\n";
+	std::cout << "Number of nodes: " << this -> nodes.size() << std::endl;
+	std::cout << "Depth: " << this -> depth << std::endl;
+	#endif
+
+	// The per-element build data is no longer needed
+	this -> element_bbox_min.clear();
+	this -> element_bbox_max.clear();
+	this -> element_centroids.clear();
+	this -> element_bbox_min.shrink_to_fit();
+	this -> element_bbox_max.shrink_to_fit();
+	this -> element_centroids.shrink_to_fit();
+
+}
+
+
+int BVHShape::build_node(int start, int end, int depth){
+
+	int node_index = this -> nodes.size();
+	this -> nodes.push_back(Node());
+	this -> depth = std::max(this -> depth,depth);
+
+	double bbox_min[3] = {std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity()};
+	double bbox_max[3] = {- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity()};
+	double centroid_min[3] = {std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity()};
+	double centroid_max[3] = {- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity()};
+
+	for (int i = start; i < end; ++i){
+		int e = this -> element_indices[i];
+		for (unsigned int k = 0; k < 3; ++k){
+			bbox_min[k] = std::min(bbox_min[k],this -> element_bbox_min[3 * e + k]);
+			bbox_max[k] = std::max(bbox_max[k],this -> element_bbox_max[3 * e + k]);
+			centroid_min[k] = std::min(centroid_min[k],this -> element_centroids[3 * e + k]);
+			centroid_max[k] = std::max(centroid_max[k],this -> element_centroids[3 * e + k]);
+		}
+	}
+
+	for (unsigned int k = 0; k < 3; ++k){
+		this -> nodes[node_index].bbox_min[k] = bbox_min[k];
+		this -> nodes[node_index].bbox_max[k] = bbox_max[k];
+	}
+
+	int count = end - start;
+
+	// Node becomes a leaf by default
+	this -> nodes[node_index].offset = start;
+	this -> nodes[node_index].count = count;
+	this -> nodes[node_index].axis = 0;
+
+	if (count == 1 || depth >= BVH_SHAPE_MAX_DEPTH){
+		return node_index;
+	}
+
+	// Binned SAH. The cost of a split is evaluated as
+	// traversal_cost + (A_L * N_L + A_R * N_R) / A
+	// while the cost of keeping the node as a leaf is N
+	auto surface_area = [](const double * b_min, const double * b_max){
+		double dx = b_max[0] - b_min[0];
+		double dy = b_max[1] - b_min[1];
+		double dz = b_max[2] - b_min[2];
+		return 2 * (dx * dy + dy * dz + dz * dx);
+	};
+
+	double node_area = surface_area(bbox_min,bbox_max);
+
+	double best_cost = std::numeric_limits<double>::infinity();
+	int best_axis = -1;
+	int best_bin = -1;
+
+	std::vector<int> bin_counts(this -> n_bins);
+	std::vector<double> bin_min(3 * this -> n_bins);
+	std::vector<double> bin_max(3 * this -> n_bins);
+	std::vector<double> right_area(this -> n_bins);
+	std::vector<int> right_count(this -> n_bins);
+
+	for (int axis = 0; axis < 3; ++axis){
+
+		double extent = centroid_max[axis] - centroid_min[axis];
+
+		if (extent <= 0){
+			continue;
+		}
+
+		std::fill(bin_counts.begin(),bin_counts.end(),0);
+		std::fill(bin_min.begin(),bin_min.end(),std::numeric_limits<double>::infinity());
+		std::fill(bin_max.begin(),bin_max.end(),- std::numeric_limits<double>::infinity());
+
+		for (int i = start; i < end; ++i){
+			int e = this -> element_indices[i];
+			int b = std::min(int(this -> n_bins * (this -> element_centroids[3 * e + axis] - centroid_min[axis]) / extent),int(this -> n_bins) - 1);
+			++bin_counts[b];
+			for (unsigned int k = 0; k < 3; ++k){
+				bin_min[3 * b + k] = std::min(bin_min[3 * b + k],this -> element_bbox_min[3 * e + k]);
+				bin_max[3 * b + k] = std::max(bin_max[3 * b + k],this -> element_bbox_max[3 * e + k]);
+			}
+		}
+
+		// Right-to-left sweep. right_area[b] and right_count[b] describe the
+		// union of bins b,b+1,...,n_bins - 1
+		double acc_min[3] = {std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity(),std::numeric_limits<double>::infinity()};
+		double acc_max[3] = {- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity(),- std::numeric_limits<double>::infinity()};
+		int acc_count = 0;
+
+		for (int b = this -> n_bins - 1; b > 0; --b){
+			if (bin_counts[b] > 0){
+				for (unsigned int k = 0; k < 3; ++k){
+					acc_min[k] = std::min(acc_min[k],bin_min[3 * b + k]);
+					acc_max[k] = std::max(acc_max[k],bin_max[3 * b + k]);
+				}
+			}
+			acc_count += bin_counts[b];
+			right_count[b] = acc_count;
+			right_area[b] = acc_count > 0 ? surface_area(acc_min,acc_max) : 0;
+		}
+
+		// Left-to-right sweep, evaluating the split between bins b - 1 and b
+		for (unsigned int k = 0; k < 3; ++k){
+			acc_min[k] = std::numeric_limits<double>::infinity();
+			acc_max[k] = - std::numeric_limits<double>::infinity();
+		}
+		acc_count = 0;
+
+		for (int b = 1; b < int(this -> n_bins); ++b){
+			if (bin_counts[b - 1] > 0){
+				for (unsigned int k = 0; k < 3; ++k){
+					acc_min[k] = std::min(acc_min[k],bin_min[3 * (b - 1) + k]);
+					acc_max[k] = std::max(acc_max[k],bin_max[3 * (b - 1) + k]);
+				}
+			}
+			acc_count += bin_counts[b - 1];
+
+			if (acc_count == 0 || right_count[b] == 0){
+				continue;
+			}
+
+			double cost = this -> traversal_cost + (surface_area(acc_min,acc_max) * acc_count + right_area[b] * right_count[b]) / node_area;
+
+			if (cost < best_cost){
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = b;
+			}
+		}
+
+	}
+
+	// All centroids coincide: there is no meaningful split
+	if (best_axis < 0){
+		return node_index;
+	}
+
+	// Small nodes are only split if the SAH deems it cheaper than intersecting every element
+	if (count <= int(this -> max_leaf_size) && best_cost >= count){
+		return node_index;
+	}
+
+	double extent = centroid_max[best_axis] - centroid_min[best_axis];
+	double c_min = centroid_min[best_axis];
+	int n_bins = this -> n_bins;
+	const std::vector<double> & centroids = this -> element_centroids;
+
+	auto mid_it = std::partition(this -> element_indices.begin() + start,
+		this -> element_indices.begin() + end,
+		[&](int e){
+			int b = std::min(int(n_bins * (centroids[3 * e + best_axis] - c_min) / extent),n_bins - 1);
+			return b < best_bin;
+		});
+
+	int mid = int(mid_it - this -> element_indices.begin());
+
+	// Safeguard against degenerate partitions caused by round-off
+	if (mid == start || mid == end){
+		mid = (start + end) / 2;
+		std::nth_element(this -> element_indices.begin() + start,
+			this -> element_indices.begin() + mid,
+			this -> element_indices.begin() + end,
+			[&](int a, int b){
+				return centroids[3 * a + best_axis] < centroids[3 * b + best_axis];
+			});
+	}
+
+	#if BVH_SHAPE_BUILD_DEBUG
+	std::cout << "Splitting node " << node_index << " at depth " << depth << " along axis " << best_axis;
+	std::cout << " : " << mid - start << " | " << end - mid << " elements, SAH cost " << best_cost << std::endl;
+	#endif
+
+	// The left child is stored right after its parent
+	this -> build_node(start,mid,depth + 1);
+	int right_child = this -> build_node(mid,end,depth + 1);
+
+	this -> nodes[node_index].offset = right_child;
+	this -> nodes[node_index].count = 0;
+	this -> nodes[node_index].axis = best_axis;
+
+	return node_index;
+
+}
+
+
+bool BVHShape::hit(Ray * ray, bool outside) const {
+
+	if (this -> nodes.size() == 0){
+		return false;
+	}
+
+	if (this -> owning_shape_bezier != nullptr){
+		return this -> hit_patches(ray,outside);
+	}
+
+	return this -> hit_triangles(ray,outside,ray -> get_true_range(),-1);
+
+}
+
+
+bool BVHShape::hit_patches(Ray * ray, bool outside) const {
+
+	const arma::vec::fixed<3> & origin = ray -> get_origin_target_frame();
+	const arma::vec::fixed<3> & dir = ray -> get_direction_target_frame();
+
+	const double * origin_ptr = origin.memptr();
+	const double * dir_ptr = dir.memptr();
+
+	double inv_dir[3] = {1. / dir(0),1. / dir(1),1. / dir(2)};
+
+	int stack[BVH_SHAPE_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	double closest_range = ray -> get_true_range();
+	int closest_slot = -1;
+	double closest_u = 0;
+	double closest_v = 0;
+	double t_entry;
+	double t,u,v;
+
+	while (stack_size > 0){
+
+		int node_index = stack[--stack_size];
+		const Node & node = this -> nodes[node_index];
+
+		if (!this -> hit_node_bbox(node,origin,inv_dir,closest_range,t_entry)){
+			continue;
+		}
+
+		if (node.is_leaf()){
+			for (int i = node.offset; i < node.offset + node.count; ++i){
+
+				// The Newton search is only run if the ray crosses the bounds of the patch
+				if (!this -> patches.hit_bbox(i,origin_ptr,inv_dir,closest_range)){
+					continue;
+				}
+
+				if (this -> patches.intersect(i,origin_ptr,dir_ptr,outside,closest_range,t,u,v)){
+					closest_range = t;
+					closest_slot = i;
+					closest_u = u;
+					closest_v = v;
+				}
+			}
+			continue;
+		}
+
+		int near_child = node_index + 1;
+		int far_child = node.offset;
+
+		if (dir(node.axis) < 0){
+			std::swap(near_child,far_child);
+		}
+
+		stack[stack_size++] = far_child;
+		stack[stack_size++] = near_child;
+
+	}
+
+	if (closest_slot < 0){
+		return false;
+	}
+
+	ray -> set_true_range(closest_range);
+	ray -> set_hit_element(this -> patches.get_element(closest_slot));
+	ray -> set_impact_coords(closest_u,closest_v);
+	ray -> set_incidence_angle(this -> patches.get_incidence_angle(closest_slot,closest_u,closest_v,dir_ptr));
+
+	return true;
+
+}
+
+
+bool BVHShape::hit_any(Ray * ray, bool outside) const {
+
+	if (this -> nodes.size() == 0){
+		return false;
+	}
+
+	const arma::vec::fixed<3> & origin = ray -> get_origin_target_frame();
+	const arma::vec::fixed<3> & dir = ray -> get_direction_target_frame();
+
+	const double * origin_ptr = origin.memptr();
+	const double * dir_ptr = dir.memptr();
+
+	double inv_dir[3] = {1. / dir(0),1. / dir(1),1. / dir(2)};
+
+	double max_range = ray -> get_true_range();
+
+	int stack[BVH_SHAPE_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	double t_entry;
+	double t,u,v;
+
+	while (stack_size > 0){
+
+		int node_index = stack[--stack_size];
+		const Node & node = this -> nodes[node_index];
+
+		if (!this -> hit_node_bbox(node,origin,inv_dir,max_range,t_entry)){
+			continue;
+		}
+
+		if (node.is_leaf()){
+			for (int i = node.offset; i < node.offset + node.count; ++i){
+
+				if (this -> owning_shape_bezier != nullptr){
+					if (this -> patches.hit_bbox(i,origin_ptr,inv_dir,max_range)
+						&& this -> patches.intersect(i,origin_ptr,dir_ptr,outside,max_range,t,u,v)){
+						return true;
+					}
+				}
+				else if (this -> triangles.intersect(i,origin_ptr,dir_ptr,outside,t) && t < max_range){
+					return true;
+				}
+
+			}
+			continue;
+		}
+
+		// The order of the children does not matter since the
+		// traversal ends at the first hit
+		stack[stack_size++] = node.offset;
+		stack[stack_size++] = node_index + 1;
+
+	}
+
+	return false;
+
+}
+
+
+bool BVHShape::hit_coherent(Ray * ray,
+	int guess,
+	bool outside,
+	bool & fast_path) const {
+
+	fast_path = false;
+
+	if (this -> nodes.size() == 0){
+		return false;
+	}
+
+	if (this -> owning_shape_bezier != nullptr){
+		return this -> hit_patches(ray,outside);
+	}
+
+	int guess_slot = this -> triangles.get_slot(guess);
+
+	if (guess_slot < 0){
+		return this -> hit_triangles(ray,outside,ray -> get_true_range(),-1);
+	}
+
+	const double * origin_ptr = ray -> get_origin_target_frame().memptr();
+	const double * dir_ptr = ray -> get_direction_target_frame().memptr();
+
+	double closest_range = ray -> get_true_range();
+	int closest_slot = -1;
+	double t;
+
+	if (this -> triangles.intersect(guess_slot,origin_ptr,dir_ptr,outside,t) && t < closest_range){
+		closest_range = t;
+		closest_slot = guess_slot;
+	}
+
+	unsigned int N_neighbors;
+	const int * neighbor_slots = this -> triangles.get_neighbor_slots(guess_slot,N_neighbors);
+
+	for (unsigned int i = 0; i < N_neighbors; ++i){
+		if (this -> triangles.intersect(neighbor_slots[i],origin_ptr,dir_ptr,outside,t) && t < closest_range){
+			closest_range = t;
+			closest_slot = neighbor_slots[i];
+		}
+	}
+
+	// A candidate on the convex hull hit from the front of its plane is the closest hit,
+	// as the whole shape lies behind that plane
+	if (closest_slot >= 0 && this -> supporting_triangles[closest_slot]){
+
+		double P0[3],E1[3],E2[3],normal[3];
+		this -> triangles.get_triangle(closest_slot,P0,E1,E2);
+		normal[0] = E1[1] * E2[2] - E1[2] * E2[1];
+		normal[1] = E1[2] * E2[0] - E1[0] * E2[2];
+		normal[2] = E1[0] * E2[1] - E1[1] * E2[0];
+
+		if (normal[0] * (origin_ptr[0] - P0[0]) + normal[1] * (origin_ptr[1] - P0[1]) + normal[2] * (origin_ptr[2] - P0[2]) > 0){
+			ray -> set_true_range(closest_range);
+			ray -> set_hit_element(this -> triangles.get_element(closest_slot));
+			ray -> set_incidence_angle(this -> triangles.get_incidence_angle(closest_slot,dir_ptr));
+			fast_path = true;
+			return true;
+		}
+	}
+
+	// Otherwise, the hierarchy is still searched for occluders lying in front of
+	// the candidate, but every node beyond it is pruned
+	bool hit = this -> hit_triangles(ray,outside,closest_range,closest_slot);
+
+	fast_path = closest_slot >= 0 && this -> triangles.get_slot(ray -> get_hit_element()) == closest_slot;
+
+	return hit;
+
+}
+
+
+void BVHShape::compute_supporting_triangles(){
+
+	const Node & root = this -> nodes[0];
+	double diagonal = std::sqrt(std::pow(root.bbox_max[0] - root.bbox_min[0],2)
+		+ std::pow(root.bbox_max[1] - root.bbox_min[1],2)
+		+ std::pow(root.bbox_max[2] - root.bbox_min[2],2));
+
+	int N_triangles = static_cast<int>(this -> triangles.size());
+	this -> supporting_triangles.resize(N_triangles);
+
+	#pragma omp parallel for schedule(dynamic,64)
+	for (int slot = 0; slot < N_triangles; ++slot){
+		this -> supporting_triangles[slot] = this -> is_supporting_triangle(slot,BVH_SHAPE_SUPPORT_TOL * diagonal);
+	}
+
+}
+
+
+bool BVHShape::is_supporting_triangle(int slot,double tolerance) const {
+
+	double P0[3],E1[3],E2[3],normal[3];
+	this -> triangles.get_triangle(slot,P0,E1,E2);
+
+	normal[0] = E1[1] * E2[2] - E1[2] * E2[1];
+	normal[1] = E1[2] * E2[0] - E1[0] * E2[2];
+	normal[2] = E1[0] * E2[1] - E1[1] * E2[0];
+
+	double norm = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	if (norm == 0){
+		return false;
+	}
+	for (unsigned int k = 0; k < 3; ++k){
+		normal[k] /= norm;
+	}
+
+	double offset = normal[0] * P0[0] + normal[1] * P0[1] + normal[2] * P0[2] + tolerance;
+
+	// A vertex lying in front of the plane, if any, belongs to one of the triangles at the rim of the concavity
+	// the triangle lies in, so the neighbors are tested first
+	auto in_front = [&](int other_slot){
+		double Q0[3],F1[3],F2[3];
+		this -> triangles.get_triangle(other_slot,Q0,F1,F2);
+		double height = normal[0] * Q0[0] + normal[1] * Q0[1] + normal[2] * Q0[2];
+		double height_1 = normal[0] * F1[0] + normal[1] * F1[1] + normal[2] * F1[2];
+		double height_2 = normal[0] * F2[0] + normal[1] * F2[1] + normal[2] * F2[2];
+		return height > offset || height + height_1 > offset || height + height_2 > offset;
+	};
+
+	unsigned int N_neighbors;
+	const int * neighbor_slots = this -> triangles.get_neighbor_slots(slot,N_neighbors);
+	for (unsigned int i = 0; i < N_neighbors; ++i){
+		if (in_front(neighbor_slots[i])){
+			return false;
+		}
+	}
+
+	int stack[BVH_SHAPE_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0){
+
+		int node_index = stack[--stack_size];
+		const Node & node = this -> nodes[node_index];
+
+		// Nodes lying entirely behind the plane are skipped
+		double furthest = 0;
+		for (unsigned int k = 0; k < 3; ++k){
+			furthest += normal[k] * (normal[k] > 0 ? node.bbox_max[k] : node.bbox_min[k]);
+		}
+		if (furthest <= offset){
+			continue;
+		}
+
+		if (node.is_leaf()){
+			for (int i = node.offset; i < node.offset + node.count; ++i){
+				if (in_front(i)){
+					return false;
+				}
+			}
+			continue;
+		}
+
+		stack[stack_size++] = node.offset;
+		stack[stack_size++] = node_index + 1;
+
+	}
+
+	return true;
+
+}
+
+
+bool BVHShape::hit_triangles(Ray * ray, bool outside, double closest_range, int closest_slot) const {
+
+	const arma::vec::fixed<3> & origin = ray -> get_origin_target_frame();
+	const arma::vec::fixed<3> & dir = ray -> get_direction_target_frame();
+
+	const double * origin_ptr = origin.memptr();
+	const double * dir_ptr = dir.memptr();
+
+	double inv_dir[3] = {1. / dir(0),1. / dir(1),1. / dir(2)};
+
+	int stack[BVH_SHAPE_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	// The closest hit is tracked locally and only
+	// written to the ray once the traversal is over
+	double t_entry;
+	double t;
+
+	while (stack_size > 0){
+
+		int node_index = stack[--stack_size];
+		const Node & node = this -> nodes[node_index];
+
+		if (!this -> hit_node_bbox(node,origin,inv_dir,closest_range,t_entry)){
+			continue;
+		}
+
+		if (node.is_leaf()){
+			for (int i = node.offset; i < node.offset + node.count; ++i){
+				if (this -> triangles.intersect(i,origin_ptr,dir_ptr,outside,t) && t < closest_range){
+					closest_range = t;
+					closest_slot = i;
+				}
+			}
+			continue;
+		}
+
+		int near_child = node_index + 1;
+		int far_child = node.offset;
+
+		if (dir(node.axis) < 0){
+			std::swap(near_child,far_child);
+		}
+
+		stack[stack_size++] = far_child;
+		stack[stack_size++] = near_child;
+
+	}
+
+	if (closest_slot < 0){
+		return false;
+	}
+
+	ray -> set_true_range(closest_range);
+	ray -> set_hit_element(this -> triangles.get_element(closest_slot));
+	ray -> set_incidence_angle(this -> triangles.get_incidence_angle(closest_slot,dir_ptr));
+
+	return true;
+
+}
+
+
+bool BVHShape::hit_packet(RayPacket & packet, bool outside) const {
+
+	if (this -> nodes.size() == 0 || packet.size() == 0){
+		return false;
+	}
+
+	if (this -> owning_shape_bezier != nullptr){
+		bool hit = false;
+		for (unsigned int i = 0; i < packet.size(); ++i){
+			if (this -> hit_patches(packet.get_ray(i),outside)){
+				hit = true;
+			}
+		}
+		return hit;
+	}
+
+	int stack[BVH_SHAPE_STACK_SIZE];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	double P0[3];
+	double E1[3];
+	double E2[3];
+
+	while (stack_size > 0){
+
+		int node_index = stack[--stack_size];
+		const Node & node = this -> nodes[node_index];
+
+		unsigned int mask = packet.hit_bbox(node.bbox_min,node.bbox_max);
+
+		if (mask == 0){
+			continue;
+		}
+
+		if (node.is_leaf()){
+
+			for (int i = node.offset; i < node.offset + node.count; ++i){
+
+				this -> triangles.get_triangle(i,P0,E1,E2);
+				packet.hit_triangle(P0,E1,E2,i,outside,mask);
+			}
+			continue;
+		}
+
+		// Rays in a packet are nearly parallel, so the
+		// front-to-back order of the first ray is used for all of them
+		int near_child = node_index + 1;
+		int far_child = node.offset;
+
+		if (packet.is_direction_negative(node.axis)){
+			std::swap(near_child,far_child);
+		}
+
+		stack[stack_size++] = far_child;
+		stack[stack_size++] = near_child;
+
+	}
+
+	// The closest hits are transferred to the rays
+	bool hit = false;
+
+	for (unsigned int i = 0; i < packet.size(); ++i){
+
+		// The packet records the storage slots of the hit triangles
+		int slot = packet.get_hit_element(i);
+
+		if (slot < 0){
+			continue;
+		}
+
+		Ray * ray = packet.get_ray(i);
+
+		ray -> set_true_range(packet.get_range(i));
+		ray -> set_hit_element(this -> triangles.get_element(slot));
+		ray -> set_incidence_angle(this -> triangles.get_incidence_angle(slot,ray -> get_direction_target_frame().memptr()));
+
+		hit = true;
+	}
+
+	return hit;
+
+}
+
+
+bool BVHShape::hit_node_bbox(const Node & node,
+	const arma::vec::fixed<3> & origin,
+	const double * inv_dir,
+	double max_range,
+	double & t_entry) const {
+
+	double t_min = 0;
+	double t_max = max_range;
+
+	for (unsigned int k = 0; k < 3; ++k){
+
+		double t_0 = (node.bbox_min[k] - origin(k)) * inv_dir[k];
+		double t_1 = (node.bbox_max[k] - origin(k)) * inv_dir[k];
+
+		if (t_0 > t_1){
+			std::swap(t_0,t_1);
+		}
+
+		// Written so that NaNs (origin on a slab plane of a parallel ray) leave the bounds untouched
+		t_min = t_0 > t_min ? t_0 : t_min;
+		t_max = t_1 < t_max ? t_1 : t_max;
+
+		if (t_min > t_max){
+			return false;
+		}
+	}
+
+	t_entry = t_min;
+	return true;
+
+}
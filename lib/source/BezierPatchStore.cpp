@@ -0,0 +1,342 @@
+#include "BezierPatchStore.hpp"
+#include "ShapeModelBezier.hpp"
+#include "Bezier.hpp"
+
+
+BezierPatchStore::BezierPatchStore(){
+
+}
+
+void BezierPatchStore::build(ShapeModelBezier<ControlPoint> * shape, const std::vector<int> & elements){
+
+	unsigned int N_patches = elements.size();
+
+	this -> elements = elements;
+	this -> degrees.resize(N_patches);
+	this -> offsets.resize(N_patches);
+	this -> bbox_min.resize(3 * N_patches);
+	this -> bbox_max.resize(3 * N_patches);
+	this -> control_points.clear();
+
+	for (unsigned int slot = 0; slot < N_patches; ++slot){
+
+		const Bezier & patch = shape -> get_element(elements[slot]);
+		int n = patch.get_degree();
+
+		if (n < 1 || n > BEZIER_PATCH_STORE_MAX_DEGREE){
+			throw(std::runtime_error("BezierPatchStore: unsupported patch degree " + std::to_string(n)));
+		}
+
+		// The Bernstein tables are computed once per degree
+		if (int(this -> exponents.size()) <= n){
+			this -> exponents.resize(n + 1);
+			this -> coefficients.resize(n + 1);
+			this -> corners.resize(n + 1);
+		}
+
+		if (this -> exponents[n].size() == 0){
+
+			std::vector<std::tuple<int, int, int> > table = Bezier::forward_table(n);
+			this -> corners[n].resize(3);
+
+			for (unsigned int l = 0; l < table.size(); ++l){
+
+				int i = std::get<0>(table[l]);
+				int j = std::get<1>(table[l]);
+				int k = std::get<2>(table[l]);
+
+				this -> exponents[n].push_back(i);
+				this -> exponents[n].push_back(j);
+				this -> exponents[n].push_back(k);
+				this -> coefficients[n].push_back(double(Bezier::combinations(i,n) * Bezier::combinations(j,n - i)));
+
+				if (i == n){
+					this -> corners[n][0] = l;
+				}
+				else if (j == n){
+					this -> corners[n][1] = l;
+				}
+				else if (k == n){
+					this -> corners[n][2] = l;
+				}
+			}
+		}
+
+		this -> degrees[slot] = n;
+		this -> offsets[slot] = this -> control_points.size() / 3;
+
+		for (unsigned int k = 0; k < 3; ++k){
+			this -> bbox_min[3 * slot + k] = std::numeric_limits<double>::infinity();
+			this -> bbox_max[3 * slot + k] = - std::numeric_limits<double>::infinity();
+		}
+
+		const std::vector<int> & points = patch.get_points();
+
+		for (unsigned int l = 0; l < points.size(); ++l){
+			const arma::vec::fixed<3> & C = shape -> get_point_coordinates(points[l]);
+			for (unsigned int k = 0; k < 3; ++k){
+				this -> control_points.push_back(C(k));
+				this -> bbox_min[3 * slot + k] = std::min(this -> bbox_min[3 * slot + k],C(k));
+				this -> bbox_max[3 * slot + k] = std::max(this -> bbox_max[3 * slot + k],C(k));
+			}
+		}
+
+	}
+
+}
+
+unsigned int BezierPatchStore::size() const{
+	return this -> elements.size();
+}
+
+int BezierPatchStore::get_element(unsigned int slot) const{
+	return this -> elements[slot];
+}
+
+bool BezierPatchStore::hit_bbox(unsigned int slot, const double * origin, const double * inv_dir, double max_range) const{
+
+	double t_min = 0;
+	double t_max = max_range;
+
+	for (unsigned int k = 0; k < 3; ++k){
+
+		double t_0 = (this -> bbox_min[3 * slot + k] - origin[k]) * inv_dir[k];
+		double t_1 = (this -> bbox_max[3 * slot + k] - origin[k]) * inv_dir[k];
+
+		if (t_0 > t_1){
+			std::swap(t_0,t_1);
+		}
+
+		t_min = t_0 > t_min ? t_0 : t_min;
+		t_max = t_1 < t_max ? t_1 : t_max;
+
+		if (t_min > t_max){
+			return false;
+		}
+	}
+
+	return true;
+
+}
+
+void BezierPatchStore::evaluate(unsigned int slot, double u, double v, double * P, double * P_u, double * P_v) const{
+
+	int n = this -> degrees[slot];
+	double w = 1 - u - v;
+
+	// Powers of the barycentric coordinates are shared by all the Bernstein polynomials
+	double pu[BEZIER_PATCH_STORE_MAX_DEGREE + 1];
+	double pv[BEZIER_PATCH_STORE_MAX_DEGREE + 1];
+	double pw[BEZIER_PATCH_STORE_MAX_DEGREE + 1];
+
+	pu[0] = 1;
+	pv[0] = 1;
+	pw[0] = 1;
+
+	for (int p = 1; p <= n; ++p){
+		pu[p] = pu[p - 1] * u;
+		pv[p] = pv[p - 1] * v;
+		pw[p] = pw[p - 1] * w;
+	}
+
+	for (unsigned int k = 0; k < 3; ++k){
+		P[k] = 0;
+		P_u[k] = 0;
+		P_v[k] = 0;
+	}
+
+	const int * exponents = this -> exponents[n].data();
+	const double * coefficients = this -> coefficients[n].data();
+	const double * C = this -> control_points.data() + 3 * this -> offsets[slot];
+
+	unsigned int N_points = this -> coefficients[n].size();
+
+	for (unsigned int l = 0; l < N_points; ++l){
+
+		int i = exponents[3 * l];
+		int j = exponents[3 * l + 1];
+		int k = exponents[3 * l + 2];
+
+		double c = coefficients[l];
+		double uv = pu[i] * pv[j];
+
+		// B = c u^i v^j w^k, with dw/du = dw/dv = -1
+		double B = c * uv * pw[k];
+		double dB_dw = k > 0 ? c * k * uv * pw[k - 1] : 0;
+		double dB_du = (i > 0 ? c * i * pu[i - 1] * pv[j] * pw[k] : 0) - dB_dw;
+		double dB_dv = (j > 0 ? c * j * pu[i] * pv[j - 1] * pw[k] : 0) - dB_dw;
+
+		for (unsigned int m = 0; m < 3; ++m){
+			P[m] += B * C[3 * l + m];
+			P_u[m] += dB_du * C[3 * l + m];
+			P_v[m] += dB_dv * C[3 * l + m];
+		}
+
+	}
+
+}
+
+bool BezierPatchStore::intersect(unsigned int slot,
+	const double * origin,
+	const double * direction,
+	bool outside,
+	double max_range,
+	double & t,
+	double & u,
+	double & v) const{
+
+	// The first guess is the intersect between the ray and the
+	// plane of the patch corners, expressed in barycentric coordinates
+	int n = this -> degrees[slot];
+	const double * C = this -> control_points.data() + 3 * this -> offsets[slot];
+	const double * C_u = C + 3 * this -> corners[n][0];
+	const double * C_v = C + 3 * this -> corners[n][1];
+	const double * C_w = C + 3 * this -> corners[n][2];
+
+	arma::vec::fixed<3> S = {origin[0],origin[1],origin[2]};
+	arma::vec::fixed<3> d = {direction[0],direction[1],direction[2]};
+	arma::vec::fixed<3> P0 = {C_w[0],C_w[1],C_w[2]};
+	arma::vec::fixed<3> E1 = {C_u[0] - C_w[0],C_u[1] - C_w[1],C_u[2] - C_w[2]};
+	arma::vec::fixed<3> E2 = {C_v[0] - C_w[0],C_v[1] - C_w[1],C_v[2] - C_w[2]};
+
+	arma::vec::fixed<3> p = arma::cross(d,E2);
+	double det = arma::dot(E1,p);
+
+	u = 1./3;
+	v = 1./3;
+
+	if (std::abs(det) > 0){
+		arma::vec::fixed<3> s = S - P0;
+		arma::vec::fixed<3> q = arma::cross(s,E1);
+		double u_0 = arma::dot(s,p) / det;
+		double v_0 = arma::dot(d,q) / det;
+
+		// The guess is brought back inside the domain
+		u_0 = std::max(u_0,0.);
+		v_0 = std::max(v_0,0.);
+		if (u_0 + v_0 > 1){
+			double sum = u_0 + v_0;
+			u_0 /= sum;
+			v_0 /= sum;
+		}
+
+		if (std::isfinite(u_0) && std::isfinite(v_0)){
+			u = u_0;
+			v = v_0;
+		}
+	}
+
+	if (this -> newton_search(slot,origin,direction,outside,max_range,t,u,v)){
+		return true;
+	}
+
+	u = 1./3;
+	v = 1./3;
+
+	return this -> newton_search(slot,origin,direction,outside,max_range,t,u,v);
+
+}
+
+bool BezierPatchStore::newton_search(unsigned int slot,
+	const double * origin,
+	const double * direction,
+	bool outside,
+	double max_range,
+	double & t,
+	double & u,
+	double & v) const{
+
+	double P[3];
+	double P_u[3];
+	double P_v[3];
+
+	auto cross = [](const double * x, const double * y, double * z){
+		z[0] = x[1] * y[2] - x[2] * y[1];
+		z[1] = x[2] * y[0] - x[0] * y[2];
+		z[2] = x[0] * y[1] - x[1] * y[0];
+	};
+
+	auto dot = [](const double * x, const double * y){
+		return x[0] * y[0] + x[1] * y[1] + x[2] * y[2];
+	};
+
+	double a[3];
+	double b[3];
+	double y[3];
+	double r[3];
+
+	for (unsigned int iter = 0; iter < BEZIER_PATCH_STORE_MAX_ITER; ++iter){
+
+		this -> evaluate(slot,u,v,P,P_u,P_v);
+
+		// Residual: component of (S - P) orthogonal to the ray
+		for (unsigned int k = 0; k < 3; ++k){
+			r[k] = origin[k] - P[k];
+		}
+		cross(direction,r,y);
+
+		if (std::sqrt(dot(y,y)) < BEZIER_PATCH_STORE_TOL){
+
+			if (u < - BEZIER_PATCH_STORE_EDGE_TOL || v < - BEZIER_PATCH_STORE_EDGE_TOL
+				|| u + v > 1 + BEZIER_PATCH_STORE_EDGE_TOL){
+				return false;
+			}
+
+			double normal[3];
+			cross(P_u,P_v,normal);
+
+			if (outside && dot(normal,direction) > 0){
+				return false;
+			}
+
+			t = - dot(r,direction);
+
+			return t > 0 && t < max_range;
+		}
+
+		// Gauss-Newton step on the residual
+		cross(direction,P_u,a);
+		cross(direction,P_v,b);
+
+		double G_aa = dot(a,a);
+		double G_ab = dot(a,b);
+		double G_bb = dot(b,b);
+		double r_a = dot(a,y);
+		double r_b = dot(b,y);
+
+		double det = G_aa * G_bb - G_ab * G_ab;
+
+		if (!(det > 0)){
+			return false;
+		}
+
+		u += (G_bb * r_a - G_ab * r_b) / det;
+		v += (G_aa * r_b - G_ab * r_a) / det;
+
+		// The search is abandoned if it wanders far from the patch
+		if (!(std::abs(u) < 3 && std::abs(v) < 3)){
+			return false;
+		}
+
+	}
+
+	return false;
+
+}
+
+double BezierPatchStore::get_incidence_angle(unsigned int slot, double u, double v, const double * direction) const{
+
+	double P[3];
+	double P_u[3];
+	double P_v[3];
+
+	this -> evaluate(slot,u,v,P,P_u,P_v);
+
+	arma::vec::fixed<3> normal = arma::normalise(arma::cross(arma::vec::fixed<3>({P_u[0],P_u[1],P_u[2]}),
+		arma::vec::fixed<3>({P_v[0],P_v[1],P_v[2]})));
+
+	double cos_angle = std::abs(normal(0) * direction[0] + normal(1) * direction[1] + normal(2) * direction[2]);
+
+	return 180. / arma::datum::pi * std::acos(std::min(cos_angle,1.));
+
+}
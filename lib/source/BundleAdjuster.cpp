@@ -119,7 +119,8 @@ void BundleAdjuster::run(
 			
 		}
 
-		destination_pc . build_kdtree(false);
+		// Only the points merged into the anchor point cloud are inserted in its KD Tree
+		destination_pc . update_kdtree();
 
 	}
 
@@ -191,6 +192,8 @@ void BundleAdjuster::solve_bundle_adjustment(
 
 		}
 
+		++this -> N_pairings;
+
 		for (int k = 0; k < this -> point_cloud_pairs.size(); ++k){
 			// They are added to the whole problem
 			this -> add_subproblem_to_problem(coefficients,Nmat,Lambda_k_vector. at(k),N_k_vector. at(k),this -> point_cloud_pairs . at(k));
@@ -326,7 +329,9 @@ void BundleAdjuster::assemble_subproblem(arma::mat & Lambda_k,arma::vec & N_k,
 			dcm_S ,
 			x_S,
 			dcm_D ,
-			x_D );
+			x_D,
+			this -> N_pairings,
+			this -> get_sampling_stream(point_cloud_pair.S_k,point_cloud_pair.D_k));
 	}
 
 	else{
@@ -425,6 +430,8 @@ void BundleAdjuster::assemble_subproblem(arma::mat & Lambda_k,arma::vec & N_k,
 
 bool BundleAdjuster::update_point_cloud_pairs(bool last_iter){
 
+	unsigned int sampling_iteration = this -> N_pairings++;
+
 	double max_error = -1;
 	int worst_Sk,worst_Dk;
 	int sum_point_pairs_sizes = 0;
@@ -476,7 +483,9 @@ bool BundleAdjuster::update_point_cloud_pairs(bool last_iter){
 				dcm_S ,
 				x_S,
 				dcm_D ,
-				x_D );
+				x_D,
+				sampling_iteration,
+				this -> get_sampling_stream(point_cloud_pair.S_k,point_cloud_pair.D_k));
 		}
 
 		else{
@@ -775,8 +784,8 @@ void BundleAdjuster::update_point_clouds(std::map<int,arma::mat::fixed<3,3> > &
 
 		arma::mat::fixed<3,3> NS_bar = RBK::mrp_to_dcm(mrp);
 		
+		// The KD Tree of the point cloud is not rebuilt: queries are mapped through the transform
 		this -> all_registered_pc -> at(i) . transform(NS_bar, x);
-		this -> all_registered_pc -> at(i) . build_kdtree(false);
 
 		// The rigid transforms are fixed
 		M_pcs[i] = NS_bar * M_pcs[i];
@@ -823,6 +832,8 @@ std::map<double,int> BundleAdjuster::find_overlap_with_pc(int pc_global_index,in
 	std::vector<PointPair> point_pairs;
 	std::map<double,int> overlaps;
 
+	unsigned int sampling_iteration = this -> N_pairings;
+
 	std::vector<int> pcs_to_check;
 	int active_h = 5;
 	int len = std::abs(end_index - start_index) + 1;
@@ -904,7 +915,13 @@ std::map<double,int> BundleAdjuster::find_overlap_with_pc(int pc_global_index,in
 					this -> all_registered_pc -> at(pc_global_index),
 					this -> all_registered_pc -> at(other_pc_index),
 					point_pairs,
-					active_h);
+					active_h,
+					arma::eye<arma::mat>(3,3),
+					arma::zeros<arma::vec>(3),
+					arma::eye<arma::mat>(3,3),
+					arma::zeros<arma::vec>(3),
+					sampling_iteration,
+					this -> get_sampling_stream(pc_global_index,other_pc_index));
 
 				double prop = double(point_pairs.size()) / N_pairs * 100;
 
@@ -1106,6 +1123,10 @@ void BundleAdjuster::remove_edges_from_graph(){
 
 }
 
+unsigned int BundleAdjuster::get_sampling_stream(int S_k,int D_k) const{
+	return S_k * this -> all_registered_pc -> size() + D_k;
+}
+
 void BundleAdjuster::set_h(int h){
 	this -> h = h;
 }
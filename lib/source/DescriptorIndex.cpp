@@ -0,0 +1,319 @@
+#include <DescriptorIndex.hpp>
+#include <PointCloud.hpp>
+#include <PointDescriptor.hpp>
+#include <Philox.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+
+#define DESCRIPTOR_INDEX_DEBUG 0
+
+
+DescriptorIndex::DescriptorIndex(unsigned int N_trees,unsigned int max_checks){
+	this -> N_trees = std::max(N_trees,1u);
+	this -> max_checks = max_checks;
+}
+
+void DescriptorIndex::build(const PointCloud<PointDescriptor> & pc){
+
+	this -> descriptors.clear();
+	this -> indices.clear();
+	this -> trees.assign(this -> N_trees,std::vector<Node>());
+	this -> permutations.assign(this -> N_trees,std::vector<int>());
+	this -> dimension = 0;
+
+	// The valid descriptors are gathered in a contiguous buffer
+	const DescriptorMatrix & descriptors = pc.get_points();
+	for (unsigned int i = 0; i < pc.size(); ++i){
+		if (pc.check_if_point_valid(i)){
+			const float * histogram = descriptors.get_histogram_data(i);
+			this -> dimension = descriptors.get_descriptor_size();
+			this -> descriptors.insert(this -> descriptors.end(),histogram,histogram + this -> dimension);
+			this -> indices.push_back(i);
+		}
+	}
+
+	// The exact search only reads the descriptors, so the trees are built once an approximate search is requested
+	if (this -> max_checks > 0){
+		this -> build_trees();
+	}
+
+}
+
+void DescriptorIndex::build_trees(){
+
+	if (this -> indices.size() == 0 || this -> trees[0].size() > 0){
+		return;
+	}
+
+	// The trees are independent
+	#pragma omp parallel for
+	for (unsigned int t = 0; t < this -> N_trees; ++t){
+		this -> permutations[t].resize(this -> indices.size());
+		std::iota(this -> permutations[t].begin(),this -> permutations[t].end(),0);
+		this -> build_node(t,0,this -> indices.size());
+	}
+
+	#if DESCRIPTOR_INDEX_DEBUG
+	std::cout << "Descriptors in index: " << this -> indices.size() << std::endl;
+	for (unsigned int t = 0; t < this -> N_trees; ++t){
+		std::cout << "Nodes in tree " << t << ": " << this -> trees[t].size() << std::endl;
+	}
+	#endif
+
+}
+
+int DescriptorIndex::build_node(unsigned int tree,int begin,int end){
+
+	std::vector<Node> & nodes = this -> trees[tree];
+	std::vector<int> & permutation = this -> permutations[tree];
+	int node_index = nodes.size();
+	nodes.push_back(Node());
+
+	if (end - begin <= DESCRIPTOR_INDEX_LEAF_SIZE){
+		nodes[node_index].left = begin;
+		nodes[node_index].right = end;
+		return node_index;
+	}
+
+	// The mean and variance of each bin are estimated over the first descriptors of the node
+	unsigned int D = this -> dimension;
+	int N_samples = std::min(end - begin,DESCRIPTOR_INDEX_VARIANCE_SAMPLES);
+	std::vector<double> mean(D,0);
+	std::vector<double> variance(D,0);
+
+	for (int i = begin; i < begin + N_samples; ++i){
+		const double * descriptor = this -> descriptors.data() + permutation[i] * D;
+		for (unsigned int k = 0; k < D; ++k){
+			mean[k] += descriptor[k] / N_samples;
+		}
+	}
+
+	for (int i = begin; i < begin + N_samples; ++i){
+		const double * descriptor = this -> descriptors.data() + permutation[i] * D;
+		for (unsigned int k = 0; k < D; ++k){
+			variance[k] += std::pow(descriptor[k] - mean[k],2);
+		}
+	}
+
+	// The split axis is drawn among the bins of highest variance
+	std::vector<int> axes(D);
+	std::iota(axes.begin(),axes.end(),0);
+	unsigned int N_candidates = std::min(D,(unsigned int)(DESCRIPTOR_INDEX_N_CANDIDATE_AXES));
+	std::partial_sort(axes.begin(),axes.begin() + N_candidates,axes.end(),
+		[&](int a,int b){return variance[a] > variance[b];});
+
+	Philox rng(PHILOX_DOMAIN_DESCRIPTOR_INDEX,tree,node_index);
+	int axis = axes[rng.uniform_int(N_candidates)];
+	double value = mean[axis];
+
+	auto coordinate = [&](int slot){return this -> descriptors[slot * D + axis];};
+
+	int mid = std::partition(permutation.begin() + begin,permutation.begin() + end,
+		[&](int slot){return coordinate(slot) <= value;}) - permutation.begin();
+
+	// Falls back on a median split if the mean split left a side empty
+	if (mid == begin || mid == end){
+		mid = begin + (end - begin) / 2;
+		std::nth_element(permutation.begin() + begin,permutation.begin() + mid,permutation.begin() + end,
+			[&](int a,int b){return coordinate(a) < coordinate(b);});
+		value = coordinate(permutation[mid]);
+
+		// All the descriptors share the same value along this axis
+		auto bounds = std::minmax_element(permutation.begin() + begin,permutation.begin() + end,
+			[&](int a,int b){return coordinate(a) < coordinate(b);});
+		if (coordinate(*bounds.first) == coordinate(*bounds.second)){
+			nodes[node_index].left = begin;
+			nodes[node_index].right = end;
+			return node_index;
+		}
+	}
+
+	// Descriptors in [begin,mid) lie at or below the split value, those in [mid,end) at or above it
+	int left = this -> build_node(tree,begin,mid);
+	int right = this -> build_node(tree,mid,end);
+
+	nodes[node_index].axis = axis;
+	nodes[node_index].value = value;
+	nodes[node_index].left = left;
+	nodes[node_index].right = right;
+
+	return node_index;
+
+}
+
+unsigned int DescriptorIndex::closest_N_point_search(const arma::vec & histogram,
+	unsigned int N,
+	int * closest_indices,
+	double * closest_distances) const{
+	return this -> closest_N_point_search(histogram.memptr(),N,closest_indices,closest_distances);
+}
+
+unsigned int DescriptorIndex::closest_N_point_search(const double * histogram,
+	unsigned int N,
+	int * closest_indices,
+	double * closest_distances) const{
+
+	unsigned int N_found = 0;
+	unsigned int N_checks = 0;
+	N = std::min(N,this -> size());
+
+	if (N == 0){
+		return N_found;
+	}
+
+	std::vector<Branch> branches;
+
+	if (this -> max_checks == 0){
+
+		// Exact search
+		for (unsigned int slot = 0; slot < this -> indices.size(); ++slot){
+
+			double new_distance = this -> distance(this -> descriptors.data() + slot * this -> dimension,histogram);
+
+			if (N_found == N && new_distance >= closest_distances[N_found - 1]){
+				continue;
+			}
+
+			unsigned int k = N_found < N ? N_found++ : N_found - 1;
+			for (; k > 0 && closest_distances[k - 1] > new_distance; --k){
+				closest_distances[k] = closest_distances[k - 1];
+				closest_indices[k] = closest_indices[k - 1];
+			}
+			closest_distances[k] = new_distance;
+			closest_indices[k] = this -> indices[slot];
+		}
+
+		return N_found;
+	}
+
+	// All the trees are descended once, then the most promising branches left aside are explored
+	for (unsigned int t = 0; t < this -> N_trees; ++t){
+		this -> search_branch(t,0,0,histogram,N,closest_indices,closest_distances,N_found,N_checks,branches);
+	}
+
+	while (branches.size() > 0 && N_checks < this -> max_checks){
+
+		std::pop_heap(branches.begin(),branches.end());
+		Branch branch = branches.back();
+		branches.pop_back();
+
+		// No descriptor left in any branch can be closer
+		if (N_found == N && branch.bound >= closest_distances[N_found - 1]){
+			break;
+		}
+
+		this -> search_branch(branch.tree,branch.node,branch.bound,histogram,
+			N,closest_indices,closest_distances,N_found,N_checks,branches);
+	}
+
+	return N_found;
+
+}
+
+void DescriptorIndex::search_branch(unsigned int tree,int node_index,double bound,
+	const double * histogram,
+	unsigned int N,
+	int * closest_indices,
+	double * closest_distances,
+	unsigned int & N_found,
+	unsigned int & N_checks,
+	std::vector<Branch> & branches) const{
+
+	const std::vector<Node> & nodes = this -> trees[tree];
+
+	// Descent to the leaf containing the query, the far side of each fork being set aside
+	while (nodes[node_index].axis >= 0){
+
+		const Node & node = nodes[node_index];
+		double offset = histogram[node.axis] - node.value;
+
+		int near_child = offset <= 0 ? node.left : node.right;
+		int far_child = offset <= 0 ? node.right : node.left;
+		double far_bound = std::max(bound,this -> plane_bound(offset,histogram[node.axis]));
+
+		if (N_found < N || far_bound < closest_distances[N_found - 1]){
+			Branch branch = {far_bound,tree,far_child};
+			branches.push_back(branch);
+			std::push_heap(branches.begin(),branches.end());
+		}
+
+		node_index = near_child;
+	}
+
+	const Node & leaf = nodes[node_index];
+	const std::vector<int> & permutation = this -> permutations[tree];
+
+	for (int i = leaf.left; i < leaf.right; ++i){
+
+		int slot = permutation[i];
+		double new_distance = this -> distance(this -> descriptors.data() + slot * this -> dimension,histogram);
+		++N_checks;
+
+		if (N_found == N && new_distance >= closest_distances[N_found - 1]){
+			continue;
+		}
+
+		// The same descriptor may already have been found in another tree
+		int index = this -> indices[slot];
+		if (std::find(closest_indices,closest_indices + N_found,index) != closest_indices + N_found){
+			continue;
+		}
+
+		unsigned int k = N_found < N ? N_found++ : N_found - 1;
+		for (; k > 0 && closest_distances[k - 1] > new_distance; --k){
+			closest_distances[k] = closest_distances[k - 1];
+			closest_indices[k] = closest_indices[k - 1];
+		}
+		closest_distances[k] = new_distance;
+		closest_indices[k] = index;
+	}
+
+}
+
+double DescriptorIndex::distance(const double * descriptor_in_index,const double * histogram) const{
+
+	// Same as PointDescriptor::distance_to_descriptor
+	double distance = 0;
+
+	for (unsigned int i = 0; i < this -> dimension; ++i){
+		double pi = descriptor_in_index[i];
+		double qi = histogram[i];
+
+		if (pi > 0 || qi > 0){
+			distance += (pi - qi) * (pi - qi) / (pi + qi);
+		}
+	}
+	return distance;
+
+}
+
+double DescriptorIndex::plane_bound(double offset,double query_value) const{
+
+	// A descriptor across the plane differs from the query by d >= |offset| along the split axis.
+	// Its term in the distance, d^2 / (2 * query_value +/- d), is then at least
+	// d^2 / (2 * query_value + d) >= offset^2 / (2 * query_value + |offset|)
+	double denominator = 2 * query_value + std::abs(offset);
+
+	if (denominator <= 0){
+		return 0;
+	}
+	return offset * offset / denominator;
+
+}
+
+void DescriptorIndex::set_max_checks(unsigned int max_checks){
+	this -> max_checks = max_checks;
+	if (max_checks > 0){
+		this -> build_trees();
+	}
+}
+
+unsigned int DescriptorIndex::get_max_checks() const{
+	return this -> max_checks;
+}
+
+unsigned int DescriptorIndex::size() const{
+	return this -> indices.size();
+}
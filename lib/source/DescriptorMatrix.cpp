@@ -0,0 +1,325 @@
+#include <DescriptorMatrix.hpp>
+
+#include <algorithm>
+
+
+// Distance of PointDescriptor::distance_to_descriptor between a stored histogram and a histogram,
+// written without branches so that it vectorizes over the bins
+static inline double chi_squared_distance(const float * stored_histogram,const double * histogram,unsigned int descriptor_size){
+
+	double distance = 0;
+
+	#pragma omp simd reduction(+:distance)
+	for (unsigned int k = 0; k < descriptor_size; ++k){
+		double pk = stored_histogram[k];
+		double qk = histogram[k];
+		double difference = pk - qk;
+		distance += (pk > 0 || qk > 0) ? difference * difference / (pk + qk) : 0.;
+	}
+
+	return distance;
+
+}
+
+DescriptorMatrix::Reference::Reference(DescriptorMatrix * matrix,unsigned int index){
+	this -> matrix = matrix;
+	this -> index = index;
+}
+
+DescriptorMatrix::Reference & DescriptorMatrix::Reference::operator=(const PointDescriptor & descriptor){
+	this -> matrix -> set(this -> index,descriptor);
+	return *this;
+}
+
+DescriptorMatrix::Reference & DescriptorMatrix::Reference::operator=(const Reference & other){
+	this -> matrix -> set(this -> index,PointDescriptor(other));
+	return *this;
+}
+
+DescriptorMatrix::Reference::operator PointDescriptor() const{
+	return ConstReference(this -> matrix,this -> index);
+}
+
+arma::vec DescriptorMatrix::Reference::get_histogram() const{
+	return this -> matrix -> get_histogram(this -> index);
+}
+
+unsigned int DescriptorMatrix::Reference::get_histogram_size() const{
+	return this -> matrix -> get_descriptor_size();
+}
+
+double DescriptorMatrix::Reference::get_histogram_value(int bin_index) const{
+	return this -> matrix -> get_histogram_data(this -> index)[bin_index];
+}
+
+void DescriptorMatrix::Reference::copy_histogram(double * histogram) const{
+	ConstReference(this -> matrix,this -> index).copy_histogram(histogram);
+}
+
+double DescriptorMatrix::Reference::distance_to_descriptor(const PointDescriptor & descriptor) const{
+	return this -> distance_to_descriptor(descriptor.get_histogram());
+}
+
+double DescriptorMatrix::Reference::distance_to_descriptor(const arma::vec & histogram) const{
+	return this -> matrix -> distance(this -> index,histogram.memptr());
+}
+
+int DescriptorMatrix::Reference::get_type() const{
+	return this -> matrix -> get_type(this -> index);
+}
+
+int DescriptorMatrix::Reference::get_global_index() const{
+	return this -> matrix -> get_global_index(this -> index);
+}
+
+void DescriptorMatrix::Reference::set_global_index(int index){
+	this -> matrix -> set_global_index(this -> index,index);
+}
+
+bool DescriptorMatrix::Reference::get_is_valid_feature() const{
+	return this -> matrix -> get_is_valid_feature(this -> index);
+}
+
+void DescriptorMatrix::Reference::set_is_valid_feature(bool valid_feature){
+	this -> matrix -> set_is_valid_feature(this -> index,valid_feature);
+}
+
+DescriptorMatrix::ConstReference::ConstReference(const DescriptorMatrix * matrix,unsigned int index){
+	this -> matrix = matrix;
+	this -> index = index;
+}
+
+DescriptorMatrix::ConstReference::operator PointDescriptor() const{
+
+	PointDescriptor descriptor(this -> get_histogram());
+	descriptor.set_type(this -> get_type());
+	descriptor.set_global_index(this -> get_global_index());
+	descriptor.set_is_valid_feature(this -> get_is_valid_feature());
+	return descriptor;
+
+}
+
+arma::vec DescriptorMatrix::ConstReference::get_histogram() const{
+	return this -> matrix -> get_histogram(this -> index);
+}
+
+unsigned int DescriptorMatrix::ConstReference::get_histogram_size() const{
+	return this -> matrix -> get_descriptor_size();
+}
+
+double DescriptorMatrix::ConstReference::get_histogram_value(int bin_index) const{
+	return this -> get_histogram_data()[bin_index];
+}
+
+const float * DescriptorMatrix::ConstReference::get_histogram_data() const{
+	return this -> matrix -> get_histogram_data(this -> index);
+}
+
+void DescriptorMatrix::ConstReference::copy_histogram(double * histogram) const{
+	const float * histogram_data = this -> get_histogram_data();
+	std::copy(histogram_data,histogram_data + this -> get_histogram_size(),histogram);
+}
+
+double DescriptorMatrix::ConstReference::distance_to_descriptor(const PointDescriptor & descriptor) const{
+	return this -> distance_to_descriptor(descriptor.get_histogram());
+}
+
+double DescriptorMatrix::ConstReference::distance_to_descriptor(const arma::vec & histogram) const{
+	return this -> matrix -> distance(this -> index,histogram.memptr());
+}
+
+int DescriptorMatrix::ConstReference::get_type() const{
+	return this -> matrix -> get_type(this -> index);
+}
+
+int DescriptorMatrix::ConstReference::get_global_index() const{
+	return this -> matrix -> get_global_index(this -> index);
+}
+
+bool DescriptorMatrix::ConstReference::get_is_valid_feature() const{
+	return this -> matrix -> get_is_valid_feature(this -> index);
+}
+
+
+unsigned int DescriptorMatrix::size() const{
+	return this -> N;
+}
+
+unsigned int DescriptorMatrix::get_descriptor_size() const{
+	return this -> descriptor_size;
+}
+
+void DescriptorMatrix::set_descriptor_size(unsigned int descriptor_size){
+
+	if (descriptor_size != this -> descriptor_size){
+		this -> descriptor_size = descriptor_size;
+		this -> histograms.assign(std::size_t(this -> N) * descriptor_size,0.f);
+	}
+
+}
+
+void DescriptorMatrix::resize(unsigned int N){
+
+	unsigned int previous_N = this -> N;
+	this -> N = N;
+
+	this -> histograms.resize(std::size_t(N) * this -> descriptor_size,0.f);
+	this -> global_indices.resize(N,0);
+	this -> types.resize(N,0);
+
+	// The new descriptors are valid, the bits past the last descriptor are kept cleared
+	this -> valid_bits.resize((N + 63) / 64,0);
+	for (unsigned int i = previous_N; i < N; ++i){
+		this -> valid_bits[i / 64] |= std::uint64_t(1) << (i % 64);
+	}
+	if (N < previous_N && N % 64 != 0){
+		this -> valid_bits.back() &= (std::uint64_t(1) << (N % 64)) - 1;
+	}
+
+}
+
+void DescriptorMatrix::clear(){
+	this -> resize(0);
+}
+
+void DescriptorMatrix::push_back(const PointDescriptor & descriptor){
+
+	if (this -> N == 0 || this -> descriptor_size == 0){
+		this -> set_descriptor_size(descriptor.get_histogram_size());
+	}
+
+	if (descriptor.get_histogram_size() != this -> descriptor_size){
+		throw(std::runtime_error("DescriptorMatrix: descriptor of size " + std::to_string(descriptor.get_histogram_size())
+			+ " pushed to a matrix of descriptors of size " + std::to_string(this -> descriptor_size)));
+	}
+
+	this -> resize(this -> N + 1);
+	this -> set(this -> N - 1,descriptor);
+
+}
+
+DescriptorMatrix::ConstReference DescriptorMatrix::operator[](unsigned int i) const{
+	return ConstReference(this,i);
+}
+
+DescriptorMatrix::Reference DescriptorMatrix::operator[](unsigned int i){
+	return Reference(this,i);
+}
+
+DescriptorMatrix::Reference DescriptorMatrix::back(){
+	return Reference(this,this -> N - 1);
+}
+
+const float * DescriptorMatrix::get_histogram_data(unsigned int i) const{
+	return this -> histograms.data() + std::size_t(i) * this -> descriptor_size;
+}
+
+arma::vec DescriptorMatrix::get_histogram(unsigned int i) const{
+
+	const float * histogram = this -> get_histogram_data(i);
+	arma::vec histogram_vec(this -> descriptor_size);
+	std::copy(histogram,histogram + this -> descriptor_size,histogram_vec.begin());
+	return histogram_vec;
+
+}
+
+void DescriptorMatrix::set(unsigned int i,const PointDescriptor & descriptor){
+
+	const arma::vec & histogram = descriptor.get_histogram();
+
+	if (this -> descriptor_size == 0){
+		this -> set_descriptor_size(histogram.n_elem);
+	}
+
+	if (histogram.n_elem != this -> descriptor_size){
+		throw(std::runtime_error("DescriptorMatrix: descriptor of size " + std::to_string(histogram.n_elem)
+			+ " written to a matrix of descriptors of size " + std::to_string(this -> descriptor_size)));
+	}
+
+	std::copy(histogram.begin(),histogram.end(),this -> histograms.begin() + std::size_t(i) * this -> descriptor_size);
+	this -> types[i] = static_cast<unsigned char>(descriptor.get_type());
+	this -> global_indices[i] = descriptor.get_global_index();
+	this -> set_is_valid_feature(i,descriptor.get_is_valid_feature());
+
+}
+
+bool DescriptorMatrix::get_is_valid_feature(unsigned int i) const{
+
+	std::uint64_t word;
+	#pragma omp atomic read
+	word = this -> valid_bits[i / 64];
+
+	return (word >> (i % 64)) & 1;
+
+}
+
+void DescriptorMatrix::set_is_valid_feature(unsigned int i,bool valid_feature){
+
+	// Neighboring descriptors share the same word, which may be written to from other threads
+	std::uint64_t & word = this -> valid_bits[i / 64];
+	std::uint64_t bit = std::uint64_t(1) << (i % 64);
+
+	if (valid_feature){
+		#pragma omp atomic
+		word |= bit;
+	}
+	else{
+		#pragma omp atomic
+		word &= ~bit;
+	}
+
+}
+
+int DescriptorMatrix::get_global_index(unsigned int i) const{
+	return this -> global_indices[i];
+}
+
+void DescriptorMatrix::set_global_index(unsigned int i,int index){
+	this -> global_indices[i] = index;
+}
+
+int DescriptorMatrix::get_type(unsigned int i) const{
+	return this -> types[i];
+}
+
+double DescriptorMatrix::distance(unsigned int i,const double * histogram) const{
+	return chi_squared_distance(this -> get_histogram_data(i),histogram,this -> descriptor_size);
+}
+
+void DescriptorMatrix::compute_distances(const arma::vec & histogram,arma::vec & distances) const{
+
+	if (histogram.n_elem != this -> descriptor_size){
+		throw(std::runtime_error("DescriptorMatrix::compute_distances: histogram of size " + std::to_string(histogram.n_elem)
+			+ " compared to descriptors of size " + std::to_string(this -> descriptor_size)));
+	}
+
+	distances.set_size(this -> N);
+
+	#pragma omp parallel for
+	for (unsigned int i = 0; i < this -> N; ++i){
+		distances(i) = chi_squared_distance(this -> get_histogram_data(i),histogram.memptr(),this -> descriptor_size);
+	}
+
+}
+
+arma::vec DescriptorMatrix::compute_mean() const{
+
+	std::vector<double> sum(this -> descriptor_size,0.);
+	double * sum_data = sum.data();
+
+	for (unsigned int i = 0; i < this -> N; ++i){
+		const float * histogram = this -> get_histogram_data(i);
+
+		#pragma omp simd
+		for (unsigned int k = 0; k < this -> descriptor_size; ++k){
+			sum_data[k] += histogram[k];
+		}
+	}
+
+	arma::vec mean = arma::conv_to<arma::vec>::from(sum);
+	if (this -> N > 0){
+		mean /= this -> N;
+	}
+	return mean;
+
+}
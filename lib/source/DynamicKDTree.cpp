@@ -0,0 +1,157 @@
+#include <DynamicKDTree.hpp>
+#include <PointDescriptor.hpp>
+#include <PointCloud.hpp>
+#include <PointNormal.hpp>
+
+
+#define DYNAMIC_KDTREE_DEBUG 0
+
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::build(const std::vector< int > & indices,const ContainerType<PointType> * owner) {
+
+	this -> trees.clear();
+
+	if (indices.size() == 0) {
+		return;
+	}
+
+	this -> trees.push_back(KDTree<ContainerType,PointType>());
+	this -> trees.back().build(indices,owner);
+
+}
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::insert(const std::vector< int > & indices,const std::vector< double > & coordinates) {
+
+	if (indices.size() == 0) {
+		return;
+	}
+
+	std::vector<int> merged_indices = indices;
+	std::vector<double> merged_coordinates = coordinates;
+
+	// The smallest trees are absorbed by the new one as long as they are not
+	// much larger than it, which keeps the sizes of the trees decreasing geometrically
+	while (this -> trees.size() > 0 && this -> trees.back().size() <= DYNAMIC_KDTREE_MERGE_RATIO * merged_indices.size()) {
+
+		const KDTree<ContainerType,PointType> & tree = this -> trees.back();
+
+		merged_indices.insert(merged_indices.end(),tree.get_indices().begin(),tree.get_indices().end());
+		merged_coordinates.insert(merged_coordinates.end(),tree.get_coordinates().begin(),tree.get_coordinates().end());
+
+		this -> trees.pop_back();
+	}
+
+	this -> trees.push_back(KDTree<ContainerType,PointType>());
+	this -> trees.back().build(merged_indices,merged_coordinates);
+
+	#if DYNAMIC_KDTREE_DEBUG
+	std::cout << "Inserted " << indices.size() << " points. Trees in forest: " << this -> trees.size() << std::endl;
+	#endif
+
+}
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::closest_point_search(const arma::vec & test_point,
+	int & best_guess_index,
+	double & distance) const {
+
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		this -> trees[t].closest_point_search(test_point,best_guess_index,distance);
+	}
+
+}
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::closest_N_point_search(const arma::vec & test_point,
+	const unsigned int & N_points,
+	double & distance,
+	std::map<double,int > & closest_points) const{
+
+	if (N_points == 0) {
+		return;
+	}
+
+	// Each tree contributes its N closest points within the current bound
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		this -> trees[t].closest_N_point_search(test_point,N_points,distance,closest_points);
+	}
+
+	while (closest_points.size() > N_points) {
+		closest_points.erase(--closest_points.end());
+	}
+
+	if (closest_points.size() == N_points) {
+		distance = std::min(distance,closest_points.rbegin() -> first);
+	}
+
+}
+
+template <template<class> class ContainerType, class PointType>
+unsigned int DynamicKDTree<ContainerType,PointType>::closest_N_point_search(const double * test_point,
+	unsigned int N_points,
+	int * closest_indices,
+	double * closest_distances) const{
+
+	unsigned int N_found = 0;
+
+	// The buffers are carried from tree to tree, so the points found in the
+	// largest trees prune the search in the smaller ones
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		N_found = this -> trees[t].closest_N_point_search(test_point,N_points,
+			closest_indices,closest_distances,N_found);
+	}
+
+	return N_found;
+
+}
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::radius_point_search(const arma::vec & test_point,
+	const double & distance,
+	std::vector< int > & closest_points) const{
+
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		this -> trees[t].radius_point_search(test_point,distance,closest_points);
+	}
+
+}
+
+template <template<class> class ContainerType, class PointType>
+void DynamicKDTree<ContainerType,PointType>::radius_point_search(const double * test_point,
+	const double & distance,
+	std::vector< int > & closest_points,
+	std::vector< double > & closest_distances) const{
+
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		this -> trees[t].radius_point_search(test_point,distance,closest_points,closest_distances);
+	}
+
+}
+
+template <template<class> class ContainerType, class PointType>
+unsigned int DynamicKDTree<ContainerType,PointType>::size() const {
+
+	unsigned int N = 0;
+	for (unsigned int t = 0; t < this -> trees.size(); ++t) {
+		N += this -> trees[t].size();
+	}
+	return N;
+
+}
+
+template <template<class> class ContainerType, class PointType>
+unsigned int DynamicKDTree<ContainerType,PointType>::get_N_trees() const {
+	return static_cast<unsigned int>(this -> trees.size());
+}
+
+template <template<class> class ContainerType, class PointType>
+const KDTree<ContainerType,PointType> & DynamicKDTree<ContainerType,PointType>::get_tree(unsigned int tree_index) const {
+	return this -> trees[tree_index];
+}
+
+
+// Explicit instantiations
+template class DynamicKDTree<PointCloud,PointNormal> ;
+template class DynamicKDTree<PointCloud,PointDescriptor> ;
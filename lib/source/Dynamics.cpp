@@ -61,6 +61,21 @@ arma::vec Dynamics::point_mass_acceleration(double t,const arma::vec & X, const
 
 }
 
+bool Dynamics::is_in_shadow(ShapeModel<ControlPoint> * shape_model,
+	ShadowCache * shadow_cache,
+	const arma::vec::fixed<3> & position_body_frame,
+	const arma::vec::fixed<3> & sun_direction_body_frame){
+
+	if (shadow_cache != nullptr){
+		return shadow_cache -> is_in_shadow(position_body_frame,sun_direction_body_frame);
+	}
+
+	// Any occluding element will do, so the closest one is not searched for
+	Ray ray(position_body_frame, sun_direction_body_frame) ;
+	return shape_model -> ray_trace_any(&ray);
+
+}
+
 arma::vec Dynamics::SRP_cannonball_truth(double t,const arma::vec & X, const Args & args){
 
 	double au2meters = 149597870700;
@@ -77,9 +92,8 @@ arma::vec Dynamics::SRP_cannonball_truth(double t,const arma::vec & X, const Arg
 	arma::vec::fixed<3> ray_direction_body_frame = - BN * arma::normalise(R + X.subvec(0,2));
 	arma::vec::fixed<3> ray_origin_body_frame = BN * X.subvec(0,2);
 
-	Ray ray(ray_origin_body_frame, ray_direction_body_frame) ;
-
-	if (args . get_true_shape_model() -> ray_trace(&ray)){
+	if (Dynamics::is_in_shadow(args . get_true_shape_model(),args . get_shadow_cache_truth(),
+		ray_origin_body_frame,ray_direction_body_frame)){
 
 		return arma::zeros<arma::vec>(3);
 	}
@@ -105,9 +119,8 @@ arma::vec Dynamics::SRP_cannonball_estimate(double t,const arma::vec & X, const
 	arma::vec::fixed<3> ray_direction_body_frame = - BN * arma::normalise(R + X.subvec(0,2));
 	arma::vec::fixed<3> ray_origin_body_frame = BN * X.subvec(0,2);
 
-	Ray ray(ray_origin_body_frame, ray_direction_body_frame) ;
-
-	if (args . get_estimated_shape_model() -> ray_trace(&ray)){
+	if (Dynamics::is_in_shadow(args . get_estimated_shape_model(),args . get_shadow_cache_estimate(),
+		ray_origin_body_frame,ray_direction_body_frame)){
 		return arma::zeros<arma::vec>(3);
 	}
 	else{
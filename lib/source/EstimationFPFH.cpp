@@ -2,8 +2,16 @@
 #include <PointNormal.hpp>
 #include <PointDescriptor.hpp>
 
+#include <cstring>
 
 
+// Bit mixer of splitmix64, spreading the bits of the point coordinates over the whole hash
+static inline std::uint64_t mix_bits(std::uint64_t x){
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
 template <class T,class U>
 EstimationFPFH<T,U>::EstimationFPFH(const PointCloud<T> & input,PointCloud<U> & output_pc) : EstimationFeature<T,U>(input,output_pc){
 
@@ -16,51 +24,216 @@ void EstimationFPFH<T,U>::estimate(double radius_neighbors,bool force_use_previo
 		throw(std::runtime_error("neighborhood_radius is negative"));
 	}
 
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_radius(radius_neighbors,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
+
+}
+
+template<class T,class U>
+void EstimationFPFH<T,U>::estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous){
+
 	unsigned int size = this -> input_pc. size();
 	assert(size == this -> output_pc.size());
 
-	std::vector<std::vector<int> > all_points_neighborhoods;
+	// Points are identified by their coordinates and normals, and their neighborhoods
+	// by the identifiers of their neighbors
+	std::vector<FPFHCacheKey> keys;
+	std::vector<std::uint64_t> signatures;
+
+	if (this -> use_cache){
+
+		keys.resize(size);
+		std::vector<std::uint64_t> key_hashes(size);
+
+		#pragma omp parallel for
+		for (unsigned int i = 0; i < size; ++i) {
+			keys[i] = EstimationFPFH<T,U>::get_cache_key(this -> input_pc,i);
+			key_hashes[i] = FPFHCacheKeyHash()(keys[i]);
+		}
+
+		signatures.resize(size);
+
+		#pragma omp parallel for
+		for (unsigned int i = 0; i < size; ++i) {
+			unsigned int N_neighbors = neighborhoods.get_N_neighbors(i);
+			const int * points = neighborhoods.get_neighbors(i);
+
+			std::uint64_t signature = N_neighbors;
+			for (unsigned int k = 0; k < N_neighbors; ++k){
+				signature += mix_bits(key_hashes[points[k]]);
+			}
+			signatures[i] = signature;
+		}
+
+	}
+
 	std::vector<SPFH> all_point_spfhs;
-	all_points_neighborhoods.resize(size);
 	all_point_spfhs.resize(size);
 
+	std::vector<const CacheEntry *> cached_entries(size,nullptr);
+
 	#pragma omp parallel for
 	for (unsigned int i = 0; i < size; ++i) {
-		std::vector<int> neighborhood = this -> input_pc.get_nearest_neighbors_radius(this -> input_pc.get_point_coordinates(i),radius_neighbors);
-		all_points_neighborhoods[i] = neighborhood;
-		all_point_spfhs[i] = SPFH(i,neighborhood,this -> N_bins,this -> input_pc);
+
+		if (this -> use_cache){
+			auto entry = this -> cache.find(keys[i]);
+			if (entry != this -> cache.end() && entry -> second.neighborhood_signature == signatures[i]){
+				cached_entries[i] = &entry -> second;
+				all_point_spfhs[i] = entry -> second.spfh;
+				continue;
+			}
+		}
+
+		all_point_spfhs[i] = SPFH(i,neighborhoods,this -> N_bins,this -> input_pc);
 	}
 
-	#pragma omp parallel for
+	std::vector<FPFH> all_point_fpfhs;
+	unsigned int N_computed_features = 0;
+
+	// The descriptors are written to from concurrent threads, so their size is set beforehand
+	this -> output_pc.set_descriptor_size(3 * this -> N_bins);
+
+	if (!this -> use_cache){
+
+		#pragma omp parallel for
+		for (unsigned int i = 0; i < size; ++i) {
+			this -> output_pc[i] = FPFH(i,
+				neighborhoods,
+				all_point_spfhs,
+				this -> input_pc,
+				this -> scale_distance,
+				this -> output_pc[i].get_is_valid_feature());
+		}
+
+		this -> N_computed_features = size;
+		return;
+	}
+
+	all_point_fpfhs.resize(size);
+
+	#pragma omp parallel for reduction(+:N_computed_features)
+	for (unsigned int i = 0; i < size; ++i) {
+
+		// The FPFH is only recomputed if its SPFH or that of one of its neighbors was
+		bool compute = (cached_entries[i] == nullptr);
+		unsigned int N_neighbors = neighborhoods.get_N_neighbors(i);
+		const int * points = neighborhoods.get_neighbors(i);
+		for (unsigned int k = 0; k < N_neighbors && !compute; ++k){
+			compute = (cached_entries[points[k]] == nullptr);
+		}
+
+		if (compute){
+			all_point_fpfhs[i] = FPFH(i,
+				neighborhoods,
+				all_point_spfhs,
+				this -> input_pc,
+				this -> scale_distance,
+				true);
+			++N_computed_features;
+		}
+		else{
+			all_point_fpfhs[i] = cached_entries[i] -> fpfh;
+		}
+
+		// The cached FPFH are computed as valid features, so that the validity of the output
+		// follows the same rule as without the cache: a feature disabled beforehand stays disabled
+		bool is_valid_feature = this -> output_pc[i].get_is_valid_feature() && all_point_fpfhs[i].get_is_valid_feature();
+		this -> output_pc[i] = all_point_fpfhs[i];
+		this -> output_pc[i].set_is_valid_feature(is_valid_feature);
+	}
+
+	this -> N_computed_features = N_computed_features;
+
+	// The cache is rebuilt from the current points only, which drops those no longer in the cloud
+	std::unordered_map<FPFHCacheKey,CacheEntry,FPFHCacheKeyHash> cache;
+	cache.reserve(size);
+
 	for (unsigned int i = 0; i < size; ++i) {
-		this -> output_pc[i] = FPFH(i,
-			all_points_neighborhoods,
-			all_point_spfhs,
-			this -> input_pc,
-			this -> scale_distance,
-			this -> output_pc[i].get_is_valid_feature());
+		CacheEntry & entry = cache[keys[i]];
+		entry.neighborhood_signature = signatures[i];
+		entry.spfh = std::move(all_point_spfhs[i]);
+		entry.fpfh = std::move(all_point_fpfhs[i]);
 	}
 
+	this -> cache.swap(cache);
+
+}
+
+
+template<class T,class U>
+FPFHCacheKey EstimationFPFH<T,U>::get_cache_key(const PointCloud<T> & pc,unsigned int i){
+
+	arma::vec::fixed<3> point = pc.get_point_coordinates(i);
+	arma::vec::fixed<3> normal = pc.get_normal_coordinates(i);
+
+	// Adding zero turns -0 into +0, as both compare equal and must hash the same
+	return {{point(0) + 0.,point(1) + 0.,point(2) + 0.,normal(0) + 0.,normal(1) + 0.,normal(2) + 0.}};
+
 }
 
 
+std::size_t FPFHCacheKeyHash::operator()(const FPFHCacheKey & key) const{
+
+	std::uint64_t hash = 0;
+	for (double value : key){
+		std::uint64_t bits;
+		std::memcpy(&bits,&value,sizeof(bits));
+		hash = mix_bits(hash ^ bits);
+	}
+	return static_cast<std::size_t>(hash);
+
+}
 
 
 template<class T,class U>
 void EstimationFPFH<T,U>::set_scale_distance(bool scale_distance){
+	if (scale_distance != this -> scale_distance){
+		this -> clear_cache();
+	}
 	this -> scale_distance = scale_distance;
 }
 
 
 template<class T,class U>
 void EstimationFPFH<T,U>::set_N_bins(int N_bins){
+	if (N_bins != this -> N_bins){
+		this -> clear_cache();
+	}
 	this -> N_bins = N_bins;
 }
 
 
+template<class T,class U>
+void EstimationFPFH<T,U>::set_use_cache(bool use_cache){
+	this -> use_cache = use_cache;
+	if (!use_cache){
+		this -> clear_cache();
+	}
+}
+
+
+template<class T,class U>
+void EstimationFPFH<T,U>::clear_cache(){
+	this -> cache.clear();
+}
+
+
+template<class T,class U>
+unsigned int EstimationFPFH<T,U>::get_N_computed_features() const{
+	return this -> N_computed_features;
+}
+
+
 template<class T,class U>
 void EstimationFPFH<T,U>::estimate(int N_neighbors,bool force_use_previous){
-	throw(std::runtime_error("EstimationFPFH<T,U>::estimate(int N_neighbors) is not implemented"));
+
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_N(N_neighbors,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
+
 }
 
 template class EstimationFPFH<PointNormal,PointDescriptor> ;
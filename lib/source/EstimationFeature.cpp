@@ -1,6 +1,7 @@
 #include <EstimationFeature.hpp>
 #include <PointNormal.hpp>
 #include <PointDescriptor.hpp>
+#include <SymmetricEigenSolver.hpp>
 
 
 template <class T,class U>
@@ -41,7 +42,14 @@ arma::mat EstimationFeature<T,U>::compute_principal_axes(const PointCloud<U> & p
 	arma::vec eigval;
 	arma::mat eigvec;
 
-	if(!arma::eig_sym( eigval, eigvec, cov )){
+	if (cov.n_rows == 3){
+		arma::vec::fixed<3> eigval_3;
+		arma::mat::fixed<3,3> eigvec_3;
+		SymmetricEigenSolver::compute(arma::mat::fixed<3,3>(cov),eigval_3,eigvec_3);
+		eigval = eigval_3;
+		eigvec = eigvec_3;
+	}
+	else if(!arma::eig_sym( eigval, eigvec, cov )){
 		throw(std::runtime_error("Principal axes computation failed in EstimationFeature<T,U>::compute_principal_axes"));
 	}
 
@@ -59,13 +67,8 @@ template<>
 arma::vec EstimationFeature<PointNormal,PointDescriptor>::compute_distances_to_center(const arma::vec & center,
 	const PointCloud<PointDescriptor> & pc){
 
-	arma::vec distances_to_center(pc.size());
-	PointDescriptor mean_descriptor(center);
-
-	#pragma omp parallel for
-	for (int i = 0 ; i < pc.size(); ++i){
-		distances_to_center(i) = mean_descriptor.distance_to_descriptor(pc.get_point(i));
-	}
+	arma::vec distances_to_center;
+	pc.get_points().compute_distances(center,distances_to_center);
 
 	distances_to_center = arma::abs(distances_to_center - arma::mean(distances_to_center))/arma::stddev(distances_to_center);
 
@@ -1,5 +1,6 @@
 #include <EstimationNormals.hpp>
 #include <PointNormal.hpp>
+#include <SymmetricEigenSolver.hpp>
 
 template <class T,class U>
 EstimationNormals<T,U>::EstimationNormals(const PointCloud<T> & input_pc,PointCloud<U> & output_pc) : EstimationFeature<T,U>(input_pc,output_pc){
@@ -8,112 +9,298 @@ EstimationNormals<T,U>::EstimationNormals(const PointCloud<T> & input_pc,PointCl
 
 
 template <>
-void EstimationNormals<PointNormal,PointNormal>::estimate(int N_neighbors,bool force_use_previous){
+void EstimationNormals<PointNormal,PointNormal>::estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous){
 	
+	unsigned int N = this -> input_pc.size();
+
+	// The covariances are gathered first, so that their eigenvalue problems are solved in batches
+	std::vector<double> covariances(6 * N);
+
 	#pragma omp parallel for 
-	for (unsigned int i = 0; i < this -> input_pc .  size(); ++i) {
+	for (unsigned int i = 0; i < N; ++i) {
 
-		// Get the N nearest neighbors to this point
-		auto closest_points = this -> input_pc.get_closest_N_points(this -> input_pc.get_point_coordinates(i), N_neighbors);
+		unsigned int size = neighborhoods.get_N_neighbors(i);
+		const int * closest_points = neighborhoods.get_neighbors(i);
 
 		arma::mat::fixed<3,3> covariance = arma::zeros<arma::mat>(3,3);
 		arma::vec::fixed<3> centroid = {0,0,0};
 
-		for (auto it = closest_points.begin(); it != closest_points.end(); ++it) {
-			centroid += this -> input_pc.get_point_coordinates(it -> second)/closest_points.size();
+		for (unsigned int k = 0; k < size; ++k) {
+			centroid += this -> input_pc.get_point_coordinates(closest_points[k])/size;
 		}
 
-		for (auto it = closest_points.begin(); it != closest_points.end(); ++it) {
-			const arma::vec & p = this -> input_pc.get_point_coordinates(it -> second);
+		for (unsigned int k = 0; k < size; ++k) {
+			const arma::vec::fixed<3> p = this -> input_pc.get_point_coordinates(closest_points[k]);
 			covariance += (p - centroid) * (p - centroid).t();
 		}
-		covariance *= 1./(closest_points.size() - 1) ;
-		
-		// The eigenvalue problem is solved
-		arma::vec eigval;
-		arma::mat eigvec;
-
-		arma::eig_sym(eigval, eigvec, covariance);
-		arma::vec n = arma::normalise(eigvec.col(arma::abs(eigval).index_min()).rows(0, 2));
-
-		// The normal is flipped to make sure it is facing the los
-		// or that it is consistently oriented with a previously computed normal
-		if (force_use_previous){
-			if (arma::dot(n, this -> output_pc.get_point(i).get_normal_coordinates()) < 0) {
-				this -> output_pc.get_point(i).set_normal_coordinates(n);
-			}
-			else {
-				this -> output_pc.get_point(i).set_normal_coordinates(-n);
-			}
-		}
-		else{
-			if (arma::dot(n, this -> los_dir) < 0) {
-				this -> output_pc.get_point(i).set_normal_coordinates(n);
-			}
-			else {
-				this -> output_pc.get_point(i).set_normal_coordinates(-n);
-			}
-		}
+		covariance *= 1./(size - 1) ;
+
+		double * coefficients = covariances.data() + 6 * i;
+		coefficients[0] = covariance(0,0);
+		coefficients[1] = covariance(0,1);
+		coefficients[2] = covariance(0,2);
+		coefficients[3] = covariance(1,1);
+		coefficients[4] = covariance(1,2);
+		coefficients[5] = covariance(2,2);
 
+	}
+
+	// The eigenvalue problems are solved
+	std::vector<double> eigenvalues(3 * N);
+	std::vector<double> eigenvectors(9 * N);
+
+	unsigned int N_chunks = (N + SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE - 1) / SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE;
+
+	#pragma omp parallel for
+	for (unsigned int chunk = 0; chunk < N_chunks; ++chunk){
+		unsigned int begin = chunk * SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE;
+		unsigned int size = std::min(N - begin,(unsigned int)(SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE));
+		SymmetricEigenSolver::compute(size,covariances.data() + 6 * begin,
+			eigenvalues.data() + 3 * begin,eigenvectors.data() + 9 * begin);
+	}
 
+	// The covariances are positive semi-definite, so the normal is the eigenvector
+	// of the first eigenvalue
+	#pragma omp parallel for
+	for (unsigned int i = 0; i < N; ++i) {
+		this -> set_oriented_normal(i,arma::vec::fixed<3>(eigenvectors.data() + 9 * i),force_use_previous);
 	}
 	
 }
 
 
 template <>
-void EstimationNormals<PointNormal,PointNormal>::estimate(double radius,bool force_use_previous){
-	
-	#pragma omp parallel for 
-	for (unsigned int i = 0; i < this -> input_pc .  size(); ++i) {
+void EstimationNormals<PointNormal,PointNormal>::estimate_organized(unsigned int half_window,bool force_use_previous){
 
-		// Get the N nearest neighbors to this point
+	if (!this -> input_pc.is_organized()){
+		throw(std::runtime_error("EstimationNormals::estimate_organized: the point cloud is not organized"));
+	}
 
-		auto closest_points = this -> input_pc.get_nearest_neighbors_radius(this -> input_pc.get_point_coordinates(i), radius);
+	int rows = static_cast<int>(this -> input_pc.get_organized_rows());
+	int cols = static_cast<int>(this -> input_pc.get_organized_cols());
+	int h = static_cast<int>(half_window);
 
-		arma::mat::fixed<3,3> covariance = arma::zeros<arma::mat>(3,3);
-		arma::vec::fixed<3> centroid = {0,0,0};
+	// The points are centered on one of them to limit the cancellations in the covariances
+	arma::vec::fixed<3> reference = arma::zeros<arma::vec>(3);
+	if (this -> input_pc.size() > 0){
+		reference = this -> input_pc.get_point_coordinates(0);
+	}
+
+	// Integral images of the number of points and of their first and second moments, with a leading row and column of zeros.
+	// Entry (r,c) holds the sums over the pixels of rows < r and columns < c
+	const int N_channels = 10;
+	std::vector<double> integral(N_channels * (rows + 1) * (cols + 1),0.);
+
+	#pragma omp parallel for
+	for (int c = 0; c < cols; ++c){
+
+		double * column = integral.data() + N_channels * (c + 1) * (rows + 1);
 
-		int size = closest_points.size();
-		for (auto it = closest_points.begin(); it != closest_points.end(); ++it) {
-			centroid += this -> input_pc.get_point_coordinates(*it)/size;
+		for (int r = 0; r < rows; ++r){
+
+			double * sums = column + N_channels * (r + 1);
+			std::copy(sums - N_channels,sums,sums);
+
+			int index = this -> input_pc.get_organized_index(r,c);
+			if (index < 0){
+				continue;
+			}
+
+			arma::vec::fixed<3> p = this -> input_pc.get_point_coordinates(index) - reference;
+
+			sums[0] += 1;
+			sums[1] += p(0);
+			sums[2] += p(1);
+			sums[3] += p(2);
+			sums[4] += p(0) * p(0);
+			sums[5] += p(0) * p(1);
+			sums[6] += p(0) * p(2);
+			sums[7] += p(1) * p(1);
+			sums[8] += p(1) * p(2);
+			sums[9] += p(2) * p(2);
 		}
+	}
 
-		for (auto it = closest_points.begin(); it != closest_points.end(); ++it) {
-			const arma::vec & p = this -> input_pc.get_point_coordinates(*it);
-			covariance += 1./(size - 1) * (p - centroid) * (p - centroid).t();
+	#pragma omp parallel for
+	for (int r = 1; r <= rows; ++r){
+		for (int c = 2; c <= cols; ++c){
+			double * sums = integral.data() + N_channels * (c * (rows + 1) + r);
+			const double * previous_sums = integral.data() + N_channels * ((c - 1) * (rows + 1) + r);
+			for (int k = 0; k < N_channels; ++k){
+				sums[k] += previous_sums[k];
+			}
 		}
+	}
+
+	// Points whose window holds fewer than 3 points (at the edges of the target or around dropouts)
+	std::vector<char> is_sparse(this -> input_pc.size(),0);
 
-		// The eigenvalue problem is solved
-		arma::vec eigval;
-		arma::mat eigvec;
+	#pragma omp parallel for
+	for (int c = 0; c < cols; ++c){
+		for (int r = 0; r < rows; ++r){
+
+			int index = this -> input_pc.get_organized_index(r,c);
+			if (index < 0){
+				continue;
+			}
 
-		arma::eig_sym(eigval, eigvec, covariance);
-		arma::vec n = arma::normalise(eigvec.col(arma::abs(eigval).index_min()).rows(0, 2));
+			int r_min = std::max(r - h,0);
+			int r_max = std::min(r + h + 1,rows);
+			int c_min = std::max(c - h,0);
+			int c_max = std::min(c + h + 1,cols);
 
-		// The normal is flipped to make sure it is facing the los
-		if (force_use_previous){
+			const double * s_11 = integral.data() + N_channels * (c_max * (rows + 1) + r_max);
+			const double * s_01 = integral.data() + N_channels * (c_min * (rows + 1) + r_max);
+			const double * s_10 = integral.data() + N_channels * (c_max * (rows + 1) + r_min);
+			const double * s_00 = integral.data() + N_channels * (c_min * (rows + 1) + r_min);
 
-			if (arma::dot(n, this -> output_pc.get_point(i).get_normal_coordinates()) < 0) {
-				this -> output_pc.get_point(i).set_normal_coordinates(n);
+			double sums[N_channels];
+			for (int k = 0; k < N_channels; ++k){
+				sums[k] = s_11[k] - s_01[k] - s_10[k] + s_00[k];
 			}
-			else {
-				this -> output_pc.get_point(i).set_normal_coordinates(-n);
+
+			double N = sums[0];
+			if (N < 3){
+				is_sparse[index] = 1;
+				continue;
 			}
 
+			double mean[3] = {sums[1] / N,sums[2] / N,sums[3] / N};
+			double covariance[6] = {
+				(sums[4] - N * mean[0] * mean[0]) / (N - 1),
+				(sums[5] - N * mean[0] * mean[1]) / (N - 1),
+				(sums[6] - N * mean[0] * mean[2]) / (N - 1),
+				(sums[7] - N * mean[1] * mean[1]) / (N - 1),
+				(sums[8] - N * mean[1] * mean[2]) / (N - 1),
+				(sums[9] - N * mean[2] * mean[2]) / (N - 1)
+			};
+
+			double eigenvalues[3];
+			double eigenvectors[9];
+			SymmetricEigenSolver::compute(covariance,eigenvalues,eigenvectors);
+
+			this -> set_oriented_normal(index,arma::vec::fixed<3>(eigenvectors),force_use_previous);
 		}
-		else{
-			if (arma::dot(n, this -> los_dir) < 0) {
-				this -> output_pc.get_point(i).set_normal_coordinates(n);
-			}
-			else {
-				this -> output_pc.get_point(i).set_normal_coordinates(-n);
-			}
+	}
+
+	std::vector<int> sparse_points;
+	for (unsigned int i = 0; i < is_sparse.size(); ++i){
+		if (is_sparse[i]){
+			sparse_points.push_back(i);
+		}
+	}
+
+	if (sparse_points.size() == 0){
+		return;
+	}
+
+	// The normals of these points are estimated from as many of their closest points as a full window holds
+	if (!this -> input_pc.has_kdtree()){
+		throw(std::runtime_error("EstimationNormals::estimate_organized: the KD Tree of the point cloud must be built to estimate the normals of the points whose window holds fewer than 3 points"));
+	}
+
+	unsigned int N_neighbors = std::min((2 * half_window + 1) * (2 * half_window + 1),this -> input_pc.size());
+	if (N_neighbors < 3){
+		throw(std::runtime_error("EstimationNormals::estimate_organized: the point cloud holds fewer than 3 points"));
+	}
+
+	#pragma omp parallel
+	{
+
+	// Neighbor buffers, allocated once per thread
+	std::vector<int> closest_indices(N_neighbors);
+	std::vector<double> closest_distances(N_neighbors);
+
+	#pragma omp for
+	for (unsigned int k = 0; k < sparse_points.size(); ++k){
+
+		int index = sparse_points[k];
+		unsigned int N_found = this -> input_pc.get_closest_N_points(this -> input_pc.get_point_coordinates(index),
+			N_neighbors,closest_indices.data(),closest_distances.data());
+
+		double sums[N_channels] = {0,0,0,0,0,0,0,0,0,0};
+		for (unsigned int j = 0; j < N_found; ++j){
+			arma::vec::fixed<3> p = this -> input_pc.get_point_coordinates(closest_indices[j]) - reference;
+			sums[1] += p(0);
+			sums[2] += p(1);
+			sums[3] += p(2);
+			sums[4] += p(0) * p(0);
+			sums[5] += p(0) * p(1);
+			sums[6] += p(0) * p(2);
+			sums[7] += p(1) * p(1);
+			sums[8] += p(1) * p(2);
+			sums[9] += p(2) * p(2);
 		}
 
+		double N = N_found;
+		double mean[3] = {sums[1] / N,sums[2] / N,sums[3] / N};
+		double covariance[6] = {
+			(sums[4] - N * mean[0] * mean[0]) / (N - 1),
+			(sums[5] - N * mean[0] * mean[1]) / (N - 1),
+			(sums[6] - N * mean[0] * mean[2]) / (N - 1),
+			(sums[7] - N * mean[1] * mean[1]) / (N - 1),
+			(sums[8] - N * mean[1] * mean[2]) / (N - 1),
+			(sums[9] - N * mean[2] * mean[2]) / (N - 1)
+		};
+
+		double eigenvalues[3];
+		double eigenvectors[9];
+		SymmetricEigenSolver::compute(covariance,eigenvalues,eigenvectors);
+
+		this -> set_oriented_normal(index,arma::vec::fixed<3>(eigenvectors),force_use_previous);
+	}
 
 	}
+
+}
+
+
+template <>
+void EstimationNormals<PointNormal,PointNormal>::estimate(int N_neighbors,bool force_use_previous){
 	
+	// Get the N nearest neighbors to each point
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_N(N_neighbors,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
+	
+}
+
+
+template <>
+void EstimationNormals<PointNormal,PointNormal>::estimate(double radius,bool force_use_previous){
+	
+	// Get the neighbors within the prescribed radius of each point
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_radius(radius,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
+	
+}
+
+
+template <class T,class U>
+void EstimationNormals<T,U>::set_oriented_normal(unsigned int i,const arma::vec::fixed<3> & n,bool force_use_previous){
+
+	// The normal is flipped to make sure it is facing the los
+	// or that it is consistently oriented with a previously computed normal
+	if (force_use_previous){
+		if (arma::dot(n, this -> output_pc.get_point(i).get_normal_coordinates()) < 0) {
+			this -> output_pc.get_point(i).set_normal_coordinates(n);
+		}
+		else {
+			this -> output_pc.get_point(i).set_normal_coordinates(-n);
+		}
+	}
+	else{
+		if (arma::dot(n, this -> los_dir) < 0) {
+			this -> output_pc.get_point(i).set_normal_coordinates(n);
+		}
+		else {
+			this -> output_pc.get_point(i).set_normal_coordinates(-n);
+		}
+	}
+
 }
 
 
@@ -9,15 +9,29 @@ EstimationPFH<T,U>::EstimationPFH(const PointCloud<T> & input_pc,PointCloud<U> &
 template<class T,class U>
 void EstimationPFH<T,U>::estimate(double radius_neighbors,bool force_use_previous){
 
-	unsigned int size = this -> input_pc. size();
-	assert(size == this -> output_pc.size());
 	if (radius_neighbors < 0){
 		throw(std::runtime_error("neighborhood_radius is negative"));
 	}
 
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_radius(radius_neighbors,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
+}
+
+template<class T,class U>
+void EstimationPFH<T,U>::estimate(const PointNeighborhoods & neighborhoods,bool force_use_previous){
+
+	unsigned int size = this -> input_pc. size();
+	assert(size == this -> output_pc.size());
+
+	// The descriptors are written to from concurrent threads, so their size is set beforehand
+	this -> output_pc.set_descriptor_size(3 * this -> N_bins);
+
 	#pragma omp parallel for
 	for (unsigned int i = 0; i < size; ++i) {
-		std::vector<int> neighborhood = this -> input_pc.get_nearest_neighbors_radius(this -> input_pc.get_point_coordinates(i),radius_neighbors);
+		std::vector<int> neighborhood(neighborhoods.get_neighbors(i),
+			neighborhoods.get_neighbors(i) + neighborhoods.get_N_neighbors(i));
 		this -> output_pc[i] = PFH(neighborhood,this -> N_bins,this -> input_pc);
 	}	
 }
@@ -30,7 +44,11 @@ void EstimationPFH<T,U>::set_N_bins(int N_bins){
 
 template<class T,class U>
 void EstimationPFH<T,U>::estimate(int N_neighbors,bool force_use_previous){
-	throw(std::runtime_error("EstimationPFH<T,U>::estimate(int N_neighbors) is not implemented"));
+
+	PointNeighborhoods neighborhoods;
+	this -> input_pc.compute_neighborhoods_N(N_neighbors,neighborhoods);
+
+	this -> estimate(neighborhoods,force_use_previous);
 }
 
 
@@ -4,7 +4,7 @@
 
 
 FPFH::FPFH(const int & query_point,
-	const std::vector<std::vector<int> > & points,
+	const PointNeighborhoods & neighborhoods,
 	const std::vector<SPFH> & spfhs,
 	const PointCloud<PointNormal> & pc,
 	bool scale_distance,
@@ -25,11 +25,15 @@ FPFH::FPFH(const int & query_point,
 		distance_to_closest_neighbor = 1.;
 	}
 	
-	for (unsigned int k = 0 ; k < points[query_point].size(); ++k){
-		double distance = arma::norm(pc.get_point_coordinates(query_point)- pc.get_point_coordinates(points[query_point][k]));
+	unsigned int N_neighbors = neighborhoods.get_N_neighbors(query_point);
+	const int * points = neighborhoods.get_neighbors(query_point);
+	const double * squared_distances = neighborhoods.get_squared_distances(query_point);
+
+	for (unsigned int k = 0 ; k < N_neighbors; ++k){
+		double distance = std::sqrt(squared_distances[k]);
 		
 		if (distance>0){
-			this -> histogram += distance_to_closest_neighbor * spfhs[points[query_point][k]]. get_histogram() / ( distance * points[query_point].size());
+			this -> histogram += distance_to_closest_neighbor * spfhs[points[k]]. get_histogram() / ( distance * N_neighbors);
 		}
 
 	}
@@ -50,7 +54,7 @@ FPFH::FPFH(const int & query_point,
 
 	if (this -> histogram.has_nan()){
 		throw(std::runtime_error("FPFH for point " + std::to_string(query_point) 
-			+ " has nans. Query point had " + std::to_string(points[query_point].size()) + " neighbors"));
+			+ " has nans. Query point had " + std::to_string(N_neighbors) + " neighbors"));
 	}
 	
 
@@ -15,15 +15,24 @@ FeatureMatching<T>::FeatureMatching(const PointCloud<T> & pc1, PointCloud<T> & p
 template <class T>
 void FeatureMatching<T>::match(std::map<int , std::vector< int > > & matches,const int & N){
 
-	// The kd tree in pc2 is recomputed
-	this -> pc2.build_kdtree(false);
+	// The features of pc2 are indexed. The exact search compares all of them, so it needs a single tree
+	DescriptorIndex index(this -> max_checks == 0 ? 1 : DESCRIPTOR_INDEX_N_TREES,this -> max_checks);
+	index.build(this -> pc2);
 
 	std::vector<std::vector< int > > matches_temp;
 
 	matches_temp.resize(pc1.size());
 	
 	// Each active features in pc1 is matched to its N closest neighbors (that are also active?) in pc2
-	#pragma omp parallel for
+	#pragma omp parallel
+	{
+
+	// Neighbor and query buffers, allocated once per thread
+	std::vector<int> closest_indices(N);
+	std::vector<double> closest_distances(N);
+	std::vector<double> histogram(pc1.get_points().get_descriptor_size());
+
+	#pragma omp for
 	for (int i = 0; i < pc1.size(); ++i){
 		
 		// Skipping this feature if it is not active 
@@ -31,10 +40,12 @@ void FeatureMatching<T>::match(std::map<int , std::vector< int > > & matches,con
 			continue;
 		}
 
-		auto closest_N_points = pc2.get_closest_N_points(pc1.get_point(i).get_histogram(),N);
-		for (auto it = closest_N_points.begin(); it != closest_N_points.end(); ++it){
-			matches_temp[i].push_back(it -> second);
-		}
+		pc1.get_point(i).copy_histogram(histogram.data());
+		unsigned int N_found = index.closest_N_point_search(histogram.data(),N,
+			closest_indices.data(),closest_distances.data());
+		matches_temp[i].assign(closest_indices.begin(),closest_indices.begin() + N_found);
+	}
+
 	}
 
 	// Only the active features are kept
@@ -54,8 +65,9 @@ void FeatureMatching<T>::match(std::map<int , std::vector< int > > & matches,con
 template <class T>
 void FeatureMatching<T>::match(std::vector< PointPair >  & matches,const int & N){
 
-	// The kd tree in pc2 is recomputed
-	this -> pc2.build_kdtree(false);
+	// The features of pc2 are indexed. The exact search compares all of them, so it needs a single tree
+	DescriptorIndex index(this -> max_checks == 0 ? 1 : DESCRIPTOR_INDEX_N_TREES,this -> max_checks);
+	index.build(this -> pc2);
 
 	std::vector<std::vector< int > > matches_temp;
 
@@ -64,17 +76,27 @@ void FeatureMatching<T>::match(std::vector< PointPair >  & matches,const int & N
 
 
 	// Each active features in pc1 is matched to its N closest neighbors (that are also active) in pc2
-	#pragma omp parallel for
+	#pragma omp parallel
+	{
+
+	// Neighbor and query buffers, allocated once per thread
+	std::vector<int> closest_indices(N);
+	std::vector<double> closest_distances(N);
+	std::vector<double> histogram(this -> pc1.get_points().get_descriptor_size());
+
+	#pragma omp for
 	for (int i = 0; i < this -> pc1.size(); ++i){
 		// Skipping this feature if it is not active 
 		if (!this -> pc1.get_point(i).get_is_valid_feature()){
 			continue;
 		}
 
-		auto closest_N_points = this -> pc2.get_closest_N_points(this -> pc1.get_point(i).get_histogram(),N);
-		for (auto it = closest_N_points.begin(); it != closest_N_points.end(); ++it){
-			matches_temp[i].push_back(it -> second);
-		}
+		this -> pc1.get_point(i).copy_histogram(histogram.data());
+		unsigned int N_found = index.closest_N_point_search(histogram.data(),N,
+			closest_indices.data(),closest_distances.data());
+		matches_temp[i].assign(closest_indices.begin(),closest_indices.begin() + N_found);
+	}
+
 	}
 
 
@@ -92,6 +114,12 @@ void FeatureMatching<T>::match(std::vector< PointPair >  & matches,const int & N
 
 
 
+template <class T>
+void FeatureMatching<T>::set_max_checks(unsigned int max_checks){
+	this -> max_checks = max_checks;
+}
+
+
 template <>
 void FeatureMatching<PointNormal>::save_matches(std::string path,
 	const std::vector<PointPair> & matches,
@@ -128,11 +156,13 @@ void FeatureMatching<T>::greedy_pairing(
 	const PointCloud<PointNormal> & point_pc2,
 	const PointCloud<T> & descriptor_pc1,
 	PointCloud<T> & descriptor_pc2,
-	std::vector< PointPair > & matches){
+	std::vector< PointPair > & matches,
+	unsigned int max_checks){
 
 
-	// The kd tree in pc2 is recomputed
-	descriptor_pc2.build_kdtree(false);
+	// The features of pc2 are indexed. The exact search compares all of them, so it needs a single tree
+	DescriptorIndex index(max_checks == 0 ? 1 : DESCRIPTOR_INDEX_N_TREES,max_checks);
+	index.build(descriptor_pc2);
 	std::vector< std::pair<int, std::vector< int > > > matches_temp,matches_active_only;
 	matches_temp.resize(point_pc1.size());
 	
@@ -142,20 +172,32 @@ void FeatureMatching<T>::greedy_pairing(
 	#endif
 
 	// Each active features in pc1 is matched to its N closest neighbors (that are also active) in pc2
-	#pragma omp parallel for
+	#pragma omp parallel
+	{
+
+	// Neighbor and query buffers, allocated once per thread
+	std::vector<int> closest_indices(N_potential_correspondances);
+	std::vector<double> closest_distances(N_potential_correspondances);
+	std::vector<double> histogram(descriptor_pc1.get_points().get_descriptor_size());
+
+	#pragma omp for
 	for (int i = 0; i < descriptor_pc1.size(); ++i){
 		// Skipping this feature if it is not active 
 		if (!descriptor_pc1.get_point(i).get_is_valid_feature()){
 			continue;
 		}
 
-		auto closest_N_points = descriptor_pc2.get_closest_N_points(descriptor_pc1.get_point(i).get_histogram(),N_potential_correspondances);
-		for (auto it = closest_N_points.begin(); it != closest_N_points.end(); ++it){
+		descriptor_pc1.get_point(i).copy_histogram(histogram.data());
+		unsigned int N_found = index.closest_N_point_search(histogram.data(),N_potential_correspondances,
+			closest_indices.data(),closest_distances.data());
+		for (unsigned int k = 0; k < N_found; ++k){
 			matches_temp[i].first = i;
-			matches_temp[i].second.push_back(it -> second);
+			matches_temp[i].second.push_back(closest_indices[k]);
 		}
 	}
 
+	}
+
 	arma::ivec random_indices = arma::shuffle(arma::regspace<arma::ivec>(0,matches_temp.size() - 1));
 
 	for (int i = 0; i < matches_temp.size(); ++i){
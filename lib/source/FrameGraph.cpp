@@ -1,4 +1,5 @@
 #include "FrameGraph.hpp"
+#include <algorithm>
 
 FrameGraph::FrameGraph() {
 
@@ -7,14 +8,139 @@ FrameGraph::FrameGraph() {
 arma::vec FrameGraph::convert(arma::vec input, std::string from, std::string to,
                               bool is_unit_vector) {
 
-	std::deque<std::shared_ptr<RefFrame > > path = this -> adjacency_list.dfs(
-	            ref_names_to_ref_ptrs[from], ref_names_to_ref_ptrs[to]);
+	if (from == to) {
+		return input;
+	}
+
+	return this -> convert(input, this -> get_frame_handle(from),
+	                       this -> get_frame_handle(to), is_unit_vector);
+}
+
+
+arma::vec FrameGraph::convert(const arma::vec & input, int from, int to,
+                              bool is_unit_vector) {
+
+	if (from == to) {
+		return input;
+	}
+
+	const TransformChain & chain = this -> get_transform_chain(from, to);
+
+	if (is_unit_vector == false) {
+		return chain.dcm * input + chain.origin;
+	}
+	else {
+		return chain.dcm * input;
+	}
+}
+
+
+arma::mat FrameGraph::convert_batch(const arma::mat & input, std::string from, std::string to,
+                                    bool is_unit_vector) {
+
+	if (input.n_rows != 3) {
+		throw (std::runtime_error("FrameGraph::convert_batch expects a 3 x N matrix"));
+	}
+
+	if (from == to) {
+		return input;
+	}
+
+	const TransformChain & chain = this -> get_transform_chain(this -> get_frame_handle(from),
+	                               this -> get_frame_handle(to));
+
+	arma::mat coords = chain.dcm * input;
+
+	if (is_unit_vector == false) {
+		coords.each_col() += chain.origin;
+	}
+
+	return coords;
+}
+
+
+void FrameGraph::get_transform(std::string from, std::string to,
+                               arma::mat::fixed<3, 3> & dcm,
+                               arma::vec::fixed<3> & origin) {
+
+	this -> get_transform(this -> get_frame_handle(from), this -> get_frame_handle(to), dcm, origin);
+
+}
+
+
+void FrameGraph::get_transform(int from, int to,
+                               arma::mat::fixed<3, 3> & dcm,
+                               arma::vec::fixed<3> & origin) {
+
+	const TransformChain & chain = this -> get_transform_chain(from, to);
+
+	dcm = chain.dcm;
+	origin = chain.origin;
+
+}
+
+
+int FrameGraph::get_frame_handle(std::string frame_name) const {
+
+	auto it = this -> ref_names_to_handles.find(frame_name);
+
+	if (it == this -> ref_names_to_handles.end()) {
+		throw (std::runtime_error("The reference frame name '" + frame_name + "' was not found in the graph"));
+	}
+
+	return it -> second;
+}
+
+
+void FrameGraph::set_use_transform_cache(bool use_transform_cache) {
+	this -> use_transform_cache = use_transform_cache;
+	this -> invalidate_transform_chains();
+}
+
+
+const FrameGraph::TransformChain & FrameGraph::get_transform_chain(int from, int to) {
+
+	int N_frames = this -> handles_to_ref_ptrs.size();
+
+	if (from < 0 || to < 0 || from >= N_frames || to >= N_frames) {
+		throw (std::runtime_error("Invalid reference frame handle"));
+	}
+
+	TransformChain & chain = this -> transform_chains[from * N_frames + to];
+
+	if (!this -> use_transform_cache || !this -> is_transform_chain_current(chain)) {
+		this -> compile_transform_chain(from, to, chain);
+	}
+
+	return chain;
+
+}
+
+
+void FrameGraph::compile_transform_chain(int from, int to, TransformChain & chain) {
+
+	chain.dcm = arma::eye<arma::mat>(3, 3);
+	chain.origin.zeros();
+	chain.frames.clear();
+	chain.revisions.clear();
+	chain.compiled = true;
 
-	arma::vec coords = input;
 	if (from == to) {
-		return coords;
+		return;
 	}
 
+	std::deque<std::shared_ptr<RefFrame > > path = this -> adjacency_list.dfs(
+	            this -> handles_to_ref_ptrs[from], this -> handles_to_ref_ptrs[to]);
+
+	if (path.size() == 0) {
+		chain.compiled = false;
+		throw (std::runtime_error("No path connects the reference frames '"
+		                          + this -> handles_to_ref_ptrs[from] -> get_name() + "' and '"
+		                          + this -> handles_to_ref_ptrs[to] -> get_name() + "'"));
+	}
+
+	// Each step of the path is an affine map x -> A * x + b
+	// composed on the left of the transform accumulated so far
 	for (auto it_current_frame = path.begin();
 	        it_current_frame != --path.end();
 	        ++it_current_frame) {
@@ -23,26 +149,74 @@ arma::vec FrameGraph::convert(arma::vec input, std::string from, std::string to,
 
 		std::pair<std::string, std::string> transform = this -> adjacency_list.getedge(*it_current_frame, *it_next_frame);
 
+		RefFrame * child_frame;
+
 		// current frame is parent frame
 		if (transform.second == (*it_next_frame) -> get_name()) {
-			this -> convert_to_child_of_provided_parent_frame(coords, (*it_next_frame).get(),
-			        is_unit_vector);
+			child_frame = (*it_next_frame).get();
+
+			const arma::mat & A = *child_frame -> get_dcm_from_parent();
+			const arma::vec & b = *child_frame -> get_origin_from_parent();
+
+			chain.dcm = A * chain.dcm;
+			chain.origin = A * (chain.origin - b);
 		}
 
 		// current frame is child frame
 		else if (transform.first == (*it_next_frame) -> get_name()) {
+			child_frame = (*it_current_frame).get();
+
+			const arma::mat & A = *child_frame -> get_dcm_from_parent();
+			const arma::vec & b = *child_frame -> get_origin_from_parent();
 
-			this -> convert_to_parent_of_provided_child_frame(coords, (*it_current_frame).get(),
-			        is_unit_vector);
+			chain.dcm = A.t() * chain.dcm;
+			chain.origin = b + A.t() * chain.origin;
 		}
 		else {
+			chain.compiled = false;
 			throw (std::runtime_error("Illegal frame conversion"));
 		}
 
+		chain.frames.push_back(child_frame);
+		chain.revisions.push_back(child_frame -> get_revision());
 
 	}
 
-	return coords;
+}
+
+
+bool FrameGraph::is_transform_chain_current(const TransformChain & chain) const {
+
+	if (!chain.compiled) {
+		return false;
+	}
+
+	// The frames may also have been edited directly through get_frame
+	for (unsigned int i = 0; i < chain.frames.size(); ++i) {
+		if (chain.frames[i] -> get_revision() != chain.revisions[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+void FrameGraph::invalidate_transform_chains(const RefFrame * ref_frame) {
+
+	for (auto & chain : this -> transform_chains) {
+		if (chain.compiled && std::find(chain.frames.begin(), chain.frames.end(), ref_frame) != chain.frames.end()) {
+			chain.compiled = false;
+		}
+	}
+}
+
+
+void FrameGraph::invalidate_transform_chains() {
+
+	for (auto & chain : this -> transform_chains) {
+		chain.compiled = false;
+	}
 }
 
 
@@ -86,6 +260,13 @@ void FrameGraph::add_frame(std::string frame_name) {
 
 	this -> adjacency_list.addvertex(frame);
 	this -> ref_names_to_ref_ptrs[frame_name] = frame;
+	this -> ref_names_to_handles[frame_name] = this -> handles_to_ref_ptrs.size();
+	this -> handles_to_ref_ptrs.push_back(frame);
+
+	// The chain table is indexed by pairs of handles and must be resized
+	unsigned int N_frames = this -> handles_to_ref_ptrs.size();
+	this -> transform_chains.clear();
+	this -> transform_chains.resize(N_frames * N_frames);
 }
 
 
@@ -102,6 +283,7 @@ void FrameGraph::set_transform_mrp(std::string parent_name,
 
 			if (transform.second == child_name) {
 				this -> ref_names_to_ref_ptrs[child_name]-> set_mrp_from_parent(mrp) ;
+				this -> invalidate_transform_chains(this -> ref_names_to_ref_ptrs[child_name].get());
 				return;
 			}
 		}
@@ -131,6 +313,7 @@ void FrameGraph::set_transform_origin(std::string parent_name,
 
 			if (transform.second == child_name) {
 				this -> ref_names_to_ref_ptrs[child_name]-> set_origin_from_parent(origin) ;
+				this -> invalidate_transform_chains(this -> ref_names_to_ref_ptrs[child_name].get());
 				return;
 			}
 		}
@@ -217,5 +400,8 @@ void FrameGraph::add_transform(std::string parent_name, std::string child_name)
 	std::pair<std::string, std::string> transform_name = std::make_pair(parent_name, child_name);
 	this -> adjacency_list.addedge(parent_frame, child_frame, transform_name);
 
+	// A new edge may open shorter paths between any pair of frames
+	this -> invalidate_transform_chains();
+
 
 }
\ No newline at end of file
@@ -40,7 +40,8 @@ void IterativeClosestPoint::compute_pairs(
 		int N_pairs_max = (int)(std::pow(2, std::max(p - h,0.)));
 
 		arma::ivec random_source_indices = arma::linspace<arma::ivec>(0,source_pc.size() - 1,source_pc. size());
-		random_source_indices = arma::shuffle(random_source_indices);
+		Philox rng(PHILOX_DOMAIN_ICP_SAMPLING,this -> N_pairings,0);
+		rng.shuffle(random_source_indices);
 
 		for (int i = 0; i < N_pairs_max; ++i){
 			this -> point_pairs.push_back(std::make_pair<int,int>(random_source_indices(i),random_source_indices(i)));
@@ -49,9 +50,12 @@ void IterativeClosestPoint::compute_pairs(
 
 	}
 	else{
-		IterativeClosestPoint::compute_pairs(source_pc,destination_pc,this -> point_pairs,h, dcm,x);
+		IterativeClosestPoint::compute_pairs(source_pc,destination_pc,this -> point_pairs,h, dcm,x,
+			arma::eye<arma::mat>(3,3),arma::zeros<arma::vec>(3),this -> N_pairings);
 	}
 
+	++this -> N_pairings;
+
 }
 
 void IterativeClosestPoint::compute_pairs(
@@ -62,7 +66,9 @@ void IterativeClosestPoint::compute_pairs(
 	const arma::mat::fixed<3,3> & dcm_S ,
 	const arma::vec::fixed<3> & x_S ,
 	const arma::mat::fixed<3,3> & dcm_D ,
-	const arma::vec::fixed<3> & x_D ){
+	const arma::vec::fixed<3> & x_D ,
+	unsigned int sampling_iteration,
+	unsigned int sampling_stream){
 
 	point_pairs.clear();
 
@@ -83,7 +89,8 @@ void IterativeClosestPoint::compute_pairs(
 
 	// a maximum of $N_pairs_max pairs will be formed. $N_points points are extracted from the source point cloud	
 	arma::uvec random_source_indices = arma::linspace<arma::uvec>(0, source_pc . size() - 1,source_pc . size());
-	random_source_indices = arma::shuffle(random_source_indices);
+	Philox rng(PHILOX_DOMAIN_ICP_SAMPLING,sampling_iteration,sampling_stream);
+	rng.shuffle(random_source_indices);
 	std::vector<PointPair> destination_source_dist_vector;
 
 	for (int i = 0; i < N_pairs_max; ++i) {
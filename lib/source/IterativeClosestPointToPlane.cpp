@@ -40,7 +40,8 @@ void IterativeClosestPointToPlane::compute_pairs(
 
 		arma::ivec random_source_indices = arma::linspace<arma::ivec>(0, source_pc . size() - 1,source_pc . size());
 		if (h != 0){
-			random_source_indices = arma::shuffle(random_source_indices);
+			Philox rng(PHILOX_DOMAIN_ICP_SAMPLING,this -> N_pairings,0);
+			rng.shuffle(random_source_indices);
 		}
 		for (int i = 0; i < N_pairs_max_from_source; ++i){
 			this -> point_pairs.push_back(std::make_pair<int,int>(random_source_indices(i),random_source_indices(i)));
@@ -49,9 +50,12 @@ void IterativeClosestPointToPlane::compute_pairs(
 
 	}
 	else{
-		IterativeClosestPointToPlane::compute_pairs(source_pc,destination_pc,this -> point_pairs,h, dcm,x);
+		IterativeClosestPointToPlane::compute_pairs(source_pc,destination_pc,this -> point_pairs,h, dcm,x,
+			arma::eye<arma::mat>(3,3),arma::zeros<arma::vec>(3),this -> N_pairings);
 	}
 
+	++this -> N_pairings;
+
 }
 
 void IterativeClosestPointToPlane::compute_pairs(
@@ -62,7 +66,9 @@ void IterativeClosestPointToPlane::compute_pairs(
 	const arma::mat::fixed<3,3> & dcm_S ,
 	const arma::vec::fixed<3> & x_S ,
 	const arma::mat::fixed<3,3> & dcm_D ,
-	const arma::vec::fixed<3> & x_D ){
+	const arma::vec::fixed<3> & x_D ,
+	unsigned int sampling_iteration,
+	unsigned int sampling_stream){
 
 
 	point_pairs.clear();
@@ -93,7 +99,11 @@ void IterativeClosestPointToPlane::compute_pairs(
 
 	// a maximum of $N_pairs_max_from_source pairs will be formed. $N_points points are extracted from the source point cloud	
 
-		arma::ivec random_source_indices = arma::randi<arma::ivec>(N_pairs_max_from_source,arma::distr_param(0,source_pc . size() - 1));
+		Philox rng(PHILOX_DOMAIN_ICP_SAMPLING,sampling_iteration,sampling_stream);
+		arma::ivec random_source_indices(N_pairs_max_from_source);
+		for (int i = 0; i < N_pairs_max_from_source; ++i){
+			random_source_indices(i) = rng.uniform_int(source_pc . size());
+		}
 
 
 		for (int i = 0; i < N_pairs_max_from_source; ++i) {
@@ -182,7 +192,11 @@ void IterativeClosestPointToPlane::compute_pairs(
 		#endif
 		// a maximum of $N_pairs_max_from_destination pairs will be formed. $N_points points are extracted from the destination point cloud	
 
-		arma::ivec random_destination_indices = arma::randi<arma::ivec>(N_pairs_max_from_destination,arma::distr_param(0,destination_pc . size() - 1));
+		Philox rng(PHILOX_DOMAIN_ICP_SAMPLING,sampling_iteration,sampling_stream);
+		arma::ivec random_destination_indices(N_pairs_max_from_destination);
+		for (int i = 0; i < N_pairs_max_from_destination; ++i){
+			random_destination_indices(i) = rng.uniform_int(destination_pc . size());
+		}
 
 		for (int i = 0; i < N_pairs_max_from_destination; ++i) {
 			PointPair destination_source_dist_pair = std::make_pair(random_destination_indices(i),-1);
@@ -5,601 +5,441 @@
 #include <ShapeModel.hpp>
 #include <ControlPoint.hpp>
 
+#include <algorithm>
+#include <numeric>
 
 
-#define KDTTREE_DEBUG_FLAG 0
-#define KDTREE_BUILD_DEBUG 0
-#define KDTTREE_CLOSEST_N_POINT_SEARCH_DEBUG_FLAG 0
-#define KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG 0
-#define KDTTREE_CLOSEST_POINT_SEARCH_DEBUG_FLAG 0
-
-template <template<class> class ContainerType, class PointType>
-void KDTree<ContainerType,PointType>::set_depth(int depth) {
-	this -> depth = depth;
-}
-
-template <template<class> class ContainerType, class PointType>
-double KDTree<ContainerType,PointType>::get_value() const {
-	return this -> value;
-}
-
-template <template<class> class ContainerType, class PointType>
-unsigned int KDTree<ContainerType,PointType>::get_axis() const {
-	return this -> axis;
-}
-
-template <template<class> class ContainerType, class PointType>
-void KDTree<ContainerType,PointType>::set_value(double value) {
-	this -> value = value;
-}
-template <template<class> class ContainerType, class PointType> void KDTree<ContainerType,PointType>::set_axis(unsigned int axis) {
-this -> axis = axis;
-}
-
-
-template <template<class> class ContainerType, class PointType>
-void KDTree<ContainerType,PointType>::closest_point_search(const arma::vec & test_point,
-	const std::shared_ptr<KDTree> & node,
-	int & best_guess_index,
-	double & distance,
-	const ContainerType<PointType> * owner) const {
-
-
-	#if KDTTREE_CLOSEST_POINT_SEARCH_DEBUG_FLAG
-	std::cout << "#############################\n";
-	std::cout << "Depth: " << this -> depth << std::endl; ;
-	std::cout << "Points in node: " << node -> indices.size() << std::endl;
-	std::cout << "Best guess index so far : " << best_guess_index << " at distance " << distance << std::endl;
-	
-	#endif
-
-	// If the left child of this node is nullptr, so is the right
-	// and we have a leaf node
-	if (node -> left == nullptr) {
-		#if KDTTREE_CLOSEST_POINT_SEARCH_DEBUG_FLAG
-		std::cout << "Leaf node\n";
-		#endif
-		KDTree<ContainerType,PointType>::search_node(test_point,node,best_guess_index,distance,owner);
-		
-
-	}
 
-	else {
-
-		bool search_left_first;
+#define KDTREE_BUILD_DEBUG 0
 
-		if (test_point(node -> get_axis()) <= node -> get_value()) {
-			search_left_first = true;
-		}
-		else {
-			search_left_first = false;
-		}
 
-		if (search_left_first) {
+// The tree compares squared distances between points, and descriptor distances between descriptors
 
+template <>
+double KDTree<PointCloud,PointNormal>::metric(const double * point_in_tree,
+	const double * point) const{
 
+	double dx = point[0] - point_in_tree[0];
+	double dy = point[1] - point_in_tree[1];
+	double dz = point[2] - point_in_tree[2];
 
-			if (test_point(node -> get_axis()) - distance <= node -> get_value()) {
-				node -> closest_point_search(test_point,
-					node -> left,
-					best_guess_index,
-					distance,
-					owner);
-			}
+	return dx * dx + dy * dy + dz * dz;
 
-			if (test_point(node -> get_axis()) + distance > node -> get_value()) {
-				node -> closest_point_search(test_point,
-					node -> right,
-					best_guess_index,
-					distance,
-					owner);
-			}
-
-		}
+}
 
-		else {
+template <>
+double KDTree<PointCloud,PointDescriptor>::metric(const double * point_in_tree,
+	const double * point) const{
 
-			if (test_point(node -> get_axis()) + distance > node -> get_value()) {
-				node -> closest_point_search(test_point,
-					node -> right,
-					best_guess_index,
-					distance,
-					owner);
-			}
+	// Same as PointDescriptor::distance_to_descriptor
+	double distance = 0;
 
-			if (test_point(node -> get_axis()) - distance <= node -> get_value()) {
-				node -> closest_point_search(test_point,
-					node -> left,
-					best_guess_index,
-					distance,
-					owner);
-			}
+	for (int i = 0; i < this -> dimension; ++i){
+		double pi = point_in_tree[i];
+		double qi = point[i];
 
+		if (pi > 0 || qi > 0){
+			distance += std::pow(pi - qi,2)/(pi + qi);
 		}
-
 	}
-
-	#if KDTTREE_CLOSEST_N_POINT_SEARCH_DEBUG_FLAG
-	std::cout << "#############################\n";
-	std::cout << " Leaving "<<  std::endl; ;
-	std::cout << "Best guess index: " << best_guess_index << " at distance " << distance << std::endl;
-	#endif
-
+	return distance;
 
 }
 
-template <template<class> class ContainerType, class PointType> 
-void KDTree<ContainerType,PointType>::closest_N_point_search(const arma::vec & test_point,
-	const unsigned int & N_points,
-	const std::shared_ptr<KDTree> & node,
-	double & distance,
-	std::map<double,int > & closest_points,
-	const ContainerType<PointType> * owner) const{
-
-	#if KDTTREE_CLOSEST_N_POINT_SEARCH_DEBUG_FLAG
-	std::cout << "#############################\n";
-	std::cout << "Depth: " << this -> depth << std::endl; ;
-	std::cout << "Points in node: " << node -> indices.size() << std::endl;
-	std::cout << "Points found so far : " << closest_points.size() << std::endl;
-	#endif
-
-	// DEPRECATED
-	if (node -> left == nullptr) {
-
-		#if KDTTREE_CLOSEST_N_POINT_SEARCH_DEBUG_FLAG
-		std::cout << "Leaf node\n";
-		#endif
-
-		KDTree<ContainerType,PointType>::search_node(test_point,N_points,node,distance,closest_points,owner);
-
-	}
-
-	else {
-
-		bool search_left_first;
-
+template <>
+double KDTree<ShapeModel,ControlPoint>::metric(const double * point_in_tree,
+	const double * point) const{
 
-		if (test_point(node -> get_axis()) <= node -> get_value()) {
-			search_left_first = true;
-		}
-		else {
-			search_left_first = false;
-		}
+	double dx = point[0] - point_in_tree[0];
+	double dy = point[1] - point_in_tree[1];
+	double dz = point[2] - point_in_tree[2];
 
-		if (search_left_first) {
+	return dx * dx + dy * dy + dz * dz;
 
+}
 
+template <template<class> class ContainerType, class PointType>
+bool KDTree<ContainerType,PointType>::is_euclidean() const{
+	return true;
+}
 
-			if (test_point(node -> get_axis()) - distance <= node -> get_value()) {
-				node -> closest_N_point_search(test_point,
-					N_points,
-					node -> left,
-					distance,
-					closest_points,
-					owner);
-			}
+template <>
+bool KDTree<PointCloud,PointDescriptor>::is_euclidean() const{
+	return false;
+}
 
-			if (test_point(node -> get_axis()) + distance > node -> get_value()) {
-				node -> closest_N_point_search(test_point,
-					N_points,
-					node -> right,
-					distance,
-					closest_points,
-					owner);
-			}
+template <template<class> class ContainerType, class PointType>
+double KDTree<ContainerType,PointType>::plane_metric(double offset) const{
+	return this -> is_euclidean() ? offset * offset : std::abs(offset);
+}
 
-		}
+template <template<class> class ContainerType, class PointType>
+double KDTree<ContainerType,PointType>::distance_to_metric(double distance) const{
+	return this -> is_euclidean() ? distance * distance : distance;
+}
 
-		else {
+template <template<class> class ContainerType, class PointType>
+double KDTree<ContainerType,PointType>::metric_to_distance(double metric) const{
+	return this -> is_euclidean() ? std::sqrt(metric) : metric;
+}
 
-			if (test_point(node -> get_axis()) + distance > node -> get_value()) {
-				node -> closest_N_point_search(test_point,
-					N_points,
-					node -> right,
-					distance,
-					closest_points,
-					owner);
-			}
 
-			if (test_point(node -> get_axis()) - distance <= node -> get_value()) {
-				node -> closest_N_point_search(test_point,
-					N_points,
-					node -> left,
-					distance,
-					closest_points,
-					owner);
-			}
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::build(const std::vector< int > & indices,const ContainerType<PointType> * owner) {
 
-		}
+	int N = static_cast<int>(indices.size());
 
+	if (N == 0) {
+		this -> build(indices,std::vector<double>());
+		return;
 	}
 
-	#if KDTTREE_CLOSEST_N_POINT_SEARCH_DEBUG_FLAG
-	std::cout << "#############################\n";
-	std::cout << " Leaving "<<  std::endl; ;
-	std::cout << "Points found : " << std::endl;
-	for (auto it = closest_points.begin(); it != closest_points.end(); ++it){
-		std::cout << it -> first << " : " << owner -> get_point_coordinates(it -> second).t().t();
+	int D = owner -> get_point_coordinates(indices[0]).n_rows;
+
+	// The coordinates are gathered once, in the order of the provided indices
+	std::vector<double> unordered_coordinates(N * D);
+	for (int i = 0; i < N; ++i) {
+		const arma::vec & point = owner -> get_point_coordinates(indices[i]);
+		std::copy(point.memptr(),point.memptr() + D,unordered_coordinates.begin() + i * D);
 	}
-	#endif
 
+	this -> build(indices,unordered_coordinates);
 
 }
 
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::build(const std::vector< int > & indices,
+	const std::vector< double > & unordered_coordinates) {
 
-template <template<class> class ContainerType, class PointType> 
-void KDTree<ContainerType,PointType>::radius_point_search(const arma::vec & test_point,
-	const std::shared_ptr<KDTree> & node,
-	const double & distance,
-	std::vector< int > & closest_points_indices,
-	const ContainerType<PointType> * owner) {
-
-
-
-	double node_value = node -> get_value();
-	double test_value = test_point(node -> get_axis());
-
+	int N = static_cast<int>(indices.size());
 
-	#if KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG
-	std::cout << "#############################\n";
-	std::cout << "Depth: " << node -> depth << std::endl; ;
-	std::cout << "Points in node: " << node -> indices.size() << std::endl;
-	std::cout << "Points found so far : " << closest_points_indices.size() << std::endl;
-	#endif
+	this -> nodes.clear();
+	this -> coordinates.clear();
+	this -> indices.clear();
+	this -> depth = 0;
+	this -> first_leaf = 0;
+	this -> dimension = 0;
 
-	if (node -> left == nullptr ) {
+	if (N == 0) {
+		return;
+	}
 
-		#if KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG
-		std::cout << "Leaf node\n";
-		#endif
+	if (unordered_coordinates.size() % N != 0) {
+		throw(std::runtime_error("KDTree::build: the number of coordinates is not a multiple of the number of points"));
+	}
 
-		KDTree<ContainerType,PointType>::search_node(test_point,node,distance,closest_points_indices,owner);
+	this -> dimension = static_cast<int>(unordered_coordinates.size()) / N;
+	int D = this -> dimension;
 
+	// The depth is the smallest for which the leaves hold at most KDTREE_LEAF_SIZE points.
+	// Since every fork splits its points in halves, all the leaves lie at this depth
+	while ((N + (1 << this -> depth) - 1) >> this -> depth > KDTREE_LEAF_SIZE) {
+		++this -> depth;
 	}
 
-	else {
+	this -> first_leaf = (1 << this -> depth) - 1;
+	this -> nodes.resize(2 * this -> first_leaf + 1);
+	this -> nodes[0].begin = 0;
+	this -> nodes[0].end = N;
 
-		#if KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG
-		std::cout << "Fork node\n";
-		#endif
+	// Permutation of the points, partitioned in place as the forks are split
+	std::vector<int> order(N);
+	std::iota(order.begin(),order.end(),0);
 
-		
+	// Parents precede their children in the node array, which can thus be filled in order
+	for (int n = 0; n < this -> first_leaf; ++n) {
 
-		if (test_value <= node_value) {
+		Node & node = this -> nodes[n];
+		int mid = node.begin + (node.end - node.begin) / 2;
 
-			#if KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG
-			std::cout << "Searching left first\n";
-			#endif
+		if (node.end - node.begin > 1) {
 
+			// The split axis is that of largest spread
+			std::vector<double> min_bounds(unordered_coordinates.begin() + order[node.begin] * D,
+				unordered_coordinates.begin() + order[node.begin] * D + D);
+			std::vector<double> max_bounds = min_bounds;
 
-			if (test_value - distance <= node_value) {
-				node -> radius_point_search(test_point,
-					node -> left,
-					distance,
-					closest_points_indices,
-					owner);
+			for (int i = node.begin + 1; i < node.end; ++i) {
+				const double * point = unordered_coordinates.data() + order[i] * D;
+				for (int k = 0; k < D; ++k) {
+					min_bounds[k] = std::min(min_bounds[k],point[k]);
+					max_bounds[k] = std::max(max_bounds[k],point[k]);
+				}
 			}
 
-			if (test_value + distance >= node_value) {
-				node -> radius_point_search(test_point,
-					node -> right,
-					distance,
-					closest_points_indices,
-					owner);
+			int axis = 0;
+			for (int k = 1; k < D; ++k) {
+				if (max_bounds[k] - min_bounds[k] > max_bounds[axis] - min_bounds[axis]) {
+					axis = k;
+				}
 			}
 
-		}
-
-		else {
-
-			#if KDTTREE_RADIUS_POINT_SEARCH_DEBUG_FLAG
-			std::cout << "Searching right first\n";
-			#endif
-			if (test_value + distance >= node_value) {
-				node -> radius_point_search(test_point,
-					node -> right,
-					distance,
-					closest_points_indices,
-					owner);
-			}
+			// Median split. Points in [begin,mid) lie at or below the split value,
+			// points in [mid,end) at or above it
+			std::nth_element(order.begin() + node.begin,order.begin() + mid,order.begin() + node.end,
+				[&](int a, int b){
+					return unordered_coordinates[a * D + axis] < unordered_coordinates[b * D + axis];
+				});
 
-			if (test_value - distance <= node_value) {
-				node -> radius_point_search(test_point,
-					node -> left,
-					distance,
-					closest_points_indices,
-					owner);
-			}
+			node.axis = axis;
+			node.value = unordered_coordinates[order[mid] * D + axis];
 
 		}
 
-	}
-
-}
-
-template <template<class> class ContainerType, class PointType>
-void KDTree<ContainerType,PointType>::build(const std::vector< int > & indices, int depth,const ContainerType<PointType> * owner) {
-
-	this -> indices = indices;
-	this -> left = nullptr;
-	this -> right = nullptr;
-	this -> set_depth(depth);
-
-	#if KDTREE_BUILD_DEBUG
-	std::cout << "Points in node: " << indices.size() <<  std::endl;
-	#endif
-
-	if (static_cast<int>(this -> indices.size()) == 0) {
-		#if KDTREE_BUILD_DEBUG
-		std::cout << "Empty node" << std::endl;
-		std::cout << "Leaf depth: " << depth << std::endl;
-		#endif
-		return;
-	}
-	else if (static_cast<int>(this -> indices.size()) == 1){
-		#if KDTREE_BUILD_DEBUG
-		std::cout << "Trivial node" << std::endl;
-		std::cout << "Leaf depth: " << depth << std::endl;
-		#endif
-		return;
-	}
-	else if (static_cast<int>(this -> indices.size()) < this -> get_min_indices_per_node()){
-		#if KDTREE_BUILD_DEBUG
-		std::cout << "Node contains less indices ("  <<static_cast<int>(this -> indices.size()) << ") than the prescribed number ";
-		std::cout << this -> min_indices_per_node << " . Node depth was " << depth << std::endl;
-		#endif
-		return ;
-	}
-	else if (this -> depth == this -> get_max_depth()){
-		
-		#if KDTREE_BUILD_DEBUG
-		std::cout << "Max depth (" << this -> get_max_depth()  << ") reached\n";
-		std::cout << "Node contains "  <<static_cast<int>(this -> indices.size()) << " indices \n";
-		#endif
-		return ;
-
-	}
-
-	else {
-
-		this -> left = std::make_shared<KDTree<ContainerType,PointType>>( KDTree<ContainerType,PointType>() );
-		this -> right = std::make_shared<KDTree<ContainerType,PointType>>( KDTree<ContainerType,PointType>() );
-
-		this -> left -> indices = std::vector<int >();
-		this -> right -> indices = std::vector<int >();
+		this -> nodes[2 * n + 1].begin = node.begin;
+		this -> nodes[2 * n + 1].end = mid;
+		this -> nodes[2 * n + 2].begin = mid;
+		this -> nodes[2 * n + 2].end = node.end;
 
 	}
 
-	arma::vec midpoint = arma::zeros<arma::vec>(owner -> get_point_coordinates(indices[0]).size());
-	const arma::vec & start_point = owner -> get_point_coordinates(indices[0]);
-
-	arma::vec min_bounds = start_point;
-	arma::vec max_bounds = start_point;
-
-	// Could multithread here
-	for (unsigned int i = 0; i < indices.size(); ++i) {
-
-		const arma::vec & point = owner -> get_point_coordinates(indices[i]);
-
-		max_bounds = arma::max(max_bounds,point);
-		min_bounds = arma::min(min_bounds,point);
-
-		// The midpoint of all the facets is found
-		midpoint += (point / indices.size());
-		
+	// The coordinates and indices are reordered so that each leaf bucket is contiguous
+	this -> coordinates.resize(N * D);
+	this -> indices.resize(N);
+	for (int i = 0; i < N; ++i) {
+		std::copy(unordered_coordinates.begin() + order[i] * D,
+			unordered_coordinates.begin() + order[i] * D + D,
+			this -> coordinates.begin() + i * D);
+		this -> indices[i] = indices[order[i]];
 	}
 
-
-
-	arma::vec bounding_box_lengths = max_bounds - min_bounds;
-
-	// Facets to be assigned to the left and right nodes
-	std::vector < int > left_points;
-	std::vector < int > right_points;
-
 	#if KDTREE_BUILD_DEBUG
-	std::cout << "Midpoint: " << midpoint.t() << std::endl;
-	std::cout << "Bounding box lengths: " << bounding_box_lengths.t();
+	std::cout << "Points in tree: " << N << std::endl;
+	std::cout << "Leaf depth: " << this -> depth << std::endl;
+	std::cout << "Number of nodes: " << this -> nodes.size() << std::endl;
 	#endif
 
+}
 
-	if (arma::norm(bounding_box_lengths) == 0) {
-		#if KDTREE_BUILD_DEBUG
-		std::cout << "Cluttered node" << std::endl;
-		#endif
-
-		this -> left = nullptr;
-		this -> right = nullptr;
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::closest_point_search(const arma::vec & test_point,
+	int & best_guess_index,
+	double & distance) const {
 
+	if (this -> nodes.size() == 0) {
 		return;
 	}
 
-	int longest_axis = bounding_box_lengths.index_max();
+	double bound = this -> distance_to_metric(distance);
+	this -> closest_point_search(0,test_point.memptr(),best_guess_index,bound);
+	distance = this -> metric_to_distance(bound);
 
-	for (unsigned int i = 0; i < indices.size() ; ++i) {
-
-		if (midpoint(longest_axis) >= owner -> get_point_coordinates(indices[i]).at(longest_axis)) {
-			left_points.push_back(indices[i]);
-		}
+}
 
-		else {
-			right_points.push_back(indices[i]);
-		}
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::closest_N_point_search(const arma::vec & test_point,
+	const unsigned int & N_points,
+	double & distance,
+	std::map<double,int > & closest_points) const{
 
+	if (this -> nodes.size() == 0 || N_points == 0) {
+		return;
 	}
 
-	this -> set_axis(longest_axis);
-	this -> set_value(midpoint(longest_axis));
+	std::vector<int> closest_indices(N_points);
+	std::vector<double> closest_distances(N_points);
 
-	// I guess this could be avoided
-	if (left_points.size() == 0 && right_points.size() > 0) {
-		left_points = right_points;
-	}
+	unsigned int N_found = this -> closest_N_point_search(test_point.memptr(),N_points,
+		closest_indices.data(),closest_distances.data());
 
-	if (right_points.size() == 0 && left_points.size() > 0) {
-		right_points = left_points;
+	for (unsigned int k = 0; k < N_found; ++k) {
+		double point_distance = this -> metric_to_distance(closest_distances[k]);
+		if (point_distance < distance) {
+			closest_points[point_distance] = closest_indices[k];
+		}
 	}
 
-
-	// Recursion continues
-	this -> left -> build(left_points, depth + 1,owner);
-	this -> right -> build(right_points, depth + 1,owner);
+	if (N_found == N_points) {
+		distance = std::min(distance,this -> metric_to_distance(closest_distances[N_found - 1]));
+	}
 
 }
 
 template <template<class> class ContainerType, class PointType>
-unsigned int KDTree<ContainerType,PointType>::size() const {
-	return static_cast<int>(this -> indices.size());
-}
-
+unsigned int KDTree<ContainerType,PointType>::closest_N_point_search(const double * test_point,
+	unsigned int N_points,
+	int * closest_indices,
+	double * closest_distances,
+	unsigned int N_found) const{
+
+	if (this -> nodes.size() == 0 || N_points == 0) {
+		return N_found;
+	}
 
-template <>
-double KDTree<PointCloud,PointNormal>::distance(const PointNormal & point_in_pc,
-	const arma::vec & point) const{
+	this -> closest_N_point_search(0,test_point,N_points,closest_indices,closest_distances,N_found);
 
-	return arma::norm(point - point_in_pc.get_point_coordinates());
+	return N_found;
 
 }
 
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::radius_point_search(const arma::vec & test_point,
+	const double & distance,
+	std::vector< int > & closest_points) const{
 
+	if (this -> nodes.size() == 0) {
+		return;
+	}
 
-template <>
-double KDTree<PointCloud,PointDescriptor>::distance(const PointDescriptor & point_in_pc,
-	const arma::vec & point) const{
-
-	return point_in_pc.distance_to_descriptor(point);
+	this -> radius_point_search(0,test_point.memptr(),this -> distance_to_metric(distance),closest_points,nullptr);
 
 }
 
-template <>
-double KDTree<ShapeModel,ControlPoint>::distance(const ControlPoint & point_in_shape,
-	const arma::vec & point) const{
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::radius_point_search(const double * test_point,
+	const double & distance,
+	std::vector< int > & closest_points,
+	std::vector< double > & closest_distances) const{
 
-	return arma::norm(point_in_shape.get_point_coordinates() - point);
+	if (this -> nodes.size() == 0) {
+		return;
+	}
+
+	this -> radius_point_search(0,test_point,this -> distance_to_metric(distance),closest_points,&closest_distances);
 
 }
 
-template <template<class> class ContainerType, class PointType> 
-void KDTree<ContainerType,PointType>::search_node(const arma::vec & test_point,
-	const std::shared_ptr<KDTree> & node,
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::closest_point_search(int node_index,
+	const double * test_point,
 	int & best_guess_index,
-	double & distance,
-	const ContainerType<PointType> * owner) const{
+	double & bound) const {
 
-	for (int i = 0; i < node -> indices.size(); ++i){
-
-		double new_distance;
-
-		
-		try{
-			new_distance = this -> distance(owner -> get_point(node -> indices[i]),test_point);
-		}
-		catch(std::logic_error & e){
-			std::cout << node -> indices[i] << std::endl;
-			throw(std::runtime_error( "found culprit\n"));
-		}
+	const Node & node = this -> nodes[node_index];
 
+	if (this -> is_leaf(node_index)) {
 
-		if (new_distance < distance) {
-			distance = new_distance;
-			best_guess_index = node -> indices[i];
+		for (int i = node.begin; i < node.end; ++i) {
+			double new_metric = this -> metric(this -> coordinates.data() + i * this -> dimension,test_point);
+			if (new_metric < bound) {
+				bound = new_metric;
+				best_guess_index = this -> indices[i];
+			}
 		}
+		return;
 	}
 
-}
-
-template <template<class> class ContainerType, class PointType> 
-void KDTree<ContainerType,PointType>::search_node(const arma::vec & test_point,
-	const std::shared_ptr<KDTree> & node,
-	const double & distance,
-	std::vector< int > & closest_points_indices,
-	const ContainerType<PointType> * owner) const{
-
+	double offset = test_point[node.axis] - node.value;
 
-	for (int i = 0; i < node -> indices.size(); ++i){
-		double new_distance = this -> distance( owner -> get_point(node -> indices[i]),test_point);
+	// The side containing the test point is searched first,
+	// the other one only if it may still hold a closer point
+	int near_child = offset <= 0 ? 2 * node_index + 1 : 2 * node_index + 2;
+	int far_child = offset <= 0 ? 2 * node_index + 2 : 2 * node_index + 1;
 
-		#if KDTTREE_DEBUG_FLAG
-		std::cout << "Distance to query_point: " << new_distance << std::endl;
-		#endif
-
-		if (new_distance < distance ) {
-			closest_points_indices.push_back(node -> indices[i]);
-			#if KDTTREE_DEBUG_FLAG
-			std::cout << "Found closest point " << node -> indices[i] << " with distance = " + std::to_string(distance)<< " \n" << std::endl;
-			#endif
-		}
+	this -> closest_point_search(near_child,test_point,best_guess_index,bound);
 
+	if (this -> plane_metric(offset) <= bound) {
+		this -> closest_point_search(far_child,test_point,best_guess_index,bound);
 	}
 
-
 }
 
 template <template<class> class ContainerType, class PointType>
-void KDTree<ContainerType,PointType>::search_node(const arma::vec & test_point,
-	const unsigned int & N_points,
-	const std::shared_ptr<KDTree> & node,
-	double & distance,
-	std::map<double,int > & closest_points,
-	const ContainerType<PointType> * owner) const{
+void KDTree<ContainerType,PointType>::closest_N_point_search(int node_index,
+	const double * test_point,
+	unsigned int N_points,
+	int * closest_indices,
+	double * closest_distances,
+	unsigned int & N_found) const{
 
-	for (int i =0 ; i < node -> indices.size(); ++i){
-		double new_distance = this -> distance(owner -> get_point(node -> indices[i]),test_point);
+	const Node & node = this -> nodes[node_index];
 
+	if (this -> is_leaf(node_index)) {
 
-		#if KDTTREE_DEBUG_FLAG
-		std::cout << "Distance to query_point: " << new_distance << std::endl;
-		#endif
+		for (int i = node.begin; i < node.end; ++i) {
 
-		if (closest_points.size() < N_points){
-			closest_points[new_distance] = node -> indices[i];
-		}
-		else{
+			double new_metric = this -> metric(this -> coordinates.data() + i * this -> dimension,test_point);
 
-			unsigned int size_before = closest_points.size(); // should always be equal to N_points
+			// The buffers are kept sorted by increasing distance. Once full,
+			// a candidate must beat the furthest point found so far, which it replaces
+			if (N_found == N_points && new_metric >= closest_distances[N_found - 1]) {
+				continue;
+			}
 
-			closest_points[new_distance] = node -> indices[i];
+			unsigned int k = N_found < N_points ? N_found++ : N_found - 1;
+			for (; k > 0 && closest_distances[k - 1] > new_metric; --k) {
+				closest_distances[k] = closest_distances[k - 1];
+				closest_indices[k] = closest_indices[k - 1];
+			}
+			closest_distances[k] = new_metric;
+			closest_indices[k] = this -> indices[i];
 
-			unsigned int size_after = closest_points.size(); // should always be equal to N_points + 1, unless new_distance was already in the map
+		}
+		return;
+	}
 
-			if (size_after == size_before + 1){
+	double offset = test_point[node.axis] - node.value;
 
-				// Remove last element in map
-				closest_points.erase(--closest_points.end());
+	int near_child = offset <= 0 ? 2 * node_index + 1 : 2 * node_index + 2;
+	int far_child = offset <= 0 ? 2 * node_index + 2 : 2 * node_index + 1;
 
-				// Set the distance to that between the query point and the last element in the map
-				distance = (--closest_points.end()) -> first;
+	this -> closest_N_point_search(near_child,test_point,N_points,closest_indices,closest_distances,N_found);
 
-			}
+	if (N_found < N_points || this -> plane_metric(offset) <= closest_distances[N_found - 1]) {
+		this -> closest_N_point_search(far_child,test_point,N_points,closest_indices,closest_distances,N_found);
+	}
 
+}
 
+template <template<class> class ContainerType, class PointType>
+void KDTree<ContainerType,PointType>::radius_point_search(int node_index,
+	const double * test_point,
+	const double & bound,
+	std::vector< int > & closest_points,
+	std::vector< double > * closest_distances) const{
+
+	const Node & node = this -> nodes[node_index];
+
+	if (this -> is_leaf(node_index)) {
+
+		for (int i = node.begin; i < node.end; ++i) {
+			double new_metric = this -> metric(this -> coordinates.data() + i * this -> dimension,test_point);
+			if (new_metric < bound) {
+				closest_points.push_back(this -> indices[i]);
+				if (closest_distances != nullptr) {
+					closest_distances -> push_back(new_metric);
+				}
+			}
 		}
+		return;
+	}
+
+	double offset = test_point[node.axis] - node.value;
+	bool reaches_plane = this -> plane_metric(offset) <= bound;
 
+	if (offset <= 0 || reaches_plane) {
+		this -> radius_point_search(2 * node_index + 1,test_point,bound,closest_points,closest_distances);
 	}
 
+	if (offset >= 0 || reaches_plane) {
+		this -> radius_point_search(2 * node_index + 2,test_point,bound,closest_points,closest_distances);
+	}
 
 }
 
+template <template<class> class ContainerType, class PointType>
+bool KDTree<ContainerType,PointType>::is_leaf(int node_index) const {
+	return node_index >= this -> first_leaf;
+}
 
-
-template < template<class> class ContainerType,class PointType>
-void KDTree<ContainerType,PointType>::set_max_depth(int max_depth){
-	this -> max_depth = max_depth;
+template <template<class> class ContainerType, class PointType>
+unsigned int KDTree<ContainerType,PointType>::size() const {
+	return static_cast<unsigned int>(this -> indices.size());
 }
 
-template < template<class> class ContainerType,class PointType>
-int KDTree<ContainerType,PointType>::get_max_depth() const{
-	return this -> max_depth;
+template <template<class> class ContainerType, class PointType>
+int KDTree<ContainerType,PointType>::get_depth() const {
+	return this -> depth;
 }
 
-template < template<class> class ContainerType,class PointType>
-void KDTree<ContainerType,PointType>::set_min_indices_per_node(int min_indices_per_node){
-	this -> min_indices_per_node = min_indices_per_node;
+template <template<class> class ContainerType, class PointType>
+const std::vector<int> & KDTree<ContainerType,PointType>::get_indices() const {
+	return this -> indices;
 }
 
-template < template<class> class ContainerType,class PointType>
-int KDTree<ContainerType,PointType>::get_min_indices_per_node() const{
-	return this -> min_indices_per_node;
+template <template<class> class ContainerType, class PointType>
+const std::vector<double> & KDTree<ContainerType,PointType>::get_coordinates() const {
+	return this -> coordinates;
 }
 
 
@@ -607,6 +447,3 @@ int KDTree<ContainerType,PointType>::get_min_indices_per_node() const{
 template class KDTree<PointCloud,PointNormal> ;
 template class KDTree<PointCloud,PointDescriptor> ;
 template class KDTree<ShapeModel,ControlPoint> ;
-
-
-
@@ -1,9 +1,22 @@
 #include <Lidar.hpp>
 #include <Ray.hpp>
 #include <FrameGraph.hpp>
+#include <RefFrame.hpp>
 #include <ShapeModel.hpp>
 #include <Facet.hpp>
 #include <ControlPoint.hpp>
+#include <Philox.hpp>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <cstdint>
+
+// Size of the focal-plane tiles traced as a single ray packet
+#define PACKET_TILE_Y 4
+#define PACKET_TILE_Z (RAY_PACKET_SIZE / PACKET_TILE_Y)
+
+// Number of active pixels forming a single task in batched flashes
+#define FLASH_BATCH_TILE_SIZE 256
 
 
 
@@ -36,6 +49,11 @@ Lidar::Lidar(
 
 	}
 
+	this -> focal_plane_directions = arma::mat(3,this -> focal_plane.size());
+	for (unsigned int pixel = 0; pixel < this -> focal_plane.size(); ++pixel){
+		this -> focal_plane_directions.col(pixel) = this -> focal_plane[pixel] -> get_direction();
+	}
+
 
 }
 
@@ -89,54 +107,383 @@ double Lidar::get_size_y() const {
 
 void Lidar::send_flash(ShapeModel<ControlPoint> * shape_model,bool add_noise,double skipping_factor) {
 
+	this -> shape_model = shape_model;
+
 	unsigned int resolution = this -> y_res * this -> z_res;
 
-	std::vector<int> active_pixel_indices;
+	std::vector<int> active_pixel_indices = this -> get_active_pixel_indices(skipping_factor);
 
-	int pixels_skipped = int(double(this -> y_res) * (1 - skipping_factor));
+	// The lidar-to-target transform is resolved once for the whole flash
+	// and applied to all the focal-plane rays at once. All rays originate
+	// from the lidar's origin
+	arma::mat::fixed<3,3> dcm;
+	arma::vec::fixed<3> origin_target_frame;
+	this -> frame_graph -> get_transform(this -> ref_frame_name,shape_model -> get_ref_frame_name(),dcm,origin_target_frame);
+
+	arma::mat directions_target_frame = dcm * this -> focal_plane_directions;
 
 	for (unsigned int pixel = 0; pixel < resolution; ++pixel){
-		this -> focal_plane[pixel] -> reset( shape_model);
-		if (active_pixel_indices.size() == 0 || pixel - active_pixel_indices.back() >= pixels_skipped){
-			active_pixel_indices.push_back(pixel);
-		}
+		this -> focal_plane[pixel] -> reset(origin_target_frame,directions_target_frame.col(pixel));
 	}
 
 	auto start = std::chrono::system_clock::now();
-	
-	#pragma omp parallel for if (USE_OMP_LIDAR)
-	for  (int pixel = 0; pixel < active_pixel_indices.size(); ++pixel){
 
-		bool hit = shape_model -> ray_trace(this -> focal_plane[active_pixel_indices[pixel]].get());
+	if (this -> use_coherence){
+
+		// Each pixel first tests the facet it hit during the previous flash
+		unsigned int fast_path_hits = 0;
+		unsigned int hits = 0;
+
+		#pragma omp parallel for reduction(+:fast_path_hits,hits) if (USE_OMP_LIDAR)
+		for (int pixel = 0; pixel < active_pixel_indices.size(); ++pixel){
+
+			Ray * ray = this -> focal_plane[active_pixel_indices[pixel]].get();
+
+			bool fast_path;
+			bool hit = shape_model -> ray_trace_coherent(ray,true,fast_path);
+
+			ray -> set_guess(ray -> get_hit_element());
+
+			if (hit){
+				++hits;
+				if (fast_path){
+					++fast_path_hits;
+				}
+			}
+
+			if (hit && add_noise) {
+				this -> add_range_noise(ray,this -> flash_index,active_pixel_indices[pixel]);
+			}
+
+		}
+
+		this -> coherence_hit_rate = hits > 0 ? double(fast_path_hits) / hits : 0;
+
+	}
+
+	else if (this -> use_packets){
+
+		std::vector<unsigned int> packet_starts = this -> get_packet_starts(active_pixel_indices);
+
+		#pragma omp parallel for if (USE_OMP_LIDAR)
+		for (int p = 0; p < int(packet_starts.size()) - 1; ++p){
 
-		// If there's a hit, noise is added along the line of sight on the true measurement
-		if (hit && add_noise) {
+			RayPacket packet(this -> packet_kernel);
 
-			arma::vec random_vec = arma::randn(1);
-			double true_range = this -> focal_plane[active_pixel_indices[pixel]] -> get_true_range();
+			for (unsigned int i = packet_starts[p]; i < packet_starts[p + 1]; ++i){
+				packet.add_ray(this -> focal_plane[active_pixel_indices[i]].get());
+			}
+
+			shape_model -> ray_trace_packet(packet);
 
-			double noise_sd = this -> los_noise_sd_baseline + this -> los_noise_fraction_mes_truth * true_range;			
-			double noise = noise_sd * random_vec(0);
+			for (unsigned int i = 0; i < packet.size(); ++i){
+				if (packet.get_ray(i) -> get_hit_element() != -1 && add_noise){
+					this -> add_range_noise(packet.get_ray(i),this -> flash_index,active_pixel_indices[packet_starts[p] + i]);
+				}
+			}
 
-			this -> focal_plane[active_pixel_indices[pixel]] -> set_true_range(true_range + noise);
-			
-			
 		}
 
 	}
 
+	else{
+
+		#pragma omp parallel for if (USE_OMP_LIDAR)
+		for  (int pixel = 0; pixel < active_pixel_indices.size(); ++pixel){
+
+			bool hit = shape_model -> ray_trace(this -> focal_plane[active_pixel_indices[pixel]].get());
+
+			// If there's a hit, noise is added along the line of sight on the true measurement
+			if (hit && add_noise) {
+				this -> add_range_noise(this -> focal_plane[active_pixel_indices[pixel]].get(),this -> flash_index,active_pixel_indices[pixel]);
+			}
+
+		}
+	}
+
 	auto end = std::chrono::system_clock::now();
 
 	std::chrono::duration<double> elapsed_seconds = end-start;
 
 	std::cout << "- Time elapsed in ray-tracer: " << elapsed_seconds.count()<< " s"<< std::endl;
 	
+	++this -> flash_index;
 
 
 }
 
 
 
+std::vector<arma::mat> Lidar::send_flashes(ShapeModel<ControlPoint> * shape_model,
+	const std::vector<FlashPose> & poses,
+	bool add_noise,
+	double skipping_factor) {
+
+	std::vector<int> active_pixel_indices = this -> get_active_pixel_indices(skipping_factor);
+
+	// The frames are moved to each pose in turn to resolve the lidar-to-target
+	// transforms. This is the only part of the job that touches the frame graph,
+	// and the frames are restored once the transforms are resolved
+	RefFrame * lidar_frame = this -> frame_graph -> get_frame(this -> ref_frame_name);
+	RefFrame * shape_frame = this -> frame_graph -> get_frame(shape_model -> get_ref_frame_name());
+
+	arma::vec lidar_origin = *lidar_frame -> get_origin_from_parent();
+	arma::vec lidar_mrp = *lidar_frame -> get_mrp_from_parent();
+	arma::vec shape_origin = *shape_frame -> get_origin_from_parent();
+	arma::vec shape_mrp = *shape_frame -> get_mrp_from_parent();
+
+	std::vector<arma::mat::fixed<3,3> > dcms(poses.size());
+	std::vector<arma::vec::fixed<3> > origins_target_frame(poses.size());
+
+	for (unsigned int flash = 0; flash < poses.size(); ++flash){
+
+		lidar_frame -> set_origin_from_parent(poses[flash].lidar_origin);
+		lidar_frame -> set_mrp_from_parent(poses[flash].lidar_mrp);
+		shape_frame -> set_origin_from_parent(poses[flash].shape_origin);
+		shape_frame -> set_mrp_from_parent(poses[flash].shape_mrp);
+
+		this -> frame_graph -> get_transform(this -> ref_frame_name,shape_model -> get_ref_frame_name(),
+			dcms[flash],origins_target_frame[flash]);
+
+	}
+
+	lidar_frame -> set_origin_from_parent(lidar_origin);
+	lidar_frame -> set_mrp_from_parent(lidar_mrp);
+	shape_frame -> set_origin_from_parent(shape_origin);
+	shape_frame -> set_mrp_from_parent(shape_mrp);
+
+	std::vector<arma::mat> range_images(poses.size());
+	for (unsigned int flash = 0; flash < poses.size(); ++flash){
+		range_images[flash] = arma::mat(this -> z_res,this -> y_res);
+		range_images[flash].fill(std::numeric_limits<double>::infinity());
+	}
+
+	unsigned int y_res = this -> y_res;
+
+	auto start = std::chrono::system_clock::now();
+
+	if (this -> use_coherence){
+
+		// Each pixel must see the flashes in order to use the facet it hit during the previous one,
+		// so each task traces a tile of active pixels through all the flashes. The guesses are carried over
+		// from the last call to send_flash or send_flashes, and left to the next one
+		int N_tiles = (active_pixel_indices.size() + FLASH_BATCH_TILE_SIZE - 1) / FLASH_BATCH_TILE_SIZE;
+		unsigned int fast_path_hits = 0;
+		unsigned int hits = 0;
+
+		#pragma omp parallel for schedule(dynamic) reduction(+:fast_path_hits,hits) if (USE_OMP_LIDAR)
+		for (int tile = 0; tile < N_tiles; ++tile){
+
+			int tile_start = tile * FLASH_BATCH_TILE_SIZE;
+			int tile_end = std::min(tile_start + FLASH_BATCH_TILE_SIZE,int(active_pixel_indices.size()));
+
+			for (int i = tile_start; i < tile_end; ++i){
+
+				int pixel = active_pixel_indices[i];
+				int guess = this -> focal_plane[pixel] -> get_guess();
+
+				for (unsigned int flash = 0; flash < poses.size(); ++flash){
+
+					Ray ray(origins_target_frame[flash],dcms[flash] * this -> focal_plane_directions.col(pixel));
+					ray.set_guess(guess);
+
+					bool fast_path;
+					bool hit = shape_model -> ray_trace_coherent(&ray,true,fast_path);
+					guess = ray.get_hit_element();
+
+					if (hit){
+						++hits;
+						if (fast_path){
+							++fast_path_hits;
+						}
+						if (add_noise){
+							this -> add_range_noise(&ray,this -> flash_index + flash,pixel);
+						}
+					}
+
+					range_images[flash](pixel / y_res,pixel % y_res) = ray.get_true_range();
+
+				}
+
+				this -> focal_plane[pixel] -> set_guess(guess);
+
+			}
+
+		}
+
+		this -> coherence_hit_rate = hits > 0 ? double(fast_path_hits) / hits : 0;
+
+	}
+
+	else {
+
+		// The active pixels are traced in units of a packet in packet mode, and of a single ray otherwise
+		std::vector<unsigned int> unit_starts;
+		unsigned int units_per_task;
+
+		if (this -> use_packets){
+			unit_starts = this -> get_packet_starts(active_pixel_indices);
+			units_per_task = std::max(FLASH_BATCH_TILE_SIZE / RAY_PACKET_SIZE,1);
+		}
+		else{
+			unit_starts.resize(active_pixel_indices.size() + 1);
+			std::iota(unit_starts.begin(),unit_starts.end(),0);
+			units_per_task = FLASH_BATCH_TILE_SIZE;
+		}
+
+		int N_units = int(unit_starts.size()) - 1;
+		int N_tiles = (N_units + units_per_task - 1) / units_per_task;
+		int N_tasks = N_tiles * poses.size();
+
+		// Each task traces a tile of active pixels of a given flash. Idle threads
+		// pick up the next pending task, whichever flash it belongs to
+		#pragma omp parallel for schedule(dynamic) if (USE_OMP_LIDAR)
+		for (int task = 0; task < N_tasks; ++task){
+
+			int flash = task / N_tiles;
+			int unit_start = (task % N_tiles) * units_per_task;
+			int unit_end = std::min(unit_start + int(units_per_task),N_units);
+
+			for (int unit = unit_start; unit < unit_end; ++unit){
+
+				if (this -> use_packets){
+
+					// The rays of the packet are allocated upfront so that the packet can point to them
+					std::vector<Ray> rays;
+					rays.reserve(unit_starts[unit + 1] - unit_starts[unit]);
+					for (unsigned int i = unit_starts[unit]; i < unit_starts[unit + 1]; ++i){
+						rays.push_back(Ray(origins_target_frame[flash],dcms[flash] * this -> focal_plane_directions.col(active_pixel_indices[i])));
+					}
+
+					RayPacket packet(this -> packet_kernel);
+					for (unsigned int k = 0; k < rays.size(); ++k){
+						packet.add_ray(&rays[k]);
+					}
+					shape_model -> ray_trace_packet(packet);
+
+					for (unsigned int k = 0; k < rays.size(); ++k){
+						int pixel = active_pixel_indices[unit_starts[unit] + k];
+						if (rays[k].get_hit_element() != -1 && add_noise){
+							this -> add_range_noise(&rays[k],this -> flash_index + flash,pixel);
+						}
+						range_images[flash](pixel / y_res,pixel % y_res) = rays[k].get_true_range();
+					}
+
+				}
+				else{
+
+					int pixel = active_pixel_indices[unit];
+
+					Ray ray(origins_target_frame[flash],dcms[flash] * this -> focal_plane_directions.col(pixel));
+
+					if (shape_model -> ray_trace(&ray) && add_noise){
+						this -> add_range_noise(&ray,this -> flash_index + flash,pixel);
+					}
+
+					range_images[flash](pixel / y_res,pixel % y_res) = ray.get_true_range();
+
+				}
+
+			}
+
+		}
+
+	}
+
+	auto end = std::chrono::system_clock::now();
+
+	std::chrono::duration<double> elapsed_seconds = end-start;
+
+	std::cout << "- Time elapsed in ray-tracer (" << poses.size() << " flashes): " << elapsed_seconds.count()<< " s"<< std::endl;
+
+	this -> flash_index += poses.size();
+
+	return range_images;
+
+}
+
+
+std::vector<unsigned int> Lidar::get_packet_starts(std::vector<int> & active_pixel_indices) const{
+
+	// Active pixels are grouped by focal-plane tiles, 
+	// each tile forming a packet of coherent rays
+	unsigned int y_res = this -> y_res;
+	auto tile = [y_res](int pixel){
+		return std::make_pair((pixel / y_res) / PACKET_TILE_Z, (pixel % y_res) / PACKET_TILE_Y);
+	};
+
+	std::stable_sort(active_pixel_indices.begin(),active_pixel_indices.end(),[&tile](int a, int b){
+		return tile(a) < tile(b);
+	});
+
+	std::vector<unsigned int> packet_starts;
+	for (unsigned int i = 0; i < active_pixel_indices.size(); ++i){
+		if (packet_starts.size() == 0 
+			|| i - packet_starts.back() == RAY_PACKET_SIZE
+			|| tile(active_pixel_indices[i]) != tile(active_pixel_indices[packet_starts.back()])){
+			packet_starts.push_back(i);
+		}
+	}
+	packet_starts.push_back(active_pixel_indices.size());
+
+	return packet_starts;
+
+}
+
+
+std::vector<int> Lidar::get_active_pixel_indices(double skipping_factor) const{
+
+	unsigned int resolution = this -> y_res * this -> z_res;
+
+	std::vector<int> active_pixel_indices;
+
+	int pixels_skipped = int(double(this -> y_res) * (1 - skipping_factor));
+
+	for (unsigned int pixel = 0; pixel < resolution; ++pixel){
+		if (active_pixel_indices.size() == 0 || pixel - active_pixel_indices.back() >= pixels_skipped){
+			active_pixel_indices.push_back(pixel);
+		}
+	}
+
+	return active_pixel_indices;
+
+}
+
+
+void Lidar::add_range_noise(Ray * ray,unsigned int flash,unsigned int pixel) const{
+
+	// The noise only depends on the seed, the flash and the pixel,
+	// so it does not change with the number of threads
+	Philox rng(PHILOX_DOMAIN_LIDAR_NOISE,flash,pixel);
+	double true_range = ray -> get_true_range();
+
+	double noise_sd = this -> los_noise_sd_baseline + this -> los_noise_fraction_mes_truth * true_range;			
+	double noise = noise_sd * rng.normal();
+
+	ray -> set_true_range(true_range + noise);
+
+}
+
+void Lidar::set_use_coherence(bool use_coherence){
+	this -> use_coherence = use_coherence;
+
+	// Guesses left over from a previous use of the mode are discarded
+	for (unsigned int pixel = 0; pixel < this -> focal_plane.size(); ++pixel){
+		this -> focal_plane[pixel] -> set_guess(-1);
+	}
+}
+
+double Lidar::get_coherence_hit_rate() const{
+	return this -> coherence_hit_rate;
+}
+
+void Lidar::set_use_packets(bool use_packets){
+	this -> use_packets = use_packets;
+}
+
+void Lidar::set_packet_kernel(RayPacket::Kernel kernel){
+	this -> packet_kernel = RayPacket::is_supported(kernel) ? kernel : RayPacket::get_best_kernel();
+}
 
 ShapeModel<ControlPoint> * Lidar::get_shape_model() {
 	return this -> shape_model;
@@ -245,6 +592,69 @@ void Lidar::save(std::string path,bool conserve_format) {
 
 
 
+}
+
+void Lidar::save_range_image(std::string path,double time) {
+
+	if (this -> shape_model == nullptr){
+		throw(std::runtime_error("Lidar::save_range_image: no flash was sent"));
+	}
+
+	unsigned int y_res = this -> y_res;
+	unsigned int z_res = this -> z_res;
+
+	uint32_t header_words[4] = {LIDAR_RANGE_IMAGE_MAGIC,LIDAR_RANGE_IMAGE_VERSION,y_res,z_res};
+
+	// Pose of the lidar in the target frame at the time of the flash
+	arma::mat::fixed<3,3> dcm;
+	arma::vec::fixed<3> origin_target_frame;
+	this -> frame_graph -> get_transform(this -> ref_frame_name,this -> shape_model -> get_ref_frame_name(),dcm,origin_target_frame);
+
+	double header_pose[13];
+	header_pose[0] = time;
+	for (unsigned int i = 0; i < 3; ++i){
+		header_pose[1 + i] = origin_target_frame(i);
+		for (unsigned int j = 0; j < 3; ++j){
+			header_pose[4 + 3 * i + j] = dcm(i,j);
+		}
+	}
+
+	// Images are laid out as in the formatted text output
+	std::vector<float> ranges(y_res * z_res);
+	std::vector<float> incidences(y_res * z_res);
+
+	for (unsigned int z_index = 0; z_index < z_res; ++z_index){
+		for (unsigned int y_index = 0; y_index < y_res; ++y_index){
+
+			const Ray * ray = this -> focal_plane[y_index + z_index * y_res].get();
+			unsigned int index = (y_res - y_index - 1) * z_res + z_index;
+
+			ranges[index] = float(ray -> get_true_range());
+			incidences[index] = std::isinf(ray -> get_true_range()) ? std::numeric_limits<float>::quiet_NaN() : float(ray -> get_incidence_angle());
+
+		}
+	}
+
+	std::ios_base::openmode mode = std::ios::binary;
+	if (this -> range_image_paths.count(path) == 0){
+		mode |= std::ios::trunc;
+		this -> range_image_paths.insert(path);
+	}
+	else{
+		mode |= std::ios::app;
+	}
+
+	std::ofstream file(path,mode);
+
+	if (!file.is_open()){
+		throw(std::runtime_error("Lidar::save_range_image: could not open " + path));
+	}
+
+	file.write(reinterpret_cast<const char *>(header_words),sizeof(header_words));
+	file.write(reinterpret_cast<const char *>(header_pose),sizeof(header_pose));
+	file.write(reinterpret_cast<const char *>(ranges.data()),ranges.size() * sizeof(float));
+	file.write(reinterpret_cast<const char *>(incidences.data()),incidences.size() * sizeof(float));
+
 }
 
 double Lidar::get_los_noise_sd_baseline() const{
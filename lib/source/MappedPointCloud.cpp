@@ -0,0 +1,324 @@
+#include <MappedPointCloud.hpp>
+#include <PointNormal.hpp>
+#include <PointDescriptor.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// Size of an array padded to a multiple of 8 bytes
+static std::size_t get_padded_size(std::size_t size){
+	return (size + 7) / 8 * 8;
+}
+
+MappedPointCloud::MappedPointCloud(std::string path){
+
+	int file = open(path.c_str(),O_RDONLY);
+	if (file < 0){
+		throw(std::runtime_error("MappedPointCloud: could not open " + path));
+	}
+
+	struct stat file_stat;
+	if (fstat(file,&file_stat) != 0){
+		close(file);
+		throw(std::runtime_error("MappedPointCloud: could not read the size of " + path));
+	}
+
+	this -> data_size = static_cast<std::size_t>(file_stat.st_size);
+	if (this -> data_size < sizeof(FileHeader)){
+		close(file);
+		throw(std::runtime_error("MappedPointCloud: " + path + " is too small to be a binary point cloud"));
+	}
+
+	this -> data = mmap(nullptr,this -> data_size,PROT_READ,MAP_PRIVATE,file,0);
+	close(file);
+
+	if (this -> data == MAP_FAILED){
+		this -> data = nullptr;
+		throw(std::runtime_error("MappedPointCloud: could not map " + path));
+	}
+
+	this -> header = static_cast<const FileHeader *>(this -> data);
+
+	try{
+		MappedPointCloud::check_header(*this -> header,path);
+	}
+	catch(...){
+		munmap(this -> data,this -> data_size);
+		this -> data = nullptr;
+		throw;
+	}
+
+	// The blocks are walked once to locate their arrays
+	std::size_t scalar_size = this -> is_single_precision() ? sizeof(float) : sizeof(double);
+	std::size_t offset = sizeof(FileHeader);
+	unsigned int N_points = 0;
+
+	for (unsigned int b = 0; b < this -> header -> N_blocks; ++b){
+
+		const char * begin = static_cast<const char *>(this -> data) + offset;
+		if (offset + sizeof(BlockHeader) > this -> data_size){
+			break;
+		}
+
+		const BlockHeader * block_header = reinterpret_cast<const BlockHeader *>(begin);
+		std::size_t block_size = get_block_size(*this -> header,block_header -> N_points);
+		if (offset + block_size > this -> data_size){
+			break;
+		}
+
+		Block block;
+		block.N_points = static_cast<unsigned int>(block_header -> N_points);
+
+		const char * array = begin + sizeof(BlockHeader);
+		block.positions = array;
+		array += get_padded_size(3 * block.N_points * scalar_size);
+
+		if (this -> has_normals()){
+			block.normals = array;
+			array += get_padded_size(3 * block.N_points * scalar_size);
+		}
+
+		block.indices = reinterpret_cast<const std::int32_t *>(array);
+		array += get_padded_size(block.N_points * sizeof(std::int32_t));
+
+		if (this -> header -> descriptor_size > 0){
+			block.descriptors = array;
+		}
+
+		this -> blocks.push_back(block);
+		this -> blocks_begin.push_back(N_points);
+
+		N_points += block.N_points;
+		offset += block_size;
+	}
+
+	if (this -> blocks.size() != this -> header -> N_blocks || N_points != this -> header -> N_points){
+		munmap(this -> data,this -> data_size);
+		this -> data = nullptr;
+		throw(std::runtime_error("MappedPointCloud: " + path + " is truncated"));
+	}
+
+}
+
+MappedPointCloud::~MappedPointCloud(){
+	if (this -> data != nullptr){
+		munmap(this -> data,this -> data_size);
+	}
+}
+
+void MappedPointCloud::check_header(const FileHeader & header,std::string path){
+
+	if (std::strncmp(header.magic,POINT_CLOUD_BINARY_MAGIC,sizeof(header.magic)) != 0){
+		throw(std::runtime_error("MappedPointCloud: " + path + " is not a binary point cloud"));
+	}
+
+	// The version is checked on its own bytes, so that a file written with the other byte order
+	// is reported as such rather than as a file of an unknown version
+	std::uint32_t swapped_version = __builtin_bswap32(header.version);
+	if (header.version != POINT_CLOUD_BINARY_VERSION && swapped_version != POINT_CLOUD_BINARY_VERSION){
+		throw(std::runtime_error("MappedPointCloud: " + path + " is a binary point cloud of an unsupported version"));
+	}
+
+	if (header.byte_order != POINT_CLOUD_BINARY_BYTE_ORDER){
+		throw(std::runtime_error("MappedPointCloud: " + path + " was written with a byte order that does not match this machine's"));
+	}
+
+}
+
+bool MappedPointCloud::is_binary(std::string path){
+
+	std::ifstream file(path,std::ios::binary);
+	char magic[sizeof(FileHeader::magic)];
+
+	if (!file.read(magic,sizeof(magic))){
+		return false;
+	}
+
+	return std::strncmp(magic,POINT_CLOUD_BINARY_MAGIC,sizeof(magic)) == 0;
+
+}
+
+std::size_t MappedPointCloud::get_block_size(const FileHeader & header,std::uint64_t N_points){
+
+	std::size_t scalar_size = (header.flags & POINT_CLOUD_BINARY_SINGLE_PRECISION) ? sizeof(float) : sizeof(double);
+	std::size_t size = sizeof(BlockHeader) + get_padded_size(3 * N_points * scalar_size);
+
+	if (header.flags & POINT_CLOUD_BINARY_NORMALS){
+		size += get_padded_size(3 * N_points * scalar_size);
+	}
+
+	size += get_padded_size(N_points * sizeof(std::int32_t));
+	size += get_padded_size(header.descriptor_size * N_points * scalar_size);
+
+	return size;
+
+}
+
+unsigned int MappedPointCloud::size() const{
+	return static_cast<unsigned int>(this -> header -> N_points);
+}
+
+unsigned int MappedPointCloud::get_N_blocks() const{
+	return static_cast<unsigned int>(this -> blocks.size());
+}
+
+const MappedPointCloud::Block & MappedPointCloud::get_block(unsigned int block_index) const{
+	return this -> blocks[block_index];
+}
+
+bool MappedPointCloud::has_normals() const{
+	return (this -> header -> flags & POINT_CLOUD_BINARY_NORMALS) != 0;
+}
+
+bool MappedPointCloud::is_single_precision() const{
+	return (this -> header -> flags & POINT_CLOUD_BINARY_SINGLE_PRECISION) != 0;
+}
+
+unsigned int MappedPointCloud::get_descriptor_size() const{
+	return this -> header -> descriptor_size;
+}
+
+arma::vec::fixed<3> MappedPointCloud::get_bbox_min() const{
+	return arma::vec::fixed<3>(this -> header -> bbox_min);
+}
+
+arma::vec::fixed<3> MappedPointCloud::get_bbox_max() const{
+	return arma::vec::fixed<3>(this -> header -> bbox_max);
+}
+
+const MappedPointCloud::Block & MappedPointCloud::find_block(unsigned int index,unsigned int & local_index) const{
+
+	if (index >= this -> size()){
+		throw(std::runtime_error("MappedPointCloud: point index out of range"));
+	}
+
+	unsigned int b = static_cast<unsigned int>(std::upper_bound(this -> blocks_begin.begin(),
+		this -> blocks_begin.end(),index) - this -> blocks_begin.begin()) - 1;
+
+	local_index = index - this -> blocks_begin[b];
+	return this -> blocks[b];
+
+}
+
+double MappedPointCloud::get_scalar(const void * array,std::size_t k) const{
+
+	if (this -> is_single_precision()){
+		return static_cast<const float *>(array)[k];
+	}
+	return static_cast<const double *>(array)[k];
+
+}
+
+arma::vec::fixed<3> MappedPointCloud::get_point_coordinates(unsigned int index) const{
+
+	unsigned int local_index;
+	const Block & block = this -> find_block(index,local_index);
+
+	arma::vec::fixed<3> point;
+	for (int k = 0; k < 3; ++k){
+		point(k) = this -> get_scalar(block.positions,3 * local_index + k);
+	}
+	return point;
+
+}
+
+arma::vec::fixed<3> MappedPointCloud::get_normal_coordinates(unsigned int index) const{
+
+	unsigned int local_index;
+	const Block & block = this -> find_block(index,local_index);
+
+	arma::vec::fixed<3> normal = arma::zeros<arma::vec>(3);
+	if (block.normals != nullptr){
+		for (int k = 0; k < 3; ++k){
+			normal(k) = this -> get_scalar(block.normals,3 * local_index + k);
+		}
+	}
+	return normal;
+
+}
+
+int MappedPointCloud::get_global_index(unsigned int index) const{
+
+	unsigned int local_index;
+	const Block & block = this -> find_block(index,local_index);
+	return block.indices[local_index];
+
+}
+
+arma::vec MappedPointCloud::get_descriptor(unsigned int index) const{
+
+	unsigned int local_index;
+	const Block & block = this -> find_block(index,local_index);
+
+	std::size_t D = this -> header -> descriptor_size;
+	arma::vec descriptor(D);
+	for (std::size_t k = 0; k < D; ++k){
+		descriptor(k) = this -> get_scalar(block.descriptors,D * local_index + k);
+	}
+	return descriptor;
+
+}
+
+void MappedPointCloud::load(PointCloud<PointNormal> & pc) const{
+
+	pc.clear();
+
+	arma::vec::fixed<3> point;
+	arma::vec::fixed<3> normal = arma::zeros<arma::vec>(3);
+
+	for (unsigned int b = 0; b < this -> blocks.size(); ++b){
+
+		const Block & block = this -> blocks[b];
+
+		for (unsigned int i = 0; i < block.N_points; ++i){
+
+			for (int k = 0; k < 3; ++k){
+				point(k) = this -> get_scalar(block.positions,3 * i + k);
+			}
+
+			if (block.normals != nullptr){
+				for (int k = 0; k < 3; ++k){
+					normal(k) = this -> get_scalar(block.normals,3 * i + k);
+				}
+			}
+
+			pc.push_back(PointNormal(point,normal,block.indices[i]));
+		}
+	}
+
+}
+
+void MappedPointCloud::load(PointCloud<PointDescriptor> & pc) const{
+
+	std::size_t D = this -> header -> descriptor_size;
+	if (D == 0){
+		throw(std::runtime_error("MappedPointCloud::load: the file holds no descriptors"));
+	}
+
+	pc.clear();
+
+	arma::vec histogram(D);
+
+	for (unsigned int b = 0; b < this -> blocks.size(); ++b){
+
+		const Block & block = this -> blocks[b];
+
+		for (unsigned int i = 0; i < block.N_points; ++i){
+
+			for (std::size_t k = 0; k < D; ++k){
+				histogram(k) = this -> get_scalar(block.descriptors,D * i + k);
+			}
+
+			PointDescriptor descriptor(histogram);
+			descriptor.set_global_index(block.indices[i]);
+			pc.push_back(descriptor);
+		}
+	}
+
+}
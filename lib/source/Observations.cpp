@@ -44,8 +44,12 @@ arma::vec Observations::obs_lidar_range_true(double t,
 	arma::vec ranges = arma::vec(focal_plane -> size());
 
 	#if IOFLAGS_observations
+	#if IOFLAGS_binary_range_images
+	lidar -> save_range_image(args.get_output_dir() + "/range_images_true.bin",t);
+	#else
 	lidar -> save(args.get_output_dir() + "/pc_true_" + std::to_string(t),true);
 	#endif
+	#endif
 
 	for (unsigned int i = 0; i < ranges.n_rows; ++i){
 		ranges(i) = focal_plane -> at(i) -> get_true_range();
@@ -107,8 +111,12 @@ arma::vec Observations::obs_lidar_range_computed(
 	arma::vec ranges = arma::vec(focal_plane -> size());
 	
 	#if IOFLAGS_observations
+	#if IOFLAGS_binary_range_images
+	lidar -> save_range_image(args.get_output_dir() + "/range_images_bezier.bin",t);
+	#else
 	lidar -> save(args.get_output_dir() + "/pc_bezier_" + std::to_string(t),true);
 	#endif
+	#endif
 
 	for (unsigned int i = 0; i < ranges.n_rows; ++i){
 		ranges(i) = focal_plane -> at(i) -> get_true_range();
@@ -1,5 +1,7 @@
 #include "PFH.hpp"
 #include <armadillo>
+#include <algorithm>
+#include <vector>
 #include "PointNormal.hpp"
 
 PFH::PFH() : PointDescriptor(){
@@ -12,31 +14,43 @@ PFH::PFH(const std::vector<int> & indices,
 	const PointCloud<PointNormal> & pc): PointDescriptor(){
 
 	this -> type = 0;
-	arma::vec::fixed<3> u,v,w,p_i,p_j,n_j;
 	int N_global_bins = 3 * N_bins;
 	
 	this -> histogram = arma::zeros<arma::vec>(N_global_bins);
 
-	int alpha_bin_index,phi_bin_index,theta_bin_index;
-	
-	for (int i = 0; i < indices.size(); ++i){
-		const PointNormal & pi = pc.get_point(indices[i]);
-
-		for (int j = 0; j < i; ++j){
-
-			const PointNormal & pj = pc. get_point(indices[j]);
-
-			
-			this -> compute_darboux_frames_local_hist( alpha_bin_index,phi_bin_index,theta_bin_index, N_bins,
-				pi.get_point_coordinates(),
-				pi.get_normal_coordinates(),
-				pj.get_point_coordinates(),
-				pj.get_normal_coordinates());
-
-			this -> histogram[theta_bin_index] += 1.;
-			this -> histogram[N_bins + alpha_bin_index] += 1.;
-			this -> histogram[2 * N_bins + phi_bin_index] += 1.;
+	// The points are gathered in contiguous blocks, so that the pairs formed by each point
+	// with the points before it are binned in a single vectorized pass
+	unsigned int N_points = indices.size();
+	std::vector<double> points(3 * N_points);
+	std::vector<double> normals(3 * N_points);
+
+	for (unsigned int i = 0; i < N_points; ++i){
+		const arma::vec::fixed<3> p = pc.get_point_coordinates(indices[i]);
+		const arma::vec::fixed<3> n = pc.get_normal_coordinates(indices[i]);
+		std::copy(p.begin(),p.end(),points.begin() + 3 * i);
+		std::copy(n.begin(),n.end(),normals.begin() + 3 * i);
+	}
 
+	std::vector<int> alpha_bin_indices(N_points);
+	std::vector<int> phi_bin_indices(N_points);
+	std::vector<int> theta_bin_indices(N_points);
+	
+	for (unsigned int i = 0; i < N_points; ++i){
+
+		PointDescriptor::compute_darboux_bins(i,
+			points.data() + 3 * i,
+			normals.data() + 3 * i,
+			points.data(),
+			normals.data(),
+			N_bins,
+			alpha_bin_indices.data(),
+			phi_bin_indices.data(),
+			theta_bin_indices.data());
+
+		for (unsigned int j = 0; j < i; ++j){
+			this -> histogram[theta_bin_indices[j]] += 1.;
+			this -> histogram[N_bins + alpha_bin_indices[j]] += 1.;
+			this -> histogram[2 * N_bins + phi_bin_indices[j]] += 1.;
 		}
 	}
 
@@ -0,0 +1,76 @@
+#include "Philox.hpp"
+
+// Multipliers and Weyl increments of Philox4x32
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+
+uint64_t Philox::seed = 0;
+
+
+Philox::Philox(uint32_t domain, uint32_t stream_0, uint32_t stream_1) : Philox(Philox::seed,domain,stream_0,stream_1){
+
+}
+
+Philox::Philox(uint64_t seed, uint32_t domain, uint32_t stream_0, uint32_t stream_1){
+
+	this -> key[0] = uint32_t(seed);
+	this -> key[1] = uint32_t(seed >> 32);
+
+	this -> counter[0] = 0;
+	this -> counter[1] = stream_0;
+	this -> counter[2] = stream_1;
+	this -> counter[3] = domain;
+
+}
+
+void Philox::set_seed(uint64_t seed){
+	Philox::seed = seed;
+}
+
+uint64_t Philox::get_seed(){
+	return Philox::seed;
+}
+
+void Philox::generate(const uint32_t * counter, const uint32_t * key, uint32_t * output){
+
+	uint32_t c[4] = {counter[0],counter[1],counter[2],counter[3]};
+	uint32_t k[2] = {key[0],key[1]};
+
+	for (unsigned int round = 0; round < PHILOX_ROUNDS; ++round){
+
+		if (round > 0){
+			k[0] += PHILOX_W0;
+			k[1] += PHILOX_W1;
+		}
+
+		uint64_t p0 = uint64_t(PHILOX_M0) * c[0];
+		uint64_t p1 = uint64_t(PHILOX_M1) * c[2];
+
+		uint32_t hi0 = uint32_t(p0 >> 32);
+		uint32_t lo0 = uint32_t(p0);
+		uint32_t hi1 = uint32_t(p1 >> 32);
+		uint32_t lo1 = uint32_t(p1);
+
+		c[0] = hi1 ^ c[1] ^ k[0];
+		c[1] = lo1;
+		c[2] = hi0 ^ c[3] ^ k[1];
+		c[3] = lo0;
+
+	}
+
+	for (unsigned int i = 0; i < 4; ++i){
+		output[i] = c[i];
+	}
+
+}
+
+double Philox::normal(){
+
+	double u_1 = this -> uniform();
+	double u_2 = this -> uniform();
+
+	return std::sqrt(- 2 * std::log(u_1)) * std::cos(2 * M_PI * u_2);
+
+}
@@ -1,10 +1,28 @@
 #include <PointCloud.hpp>
 #include <PointNormal.hpp>
-#include <KDTree.hpp>
+#include <DynamicKDTree.hpp>
+#include <PointNeighborhoods.hpp>
+#include <VoxelHashGrid.hpp>
+#include <MappedPointCloud.hpp>
 #include <Ray.hpp>
+#include <Lidar.hpp>
+#include <Philox.hpp>
+
+#include <array>
+#include <numeric>
+#include <unordered_map>
 
 #define PC_DEBUG_FLAG 1
 
+// Number of consecutive queries processed by a thread when computing all the neighborhoods
+#define PC_NEIGHBORHOODS_CHUNK_SIZE 256
+
+// Relative tolerance on the number of points kept by the downsamplings to a target count
+#define PC_DOWNSAMPLING_COUNT_TOLERANCE 0.02
+
+// Maximum number of downsamplings run when searching the spacing giving a target count
+#define PC_DOWNSAMPLING_MAX_ITERATIONS 20
+
 
 template <class PointType> PointCloud<PointType>::PointCloud(){
 }
@@ -16,12 +34,25 @@ this -> points.resize(size);
 template <>
 PointCloud<PointNormal>::PointCloud(std::vector<std::shared_ptr<Ray> > * focal_plane){
 
+	// The pixel of each point is kept when the rays belong to a lidar
+	Lidar * lidar = (focal_plane -> size() > 0) ? focal_plane -> at(0) -> get_lidar() : nullptr;
+	if (lidar != nullptr){
+		this -> organized_rows = static_cast<unsigned int>(lidar -> get_y_res());
+		this -> organized_cols = static_cast<unsigned int>(lidar -> get_z_res());
+		this -> organized_indices.assign(this -> organized_rows * this -> organized_cols,-1);
+	}
+
 	for (int i = 0; i < focal_plane -> size(); ++i){
 
 		if (focal_plane -> at(i) -> get_hit_element() >= 0){
 
 			const arma::vec::fixed<3> & impact_point = focal_plane -> at(i) -> get_impact_point();
 
+			if (lidar != nullptr){
+				this -> organized_indices[focal_plane -> at(i) -> get_row_index()
+				+ focal_plane -> at(i) -> get_col_index() * this -> organized_rows] = this -> points.size();
+			}
+
 			PointNormal point(impact_point,this -> points.size());
 			this -> points.push_back(point);
 
@@ -41,8 +72,8 @@ PointCloud<PointType>::PointCloud(const std::vector< PointType > & points) {
 	// The valid measurements used to form the point cloud are extracted
 	for (unsigned int i = 0; i < points.size(); ++i) {
 
-		this -> points[i].set_global_index(i);
 		this -> points.push_back(points[i]);
+		this -> points.back().set_global_index(i);
 
 	}
 
@@ -53,8 +84,9 @@ int PointCloud<PointType>::get_closest_point(const arma::vec & test_point) const
 
 	double distance = std::numeric_limits<double>::infinity();
 	int closest_point_index = -1;
+	arma::vec::fixed<3> buffer;
 
-	this -> kdt  -> closest_point_search(test_point,this -> kdt,closest_point_index,distance,this);
+	this -> kdt -> closest_point_search(this -> to_kdtree_frame(test_point,buffer),closest_point_index,distance);
 
 	return closest_point_index;
 
@@ -66,13 +98,23 @@ const unsigned int & N) const {
 
 	std::map<double,int > closest_points;
 	double distance = std::numeric_limits<double>::infinity();
+	arma::vec::fixed<3> buffer;
 
-	this -> kdt -> closest_N_point_search(test_point,N,this -> kdt,distance,closest_points,this);
+	this -> kdt -> closest_N_point_search(this -> to_kdtree_frame(test_point,buffer),N,distance,closest_points);
 
 	return closest_points;
 
 }
 
+template <class PointType> unsigned int PointCloud<PointType>::get_closest_N_points(const arma::vec & test_point, 
+	unsigned int N,int * closest_indices,double * closest_distances) const {
+
+	arma::vec::fixed<3> buffer;
+	return this -> kdt -> closest_N_point_search(this -> to_kdtree_frame(test_point,buffer).memptr(),
+		N,closest_indices,closest_distances);
+
+}
+
 
 template <class PointType> PointCloud<PointType>::PointCloud(std::vector< std::shared_ptr<PointCloud< PointType > > > & pcs,int points_retained){
 
@@ -106,11 +148,13 @@ for (unsigned int i = 0; i < pcs.size();++i){
 }
 
 
-template <class PointType> const PointType & PointCloud<PointType>::get_point(unsigned int index) const{
+template <class PointType> typename PointStorage<PointType>::const_reference PointCloud<PointType>::get_point(unsigned int index) const{
+this -> apply_transform();
 return this -> points[index];
 }
 
-template <class PointType>  PointType & PointCloud<PointType>::get_point(unsigned int index) {
+template <class PointType> typename PointStorage<PointType>::reference PointCloud<PointType>::get_point(unsigned int index) {
+this -> apply_transform();
 return this -> points[index];
 }
 
@@ -122,35 +166,178 @@ return this -> points.size();
 
 template <class PointType> std::vector<int> PointCloud<PointType>::get_nearest_neighbors_radius(const arma::vec & test_point, const double & radius) const{
 std::vector< int > neighbors_indices;
-this -> kdt -> radius_point_search(test_point,this -> kdt,radius,neighbors_indices,this);
+arma::vec::fixed<3> buffer;
+if (this -> voxel_grid != nullptr){
+	this -> voxel_grid -> radius_point_search(this -> to_kdtree_frame(test_point,buffer),radius,neighbors_indices);
+}
+else{
+	this -> kdt -> radius_point_search(this -> to_kdtree_frame(test_point,buffer),radius,neighbors_indices);
+}
 return neighbors_indices;
 }
 
 
+template <class PointType> 
+void PointCloud<PointType>::get_kdtree_queries(std::vector<int> & query_order,std::vector<const double *> & query_points) const{
+
+	// Queries are run in the leaf order of each tree of the KD Tree, from the coordinates stored
+	// in the tree so that a pending transform does not need to be applied
+	query_order.clear();
+	query_points.clear();
+
+	for (unsigned int t = 0; t < this -> kdt -> get_N_trees(); ++t){
+
+		const std::vector<int> & tree_indices = this -> kdt -> get_tree(t).get_indices();
+		const std::vector<double> & tree_coordinates = this -> kdt -> get_tree(t).get_coordinates();
+		unsigned int dimension = tree_coordinates.size() / tree_indices.size();
+
+		for (unsigned int q = 0; q < tree_indices.size(); ++q){
+			query_order.push_back(tree_indices[q]);
+			query_points.push_back(tree_coordinates.data() + q * dimension);
+		}
+
+	}
+
+}
+
+template <class PointType> 
+void PointCloud<PointType>::compute_neighborhoods_radius(const double & radius,PointNeighborhoods & neighborhoods) const{
+
+	std::vector<int> query_order;
+	std::vector<const double *> query_points;
+	this -> get_kdtree_queries(query_order,query_points);
+	unsigned int N_queries = query_order.size();
+	unsigned int N_chunks = (N_queries + PC_NEIGHBORHOODS_CHUNK_SIZE - 1) / PC_NEIGHBORHOODS_CHUNK_SIZE;
+
+	// The neighborhoods of each chunk of queries are first gathered separately,
+	// since their sizes are not known in advance
+	std::vector<std::vector<int> > chunk_indices(N_chunks);
+	std::vector<std::vector<double> > chunk_squared_distances(N_chunks);
+	std::vector<unsigned int> & offsets = neighborhoods.offsets;
+	offsets.assign(this -> size() + 1,0);
+
+	#pragma omp parallel for schedule(dynamic)
+	for (unsigned int c = 0; c < N_chunks; ++c){
+
+		unsigned int end = std::min(N_queries,(c + 1) * PC_NEIGHBORHOODS_CHUNK_SIZE);
+
+		for (unsigned int q = c * PC_NEIGHBORHOODS_CHUNK_SIZE; q < end; ++q){
+
+			int i = query_order[q];
+			unsigned int size_before = chunk_indices[c].size();
+
+			if (this -> voxel_grid != nullptr){
+				this -> voxel_grid -> radius_point_search(query_points[q],radius,
+					chunk_indices[c],chunk_squared_distances[c]);
+			}
+			else{
+				this -> kdt -> radius_point_search(query_points[q],radius,
+					chunk_indices[c],chunk_squared_distances[c]);
+			}
+
+			// The size of neighborhood i is temporarily stored in offsets[i + 1]
+			offsets[i + 1] = chunk_indices[c].size() - size_before;
+		}
+
+	}
+
+	for (unsigned int i = 0; i < this -> size(); ++i){
+		offsets[i + 1] += offsets[i];
+	}
+
+	neighborhoods.indices.resize(offsets.back());
+	neighborhoods.squared_distances.resize(offsets.back());
+
+	// Each chunk is then copied at its place in the adjacency
+	#pragma omp parallel for schedule(dynamic)
+	for (unsigned int c = 0; c < N_chunks; ++c){
+
+		unsigned int end = std::min(N_queries,(c + 1) * PC_NEIGHBORHOODS_CHUNK_SIZE);
+		unsigned int position = 0;
+
+		for (unsigned int q = c * PC_NEIGHBORHOODS_CHUNK_SIZE; q < end; ++q){
+
+			int i = query_order[q];
+			unsigned int N_neighbors = offsets[i + 1] - offsets[i];
+
+			std::copy(chunk_indices[c].begin() + position,chunk_indices[c].begin() + position + N_neighbors,
+				neighborhoods.indices.begin() + offsets[i]);
+			std::copy(chunk_squared_distances[c].begin() + position,chunk_squared_distances[c].begin() + position + N_neighbors,
+				neighborhoods.squared_distances.begin() + offsets[i]);
+
+			position += N_neighbors;
+		}
+
+	}
+
+}
+
+template <class PointType> 
+void PointCloud<PointType>::compute_neighborhoods_N(const unsigned int & N,PointNeighborhoods & neighborhoods) const{
+
+	std::vector<int> query_order;
+	std::vector<const double *> query_points;
+	this -> get_kdtree_queries(query_order,query_points);
+	unsigned int N_queries = query_order.size();
+	unsigned int N_neighbors = std::min(N,N_queries);
+
+	// Every point in the KD Tree gets exactly N_neighbors neighbors,
+	// so the adjacency can be laid out before searching
+	std::vector<unsigned int> & offsets = neighborhoods.offsets;
+	offsets.assign(this -> size() + 1,0);
+
+	for (unsigned int q = 0; q < N_queries; ++q){
+		offsets[query_order[q] + 1] = N_neighbors;
+	}
+
+	for (unsigned int i = 0; i < this -> size(); ++i){
+		offsets[i + 1] += offsets[i];
+	}
+
+	neighborhoods.indices.resize(offsets.back());
+	neighborhoods.squared_distances.resize(offsets.back());
+
+	#pragma omp parallel for schedule(dynamic,PC_NEIGHBORHOODS_CHUNK_SIZE)
+	for (unsigned int q = 0; q < N_queries; ++q){
+
+		int i = query_order[q];
+
+		this -> kdt -> closest_N_point_search(query_points[q],N_neighbors,
+			neighborhoods.indices.data() + offsets[i],
+			neighborhoods.squared_distances.data() + offsets[i]);
+
+	}
+
+}
+
+
 template <class PointType> void PointCloud<PointType>::push_back(const PointType & point){
+this -> apply_transform();
 this -> points.push_back(point);
 }
 
-template <> const arma::vec & PointCloud<PointNormal>::get_point_coordinates(int i) const{
-return this -> points[i].get_point_coordinates();
+template <> arma::vec::fixed<3> PointCloud<PointNormal>::get_point_coordinates(int i) const{
+this -> apply_transform();
+return this -> points.get_point_coordinates(i);
 }
 
 
-template <> const arma::vec & PointCloud<PointDescriptor>::get_point_coordinates(int i) const{
-return this -> points[i].get_histogram();
+template <> arma::vec PointCloud<PointDescriptor>::get_point_coordinates(int i) const{
+return this -> points.get_histogram(i);
 }
 
 
-template <> const arma::vec & PointCloud<PointNormal>::get_normal_coordinates(int i) const{
-return this -> points[i].get_normal_coordinates();
+template <> arma::vec::fixed<3> PointCloud<PointNormal>::get_normal_coordinates(int i) const{
+this -> apply_transform();
+return this -> points.get_normal_coordinates(i);
 }
 
 
 template <> 
-const arma::vec & PointCloud<PointDescriptor>::get_normal_coordinates(int i) const{
+arma::vec PointCloud<PointDescriptor>::get_normal_coordinates(int i) const{
 	throw(std::runtime_error("PointCloud<PointDescriptor>::get_normal_coordinates(int i) is not defined"));
 	// The following will never be returned, it's merely to silence a compiler warning
-	return this -> points[i].get_histogram();
+	return this -> points.get_histogram(i);
 }
 
 
@@ -161,6 +348,12 @@ PointCloud<PointNormal>::PointCloud(std::string filename,bool is_txt){
 
 	std::cout << "Reading " << filename << std::endl;
 
+	// Files in the binary format are mapped instead of parsed
+	if (MappedPointCloud::is_binary(filename)){
+		MappedPointCloud(filename).load(*this);
+		return;
+	}
+
 	std::ifstream ifs(filename);
 
 	if (!ifs.is_open()) {
@@ -248,6 +441,12 @@ void PointCloud<PointType>::build_kdtree(bool verbose){
 		std::cout << "- building kd tree ..." << std::endl;
 	}
 
+	// The tree is built in the frame the points are in once the pending transform is applied
+	this -> apply_transform();
+	this -> kdt_dcm = arma::eye<arma::mat>(3,3);
+	this -> kdt_x = arma::zeros<arma::vec>(3);
+	this -> kdt_transformed = false;
+
 	std::vector<int> indices;
 	for (int i =0; i < this -> size(); ++i){
 		if (this -> check_if_point_valid(i)){
@@ -255,9 +454,13 @@ void PointCloud<PointType>::build_kdtree(bool verbose){
 		}
 	}
 
-	this -> kdt = std::make_shared< KDTree<PointCloud,PointType> >(KDTree< PointCloud,PointType> ());
-	if (indices.size() > 0)
-		this -> kdt -> build(indices,0,this);
+	this -> kdt = std::make_shared< DynamicKDTree<PointCloud,PointType> >(DynamicKDTree< PointCloud,PointType> ());
+	this -> kdt -> build(indices,this);
+	this -> kdt_end = this -> size();
+
+	if (this -> voxel_grid != nullptr){
+		this -> build_voxel_grid(this -> voxel_grid -> get_cell_size());
+	}
 
 	auto end = std::chrono::system_clock::now();
 
@@ -270,27 +473,542 @@ void PointCloud<PointType>::build_kdtree(bool verbose){
 
 
 template <class PointType> 
-PointType & PointCloud<PointType>::operator[] (const int index){
+void PointCloud<PointType>::update_kdtree(){
+
+	if (this -> kdt == nullptr){
+		this -> build_kdtree(false);
+		return;
+	}
+
+	// The new points are brought to the frame the KD Tree was built in
+	std::vector<int> indices;
+	std::vector<double> coordinates;
+	arma::vec::fixed<3> buffer;
+
+	for (unsigned int i = this -> kdt_end; i < this -> size(); ++i){
+		if (this -> check_if_point_valid(i)){
+			typename PointCoordinates<PointType>::type point_coordinates = this -> get_point_coordinates(i);
+			const arma::vec & point = this -> to_kdtree_frame(point_coordinates,buffer);
+			indices.push_back(i);
+			coordinates.insert(coordinates.end(),point.begin(),point.end());
+		}
+	}
+
+	this -> kdt -> insert(indices,coordinates);
+	this -> kdt_end = this -> size();
+
+	if (this -> voxel_grid != nullptr){
+		this -> build_voxel_grid(this -> voxel_grid -> get_cell_size());
+	}
+
+}
+
+template <class PointType> 
+void PointCloud<PointType>::build_voxel_grid(const double & cell_size){
+
+	if (cell_size <= 0){
+		this -> voxel_grid = nullptr;
+		return;
+	}
+
+	if (this -> kdt == nullptr){
+		this -> build_kdtree(false);
+	}
+
+	// The grid holds the points of the KD Tree, in the same frame
+	std::vector<int> indices;
+	std::vector<double> coordinates;
+
+	for (unsigned int t = 0; t < this -> kdt -> get_N_trees(); ++t){
+		const std::vector<int> & tree_indices = this -> kdt -> get_tree(t).get_indices();
+		const std::vector<double> & tree_coordinates = this -> kdt -> get_tree(t).get_coordinates();
+		indices.insert(indices.end(),tree_indices.begin(),tree_indices.end());
+		coordinates.insert(coordinates.end(),tree_coordinates.begin(),tree_coordinates.end());
+	}
+
+	std::shared_ptr<VoxelHashGrid> grid = std::make_shared<VoxelHashGrid>();
+	grid -> build(indices,coordinates,cell_size);
+	this -> voxel_grid = grid;
+
+}
+
+
+template <class PointType> 
+bool PointCloud<PointType>::is_organized() const{
+	return this -> organized_indices.size() > 0;
+}
+
+template <class PointType> 
+bool PointCloud<PointType>::has_kdtree() const{
+	return this -> kdt != nullptr;
+}
+
+template <class PointType> 
+unsigned int PointCloud<PointType>::get_organized_rows() const{
+	return this -> organized_rows;
+}
+
+template <class PointType> 
+unsigned int PointCloud<PointType>::get_organized_cols() const{
+	return this -> organized_cols;
+}
+
+template <class PointType> 
+int PointCloud<PointType>::get_organized_index(unsigned int row_index,unsigned int col_index) const{
+	return this -> organized_indices[row_index + col_index * this -> organized_rows];
+}
+
+
+template <class PointType> 
+typename PointStorage<PointType>::reference PointCloud<PointType>::operator[] (const int index){
+	this -> apply_transform();
 	return this -> points[index];
 }
 
 template <>
 void PointCloud<PointNormal>::transform(const arma::mat::fixed<3,3> & dcm,const arma::vec::fixed<3> & x){
 
-	// The valid measurements used to form the point cloud are extracted
+	// The KDTree is only built if missing, in the current frame of the points.
+	// Otherwise, the transform is appended to the one mapping the tree to the points
+	if (this -> kdt == nullptr){
+		this -> build_kdtree(false);
+	}
+
+	this -> kdt_x = dcm * this -> kdt_x + x;
+	this -> kdt_dcm = dcm * this -> kdt_dcm;
+	this -> kdt_transformed = true;
+
+	// The points are only rewritten when next accessed
+	if (this -> pending_transform){
+		this -> pending_x = dcm * this -> pending_x + x;
+		this -> pending_dcm = dcm * this -> pending_dcm;
+	}
+	else{
+		this -> pending_x = x;
+		this -> pending_dcm = dcm;
+		this -> pending_transform = 1;
+	}
+
+}
+
+template <>
+void PointCloud<PointNormal>::transform_points() const{
+
+	this -> points.transform(this -> pending_dcm,this -> pending_x);
+
+}
+
+template <>
+void PointCloud<PointDescriptor>::transform_points() const{
+	throw(std::runtime_error("PointCloud<PointDescriptor>::transform_points() is not defined"));
+}
+
+template <class PointType>
+void PointCloud<PointType>::apply_transform() const{
+
+	int pending;
+	#pragma omp atomic read seq_cst
+	pending = this -> pending_transform;
+
+	if (!pending){
+		return;
+	}
+
+	// The first thread to get there applies the transform, the others wait for it
+	#pragma omp critical (point_cloud_transform)
+	{
+		if (this -> pending_transform){
+
+			this -> transform_points();
+			this -> pending_dcm = arma::eye<arma::mat>(3,3);
+			this -> pending_x = arma::zeros<arma::vec>(3);
+
+			#pragma omp atomic write seq_cst
+			this -> pending_transform = 0;
+		}
+	}
+
+}
+
+template <class PointType>
+const arma::vec & PointCloud<PointType>::to_kdtree_frame(const arma::vec & test_point,arma::vec::fixed<3> & buffer) const{
+
+	if (!this -> kdt_transformed){
+		return test_point;
+	}
+
+	buffer = this -> kdt_dcm.t() * (test_point - this -> kdt_x);
+	return buffer;
+
+}
+
+
+// Integer coordinates of a voxel
+typedef std::array<std::int64_t,3> VoxelIndex;
+
+struct VoxelIndexHash {
+	std::size_t operator()(const VoxelIndex & voxel) const{
+		std::uint64_t hash = std::uint64_t(voxel[0]) * 0x9E3779B97F4A7C15ull;
+		hash = (hash ^ (hash >> 29)) + std::uint64_t(voxel[1]) * 0xBF58476D1CE4E5B9ull;
+		hash = (hash ^ (hash >> 29)) + std::uint64_t(voxel[2]) * 0x94D049BB133111EBull;
+		return std::size_t(hash ^ (hash >> 32));
+	}
+};
+
+// Sorts the points by voxel, keeping their input order within each voxel.
+// order: input: order of the points, output: points sorted by voxel.
+// voxels: occupied voxels. voxels_begin: position in order of the first point of each voxel, followed by the number of points
+static void sort_by_voxel(const std::vector<double> & coordinates,
+	double cell_size,
+	std::vector<int> & order,
+	std::vector<VoxelIndex> & voxels,
+	std::vector<int> & voxels_begin){
+
+	int N = static_cast<int>(order.size());
+	std::vector<VoxelIndex> point_voxels(N);
+
+	#pragma omp parallel for
+	for (int i = 0; i < N; ++i){
+		for (int k = 0; k < 3; ++k){
+			point_voxels[i][k] = std::int64_t(std::floor(coordinates[3 * i + k] / cell_size));
+		}
+	}
+
+	std::stable_sort(order.begin(),order.end(),[&](int a, int b){
+		return point_voxels[a] < point_voxels[b];
+	});
+
+	voxels.clear();
+	voxels_begin.clear();
+	for (int p = 0; p < N; ++p){
+		if (p == 0 || point_voxels[order[p]] != voxels.back()){
+			voxels.push_back(point_voxels[order[p]]);
+			voxels_begin.push_back(p);
+		}
+	}
+	voxels_begin.push_back(N);
+
+}
+
+// Length of the diagonal of the bounding box of the points
+static double get_bounding_box_diagonal(const PointNormalColumns & points){
+
+	arma::vec::fixed<3> bbox_min,bbox_max;
+	points.get_bounding_box(bbox_min,bbox_max);
+
+	return arma::norm(bbox_max - bbox_min);
+
+}
+
+// Replaces the content of downsampled_pc with the first point of points, reindexed. Used when
+// all the points coincide, so that any spacing keeps a single one of them
+static void keep_first_point(const PointNormalColumns & points,PointCloud<PointNormal> & downsampled_pc){
+
+	PointNormal point = points[0];
+	point.set_global_index(0);
+	downsampled_pc = PointCloud<PointNormal>(std::vector<PointNormal>(1,point));
+
+}
+
+// Searches the spacing of a downsampling keeping about N_points points, downsample(spacing) running the
+// downsampling and returning the number of points kept. The number of kept points decreases with the spacing,
+// roughly as its inverse square on surfaces, which drives the search within a bracket of the solution
+template <class Downsample>
+static double find_downsampling_spacing(unsigned int N_points,double diagonal,Downsample downsample){
+
+	double lower_spacing = 0;
+	double upper_spacing = diagonal;
+	double spacing = diagonal / std::sqrt(double(N_points));
+
+	double best_spacing = spacing;
+	double best_error = std::numeric_limits<double>::infinity();
+	double last_spacing = spacing;
+
+	for (int iteration = 0; iteration < PC_DOWNSAMPLING_MAX_ITERATIONS; ++iteration){
+
+		unsigned int N_kept = downsample(spacing);
+		last_spacing = spacing;
+
+		double error = std::abs(double(N_kept) - N_points);
+		if (error < best_error){
+			best_error = error;
+			best_spacing = spacing;
+		}
+
+		if (error <= PC_DOWNSAMPLING_COUNT_TOLERANCE * N_points){
+			break;
+		}
+
+		if (N_kept > N_points){
+			lower_spacing = spacing;
+		}
+		else{
+			upper_spacing = spacing;
+		}
+
+		spacing = spacing * std::sqrt(std::max(double(N_kept),1.) / N_points);
+		if (!(spacing > lower_spacing && spacing < upper_spacing)){
+			spacing = 0.5 * (lower_spacing + upper_spacing);
+		}
+	}
+
+	if (best_spacing != last_spacing){
+		downsample(best_spacing);
+	}
+
+	return best_spacing;
+
+}
+
+template <>
+void PointCloud<PointNormal>::downsample_voxel_grid(const double & cell_size,PointCloud<PointNormal> & downsampled_pc,bool use_centroids) const{
+
+	if (cell_size <= 0){
+		throw(std::runtime_error("PointCloud<PointNormal>::downsample_voxel_grid: the voxel size must be positive"));
+	}
+
+	this -> apply_transform();
+	int N = static_cast<int>(this -> points.size());
+
+	std::vector<double> coordinates(3 * N);
+	#pragma omp parallel for
+	for (int i = 0; i < N; ++i){
+		arma::vec::fixed<3> point = this -> points.get_point_coordinates(i);
+		std::copy(point.begin(),point.end(),coordinates.begin() + 3 * i);
+	}
+
+	std::vector<int> order(N);
+	std::iota(order.begin(),order.end(),0);
+	std::vector<VoxelIndex> voxels;
+	std::vector<int> voxels_begin;
+	sort_by_voxel(coordinates,cell_size,order,voxels,voxels_begin);
+
+	int N_voxels = static_cast<int>(voxels.size());
+	std::vector<PointNormal> kept_points(N_voxels);
+
+	#pragma omp parallel for
+	for (int v = 0; v < N_voxels; ++v){
+
+		arma::vec::fixed<3> centroid = arma::zeros<arma::vec>(3);
+		arma::vec::fixed<3> mean_normal = arma::zeros<arma::vec>(3);
+		for (int p = voxels_begin[v]; p < voxels_begin[v + 1]; ++p){
+			centroid += this -> points.get_point_coordinates(order[p]);
+			mean_normal += this -> points.get_normal_coordinates(order[p]);
+		}
+		centroid /= (voxels_begin[v + 1] - voxels_begin[v]);
+
+		if (use_centroids){
+			double norm = arma::norm(mean_normal);
+			if (norm > 0){
+				mean_normal /= norm;
+			}
+			kept_points[v] = PointNormal(centroid,mean_normal,v);
+		}
+		else{
+			int closest_point = order[voxels_begin[v]];
+			double closest_distance = std::numeric_limits<double>::infinity();
+			for (int p = voxels_begin[v]; p < voxels_begin[v + 1]; ++p){
+				double distance = arma::norm(this -> points.get_point_coordinates(order[p]) - centroid);
+				if (distance < closest_distance){
+					closest_distance = distance;
+					closest_point = order[p];
+				}
+			}
+			kept_points[v] = this -> points[closest_point];
+			kept_points[v].set_global_index(v);
+		}
+	}
+
+	downsampled_pc = PointCloud<PointNormal>(kept_points);
+
+}
+
+template <>
+void PointCloud<PointNormal>::downsample_poisson_disk(const double & spacing,PointCloud<PointNormal> & downsampled_pc) const{
+
+	if (spacing <= 0){
+		throw(std::runtime_error("PointCloud<PointNormal>::downsample_poisson_disk: the spacing must be positive"));
+	}
+
+	this -> apply_transform();
+	int N = static_cast<int>(this -> points.size());
+
+	std::vector<double> coordinates(3 * N);
 	#pragma omp parallel for
-	for (unsigned int i = 0; i < this -> size(); ++i) {
-		PointNormal & p = this -> points.at(i);
-		p.set_point_coordinates(dcm * p. get_point_coordinates() + x);
-		p.set_normal_coordinates(dcm * p. get_normal_coordinates());
+	for (int i = 0; i < N; ++i){
+		arma::vec::fixed<3> point = this -> points.get_point_coordinates(i);
+		std::copy(point.begin(),point.end(),coordinates.begin() + 3 * i);
+	}
+
+	// The points are visited in random order within each voxel. The voxels have a diagonal of spacing,
+	// so each holds at most one kept point and conflicting points are at most two voxels apart along each axis
+	arma::uvec random_order = arma::regspace<arma::uvec>(0,N - 1);
+	Philox rng(PHILOX_DOMAIN_DOWNSAMPLING,0,0);
+	rng.shuffle(random_order);
+
+	std::vector<int> order(random_order.begin(),random_order.end());
+	std::vector<VoxelIndex> voxels;
+	std::vector<int> voxels_begin;
+	sort_by_voxel(coordinates,spacing / std::sqrt(3.),order,voxels,voxels_begin);
+
+	int N_voxels = static_cast<int>(voxels.size());
+	std::unordered_map<VoxelIndex,int,VoxelIndexHash> voxel_map;
+	voxel_map.reserve(N_voxels);
+	for (int v = 0; v < N_voxels; ++v){
+		voxel_map[voxels[v]] = v;
+	}
+
+	// Voxels whose coordinates agree modulo 3 are at least two voxels apart along one axis,
+	// so they cannot hold conflicting points and are processed in parallel
+	std::vector<std::vector<int> > phases(27);
+	for (int v = 0; v < N_voxels; ++v){
+		int phase = 0;
+		for (int k = 0; k < 3; ++k){
+			phase = 3 * phase + int(((voxels[v][k] % 3) + 3) % 3);
+		}
+		phases[phase].push_back(v);
+	}
+
+	std::vector<int> samples(N_voxels,-1);
+	double squared_spacing = spacing * spacing;
+
+	for (int phase = 0; phase < 27; ++phase){
+
+		const std::vector<int> & phase_voxels = phases[phase];
+
+		#pragma omp parallel for schedule(dynamic,PC_NEIGHBORHOODS_CHUNK_SIZE)
+		for (unsigned int c = 0; c < phase_voxels.size(); ++c){
+
+			int v = phase_voxels[c];
+
+			for (int p = voxels_begin[v]; p < voxels_begin[v + 1] && samples[v] < 0; ++p){
+
+				const double * point = coordinates.data() + 3 * order[p];
+				bool conflict = false;
+
+				for (int di = -2; di <= 2 && !conflict; ++di){
+					for (int dj = -2; dj <= 2 && !conflict; ++dj){
+						for (int dk = -2; dk <= 2 && !conflict; ++dk){
+
+							auto neighbor = voxel_map.find({{voxels[v][0] + di,voxels[v][1] + dj,voxels[v][2] + dk}});
+							if (neighbor == voxel_map.end() || samples[neighbor -> second] < 0){
+								continue;
+							}
+
+							const double * sample = coordinates.data() + 3 * samples[neighbor -> second];
+							double squared_distance = (point[0] - sample[0]) * (point[0] - sample[0])
+							+ (point[1] - sample[1]) * (point[1] - sample[1])
+							+ (point[2] - sample[2]) * (point[2] - sample[2]);
+
+							conflict = (squared_distance < squared_spacing);
+						}
+					}
+				}
+
+				if (!conflict){
+					samples[v] = order[p];
+				}
+			}
+		}
 	}
 
-	// The KDTree is rebuilt
+	std::vector<PointNormal> kept_points;
+	for (int v = 0; v < N_voxels; ++v){
+		if (samples[v] >= 0){
+			kept_points.push_back(this -> points[samples[v]]);
+			kept_points.back().set_global_index(static_cast<int>(kept_points.size()) - 1);
+		}
+	}
 
-	this -> build_kdtree(false);
+	downsampled_pc = PointCloud<PointNormal>(kept_points);
 
 }
 
+template <>
+double PointCloud<PointNormal>::downsample_voxel_grid_to_count(unsigned int N_points,PointCloud<PointNormal> & downsampled_pc,bool use_centroids) const{
+
+	if (N_points == 0){
+		throw(std::runtime_error("PointCloud<PointNormal>::downsample_voxel_grid_to_count: the number of points to keep must be positive"));
+	}
+
+	this -> apply_transform();
+
+	if (N_points >= this -> size()){
+		PointNormalColumns kept_points = this -> points;
+		for (unsigned int i = 0; i < kept_points.size(); ++i){
+			kept_points.set_global_index(i,i);
+		}
+		downsampled_pc.clear();
+		downsampled_pc.points = std::move(kept_points);
+		return 0;
+	}
+
+	double diagonal = get_bounding_box_diagonal(this -> points);
+	if (diagonal == 0){
+		keep_first_point(this -> points,downsampled_pc);
+		return 0;
+	}
+
+	return find_downsampling_spacing(N_points,diagonal,
+		[&](double cell_size){
+			this -> downsample_voxel_grid(cell_size,downsampled_pc,use_centroids);
+			return downsampled_pc.size();
+		});
+
+}
+
+template <>
+double PointCloud<PointNormal>::downsample_poisson_disk_to_count(unsigned int N_points,PointCloud<PointNormal> & downsampled_pc) const{
+
+	if (N_points == 0){
+		throw(std::runtime_error("PointCloud<PointNormal>::downsample_poisson_disk_to_count: the number of points to keep must be positive"));
+	}
+
+	this -> apply_transform();
+
+	if (N_points >= this -> size()){
+		PointNormalColumns kept_points = this -> points;
+		for (unsigned int i = 0; i < kept_points.size(); ++i){
+			kept_points.set_global_index(i,i);
+		}
+		downsampled_pc.clear();
+		downsampled_pc.points = std::move(kept_points);
+		return 0;
+	}
+
+	double diagonal = get_bounding_box_diagonal(this -> points);
+	if (diagonal == 0){
+		keep_first_point(this -> points,downsampled_pc);
+		return 0;
+	}
+
+	return find_downsampling_spacing(N_points,diagonal,
+		[&](double spacing){
+			this -> downsample_poisson_disk(spacing,downsampled_pc);
+			return downsampled_pc.size();
+		});
+
+}
+
+template <>
+void PointCloud<PointDescriptor>::downsample_voxel_grid(const double & cell_size,PointCloud<PointDescriptor> & downsampled_pc,bool use_centroids) const{
+	throw(std::runtime_error("PointCloud<PointDescriptor>::downsample_voxel_grid is not defined"));
+}
+
+template <>
+double PointCloud<PointDescriptor>::downsample_voxel_grid_to_count(unsigned int N_points,PointCloud<PointDescriptor> & downsampled_pc,bool use_centroids) const{
+	throw(std::runtime_error("PointCloud<PointDescriptor>::downsample_voxel_grid_to_count is not defined"));
+}
+
+template <>
+void PointCloud<PointDescriptor>::downsample_poisson_disk(const double & spacing,PointCloud<PointDescriptor> & downsampled_pc) const{
+	throw(std::runtime_error("PointCloud<PointDescriptor>::downsample_poisson_disk is not defined"));
+}
+
+template <>
+double PointCloud<PointDescriptor>::downsample_poisson_disk_to_count(unsigned int N_points,PointCloud<PointDescriptor> & downsampled_pc) const{
+	throw(std::runtime_error("PointCloud<PointDescriptor>::downsample_poisson_disk_to_count is not defined"));
+}
 
 template <>
 bool PointCloud<PointNormal>::check_if_point_valid(int i) const{
@@ -300,7 +1018,26 @@ bool PointCloud<PointNormal>::check_if_point_valid(int i) const{
 
 template <>
 bool PointCloud<PointDescriptor>::check_if_point_valid(int i) const{
-	return this -> points[i].get_is_valid_feature();
+	return this -> points.get_is_valid_feature(i);
+}
+
+
+template <class PointType>
+const typename PointStorage<PointType>::type & PointCloud<PointType>::get_points() const{
+	this -> apply_transform();
+	return this -> points;
+}
+
+
+template <>
+void PointCloud<PointNormal>::set_descriptor_size(unsigned int descriptor_size){
+	throw(std::runtime_error("PointCloud<PointNormal>::set_descriptor_size is not defined"));
+}
+
+
+template <>
+void PointCloud<PointDescriptor>::set_descriptor_size(unsigned int descriptor_size){
+	this -> points.set_descriptor_size(descriptor_size);
 }
 
 
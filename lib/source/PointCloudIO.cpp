@@ -2,6 +2,115 @@
 #include <PointNormal.hpp>
 #include <PointDescriptor.hpp>
 
+#include <limits>
+#include <cstring>
+#include <fstream>
+
+
+// Writes values as an array of scalars of the precision of the file, padded to a multiple of 8 bytes
+static void write_binary_array(std::ostream & file,const std::vector<double> & values,bool single_precision){
+
+	std::size_t size;
+	if (single_precision){
+		std::vector<float> single_values(values.begin(),values.end());
+		size = single_values.size() * sizeof(float);
+		file.write(reinterpret_cast<const char *>(single_values.data()),size);
+	}
+	else{
+		size = values.size() * sizeof(double);
+		file.write(reinterpret_cast<const char *>(values.data()),size);
+	}
+
+	const char padding[8] = {0,0,0,0,0,0,0,0};
+	file.write(padding,(8 - size % 8) % 8);
+
+}
+
+// Writes a point cloud at the current position of the file as a new block, and updates the file header
+static void write_binary_block(std::ostream & file,
+	MappedPointCloud::FileHeader & header,
+	const PointCloud<PointNormal> & pc, 
+	const arma::mat::fixed<3,3> & dcm, 
+	const arma::vec::fixed<3> & x,
+	const PointCloud<PointDescriptor> * pc_features){
+
+	unsigned int N = pc.size();
+	bool single_precision = (header.flags & POINT_CLOUD_BINARY_SINGLE_PRECISION) != 0;
+
+	if ((pc_features == nullptr) != (header.descriptor_size == 0)){
+		throw(std::runtime_error("PointCloudIO: descriptors must be saved along all the blocks of a binary point cloud, or none"));
+	}
+
+	if (pc_features != nullptr && pc_features -> size() != N){
+		throw(std::runtime_error("PointCloudIO: the point cloud and its descriptors must have as many points"));
+	}
+
+	MappedPointCloud::BlockHeader block_header;
+	block_header.N_points = N;
+
+	std::vector<double> positions(3 * N);
+	std::vector<double> normals(3 * N);
+	std::vector<std::int32_t> indices(N);
+
+	for (int k = 0; k < 3; ++k){
+		block_header.bbox_min[k] = std::numeric_limits<double>::infinity();
+		block_header.bbox_max[k] = - std::numeric_limits<double>::infinity();
+	}
+
+	for (unsigned int i = 0; i < N; ++i){
+
+		arma::vec::fixed<3> p = dcm * pc.get_point_coordinates(i) + x;
+		arma::vec::fixed<3> n = dcm * pc.get_normal_coordinates(i);
+
+		for (int k = 0; k < 3; ++k){
+			positions[3 * i + k] = p(k);
+			normals[3 * i + k] = n(k);
+			block_header.bbox_min[k] = std::min(block_header.bbox_min[k],p(k));
+			block_header.bbox_max[k] = std::max(block_header.bbox_max[k],p(k));
+		}
+
+		indices[i] = pc.get_point(i).get_global_index();
+	}
+
+	file.write(reinterpret_cast<const char *>(&block_header),sizeof(block_header));
+	write_binary_array(file,positions,single_precision);
+	if (header.flags & POINT_CLOUD_BINARY_NORMALS){
+		write_binary_array(file,normals,single_precision);
+	}
+
+	const char padding[8] = {0,0,0,0,0,0,0,0};
+	file.write(reinterpret_cast<const char *>(indices.data()),N * sizeof(std::int32_t));
+	file.write(padding,(8 - (N * sizeof(std::int32_t)) % 8) % 8);
+
+	if (pc_features != nullptr){
+		// All the descriptors of a point cloud have the same size
+		const DescriptorMatrix & features = pc_features -> get_points();
+		if (features.get_descriptor_size() != header.descriptor_size){
+			throw(std::runtime_error("PointCloudIO: all the descriptors of a binary point cloud must have the same size"));
+		}
+
+		std::vector<double> descriptors;
+		descriptors.reserve(header.descriptor_size * N);
+		for (unsigned int i = 0; i < N; ++i){
+			const float * histogram = features.get_histogram_data(i);
+			descriptors.insert(descriptors.end(),histogram,histogram + header.descriptor_size);
+		}
+		write_binary_array(file,descriptors,single_precision);
+	}
+
+	if (!file){
+		throw(std::runtime_error("PointCloudIO: could not write the binary point cloud"));
+	}
+
+	header.N_blocks += 1;
+	header.N_points += N;
+	for (int k = 0; k < 3; ++k){
+		header.bbox_min[k] = std::min(header.bbox_min[k],block_header.bbox_min[k]);
+		header.bbox_max[k] = std::max(header.bbox_max[k],block_header.bbox_max[k]);
+	}
+
+}
+
 template<>
 void PointCloudIO<PointNormal>::save_to_obj(
 	const PointCloud<PointNormal> & pc, 
@@ -53,6 +162,99 @@ void PointCloudIO<PointNormal>::save_to_txt(const PointCloud<PointNormal> & pc,
 
 }
 
+template<>
+void PointCloudIO<PointNormal>::save_to_binary(const PointCloud<PointNormal> & pc, 
+	std::string savepath,const arma::mat::fixed<3,3> & dcm, const arma::vec::fixed<3> & x,
+	bool single_precision,const PointCloud<PointDescriptor> * pc_features){
+
+	MappedPointCloud::FileHeader header;
+	std::memset(&header,0,sizeof(header));
+	std::strncpy(header.magic,POINT_CLOUD_BINARY_MAGIC,sizeof(header.magic));
+	header.version = POINT_CLOUD_BINARY_VERSION;
+	header.byte_order = POINT_CLOUD_BINARY_BYTE_ORDER;
+	header.flags = POINT_CLOUD_BINARY_NORMALS;
+	if (single_precision){
+		header.flags |= POINT_CLOUD_BINARY_SINGLE_PRECISION;
+	}
+
+	if (pc_features != nullptr){
+		header.descriptor_size = pc_features -> get_points().get_descriptor_size();
+		if (header.descriptor_size == 0){
+			pc_features = nullptr;
+		}
+	}
+
+	for (int k = 0; k < 3; ++k){
+		header.bbox_min[k] = std::numeric_limits<double>::infinity();
+		header.bbox_max[k] = - std::numeric_limits<double>::infinity();
+	}
+
+	std::ofstream file(savepath,std::ios::binary | std::ios::trunc);
+	if (!file.is_open()){
+		throw(std::runtime_error("PointCloudIO::save_to_binary: could not open " + savepath));
+	}
+
+	file.write(reinterpret_cast<const char *>(&header),sizeof(header));
+	write_binary_block(file,header,pc,dcm,x,pc_features);
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char *>(&header),sizeof(header));
+
+}
+
+template<>
+void PointCloudIO<PointNormal>::append_to_binary(const PointCloud<PointNormal> & pc, 
+	std::string savepath,const arma::mat::fixed<3,3> & dcm, const arma::vec::fixed<3> & x,
+	const PointCloud<PointDescriptor> * pc_features){
+
+	MappedPointCloud::FileHeader header;
+
+	std::fstream file(savepath,std::ios::binary | std::ios::in | std::ios::out);
+	if (!file.is_open()){
+		PointCloudIO<PointNormal>::save_to_binary(pc,savepath,dcm,x,false,pc_features);
+		return;
+	}
+
+	if (!file.read(reinterpret_cast<char *>(&header),sizeof(header))){
+		throw(std::runtime_error("PointCloudIO::append_to_binary: " + savepath + " is too small to be a binary point cloud"));
+	}
+	MappedPointCloud::check_header(header,savepath);
+
+	// The new block starts right after the last one
+	std::size_t offset = sizeof(header);
+	for (unsigned int b = 0; b < header.N_blocks; ++b){
+		MappedPointCloud::BlockHeader block_header;
+		file.seekg(offset);
+		if (!file.read(reinterpret_cast<char *>(&block_header),sizeof(block_header))){
+			throw(std::runtime_error("PointCloudIO::append_to_binary: " + savepath + " is truncated"));
+		}
+		offset += MappedPointCloud::get_block_size(header,block_header.N_points);
+	}
+
+	file.seekp(offset);
+	write_binary_block(file,header,pc,dcm,x,pc_features);
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char *>(&header),sizeof(header));
+
+}
+
+template<>
+void PointCloudIO<PointDescriptor>::save_to_binary(const PointCloud<PointDescriptor> & pc, 
+	std::string savepath,const arma::mat::fixed<3,3> & dcm, const arma::vec::fixed<3> & x,
+	bool single_precision,const PointCloud<PointDescriptor> * pc_features){
+
+	throw(std::runtime_error("Descriptors are saved to binary along the point cloud they describe"));
+}
+
+template<>
+void PointCloudIO<PointDescriptor>::append_to_binary(const PointCloud<PointDescriptor> & pc, 
+	std::string savepath,const arma::mat::fixed<3,3> & dcm, const arma::vec::fixed<3> & x,
+	const PointCloud<PointDescriptor> * pc_features){
+
+	throw(std::runtime_error("Descriptors are saved to binary along the point cloud they describe"));
+}
+
 template<>
 void PointCloudIO<PointDescriptor>::save_to_obj(const PointCloud<PointDescriptor> & pc, 
 	std::string savepath,const arma::mat::fixed<3,3> & dcm, const arma::vec::fixed<3> & x){
@@ -68,7 +270,7 @@ void PointCloudIO<PointDescriptor>::save_to_txt(const PointCloud<PointDescriptor
 	feature_file.open(savepath);
 
 	for (unsigned int index = 0;index < pc.size();++index) {
-		const arma::vec & hist = pc.get_point(index).get_histogram();
+		arma::vec hist = pc.get_point_coordinates(index);
 		int feature_size = hist.size();
 
 		for (int i = 0; i < feature_size; ++i){
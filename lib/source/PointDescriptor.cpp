@@ -61,44 +61,82 @@ void PointDescriptor::compute_darboux_frames_local_hist( int & alpha_bin_index,
 	const arma::vec::fixed<3> & p_j,
 	const arma::vec::fixed<3> & n_j) {
 
+	PointDescriptor::compute_darboux_bins(1,p_i.memptr(),n_i.memptr(),p_j.memptr(),n_j.memptr(),N_bins,
+		&alpha_bin_index,&phi_bin_index,&theta_bin_index);
 
+}
 
-	arma::vec::fixed<3> d = arma::normalise(p_j - p_i);
-	arma::vec::fixed<3> n1(n_i);
-	arma::vec::fixed<3> n2(n_j);
 
+// Bin of a value wrapped within [0,1], clamped so that a value of exactly 1 falls in the last bin
+static inline int get_bin_index(double value,int N_bins){
+	return std::min(std::max(static_cast<int>(std::floor(value * N_bins)),0),N_bins - 1);
+}
 
-	double angle_1 = arma::dot(n_i,d);
-	double angle_2 = arma::dot(n_j,d);
-	double phi;
+void PointDescriptor::compute_darboux_bins(unsigned int N_pairs,
+	const double * p_i,const double * n_i,const double * p_j,const double * n_j,int N_bins,
+	int * alpha_bin_indices,int * phi_bin_indices,int * theta_bin_indices){
 
-	// Ensures consistency of pair orientations
-	if (std::acos(std::abs(angle_1)) > std::acos(std::abs(angle_2))){
-		n1 = n_j;
-		n2 = n_i;
-		d *= -1.;
-		phi = - angle_2;
-	}
-	else{
-		phi = angle_1;
-	}
+	#pragma omp simd
+	for (unsigned int j = 0; j < N_pairs; ++j){
 
+		const double * p = p_j + 3 * j;
+		const double * n = n_j + 3 * j;
 
-	arma::vec::fixed<3> v = arma::normalise(arma::cross(d,n1));
-	arma::vec::fixed<3> w = arma::cross(n1,v);
+		double d[3] = {p[0] - p_i[0],p[1] - p_i[1],p[2] - p_i[2]};
+		double d_norm = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		double inverse_d_norm = d_norm > 0 ? 1. / d_norm : 0.;
+		for (int k = 0; k < 3; ++k){
+			d[k] *= inverse_d_norm;
+		}
 
-	double alpha = arma::dot(v,n2);
-	double theta = std::atan2(arma::dot(w,n2),arma::dot(n1,n2));
+		double angle_1 = n_i[0] * d[0] + n_i[1] * d[1] + n_i[2] * d[2];
+		double angle_2 = n[0] * d[0] + n[1] * d[1] + n[2] * d[2];
+
+		// Ensures consistency of pair orientations. acos being decreasing,
+		// acos(|angle_1|) > acos(|angle_2|) amounts to |angle_1| < |angle_2|
+		bool swap = std::abs(angle_1) < std::abs(angle_2);
+		double sign = swap ? -1. : 1.;
+		double phi = swap ? - angle_2 : angle_1;
+
+		double n1[3];
+		double n2[3];
+		for (int k = 0; k < 3; ++k){
+			n1[k] = swap ? n[k] : n_i[k];
+			n2[k] = swap ? n_i[k] : n[k];
+			d[k] *= sign;
+		}
 
+		double v[3] = {
+			d[1] * n1[2] - d[2] * n1[1],
+			d[2] * n1[0] - d[0] * n1[2],
+			d[0] * n1[1] - d[1] * n1[0]
+		};
+		double v_norm = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		double inverse_v_norm = v_norm > 0 ? 1. / v_norm : 0.;
+		for (int k = 0; k < 3; ++k){
+			v[k] *= inverse_v_norm;
+		}
 
-	// All values are wrapped within [0,1]
-	alpha = 0.5 * ( 1. + alpha);
-	phi = 0.5 * ( 1. + phi);
-	theta = (theta + arma::datum::pi) * 1.0 / (2.0 * arma::datum::pi);
+		double w[3] = {
+			n1[1] * v[2] - n1[2] * v[1],
+			n1[2] * v[0] - n1[0] * v[2],
+			n1[0] * v[1] - n1[1] * v[0]
+		};
 
-	alpha_bin_index = static_cast<int>(std::floor(alpha * N_bins));
-	phi_bin_index = static_cast<int>(std::floor(phi  * N_bins));
-	theta_bin_index = static_cast<int>(std::floor(theta  * N_bins));
+		double alpha = v[0] * n2[0] + v[1] * n2[1] + v[2] * n2[2];
+		double theta = std::atan2(w[0] * n2[0] + w[1] * n2[1] + w[2] * n2[2],
+			n1[0] * n2[0] + n1[1] * n2[1] + n1[2] * n2[2]);
+
+		// All values are wrapped within [0,1]
+		alpha = 0.5 * ( 1. + alpha);
+		phi = 0.5 * ( 1. + phi);
+		theta = (theta + arma::datum::pi) * 1.0 / (2.0 * arma::datum::pi);
+
+		alpha_bin_indices[j] = get_bin_index(alpha,N_bins);
+		phi_bin_indices[j] = get_bin_index(phi,N_bins);
+		theta_bin_indices[j] = get_bin_index(theta,N_bins);
+
+	}
 
 }
 
@@ -107,6 +145,10 @@ int PointDescriptor::get_type() const{
 	return this -> type;
 }
 
+void PointDescriptor::set_type(int type){
+	this -> type = type;
+}
+
 
 
 int PointDescriptor::get_global_index() const{
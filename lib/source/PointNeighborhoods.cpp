@@ -0,0 +1,87 @@
+#include <PointNeighborhoods.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+
+unsigned int PointNeighborhoods::size() const{
+	return this -> offsets.size() - 1;
+}
+
+unsigned int PointNeighborhoods::get_N_neighbors(unsigned int i) const{
+	return this -> offsets[i + 1] - this -> offsets[i];
+}
+
+const int * PointNeighborhoods::get_neighbors(unsigned int i) const{
+	return this -> indices.data() + this -> offsets[i];
+}
+
+const double * PointNeighborhoods::get_squared_distances(unsigned int i) const{
+	return this -> squared_distances.data() + this -> offsets[i];
+}
+
+unsigned int PointNeighborhoods::get_N_edges() const{
+	return this -> indices.size();
+}
+
+void PointNeighborhoods::clear(){
+	this -> offsets.assign(1,0);
+	this -> indices.clear();
+	this -> squared_distances.clear();
+}
+
+void PointNeighborhoods::restrict_to_radius(double radius,PointNeighborhoods & restricted_neighborhoods) const{
+
+	if (&restricted_neighborhoods == this){
+		throw(std::runtime_error("PointNeighborhoods::restrict_to_radius: the neighborhoods cannot be restricted in place"));
+	}
+
+	// The searches keep the neighbors whose squared distance is strictly below the squared radius
+	double squared_radius = radius * radius;
+
+	restricted_neighborhoods.clear();
+	restricted_neighborhoods.offsets.reserve(this -> offsets.size());
+
+	for (unsigned int i = 0; i < this -> size(); ++i){
+		for (unsigned int k = this -> offsets[i]; k < this -> offsets[i + 1]; ++k){
+			if (this -> squared_distances[k] < squared_radius){
+				restricted_neighborhoods.indices.push_back(this -> indices[k]);
+				restricted_neighborhoods.squared_distances.push_back(this -> squared_distances[k]);
+			}
+		}
+		restricted_neighborhoods.offsets.push_back(restricted_neighborhoods.indices.size());
+	}
+}
+
+void PointNeighborhoods::restrict_to_N(unsigned int N,PointNeighborhoods & restricted_neighborhoods) const{
+
+	if (&restricted_neighborhoods == this){
+		throw(std::runtime_error("PointNeighborhoods::restrict_to_N: the neighborhoods cannot be restricted in place"));
+	}
+
+	restricted_neighborhoods.clear();
+	restricted_neighborhoods.offsets.reserve(this -> offsets.size());
+	restricted_neighborhoods.indices.reserve(std::min<std::size_t>(this -> indices.size(),std::size_t(N) * this -> size()));
+	restricted_neighborhoods.squared_distances.reserve(restricted_neighborhoods.indices.capacity());
+
+	std::vector<unsigned int> order;
+
+	for (unsigned int i = 0; i < this -> size(); ++i){
+
+		unsigned int N_neighbors = this -> get_N_neighbors(i);
+		unsigned int N_kept = std::min(N,N_neighbors);
+		const double * distances = this -> get_squared_distances(i);
+
+		order.resize(N_neighbors);
+		std::iota(order.begin(),order.end(),0);
+		std::partial_sort(order.begin(),order.begin() + N_kept,order.end(),
+			[distances](unsigned int a,unsigned int b){ return distances[a] < distances[b]; });
+
+		for (unsigned int k = 0; k < N_kept; ++k){
+			restricted_neighborhoods.indices.push_back(this -> indices[this -> offsets[i] + order[k]]);
+			restricted_neighborhoods.squared_distances.push_back(distances[order[k]]);
+		}
+		restricted_neighborhoods.offsets.push_back(restricted_neighborhoods.indices.size());
+	}
+}
@@ -8,57 +8,44 @@ PointNormal::PointNormal(){
 }
 
 
-PointNormal::PointNormal(arma::vec point,int index) {
+PointNormal::PointNormal(const arma::vec & point,int index) {
 	this -> global_index = index;
-	this -> point = point;
+	this -> set_point_coordinates(point);
 }
 
-PointNormal::PointNormal(arma::vec point, arma::vec normal,int index) {
-	this -> point = point;
-	this -> normal = normal;
+PointNormal::PointNormal(const arma::vec & point,const arma::vec & normal,int index) {
+	this -> set_point_coordinates(point);
+	this -> set_normal_coordinates(normal);
 	this -> global_index = index;
 }
 
 
 
-const arma::vec & PointNormal::get_point_coordinates() const {
-	return this -> point;
+arma::vec::fixed<3> PointNormal::get_point_coordinates() const {
+	return arma::vec::fixed<3>(this -> point);
 }
 
-const arma::vec & PointNormal::get_normal_coordinates() const {
-	return this -> normal;
+arma::vec::fixed<3> PointNormal::get_normal_coordinates() const {
+	return arma::vec::fixed<3>(this -> normal);
 }
 
 
-void PointNormal::set_normal_coordinates(arma::vec normal) {
-	this -> normal = normal;
+void PointNormal::set_normal_coordinates(const arma::vec & normal) {
+	std::copy(normal.begin(),normal.begin() + 3,this -> normal);
 }
 
 
-void PointNormal::set_point_coordinates(arma::vec point) {
-	this -> point = point;
+void PointNormal::set_point_coordinates(const arma::vec & point) {
+	std::copy(point.begin(),point.begin() + 3,this -> point);
 }
 
 double PointNormal::distance(const std::shared_ptr<PointNormal> & other_point) const {
-	return arma::norm(this -> point - other_point -> get_point_coordinates());
+	return arma::norm(this -> get_point_coordinates() - other_point -> get_point_coordinates());
 }
 
 
 double PointNormal::distance(PointNormal * other_point) const {
-	return arma::norm(this -> point - other_point -> get_point_coordinates());
-}
-
-
-void PointNormal::decrement_inclusion_counter() {
-	this -> inclusion_counter = this -> inclusion_counter - 1;
-}
-
-int PointNormal::get_inclusion_counter() const {
-	return this -> inclusion_counter ;
-}
-
-void PointNormal::set_descriptor(const PointDescriptor & descriptor) {
-	this -> descriptor = descriptor;
+	return arma::norm(this -> get_point_coordinates() - other_point -> get_point_coordinates());
 }
 
 
@@ -69,4 +56,3 @@ void PointNormal::set_global_index (int global_index){
 	this -> global_index = global_index;
 }
 
-
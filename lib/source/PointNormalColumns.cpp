@@ -0,0 +1,193 @@
+#include <PointNormalColumns.hpp>
+#include <PointNormal.hpp>
+
+#include <algorithm>
+
+
+PointNormalColumns::Reference::Reference(PointNormalColumns * columns,unsigned int index){
+	this -> columns = columns;
+	this -> index = index;
+}
+
+PointNormalColumns::Reference & PointNormalColumns::Reference::operator=(const PointNormal & point){
+	this -> columns -> set_point_coordinates(this -> index,point.get_point_coordinates());
+	this -> columns -> set_normal_coordinates(this -> index,point.get_normal_coordinates());
+	this -> columns -> set_global_index(this -> index,point.get_global_index());
+	return *this;
+}
+
+PointNormalColumns::Reference & PointNormalColumns::Reference::operator=(const Reference & other){
+	return *this = PointNormal(other);
+}
+
+PointNormalColumns::Reference::operator PointNormal() const{
+	return static_cast<const PointNormalColumns &>(*this -> columns)[this -> index];
+}
+
+arma::vec::fixed<3> PointNormalColumns::Reference::get_point_coordinates() const{
+	return this -> columns -> get_point_coordinates(this -> index);
+}
+
+arma::vec::fixed<3> PointNormalColumns::Reference::get_normal_coordinates() const{
+	return this -> columns -> get_normal_coordinates(this -> index);
+}
+
+void PointNormalColumns::Reference::set_point_coordinates(const arma::vec & point){
+	this -> columns -> set_point_coordinates(this -> index,point);
+}
+
+void PointNormalColumns::Reference::set_normal_coordinates(const arma::vec & normal){
+	this -> columns -> set_normal_coordinates(this -> index,normal);
+}
+
+int PointNormalColumns::Reference::get_global_index() const{
+	return this -> columns -> get_global_index(this -> index);
+}
+
+void PointNormalColumns::Reference::set_global_index(int global_index){
+	this -> columns -> set_global_index(this -> index,global_index);
+}
+
+unsigned int PointNormalColumns::size() const{
+	return this -> global_indices.size();
+}
+
+void PointNormalColumns::resize(unsigned int N){
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> point_columns[axis].resize(N,0);
+		this -> normal_columns[axis].resize(N,0);
+	}
+	this -> global_indices.resize(N,0);
+}
+
+void PointNormalColumns::reserve(unsigned int N){
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> point_columns[axis].reserve(N);
+		this -> normal_columns[axis].reserve(N);
+	}
+	this -> global_indices.reserve(N);
+}
+
+void PointNormalColumns::clear(){
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> point_columns[axis].clear();
+		this -> normal_columns[axis].clear();
+	}
+	this -> global_indices.clear();
+}
+
+void PointNormalColumns::push_back(const PointNormal & point){
+
+	arma::vec::fixed<3> point_coordinates = point.get_point_coordinates();
+	arma::vec::fixed<3> normal_coordinates = point.get_normal_coordinates();
+
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> point_columns[axis].push_back(point_coordinates(axis));
+		this -> normal_columns[axis].push_back(normal_coordinates(axis));
+	}
+	this -> global_indices.push_back(point.get_global_index());
+}
+
+PointNormal PointNormalColumns::operator[](unsigned int i) const{
+	return PointNormal(this -> get_point_coordinates(i),this -> get_normal_coordinates(i),this -> global_indices[i]);
+}
+
+PointNormalColumns::Reference PointNormalColumns::operator[](unsigned int i){
+	return Reference(this,i);
+}
+
+PointNormalColumns::Reference PointNormalColumns::back(){
+	return Reference(this,this -> size() - 1);
+}
+
+arma::vec::fixed<3> PointNormalColumns::get_point_coordinates(unsigned int i) const{
+	return {this -> point_columns[0][i],this -> point_columns[1][i],this -> point_columns[2][i]};
+}
+
+arma::vec::fixed<3> PointNormalColumns::get_normal_coordinates(unsigned int i) const{
+	return {this -> normal_columns[0][i],this -> normal_columns[1][i],this -> normal_columns[2][i]};
+}
+
+void PointNormalColumns::set_point_coordinates(unsigned int i,const arma::vec & point){
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> point_columns[axis][i] = point(axis);
+	}
+}
+
+void PointNormalColumns::set_normal_coordinates(unsigned int i,const arma::vec & normal){
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		this -> normal_columns[axis][i] = normal(axis);
+	}
+}
+
+int PointNormalColumns::get_global_index(unsigned int i) const{
+	return this -> global_indices[i];
+}
+
+void PointNormalColumns::set_global_index(unsigned int i,int global_index){
+	this -> global_indices[i] = global_index;
+}
+
+const double * PointNormalColumns::get_point_column(unsigned int axis) const{
+	return this -> point_columns[axis].data();
+}
+
+const double * PointNormalColumns::get_normal_column(unsigned int axis) const{
+	return this -> normal_columns[axis].data();
+}
+
+void PointNormalColumns::transform(const arma::mat::fixed<3,3> & dcm,const arma::vec::fixed<3> & x){
+
+	double * px = this -> point_columns[0].data();
+	double * py = this -> point_columns[1].data();
+	double * pz = this -> point_columns[2].data();
+	double * nx = this -> normal_columns[0].data();
+	double * ny = this -> normal_columns[1].data();
+	double * nz = this -> normal_columns[2].data();
+
+	const double m00 = dcm(0,0), m01 = dcm(0,1), m02 = dcm(0,2);
+	const double m10 = dcm(1,0), m11 = dcm(1,1), m12 = dcm(1,2);
+	const double m20 = dcm(2,0), m21 = dcm(2,1), m22 = dcm(2,2);
+	const double x0 = x(0), x1 = x(1), x2 = x(2);
+	const int N = static_cast<int>(this -> size());
+
+	#pragma omp parallel for simd
+	for (int i = 0; i < N; ++i){
+
+		double p0 = px[i], p1 = py[i], p2 = pz[i];
+		px[i] = m00 * p0 + m01 * p1 + m02 * p2 + x0;
+		py[i] = m10 * p0 + m11 * p1 + m12 * p2 + x1;
+		pz[i] = m20 * p0 + m21 * p1 + m22 * p2 + x2;
+
+		double n0 = nx[i], n1 = ny[i], n2 = nz[i];
+		nx[i] = m00 * n0 + m01 * n1 + m02 * n2;
+		ny[i] = m10 * n0 + m11 * n1 + m12 * n2;
+		nz[i] = m20 * n0 + m21 * n1 + m22 * n2;
+	}
+
+}
+
+void PointNormalColumns::get_bounding_box(arma::vec::fixed<3> & bbox_min,arma::vec::fixed<3> & bbox_max) const{
+
+	bbox_min.fill(arma::datum::inf);
+	bbox_max.fill(-arma::datum::inf);
+
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		if (this -> size() > 0){
+			auto bounds = std::minmax_element(this -> point_columns[axis].begin(),this -> point_columns[axis].end());
+			bbox_min(axis) = *bounds.first;
+			bbox_max(axis) = *bounds.second;
+		}
+	}
+
+}
+
+std::size_t PointNormalColumns::get_memory_size() const{
+
+	std::size_t memory_size = sizeof(PointNormalColumns) + this -> global_indices.capacity() * sizeof(int);
+	for (unsigned int axis = 0; axis < 3; ++axis){
+		memory_size += (this -> point_columns[axis].capacity() + this -> normal_columns[axis].capacity()) * sizeof(double);
+	}
+	return memory_size;
+
+}
@@ -95,6 +95,14 @@ Lidar * Ray::get_lidar() {
 	return this -> lidar;
 }
 
+unsigned int Ray::get_row_index() const{
+	return this -> row_index;
+}
+
+unsigned int Ray::get_col_index() const{
+	return this -> col_index;
+}
+
 const arma::vec::fixed<3> & Ray::get_direction() const{
 	return this -> direction;
 }
@@ -136,6 +144,19 @@ void Ray::reset(ShapeModel<ControlPoint> * shape_model) {
 
 }
 
+void Ray::reset(const arma::vec::fixed<3> & origin_target_frame,
+	const arma::vec::fixed<3> & direction_target_frame) {
+
+	this -> true_range = std::numeric_limits<double>::infinity();
+	this -> hit_element = -1;
+
+	this -> direction_target_frame = direction_target_frame;
+	this -> origin_target_frame = origin_target_frame;
+
+	this -> incidence_angle = std::numeric_limits<double>::infinity();
+
+}
+
 bool Ray::intersection_inside(const arma::vec::fixed<3> & H, const Facet & facet, double tol) {
 
 
@@ -407,6 +428,10 @@ double Ray::get_incidence_angle() const{
 	return this -> incidence_angle;
 }
 
+void Ray::set_incidence_angle(double incidence_angle){
+	this -> incidence_angle = incidence_angle;
+}
+
 
 void Ray::set_impact_coords(const double & u,const double & v){
 	this -> u = u;
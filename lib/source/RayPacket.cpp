@@ -0,0 +1,455 @@
+#include "RayPacket.hpp"
+#include "Ray.hpp"
+#include "TriangleStore.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RAY_PACKET_X86 1
+#include <immintrin.h>
+#define RAY_PACKET_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RAY_PACKET_X86 0
+#define RAY_PACKET_TARGET(isa)
+#endif
+
+
+RayPacket::RayPacket() : RayPacket(RayPacket::get_best_kernel()){
+
+}
+
+RayPacket::RayPacket(Kernel kernel){
+	this -> kernel = RayPacket::is_supported(kernel) ? kernel : RayPacket::get_best_kernel();
+	this -> clear();
+}
+
+void RayPacket::clear(){
+
+	this -> N_rays = 0;
+
+	// Unused lanes carry a negative range so that they never register a hit
+	for (unsigned int i = 0; i < RAY_PACKET_SIZE; ++i){
+		for (unsigned int k = 0; k < 3; ++k){
+			this -> origin[k][i] = 0;
+			this -> direction[k][i] = 1;
+			this -> inv_direction[k][i] = 1;
+		}
+		this -> range[i] = -1;
+		this -> hit_elements[i] = -1;
+		this -> rays[i] = nullptr;
+	}
+}
+
+void RayPacket::add_ray(Ray * ray){
+
+	if (this -> N_rays == RAY_PACKET_SIZE){
+		throw(std::runtime_error("Ray packet is full"));
+	}
+
+	unsigned int i = this -> N_rays;
+
+	const arma::vec::fixed<3> & o = ray -> get_origin_target_frame();
+	const arma::vec::fixed<3> & u = ray -> get_direction_target_frame();
+
+	for (unsigned int k = 0; k < 3; ++k){
+		this -> origin[k][i] = o(k);
+		this -> direction[k][i] = u(k);
+		this -> inv_direction[k][i] = 1. / u(k);
+	}
+
+	this -> range[i] = ray -> get_true_range();
+	this -> hit_elements[i] = -1;
+	this -> rays[i] = ray;
+
+	++this -> N_rays;
+}
+
+unsigned int RayPacket::size() const{
+	return this -> N_rays;
+}
+
+Ray * RayPacket::get_ray(unsigned int i) const{
+	return this -> rays[i];
+}
+
+double RayPacket::get_range(unsigned int i) const{
+	return this -> range[i];
+}
+
+int RayPacket::get_hit_element(unsigned int i) const{
+	return this -> hit_elements[i];
+}
+
+bool RayPacket::is_direction_negative(unsigned int axis) const{
+	return this -> direction[axis][0] < 0;
+}
+
+RayPacket::Kernel RayPacket::get_kernel() const{
+	return this -> kernel;
+}
+
+bool RayPacket::is_supported(Kernel kernel){
+
+	switch (kernel){
+		case SCALAR:
+		return true;
+
+		#if RAY_PACKET_X86
+		case SSE2:
+		return __builtin_cpu_supports("sse2");
+		case AVX:
+		return __builtin_cpu_supports("avx");
+		#endif
+
+		default:
+		return false;
+	}
+
+}
+
+RayPacket::Kernel RayPacket::get_best_kernel(){
+
+	if (RayPacket::is_supported(AVX)){
+		return AVX;
+	}
+	else if (RayPacket::is_supported(SSE2)){
+		return SSE2;
+	}
+	return SCALAR;
+
+}
+
+
+unsigned int RayPacket::hit_bbox(const double * bbox_min, const double * bbox_max) const{
+
+	switch (this -> kernel){
+		case AVX:
+		return this -> hit_bbox_avx(bbox_min,bbox_max);
+		case SSE2:
+		return this -> hit_bbox_sse2(bbox_min,bbox_max);
+		default:
+		return this -> hit_bbox_scalar(bbox_min,bbox_max);
+	}
+
+}
+
+void RayPacket::hit_triangle(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+
+	switch (this -> kernel){
+		case AVX:
+		this -> hit_triangle_avx(P0,E1,E2,element,outside,mask);
+		break;
+		case SSE2:
+		this -> hit_triangle_sse2(P0,E1,E2,element,outside,mask);
+		break;
+		default:
+		this -> hit_triangle_scalar(P0,E1,E2,element,outside,mask);
+		break;
+	}
+
+}
+
+
+unsigned int RayPacket::hit_bbox_scalar(const double * bbox_min, const double * bbox_max) const{
+
+	unsigned int mask = 0;
+
+	for (unsigned int i = 0; i < this -> N_rays; ++i){
+
+		double t_min = 0;
+		double t_max = this -> range[i];
+
+		for (unsigned int k = 0; k < 3; ++k){
+			double t_0 = (bbox_min[k] - this -> origin[k][i]) * this -> inv_direction[k][i];
+			double t_1 = (bbox_max[k] - this -> origin[k][i]) * this -> inv_direction[k][i];
+
+			if (t_0 > t_1){
+				std::swap(t_0,t_1);
+			}
+
+			t_min = t_0 > t_min ? t_0 : t_min;
+			t_max = t_1 < t_max ? t_1 : t_max;
+		}
+
+		if (t_min <= t_max){
+			mask |= (1 << i);
+		}
+	}
+
+	return mask;
+
+}
+
+
+void RayPacket::hit_triangle_scalar(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+
+	for (unsigned int i = 0; i < this -> N_rays; ++i){
+
+		if (!(mask & (1 << i))){
+			continue;
+		}
+
+		const double dx = this -> direction[0][i];
+		const double dy = this -> direction[1][i];
+		const double dz = this -> direction[2][i];
+
+		// P = d x E2
+		double px = dy * E2[2] - dz * E2[1];
+		double py = dz * E2[0] - dx * E2[2];
+		double pz = dx * E2[1] - dy * E2[0];
+
+		// det > 0 if the ray travels against the triangle normal
+		double det = E1[0] * px + E1[1] * py + E1[2] * pz;
+
+		if ((outside && !(det > 0)) || det == 0){
+			continue;
+		}
+
+		double inv_det = 1. / det;
+
+		double sx = this -> origin[0][i] - P0[0];
+		double sy = this -> origin[1][i] - P0[1];
+		double sz = this -> origin[2][i] - P0[2];
+
+		double u = (sx * px + sy * py + sz * pz) * inv_det;
+
+		// Q = S x E1
+		double qx = sy * E1[2] - sz * E1[1];
+		double qy = sz * E1[0] - sx * E1[2];
+		double qz = sx * E1[1] - sy * E1[0];
+
+		double v = (dx * qx + dy * qy + dz * qz) * inv_det;
+		double t = (E2[0] * qx + E2[1] * qy + E2[2] * qz) * inv_det;
+
+		if (u >= - TRIANGLE_STORE_EDGE_TOL && v >= - TRIANGLE_STORE_EDGE_TOL && u + v <= 1 + TRIANGLE_STORE_EDGE_TOL && t > 0 && t < this -> range[i]){
+			this -> range[i] = t;
+			this -> hit_elements[i] = element;
+		}
+	}
+
+}
+
+
+#if RAY_PACKET_X86
+
+RAY_PACKET_TARGET("sse2")
+unsigned int RayPacket::hit_bbox_sse2(const double * bbox_min, const double * bbox_max) const{
+
+	unsigned int mask = 0;
+
+	for (unsigned int i = 0; i < this -> N_rays; i += 2){
+
+		__m128d t_min = _mm_setzero_pd();
+		__m128d t_max = _mm_load_pd(this -> range + i);
+
+		for (unsigned int k = 0; k < 3; ++k){
+			__m128d o = _mm_load_pd(this -> origin[k] + i);
+			__m128d inv = _mm_load_pd(this -> inv_direction[k] + i);
+			__m128d t_0 = _mm_mul_pd(_mm_sub_pd(_mm_set1_pd(bbox_min[k]),o),inv);
+			__m128d t_1 = _mm_mul_pd(_mm_sub_pd(_mm_set1_pd(bbox_max[k]),o),inv);
+
+			// The accumulated bounds are passed last so that NaNs leave them untouched
+			t_min = _mm_max_pd(_mm_min_pd(t_0,t_1),t_min);
+			t_max = _mm_min_pd(_mm_max_pd(t_0,t_1),t_max);
+		}
+
+		mask |= (unsigned int)(_mm_movemask_pd(_mm_cmple_pd(t_min,t_max))) << i;
+	}
+
+	return mask & ((1 << this -> N_rays) - 1);
+
+}
+
+
+RAY_PACKET_TARGET("sse2")
+void RayPacket::hit_triangle_sse2(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d one = _mm_set1_pd(1.);
+	const __m128d one_plus_tol = _mm_set1_pd(1. + TRIANGLE_STORE_EDGE_TOL);
+	const __m128d minus_tol = _mm_set1_pd(- TRIANGLE_STORE_EDGE_TOL);
+
+	for (unsigned int i = 0; i < this -> N_rays; i += 2){
+
+		if (!((mask >> i) & 3)){
+			continue;
+		}
+
+		__m128d dx = _mm_load_pd(this -> direction[0] + i);
+		__m128d dy = _mm_load_pd(this -> direction[1] + i);
+		__m128d dz = _mm_load_pd(this -> direction[2] + i);
+
+		__m128d px = _mm_sub_pd(_mm_mul_pd(dy,_mm_set1_pd(E2[2])),_mm_mul_pd(dz,_mm_set1_pd(E2[1])));
+		__m128d py = _mm_sub_pd(_mm_mul_pd(dz,_mm_set1_pd(E2[0])),_mm_mul_pd(dx,_mm_set1_pd(E2[2])));
+		__m128d pz = _mm_sub_pd(_mm_mul_pd(dx,_mm_set1_pd(E2[1])),_mm_mul_pd(dy,_mm_set1_pd(E2[0])));
+
+		__m128d det = _mm_add_pd(_mm_add_pd(
+			_mm_mul_pd(_mm_set1_pd(E1[0]),px),
+			_mm_mul_pd(_mm_set1_pd(E1[1]),py)),
+		_mm_mul_pd(_mm_set1_pd(E1[2]),pz));
+
+		__m128d valid = outside ? _mm_cmpgt_pd(det,zero) : _mm_cmpneq_pd(det,zero);
+		__m128d inv_det = _mm_div_pd(one,det);
+
+		__m128d sx = _mm_sub_pd(_mm_load_pd(this -> origin[0] + i),_mm_set1_pd(P0[0]));
+		__m128d sy = _mm_sub_pd(_mm_load_pd(this -> origin[1] + i),_mm_set1_pd(P0[1]));
+		__m128d sz = _mm_sub_pd(_mm_load_pd(this -> origin[2] + i),_mm_set1_pd(P0[2]));
+
+		__m128d u = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(sx,px),_mm_mul_pd(sy,py)),_mm_mul_pd(sz,pz)),inv_det);
+
+		__m128d qx = _mm_sub_pd(_mm_mul_pd(sy,_mm_set1_pd(E1[2])),_mm_mul_pd(sz,_mm_set1_pd(E1[1])));
+		__m128d qy = _mm_sub_pd(_mm_mul_pd(sz,_mm_set1_pd(E1[0])),_mm_mul_pd(sx,_mm_set1_pd(E1[2])));
+		__m128d qz = _mm_sub_pd(_mm_mul_pd(sx,_mm_set1_pd(E1[1])),_mm_mul_pd(sy,_mm_set1_pd(E1[0])));
+
+		__m128d v = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx,qx),_mm_mul_pd(dy,qy)),_mm_mul_pd(dz,qz)),inv_det);
+		__m128d t = _mm_mul_pd(_mm_add_pd(_mm_add_pd(
+			_mm_mul_pd(_mm_set1_pd(E2[0]),qx),
+			_mm_mul_pd(_mm_set1_pd(E2[1]),qy)),
+		_mm_mul_pd(_mm_set1_pd(E2[2]),qz)),inv_det);
+
+		__m128d r = _mm_load_pd(this -> range + i);
+
+		valid = _mm_and_pd(valid,_mm_cmpge_pd(u,minus_tol));
+		valid = _mm_and_pd(valid,_mm_cmpge_pd(v,minus_tol));
+		valid = _mm_and_pd(valid,_mm_cmple_pd(_mm_add_pd(u,v),one_plus_tol));
+		valid = _mm_and_pd(valid,_mm_cmpgt_pd(t,zero));
+		valid = _mm_and_pd(valid,_mm_cmplt_pd(t,r));
+
+		unsigned int hits = (unsigned int)(_mm_movemask_pd(valid)) & ((mask >> i) & 3);
+
+		if (hits){
+			alignas(16) double t_lanes[2];
+			_mm_store_pd(t_lanes,t);
+			for (unsigned int l = 0; l < 2; ++l){
+				if (hits & (1 << l)){
+					this -> range[i + l] = t_lanes[l];
+					this -> hit_elements[i + l] = element;
+				}
+			}
+		}
+	}
+
+}
+
+
+RAY_PACKET_TARGET("avx")
+unsigned int RayPacket::hit_bbox_avx(const double * bbox_min, const double * bbox_max) const{
+
+	unsigned int mask = 0;
+
+	for (unsigned int i = 0; i < this -> N_rays; i += 4){
+
+		__m256d t_min = _mm256_setzero_pd();
+		__m256d t_max = _mm256_load_pd(this -> range + i);
+
+		for (unsigned int k = 0; k < 3; ++k){
+			__m256d o = _mm256_load_pd(this -> origin[k] + i);
+			__m256d inv = _mm256_load_pd(this -> inv_direction[k] + i);
+			__m256d t_0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(bbox_min[k]),o),inv);
+			__m256d t_1 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(bbox_max[k]),o),inv);
+
+			t_min = _mm256_max_pd(_mm256_min_pd(t_0,t_1),t_min);
+			t_max = _mm256_min_pd(_mm256_max_pd(t_0,t_1),t_max);
+		}
+
+		mask |= (unsigned int)(_mm256_movemask_pd(_mm256_cmp_pd(t_min,t_max,_CMP_LE_OQ))) << i;
+	}
+
+	return mask & ((1 << this -> N_rays) - 1);
+
+}
+
+
+RAY_PACKET_TARGET("avx")
+void RayPacket::hit_triangle_avx(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d one = _mm256_set1_pd(1.);
+	const __m256d one_plus_tol = _mm256_set1_pd(1. + TRIANGLE_STORE_EDGE_TOL);
+	const __m256d minus_tol = _mm256_set1_pd(- TRIANGLE_STORE_EDGE_TOL);
+
+	for (unsigned int i = 0; i < this -> N_rays; i += 4){
+
+		if (!((mask >> i) & 15)){
+			continue;
+		}
+
+		__m256d dx = _mm256_load_pd(this -> direction[0] + i);
+		__m256d dy = _mm256_load_pd(this -> direction[1] + i);
+		__m256d dz = _mm256_load_pd(this -> direction[2] + i);
+
+		__m256d px = _mm256_sub_pd(_mm256_mul_pd(dy,_mm256_set1_pd(E2[2])),_mm256_mul_pd(dz,_mm256_set1_pd(E2[1])));
+		__m256d py = _mm256_sub_pd(_mm256_mul_pd(dz,_mm256_set1_pd(E2[0])),_mm256_mul_pd(dx,_mm256_set1_pd(E2[2])));
+		__m256d pz = _mm256_sub_pd(_mm256_mul_pd(dx,_mm256_set1_pd(E2[1])),_mm256_mul_pd(dy,_mm256_set1_pd(E2[0])));
+
+		__m256d det = _mm256_add_pd(_mm256_add_pd(
+			_mm256_mul_pd(_mm256_set1_pd(E1[0]),px),
+			_mm256_mul_pd(_mm256_set1_pd(E1[1]),py)),
+		_mm256_mul_pd(_mm256_set1_pd(E1[2]),pz));
+
+		__m256d valid = outside ? _mm256_cmp_pd(det,zero,_CMP_GT_OQ) : _mm256_cmp_pd(det,zero,_CMP_NEQ_OQ);
+		__m256d inv_det = _mm256_div_pd(one,det);
+
+		__m256d sx = _mm256_sub_pd(_mm256_load_pd(this -> origin[0] + i),_mm256_set1_pd(P0[0]));
+		__m256d sy = _mm256_sub_pd(_mm256_load_pd(this -> origin[1] + i),_mm256_set1_pd(P0[1]));
+		__m256d sz = _mm256_sub_pd(_mm256_load_pd(this -> origin[2] + i),_mm256_set1_pd(P0[2]));
+
+		__m256d u = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(sx,px),_mm256_mul_pd(sy,py)),_mm256_mul_pd(sz,pz)),inv_det);
+
+		__m256d qx = _mm256_sub_pd(_mm256_mul_pd(sy,_mm256_set1_pd(E1[2])),_mm256_mul_pd(sz,_mm256_set1_pd(E1[1])));
+		__m256d qy = _mm256_sub_pd(_mm256_mul_pd(sz,_mm256_set1_pd(E1[0])),_mm256_mul_pd(sx,_mm256_set1_pd(E1[2])));
+		__m256d qz = _mm256_sub_pd(_mm256_mul_pd(sx,_mm256_set1_pd(E1[1])),_mm256_mul_pd(sy,_mm256_set1_pd(E1[0])));
+
+		__m256d v = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx,qx),_mm256_mul_pd(dy,qy)),_mm256_mul_pd(dz,qz)),inv_det);
+		__m256d t = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(
+			_mm256_mul_pd(_mm256_set1_pd(E2[0]),qx),
+			_mm256_mul_pd(_mm256_set1_pd(E2[1]),qy)),
+		_mm256_mul_pd(_mm256_set1_pd(E2[2]),qz)),inv_det);
+
+		__m256d r = _mm256_load_pd(this -> range + i);
+
+		valid = _mm256_and_pd(valid,_mm256_cmp_pd(u,minus_tol,_CMP_GE_OQ));
+		valid = _mm256_and_pd(valid,_mm256_cmp_pd(v,minus_tol,_CMP_GE_OQ));
+		valid = _mm256_and_pd(valid,_mm256_cmp_pd(_mm256_add_pd(u,v),one_plus_tol,_CMP_LE_OQ));
+		valid = _mm256_and_pd(valid,_mm256_cmp_pd(t,zero,_CMP_GT_OQ));
+		valid = _mm256_and_pd(valid,_mm256_cmp_pd(t,r,_CMP_LT_OQ));
+
+		unsigned int hits = (unsigned int)(_mm256_movemask_pd(valid)) & ((mask >> i) & 15);
+
+		if (hits){
+			alignas(32) double t_lanes[4];
+			_mm256_store_pd(t_lanes,t);
+			for (unsigned int l = 0; l < 4; ++l){
+				if (hits & (1 << l)){
+					this -> range[i + l] = t_lanes[l];
+					this -> hit_elements[i + l] = element;
+				}
+			}
+		}
+	}
+
+}
+
+#else
+
+unsigned int RayPacket::hit_bbox_sse2(const double * bbox_min, const double * bbox_max) const{
+	return this -> hit_bbox_scalar(bbox_min,bbox_max);
+}
+
+void RayPacket::hit_triangle_sse2(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+	this -> hit_triangle_scalar(P0,E1,E2,element,outside,mask);
+}
+
+unsigned int RayPacket::hit_bbox_avx(const double * bbox_min, const double * bbox_max) const{
+	return this -> hit_bbox_scalar(bbox_min,bbox_max);
+}
+
+void RayPacket::hit_triangle_avx(const double * P0, const double * E1, const double * E2,
+	int element, bool outside, unsigned int mask){
+	this -> hit_triangle_scalar(P0,E1,E2,element,outside,mask);
+}
+
+#endif
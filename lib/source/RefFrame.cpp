@@ -20,6 +20,7 @@ RefFrame& RefFrame::operator=(const RefFrame & other) {
 	*this -> mrp_from_parent = *(other.mrp_from_parent);
 	*this -> origin_from_parent = *(other.origin_from_parent);
 	*this -> dcm_from_parent = *(other . dcm_from_parent);
+	++this -> revision;
 
 
 	return *this;
@@ -63,10 +64,16 @@ arma::vec * RefFrame::get_origin_from_parent() {
 void RefFrame::set_mrp_from_parent(arma::vec mrp) {
 	*this -> mrp_from_parent = mrp;
 	*this -> dcm_from_parent = RBK::mrp_to_dcm(mrp);
+	++this -> revision;
 }
 
 void RefFrame::set_origin_from_parent(arma::vec origin) {
 	*this -> origin_from_parent = origin;
+	++this -> revision;
+}
+
+unsigned int RefFrame::get_revision() const {
+	return this -> revision;
 }
 
 
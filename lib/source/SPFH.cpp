@@ -2,17 +2,17 @@
 #include "PointNormal.hpp"
 
 #include <armadillo>
+#include <algorithm>
+#include <vector>
 
 
 SPFH::SPFH() : PointDescriptor(){}
 
 SPFH::SPFH(const int & query_point,
-	const std::vector<int > & points,
+	const PointNeighborhoods & neighborhoods,
 	int N_bins,
 	const PointCloud<PointNormal> & pc) : PointDescriptor(){
 
-	arma::vec::fixed<3> u,v,w,p_i,p_j,n_j;
-
 	int N_global_bins = 3 * N_bins;
 	
 
@@ -21,44 +21,62 @@ SPFH::SPFH(const int & query_point,
 
 	int non_trivial_neighbors_count = 0;
 
+	unsigned int N_neighbors = neighborhoods.get_N_neighbors(query_point);
+	const int * points = neighborhoods.get_neighbors(query_point);
+	const double * squared_distances = neighborhoods.get_squared_distances(query_point);
+
+	// The neighbors distinct from the query point are gathered in a contiguous block
+	// so that their Darboux frames are binned in a single vectorized pass
+	std::vector<double> neighbor_points(3 * N_neighbors);
+	std::vector<double> neighbor_normals(3 * N_neighbors);
 	
-	for (int j = 0; j < points.size(); ++j){
-		double distance = arma::norm(pc.get_point_coordinates(points[j]) - pc.get_point_coordinates(query_point));
+	for (unsigned int j = 0; j < N_neighbors; ++j){
+		double distance = std::sqrt(squared_distances[j]);
 		
 		if (distance > 0){
 
-			int alpha_bin_index,phi_bin_index,theta_bin_index;
-
 			this -> distance_to_closest_neighbor = std::min(this-> distance_to_closest_neighbor,distance);
 
-			this -> compute_darboux_frames_local_hist( 
-				alpha_bin_index,
-				phi_bin_index,
-				theta_bin_index, 
-				N_bins,
-				pc.get_point_coordinates(query_point),
-				pc.get_point(query_point).get_normal_coordinates(),
-				pc.get_point_coordinates(points.at(j)),
-				pc.get_point(points.at(j)).get_normal_coordinates());
-
-			this -> histogram(theta_bin_index) += 1.;
-			this -> histogram(N_bins + alpha_bin_index) += 1.;
-			this -> histogram(2 * N_bins + phi_bin_index) += 1.;
-			
+			const arma::vec::fixed<3> p_j = pc.get_point_coordinates(points[j]);
+			const arma::vec::fixed<3> n_j = pc.get_normal_coordinates(points[j]);
+			std::copy(p_j.begin(),p_j.end(),neighbor_points.begin() + 3 * non_trivial_neighbors_count);
+			std::copy(n_j.begin(),n_j.end(),neighbor_normals.begin() + 3 * non_trivial_neighbors_count);
 
 			++non_trivial_neighbors_count;
 
 		}
 
 	}
+
+	std::vector<int> alpha_bin_indices(non_trivial_neighbors_count);
+	std::vector<int> phi_bin_indices(non_trivial_neighbors_count);
+	std::vector<int> theta_bin_indices(non_trivial_neighbors_count);
+
+	const arma::vec::fixed<3> p_i = pc.get_point_coordinates(query_point);
+	const arma::vec::fixed<3> n_i = pc.get_normal_coordinates(query_point);
+	PointDescriptor::compute_darboux_bins(non_trivial_neighbors_count,
+		p_i.memptr(),
+		n_i.memptr(),
+		neighbor_points.data(),
+		neighbor_normals.data(),
+		N_bins,
+		alpha_bin_indices.data(),
+		phi_bin_indices.data(),
+		theta_bin_indices.data());
+
+	for (int j = 0; j < non_trivial_neighbors_count; ++j){
+		this -> histogram(theta_bin_indices[j]) += 1.;
+		this -> histogram(N_bins + alpha_bin_indices[j]) += 1.;
+		this -> histogram(2 * N_bins + phi_bin_indices[j]) += 1.;
+	}
 	
 	
 
-	assert(non_trivial_neighbors_count + 1 == static_cast<int>(points.size()));
+	assert(non_trivial_neighbors_count + 1 == static_cast<int>(N_neighbors));
 	if (this -> histogram.has_nan()){
 		throw(std::runtime_error("SPFH for point " + std::to_string(query_point) 
 			+ " has nans. Distance to closest neighbor was " + std::to_string(this -> distance_to_closest_neighbor) 
-			+ " and point had " + std::to_string(points.size()) + " neighbors"));
+			+ " and point had " + std::to_string(N_neighbors) + " neighbors"));
 	}
 	if (non_trivial_neighbors_count > 0){
 		this -> histogram *= 100./non_trivial_neighbors_count;
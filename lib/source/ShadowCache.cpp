@@ -0,0 +1,83 @@
+#include "ShadowCache.hpp"
+#include "ShapeModel.hpp"
+#include "ControlPoint.hpp"
+#include "Ray.hpp"
+
+
+ShadowCache::ShadowCache(ShapeModel<ControlPoint> * shape_model,
+	double position_resolution,
+	double direction_resolution){
+
+	if (!(position_resolution > 0) || !(direction_resolution > 0)){
+		throw(std::runtime_error("ShadowCache: resolutions must be positive"));
+	}
+
+	this -> shape_model = shape_model;
+	this -> position_resolution = position_resolution;
+	this -> direction_resolution = direction_resolution;
+
+}
+
+bool ShadowCache::is_in_shadow(const arma::vec::fixed<3> & position_body_frame,
+	const arma::vec::fixed<3> & sun_direction_body_frame){
+
+	std::array<int,6> key;
+	for (unsigned int k = 0; k < 3; ++k){
+		key[k] = int(std::floor(position_body_frame(k) / this -> position_resolution));
+		key[k + 3] = int(std::floor(sun_direction_body_frame(k) / this -> direction_resolution));
+	}
+
+	bool found = false;
+	bool in_shadow = false;
+
+	#pragma omp critical (shadow_cache)
+	{
+		++this -> N_queries;
+		auto entry = this -> entries.find(key);
+		if (entry != this -> entries.end()){
+			found = true;
+			in_shadow = entry -> second;
+			++this -> N_cache_hits;
+		}
+	}
+
+	if (found){
+		return in_shadow;
+	}
+
+	// The ray is cast from the center of the cell
+	arma::vec::fixed<3> origin;
+	arma::vec::fixed<3> direction;
+	for (unsigned int k = 0; k < 3; ++k){
+		origin(k) = (key[k] + 0.5) * this -> position_resolution;
+		direction(k) = (key[k + 3] + 0.5) * this -> direction_resolution;
+	}
+
+	Ray ray(origin,arma::normalise(direction));
+	in_shadow = this -> shape_model -> ray_trace_any(&ray);
+
+	#pragma omp critical (shadow_cache)
+	{
+		if (this -> entries.size() >= SHADOW_CACHE_MAX_SIZE){
+			this -> entries.clear();
+		}
+		this -> entries[key] = in_shadow;
+	}
+
+	return in_shadow;
+
+}
+
+void ShadowCache::clear(){
+	this -> entries.clear();
+	this -> N_queries = 0;
+	this -> N_cache_hits = 0;
+}
+
+unsigned int ShadowCache::size() const{
+	return this -> entries.size();
+}
+
+double ShadowCache::get_hit_rate() const{
+	return this -> N_queries > 0 ? double(this -> N_cache_hits) / this -> N_queries : 0;
+}
@@ -21,8 +21,10 @@
 #include <IODBounds.hpp>
 #include <PointCloud.hpp>
 #include <PointNormal.hpp>
+#include <PointNeighborhoods.hpp>
 
 #include <PointCloudIO.hpp>
+#include <IOFlags.hpp>
 
 #include <boost/progress.hpp>
 #include <chrono>
@@ -122,8 +124,12 @@ void ShapeBuilder::run_shape_reconstruction(const arma::vec &times ,
 		this -> lidar -> send_flash(this -> true_shape_model,true);
 
 		#if IOFLAGS_shape_builder
+		#if IOFLAGS_binary_range_images
+		this -> lidar -> save_range_image(dir + "/range_images.bin",times(time_index));
+		#else
 		this -> lidar -> save(dir + "/pc_" + std::to_string(time_index),true);
 		#endif
+		#endif
 
 		// The rigid transform best aligning the two point clouds is found
 		// The solution to this first registration will be used to prealign the 
@@ -803,7 +809,7 @@ void ShapeBuilder::store_point_clouds(int index,const std::string dir) {
 		arma::vec::fixed<3> los = {1,0,0};
 		EstimationNormals<PointNormal,PointNormal> estimate_normals(pc,pc);
 		estimate_normals.set_los_dir(los);
-		estimate_normals.estimate(6);
+		estimate_normals.estimate_organized(1);
 
 	
 
@@ -826,7 +832,7 @@ void ShapeBuilder::store_point_clouds(int index,const std::string dir) {
 		arma::vec::fixed<3> los = {1,0,0};
 		EstimationNormals<PointNormal,PointNormal> estimate_normals(pc,pc);
 		estimate_normals.set_los_dir(los);
-		estimate_normals.estimate(6);
+		estimate_normals.estimate_organized(1);
 
 
 
@@ -851,6 +857,20 @@ void ShapeBuilder::store_point_clouds(int index,const std::string dir) {
 			PointCloudIO<PointNormal>::save_to_obj(this -> all_registered_pc[this -> source_pc_index], 
 				dir + "/source_" + std::to_string(index) + ".obj",
 				this -> LN_t0.t(),this -> x_t0);
+
+			// All the registered source point clouds are also archived in a single binary file,
+			// overwritten by the first one of the run
+			if (this -> N_archived_pcs == 0){
+				PointCloudIO<PointNormal>::save_to_binary(this -> all_registered_pc[this -> source_pc_index], 
+					dir + "/registered_pcs.bin",
+					this -> LN_t0.t(),this -> x_t0);
+			}
+			else{
+				PointCloudIO<PointNormal>::append_to_binary(this -> all_registered_pc[this -> source_pc_index], 
+					dir + "/registered_pcs.bin",
+					this -> LN_t0.t(),this -> x_t0);
+			}
+			++this -> N_archived_pcs;
 		}
 
 
@@ -864,7 +884,7 @@ void ShapeBuilder::store_point_clouds(int index,const std::string dir) {
 		arma::vec::fixed<3> los = {1,0,0};
 		EstimationNormals<PointNormal,PointNormal> estimate_normals(pc,pc);
 		estimate_normals.set_los_dir(los);
-		estimate_normals.estimate(6);
+		estimate_normals.estimate_organized(1);
 
 	
 
@@ -1004,16 +1024,15 @@ void ShapeBuilder::estimate_coverage(const PointCloud < PointNormal >  & anchor_
 	
 	std::cout << "\n-- Computing coverage ..."<< std::endl;
 	int unsatisfying_points_count = 0;
-	#pragma omp parallel for reduction(+:unsatisfying_points_count)
-	for (int i = 0; i < anchor_pc . size(); ++i){
 
-		// The closest neighbors are extracted
-		// std::map<double, int > closest_points = global_pc.get_closest_N_points(global_pc.get_point_coordinates(i),3);
+	// The closest neighbors are extracted
+	PointNeighborhoods neighborhoods;
+	anchor_pc . compute_neighborhoods_radius(1.,neighborhoods);
 
-		if (anchor_pc . get_nearest_neighbors_radius(anchor_pc . get_point_coordinates(i),1.).size() <= 3){
+	for (int i = 0; i < anchor_pc . size(); ++i){
+		if (neighborhoods.get_N_neighbors(i) <= 3){
 			++unsatisfying_points_count;
 		}
-
 	}
 
 	auto end = std::chrono::system_clock::now();
@@ -1036,19 +1055,12 @@ void ShapeBuilder::run_psr(const PointCloud<PointNormal> & pc,
 
 	PointCloud<PointNormal> pc_downsampled;
 
-	std::vector<int> indices;
-	for (int i = 0; i < pc . size(); ++i){
-		indices.push_back(i);
-	}
-
-	std::cout << "\tShuffling\n";
-	std::random_shuffle ( indices.begin(), indices.end() );
-
 	int points_kept = static_cast<int>(percentage_point_kept/100. * pc . size() );
 
-	for (int i = 0; i < points_kept; ++i){
-		pc_downsampled.push_back(pc . get_point(indices[i]));
-	}
+	// A Poisson-disk downsampling keeps the density even, where the regions covered
+	// by several point clouds would keep more points than the others with a random selection
+	std::cout << "\tDownsampling\n";
+	pc.downsample_poisson_disk_to_count(points_kept,pc_downsampled);
 
 	std::cout << "\tSaving to txt\n";
 
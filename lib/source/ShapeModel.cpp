@@ -3,6 +3,7 @@
 #include <ControlPoint.hpp>
 #include <KDTree.hpp>
 #include <ShapeModel.hpp>
+#include <RayPacket.hpp>
 
 template <class PointType>
 ShapeModel<PointType>::ShapeModel() {
@@ -121,8 +122,8 @@ unsigned int ShapeModel<PointType>::get_NControlPoints() const {
 }
 
 template <class PointType>
-std::shared_ptr<KDTreeShape> ShapeModel<PointType>::get_KDTreeShape() const {
-	return this -> kdt_facet;
+std::shared_ptr<BVHShape> ShapeModel<PointType>::get_BVHShape() const {
+	return this -> bvh_facet;
 }
 
 template <class PointType>
@@ -134,11 +135,35 @@ void ShapeModel<PointType>::construct_kd_tree_control_points(){
 	}
 
 	this -> kdt_control_points = std::make_shared< KDTree<ShapeModel,PointType> >(KDTree< ShapeModel,PointType> ());
-	this -> kdt_control_points -> build(indices,0,this);
+	this -> kdt_control_points -> build(indices,this);
 
 }
 
 
+template <class PointType>
+void ShapeModel<PointType>::ray_trace_packet(RayPacket & packet,bool outside){
+
+	for (unsigned int i = 0; i < packet.size(); ++i){
+		this -> ray_trace(packet.get_ray(i),outside);
+	}
+
+}
+
+template <class PointType>
+bool ShapeModel<PointType>::ray_trace_coherent(Ray * ray,bool outside,bool & fast_path){
+
+	fast_path = false;
+	return this -> ray_trace(ray,outside);
+
+}
+
+template <class PointType>
+bool ShapeModel<PointType>::ray_trace_any(Ray * ray,bool outside){
+
+	return this -> ray_trace(ray,outside);
+
+}
+
 template <class PointType>
 arma::vec::fixed<3> ShapeModel<PointType>::get_center() const{
 	arma::vec center = {0,0,0};
@@ -1,7 +1,8 @@
 #include "ShapeModelBezier.hpp"
 #include "ShapeModelTri.hpp"
 #include "ShapeModelImporter.hpp"
-#include "KDTreeShape.hpp"
+#include "BVHShape.hpp"
+#include "SymmetricEigenSolver.hpp"
 
 #pragma omp declare reduction (+ : arma::vec::fixed<6> : omp_out += omp_in)\
 initializer( omp_priv = arma::zeros<arma::vec>(6) )
@@ -1008,7 +1009,7 @@ void ShapeModelBezier<PointType>::run_monte_carlo(int N,
 		arma::vec I = {I_C(0,0),I_C(1,1),I_C(2,2),I_C(0,1),I_C(0,2),I_C(1,2)};
 
 		arma::vec moments_col(4);
-		arma::vec eig_val = arma::eig_sym(I_C);
+		arma::vec eig_val = SymmetricEigenSolver::compute_eigenvalues(I_C);
 		arma::mat eig_vec =  ShapeModelBezier<PointType>::get_principal_axes_stable(I_C);
 		moments_col.rows(0,2) = eig_val;
 
@@ -1054,7 +1055,7 @@ arma::vec::fixed<3> ShapeModelBezier<PointType>::get_dims(const double & volume,
 	const arma::mat::fixed<3,3> & I_C){
 
 
-	arma::vec moments = arma::eig_sym(I_C);
+	arma::vec moments = SymmetricEigenSolver::compute_eigenvalues(I_C);
 
 	double A = moments(0);
 	double B = moments(1);
@@ -1076,10 +1077,17 @@ arma::vec::fixed<3> ShapeModelBezier<PointType>::get_dims(const double & volume,
 template <class PointType>
 bool ShapeModelBezier<PointType>::ray_trace(Ray * ray,bool outside){
 
-	return this -> kdt_facet -> hit(this -> get_KDTreeShape(),ray,false,this);
+	return this -> bvh_facet -> hit(ray,outside);
 	
 }
 
+template <class PointType>
+bool ShapeModelBezier<PointType>::ray_trace_any(Ray * ray,bool outside){
+
+	return this -> bvh_facet -> hit_any(ray,outside);
+
+}
+
 template <class PointType>
 void ShapeModelBezier<PointType>::assemble_mapping_matrices(){
 
@@ -1838,91 +1846,20 @@ void ShapeModelBezier<PointType>::construct_kd_tree_shape(){
 	start = std::chrono::system_clock::now();
 
 
-	// The KD tree is constructed by building 
-	// an "enclosing" (not strictly-speaking) KD tree from the bezier shape
-
-	// An inverse map going from vertex pointer to global indices is created
-	// Note that the actual vertices on the shape model will not be be 
-	// the control points, but the points lying on the bezier patch
- 	// they support
-
-
-	std::vector<std::vector<int> > vertices_in_facets;
-	std::vector<int> facets_super_element;
-
+	// The hierarchy directly bounds the patches. The bounds of each patch are those of its
+	// control points, which are guaranteed to enclose the patch (convex hull property)
+	std::vector<int> patches;
 	for (unsigned int e = 0; e < this -> get_NElements(); ++e){
-
-		const Bezier & patch = this -> get_element(e);
-
-	// The facets are created
-
-		for (unsigned int l = 0; l < patch . get_degree(); ++l){
-
-			for (unsigned int t = 0; t < l + 1; ++t){
-
-				if (t <= l){
-
-					int v0 = patch . get_point_global_index(patch . get_degree() - l,l - t);
-					int v1 = patch . get_point_global_index(patch . get_degree() - l - 1,l - t + 1);
-					int v2 = patch . get_point_global_index(patch . get_degree() - l - 1,l-t);
-
-					std::vector<int> vertices_in_facet;
-					vertices_in_facet.push_back(v0);
-					vertices_in_facet.push_back(v1);
-					vertices_in_facet.push_back(v2);
-					
-					facets_super_element.push_back(e);
-					vertices_in_facets.push_back(vertices_in_facet);
-
-				}
-
-				if (t > 0 ){
-
-					int v0 = patch . get_point_global_index(patch . get_degree() - l,l-t);
-					int v1 = patch . get_point_global_index(patch . get_degree() - l,l - t + 1 );
-					int v2 = patch . get_point_global_index(patch . get_degree() - l -1,l - t + 1);
-
-					std::vector<int> vertices_in_facet;
-					vertices_in_facet.push_back(v0);
-					vertices_in_facet.push_back(v1);
-					vertices_in_facet.push_back(v2);
-					
-					facets_super_element.push_back(e);
-					vertices_in_facets.push_back(vertices_in_facet);
-
-
-				}
-
-			}
-
-		}
+		patches.push_back(e);
 	}
 
-	// We know have everything we need to create the enclosing shape
-	this -> enclosing_polyhedron = std::make_shared<ShapeModelTri<ControlPoint>>(ShapeModelTri<ControlPoint>(vertices_in_facets,
-		facets_super_element,this -> control_points));
-
-
-	for(int e = 0; e < this -> enclosing_polyhedron -> get_NElements(); ++e){
-		Facet & facet =  this -> enclosing_polyhedron -> get_element(e);
-		facet.set_owning_shape(this -> enclosing_polyhedron.get());
-	}
-
-
-
-	std::vector<int> facets;
-	for (int e = 0; e < this -> enclosing_polyhedron -> get_NElements(); ++e){
-		facets.push_back(e);
-	}
-
-
-	this -> kdt_facet = std::make_shared<KDTreeShape>(KDTreeShape(this -> enclosing_polyhedron.get()));
-	this -> kdt_facet -> build(facets, 0);
+	this -> bvh_facet = std::make_shared<BVHShape>(BVHShape(this));
+	this -> bvh_facet -> build(patches);
 
 	end = std::chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_seconds = end - start;
 
-	std::cout << "\n Elapsed time during Bezier KDTree construction : " << elapsed_seconds.count() << "s\n\n";
+	std::cout << "\n Elapsed time during Bezier BVH construction : " << elapsed_seconds.count() << "s\n\n";
 
 }
 
@@ -2032,7 +1969,7 @@ template <class PointType>
 arma::vec::fixed<9> ShapeModelBezier<PointType>::get_E_vectors(const arma::mat::fixed<3,3> & inertia){
 
 	arma::vec::fixed<9> E_vectors;
-	arma::vec moments = arma::eig_sym(inertia);
+	arma::vec moments = SymmetricEigenSolver::compute_eigenvalues(inertia);
 	for (int i = 0; i < 3; ++i){
 
 		arma::mat L = inertia - moments(i) * arma::eye<arma::mat>(3,3);
@@ -2067,10 +2004,17 @@ arma::mat::fixed<3,3> ShapeModelBezier<PointType>::get_principal_axes_stable(con
 
 	auto E_vectors = ShapeModelBezier<PointType>::get_E_vectors(inertia);
 
+	arma::vec::fixed<3> moments;
 	arma::mat::fixed<3,3> pa;
-	pa.col(0) = E_vectors.rows(0,2) / arma::norm( E_vectors.rows(0,2));
-	pa.col(1) = E_vectors.rows(3,5) / arma::norm( E_vectors.rows(3,5));
-	pa.col(2) = E_vectors.rows(6,8) / arma::norm( E_vectors.rows(6,8));
+	SymmetricEigenSolver::compute(inertia,moments,pa);
+
+	// The axes keep the orientation of the E vectors, which is what makes them stable
+	// from one inertia tensor to a nearby one
+	for (int i = 0; i < 3; ++i){
+		if (arma::dot(pa.col(i),E_vectors.rows(3 * i,3 * i + 2)) < 0){
+			pa.col(i) *= -1;
+		}
+	}
 
 	return pa;
 
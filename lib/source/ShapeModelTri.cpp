@@ -2,7 +2,8 @@
 #include "Facet.hpp"
 #include "Ray.hpp"
 #include <boost/progress.hpp>
-#include <KDTreeShape.hpp>
+#include <BVHShape.hpp>
+#include <RayPacket.hpp>
 
 
 #pragma omp declare reduction (+ : arma::vec::fixed<3> : omp_out += omp_in) \
@@ -156,7 +157,25 @@ const std::vector<int> & ShapeModelTri<PointType>::get_element_control_points(in
 template <class PointType>
 bool ShapeModelTri<PointType>::ray_trace(Ray * ray,bool outside){
 
-	return this -> kdt_facet -> hit(this -> get_KDTreeShape(),ray,outside);
+	return this -> bvh_facet -> hit(ray,outside);
+}
+
+template <class PointType>
+void ShapeModelTri<PointType>::ray_trace_packet(RayPacket & packet,bool outside){
+
+	this -> bvh_facet -> hit_packet(packet,outside);
+}
+
+template <class PointType>
+bool ShapeModelTri<PointType>::ray_trace_coherent(Ray * ray,bool outside,bool & fast_path){
+
+	return this -> bvh_facet -> hit_coherent(ray,ray -> get_guess(),outside,fast_path);
+}
+
+template <class PointType>
+bool ShapeModelTri<PointType>::ray_trace_any(Ray * ray,bool outside){
+
+	return this -> bvh_facet -> hit_any(ray,outside);
 }
 
 template <class PointType>
@@ -176,13 +195,13 @@ void ShapeModelTri<PointType>::construct_kd_tree_shape() {
 		element_indices.push_back(i);
 	}
 
-	this -> kdt_facet = std::make_shared<KDTreeShape>(KDTreeShape(this));
-	this -> kdt_facet -> build(element_indices, 0);
+	this -> bvh_facet = std::make_shared<BVHShape>(BVHShape(this));
+	this -> bvh_facet -> build(element_indices);
 
 	end = std::chrono::system_clock::now();
 	std::chrono::duration<double> elapsed_seconds = end - start;
 
-	std::cout << "\n Elapsed time during polyhedron KDTree construction : " << elapsed_seconds.count() << "s\n\n";
+	std::cout << "\n Elapsed time during polyhedron BVH construction : " << elapsed_seconds.count() << "s\n\n";
 
 }
 
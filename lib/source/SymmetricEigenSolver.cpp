@@ -0,0 +1,254 @@
+#include <SymmetricEigenSolver.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+static inline double dot(const double * a,const double * b){
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static inline void cross(const double * a,const double * b,double * c){
+	c[0] = a[1] * b[2] - a[2] * b[1];
+	c[1] = a[2] * b[0] - a[0] * b[2];
+	c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// v^T A v, for a unit vector v
+static inline double rayleigh_quotient(const double * a,const double * v){
+	return a[0] * v[0] * v[0] + a[3] * v[1] * v[1] + a[5] * v[2] * v[2]
+	+ 2 * (a[1] * v[0] * v[1] + a[2] * v[0] * v[2] + a[4] * v[1] * v[2]);
+}
+
+// Unit vector spanning the null space of the rank-2 matrix A - eigenvalue * I, taken as
+// the largest of the cross products of its rows
+static void compute_first_eigenvector(const double * a,double eigenvalue,double * eigenvector){
+
+	double rows[3][3] = {
+		{a[0] - eigenvalue,a[1],a[2]},
+		{a[1],a[3] - eigenvalue,a[4]},
+		{a[2],a[4],a[5] - eigenvalue}
+	};
+
+	double products[3][3];
+	cross(rows[0],rows[1],products[0]);
+	cross(rows[0],rows[2],products[1]);
+	cross(rows[1],rows[2],products[2]);
+
+	int largest = 0;
+	double largest_squared_norm = dot(products[0],products[0]);
+	for (int k = 1; k < 3; ++k){
+		double squared_norm = dot(products[k],products[k]);
+		if (squared_norm > largest_squared_norm){
+			largest_squared_norm = squared_norm;
+			largest = k;
+		}
+	}
+
+	if (largest_squared_norm > 0){
+		double inverse_norm = 1. / std::sqrt(largest_squared_norm);
+		for (int k = 0; k < 3; ++k){
+			eigenvector[k] = products[largest][k] * inverse_norm;
+		}
+	}
+	else{
+		eigenvector[0] = 1;
+		eigenvector[1] = 0;
+		eigenvector[2] = 0;
+	}
+
+}
+
+// Unit eigenvector in the plane orthogonal to a known unit eigenvector, found by diagonalizing
+// A restricted to that plane with a rotation. largest selects the eigenvector of the
+// largest of the two remaining eigenvalues, otherwise that of the smallest
+static void compute_second_eigenvector(const double * a,const double * first_eigenvector,bool largest,double * eigenvector){
+
+	const double * w = first_eigenvector;
+	double u[3];
+	double v[3];
+
+	if (std::abs(w[0]) > std::abs(w[1])){
+		double inverse_norm = 1. / std::sqrt(w[0] * w[0] + w[2] * w[2]);
+		u[0] = - w[2] * inverse_norm;
+		u[1] = 0;
+		u[2] = w[0] * inverse_norm;
+	}
+	else{
+		double inverse_norm = 1. / std::sqrt(w[1] * w[1] + w[2] * w[2]);
+		u[0] = 0;
+		u[1] = w[2] * inverse_norm;
+		u[2] = - w[1] * inverse_norm;
+	}
+	cross(w,u,v);
+
+	double av[3] = {
+		a[0] * v[0] + a[1] * v[1] + a[2] * v[2],
+		a[1] * v[0] + a[3] * v[1] + a[4] * v[2],
+		a[2] * v[0] + a[4] * v[1] + a[5] * v[2]
+	};
+
+	double m_uu = rayleigh_quotient(a,u);
+	double m_uv = dot(u,av);
+	double m_vv = dot(v,av);
+
+	// (cos(theta),sin(theta)) is the eigenvector of the largest eigenvalue of the 2x2 matrix
+	double theta = 0.5 * std::atan2(2 * m_uv,m_uu - m_vv);
+	double c = std::cos(theta);
+	double s = std::sin(theta);
+
+	double c_u = largest ? c : - s;
+	double c_v = largest ? s : c;
+
+	for (int k = 0; k < 3; ++k){
+		eigenvector[k] = c_u * u[k] + c_v * v[k];
+	}
+
+}
+
+// First stage of the decomposition, free of branches so that it vectorizes across matrices.
+// The matrix is scaled to avoid overflows and underflows in the cubic, and its eigenvalues are estimated
+// as q + p * beta where the beta's are the roots of beta^3 - 3 beta - det(B), B = (A - q * I) / p.
+// The estimates are those of the scaled matrix. half_det is det(B) / 2, which decides which eigenvalue
+// is the furthest from the other two
+static inline void estimate_eigenvalues(const double * matrix,double * a,double * eigenvalues,double & scale,double & half_det){
+
+	scale = std::max(std::max(std::max(std::abs(matrix[0]),std::abs(matrix[1])),std::max(std::abs(matrix[2]),std::abs(matrix[3]))),
+		std::max(std::abs(matrix[4]),std::abs(matrix[5])));
+
+	double inverse_scale = scale > 0 ? 1. / scale : 0.;
+	for (int k = 0; k < 6; ++k){
+		a[k] = matrix[k] * inverse_scale;
+	}
+
+	double q = (a[0] + a[3] + a[5]) / 3;
+	double b00 = a[0] - q;
+	double b11 = a[3] - q;
+	double b22 = a[5] - q;
+	double p = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2 * (a[1] * a[1] + a[2] * a[2] + a[4] * a[4])) / 6);
+
+	double c00 = b11 * b22 - a[4] * a[4];
+	double c01 = a[1] * b22 - a[4] * a[2];
+	double c02 = a[1] * a[4] - b11 * a[2];
+	double p_cubed = p * p * p;
+	half_det = p_cubed > 0 ? 0.5 * (b00 * c00 - a[1] * c01 + a[2] * c02) / p_cubed : 0.;
+	half_det = std::min(std::max(half_det,-1.),1.);
+
+	double angle = std::acos(half_det) / 3;
+	double beta_2 = 2 * std::cos(angle);
+	double beta_0 = 2 * std::cos(angle + 2 * arma::datum::pi / 3);
+	double beta_1 = - (beta_0 + beta_2);
+
+	eigenvalues[0] = q + p * beta_0;
+	eigenvalues[1] = q + p * beta_1;
+	eigenvalues[2] = q + p * beta_2;
+
+}
+
+// Second stage of the decomposition, from the output of estimate_eigenvalues
+static void compute_eigenvectors(const double * matrix,const double * a,double scale,double half_det,
+	double * eigenvalues,double * eigenvectors){
+
+	if (scale == 0 || (matrix[1] == 0 && matrix[2] == 0 && matrix[4] == 0)){
+
+		// Diagonal matrix: the eigenvectors are the axes
+		int order[3] = {0,1,2};
+		const double diagonal[3] = {matrix[0],matrix[3],matrix[5]};
+		std::sort(order,order + 3,[&](int i, int j){ return diagonal[i] < diagonal[j]; });
+
+		std::fill(eigenvectors,eigenvectors + 9,0.);
+		for (int k = 0; k < 3; ++k){
+			eigenvalues[k] = diagonal[order[k]];
+			eigenvectors[3 * k + order[k]] = 1;
+		}
+
+		// The basis is kept right-handed
+		double third[3];
+		cross(eigenvectors,eigenvectors + 3,third);
+		if (dot(third,eigenvectors + 6) < 0){
+			for (int k = 6; k < 9; ++k){
+				eigenvectors[k] = - eigenvectors[k];
+			}
+		}
+		return;
+	}
+
+	// The eigenvector of the eigenvalue furthest from the other two is the best conditioned,
+	// the two others are resolved in the plane orthogonal to it
+	int first = (half_det >= 0) ? 2 : 0;
+	double * first_eigenvector = eigenvectors + 3 * first;
+
+	compute_first_eigenvector(a,eigenvalues[first],first_eigenvector);
+	compute_second_eigenvector(a,first_eigenvector,first == 2,eigenvectors + 3);
+
+	if (first == 2){
+		cross(eigenvectors + 3,eigenvectors + 6,eigenvectors);
+	}
+	else{
+		cross(eigenvectors,eigenvectors + 3,eigenvectors + 6);
+	}
+
+	// The cubic only gives the eigenvalues to about half the machine precision when two of them are close,
+	// so they are recomputed as the Rayleigh quotients of the eigenvectors
+	for (int k = 0; k < 3; ++k){
+		eigenvalues[k] = rayleigh_quotient(a,eigenvectors + 3 * k) * scale;
+	}
+
+}
+
+void SymmetricEigenSolver::compute(const double * matrix,double * eigenvalues,double * eigenvectors){
+
+	double a[6];
+	double scale;
+	double half_det;
+
+	estimate_eigenvalues(matrix,a,eigenvalues,scale,half_det);
+	compute_eigenvectors(matrix,a,scale,half_det,eigenvalues,eigenvectors);
+
+}
+
+void SymmetricEigenSolver::compute(unsigned int N,const double * matrices,double * eigenvalues,double * eigenvectors){
+
+	const unsigned int block_size = SYMMETRIC_EIGEN_SOLVER_BLOCK_SIZE;
+
+	double a[6 * block_size];
+	double scales[block_size];
+	double half_dets[block_size];
+
+	for (unsigned int begin = 0; begin < N; begin += block_size){
+
+		unsigned int size = std::min(block_size,N - begin);
+		const double * block_matrices = matrices + 6 * begin;
+		double * block_eigenvalues = eigenvalues + 3 * begin;
+		double * block_eigenvectors = eigenvectors + 9 * begin;
+
+		#pragma omp simd
+		for (unsigned int i = 0; i < size; ++i){
+			estimate_eigenvalues(block_matrices + 6 * i,a + 6 * i,block_eigenvalues + 3 * i,scales[i],half_dets[i]);
+		}
+
+		for (unsigned int i = 0; i < size; ++i){
+			compute_eigenvectors(block_matrices + 6 * i,a + 6 * i,scales[i],half_dets[i],
+				block_eigenvalues + 3 * i,block_eigenvectors + 9 * i);
+		}
+	}
+
+}
+
+void SymmetricEigenSolver::compute(const arma::mat::fixed<3,3> & matrix,
+	arma::vec::fixed<3> & eigenvalues,
+	arma::mat::fixed<3,3> & eigenvectors){
+
+	const double coefficients[6] = {matrix(0,0),matrix(0,1),matrix(0,2),matrix(1,1),matrix(1,2),matrix(2,2)};
+	SymmetricEigenSolver::compute(coefficients,eigenvalues.memptr(),eigenvectors.memptr());
+
+}
+
+arma::vec::fixed<3> SymmetricEigenSolver::compute_eigenvalues(const arma::mat::fixed<3,3> & matrix){
+
+	arma::vec::fixed<3> eigenvalues;
+	arma::mat::fixed<3,3> eigenvectors;
+	SymmetricEigenSolver::compute(matrix,eigenvalues,eigenvectors);
+	return eigenvalues;
+
+}
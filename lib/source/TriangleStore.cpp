@@ -0,0 +1,125 @@
+#include "TriangleStore.hpp"
+#include "ShapeModelTri.hpp"
+
+#include <algorithm>
+
+
+TriangleStore::TriangleStore(){
+
+}
+
+void TriangleStore::build(ShapeModelTri<ControlPoint> * shape, const std::vector<int> & elements){
+
+	unsigned int N_triangles = elements.size();
+
+	for (unsigned int k = 0; k < 3; ++k){
+		this -> P0[k].resize(N_triangles);
+		this -> E1[k].resize(N_triangles);
+		this -> E2[k].resize(N_triangles);
+		this -> N[k].resize(N_triangles);
+	}
+
+	this -> elements = elements;
+	this -> slots = std::vector<int>(shape -> get_NElements(),-1);
+
+	for (unsigned int slot = 0; slot < N_triangles; ++slot){
+
+		int e = elements[slot];
+		const std::vector<int> & vertices = shape -> get_element_control_points(e);
+
+		const arma::vec::fixed<3> & V0 = shape -> get_point_coordinates(vertices[0]);
+		const arma::vec::fixed<3> & V1 = shape -> get_point_coordinates(vertices[1]);
+		const arma::vec::fixed<3> & V2 = shape -> get_point_coordinates(vertices[2]);
+		const arma::vec::fixed<3> & n = shape -> get_element(e).get_normal_coordinates();
+
+		for (unsigned int k = 0; k < 3; ++k){
+			this -> P0[k][slot] = V0(k);
+			this -> E1[k][slot] = V1(k) - V0(k);
+			this -> E2[k][slot] = V2(k) - V0(k);
+			this -> N[k][slot] = n(k);
+		}
+
+		this -> slots[e] = slot;
+
+	}
+
+	// Neighbors are found through the stored triangles owning each vertex
+	std::vector<std::vector<int> > vertex_slots(shape -> get_NControlPoints());
+
+	for (unsigned int slot = 0; slot < N_triangles; ++slot){
+		const std::vector<int> & vertices = shape -> get_element_control_points(elements[slot]);
+		for (unsigned int v = 0; v < vertices.size(); ++v){
+			vertex_slots[vertices[v]].push_back(slot);
+		}
+	}
+
+	this -> neighbor_offsets.resize(N_triangles + 1);
+	this -> neighbor_slots.clear();
+	this -> neighbor_offsets[0] = 0;
+
+	std::vector<int> slot_neighbors;
+
+	for (unsigned int slot = 0; slot < N_triangles; ++slot){
+
+		slot_neighbors.clear();
+
+		const std::vector<int> & vertices = shape -> get_element_control_points(elements[slot]);
+		for (unsigned int v = 0; v < vertices.size(); ++v){
+			for (int other_slot : vertex_slots[vertices[v]]){
+				if (other_slot != int(slot)){
+					slot_neighbors.push_back(other_slot);
+				}
+			}
+		}
+
+		std::sort(slot_neighbors.begin(),slot_neighbors.end());
+		slot_neighbors.erase(std::unique(slot_neighbors.begin(),slot_neighbors.end()),slot_neighbors.end());
+
+		this -> neighbor_slots.insert(this -> neighbor_slots.end(),slot_neighbors.begin(),slot_neighbors.end());
+		this -> neighbor_offsets[slot + 1] = this -> neighbor_slots.size();
+
+	}
+
+}
+
+const int * TriangleStore::get_neighbor_slots(unsigned int slot, unsigned int & N_neighbors) const{
+
+	N_neighbors = this -> neighbor_offsets[slot + 1] - this -> neighbor_offsets[slot];
+	return this -> neighbor_slots.data() + this -> neighbor_offsets[slot];
+
+}
+
+unsigned int TriangleStore::size() const{
+	return this -> elements.size();
+}
+
+int TriangleStore::get_element(unsigned int slot) const{
+	return this -> elements[slot];
+}
+
+int TriangleStore::get_slot(int element) const{
+	if (element < 0 || element >= int(this -> slots.size())){
+		return -1;
+	}
+	return this -> slots[element];
+}
+
+void TriangleStore::get_triangle(unsigned int slot, double * P0, double * E1, double * E2) const{
+
+	for (unsigned int k = 0; k < 3; ++k){
+		P0[k] = this -> P0[k][slot];
+		E1[k] = this -> E1[k][slot];
+		E2[k] = this -> E2[k][slot];
+	}
+
+}
+
+double TriangleStore::get_incidence_angle(unsigned int slot, const double * direction) const{
+
+	double cos_angle = std::abs(this -> N[0][slot] * direction[0]
+		+ this -> N[1][slot] * direction[1]
+		+ this -> N[2][slot] * direction[2]);
+
+	return 180. / arma::datum::pi * std::acos(std::min(cos_angle,1.));
+
+}
@@ -0,0 +1,222 @@
+#include <VoxelHashGrid.hpp>
+
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+
+// Number of bits of each integer column coordinate in the column keys. Columns further apart
+// than 2^VOXEL_HASH_GRID_KEY_BITS along an axis share their key, which only adds candidates to the
+// queries since these then check the distance to every point they scan
+#define VOXEL_HASH_GRID_KEY_BITS 31
+
+// Key of the empty slots of the hash table, which no column can have
+#define VOXEL_HASH_GRID_EMPTY_KEY (~std::uint64_t(0))
+
+
+std::uint64_t VoxelHashGrid::get_key(std::int64_t i,std::int64_t j){
+
+	const std::uint64_t mask = (std::uint64_t(1) << VOXEL_HASH_GRID_KEY_BITS) - 1;
+
+	return ((std::uint64_t(i) & mask) << VOXEL_HASH_GRID_KEY_BITS) | (std::uint64_t(j) & mask);
+
+}
+
+std::uint64_t VoxelHashGrid::get_slot(std::uint64_t key) const{
+
+	std::uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+	return (hash ^ (hash >> 32)) & (this -> table.size() - 1);
+
+}
+
+const VoxelHashGrid::Column * VoxelHashGrid::find_column(std::uint64_t key) const{
+
+	std::uint64_t mask = this -> table.size() - 1;
+
+	// Linear probing until the column or an empty slot is found
+	for (std::uint64_t slot = this -> get_slot(key); this -> table[slot].key != VOXEL_HASH_GRID_EMPTY_KEY; slot = (slot + 1) & mask){
+		if (this -> table[slot].key == key){
+			return &this -> table[slot];
+		}
+	}
+
+	return nullptr;
+
+}
+
+void VoxelHashGrid::build(const std::vector< int > & indices,const std::vector< double > & coordinates,double cell_size){
+
+	int N = static_cast<int>(indices.size());
+
+	if (cell_size <= 0){
+		throw(std::runtime_error("VoxelHashGrid::build: the voxel size must be positive"));
+	}
+
+	if (coordinates.size() != 3 * indices.size()){
+		throw(std::runtime_error("VoxelHashGrid::build: the grid only holds 3D points"));
+	}
+
+	this -> cell_size = cell_size;
+	this -> cells.clear();
+
+	// The points are sorted by column, then by voxel within each column
+	std::vector<std::uint64_t> keys(N);
+	std::vector<std::int64_t> k_cells(N);
+	for (int i = 0; i < N; ++i){
+		keys[i] = get_key(std::int64_t(std::floor(coordinates[3 * i] / cell_size)),
+			std::int64_t(std::floor(coordinates[3 * i + 1] / cell_size)));
+		k_cells[i] = std::int64_t(std::floor(coordinates[3 * i + 2] / cell_size));
+	}
+
+	std::vector<int> order(N);
+	std::iota(order.begin(),order.end(),0);
+	std::sort(order.begin(),order.end(),[&](int a, int b){
+		return keys[a] < keys[b] || (keys[a] == keys[b] && k_cells[a] < k_cells[b]);
+	});
+
+	this -> coordinates.resize(3 * N);
+	this -> indices.resize(N);
+	unsigned int N_columns = 0;
+
+	for (int i = 0; i < N; ++i){
+
+		int p = order[i];
+		std::copy(coordinates.begin() + 3 * p,coordinates.begin() + 3 * p + 3,this -> coordinates.begin() + 3 * i);
+		this -> indices[i] = indices[p];
+
+		bool new_column = (i == 0 || keys[p] != keys[order[i - 1]]);
+		if (new_column || k_cells[p] != this -> cells.back().k){
+			Cell cell;
+			cell.k = k_cells[p];
+			cell.begin = i;
+			this -> cells.push_back(cell);
+		}
+		this -> cells.back().end = i + 1;
+
+		if (new_column){
+			++N_columns;
+		}
+	}
+
+	// The columns are then inserted in the table, kept at most half full
+	std::size_t table_size = 1;
+	while (table_size < 2 * std::size_t(N_columns)){
+		table_size *= 2;
+	}
+
+	Column empty_column;
+	empty_column.key = VOXEL_HASH_GRID_EMPTY_KEY;
+	this -> table.assign(table_size,empty_column);
+
+	std::uint64_t mask = table_size - 1;
+	int begin = 0;
+	while (begin < static_cast<int>(this -> cells.size())){
+
+		std::uint64_t key = keys[order[this -> cells[begin].begin]];
+		int end = begin + 1;
+		while (end < static_cast<int>(this -> cells.size()) && keys[order[this -> cells[end].begin]] == key){
+			++end;
+		}
+
+		std::uint64_t slot = this -> get_slot(key);
+		while (this -> table[slot].key != VOXEL_HASH_GRID_EMPTY_KEY){
+			slot = (slot + 1) & mask;
+		}
+
+		this -> table[slot].key = key;
+		this -> table[slot].begin = begin;
+		this -> table[slot].end = end;
+
+		begin = end;
+	}
+
+}
+
+void VoxelHashGrid::radius_point_search(const arma::vec & test_point,
+	const double & distance,
+	std::vector< int > & closest_points) const{
+
+	this -> radius_point_search(test_point.memptr(),distance,closest_points,nullptr);
+
+}
+
+void VoxelHashGrid::radius_point_search(const double * test_point,
+	const double & distance,
+	std::vector< int > & closest_points,
+	std::vector< double > & closest_distances) const{
+
+	this -> radius_point_search(test_point,distance,closest_points,&closest_distances);
+
+}
+
+void VoxelHashGrid::radius_point_search(const double * test_point,
+	const double & distance,
+	std::vector< int > & closest_points,
+	std::vector< double > * closest_distances) const{
+
+	if (this -> cells.size() == 0){
+		return;
+	}
+
+	double bound = distance * distance;
+
+	// Range of the voxels overlapping the cube circumscribing the search sphere
+	std::int64_t min_cell[3];
+	std::int64_t max_cell[3];
+	for (int k = 0; k < 3; ++k){
+		min_cell[k] = std::int64_t(std::floor((test_point[k] - distance) / this -> cell_size));
+		max_cell[k] = std::int64_t(std::floor((test_point[k] + distance) / this -> cell_size));
+	}
+
+	for (std::int64_t i = min_cell[0]; i <= max_cell[0]; ++i){
+		for (std::int64_t j = min_cell[1]; j <= max_cell[1]; ++j){
+
+			const Column * column = this -> find_column(get_key(i,j));
+			if (column == nullptr){
+				continue;
+			}
+
+			// The voxels of the column within range hold a contiguous range of points
+			int first = column -> begin;
+			while (first < column -> end && this -> cells[first].k < min_cell[2]){
+				++first;
+			}
+			int last = first;
+			while (last < column -> end && this -> cells[last].k <= max_cell[2]){
+				++last;
+			}
+			if (first == last){
+				continue;
+			}
+
+			for (int p = this -> cells[first].begin; p < this -> cells[last - 1].end; ++p){
+
+				const double * point = this -> coordinates.data() + 3 * p;
+				double squared_distance = (point[0] - test_point[0]) * (point[0] - test_point[0])
+				+ (point[1] - test_point[1]) * (point[1] - test_point[1])
+				+ (point[2] - test_point[2]) * (point[2] - test_point[2]);
+
+				if (squared_distance < bound){
+					closest_points.push_back(this -> indices[p]);
+					if (closest_distances != nullptr){
+						closest_distances -> push_back(squared_distance);
+					}
+				}
+			}
+
+		}
+	}
+
+}
+
+unsigned int VoxelHashGrid::size() const{
+	return static_cast<unsigned int>(this -> indices.size());
+}
+
+unsigned int VoxelHashGrid::get_N_cells() const{
+	return static_cast<unsigned int>(this -> cells.size());
+}
+
+double VoxelHashGrid::get_cell_size() const{
+	return this -> cell_size;
+}
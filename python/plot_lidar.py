@@ -22,6 +22,58 @@ def plot_lidar(path,savepath = None):
 
 
 
+# Magic number ("RIMG") and version of the binary range-image records written by Lidar::save_range_image
+RANGE_IMAGE_MAGIC = 0x474d4952
+RANGE_IMAGE_VERSION = 1
+
+
+def load_range_images(path):
+	"""
+	Memory-maps a binary range-image file written by Lidar::save_range_image.
+	Returns a numpy record array with one entry per flash, holding the fields
+	"time", "position" (lidar position in target frame), "dcm" (lidar to target frame),
+	"ranges" and "incidences" (images of identical orientation as those of plot_lidar)
+	"""
+
+	magic, version, rows, cols = np.fromfile(path,dtype = np.uint32,count = 4)
+
+	if magic != RANGE_IMAGE_MAGIC or version != RANGE_IMAGE_VERSION:
+		raise ValueError(path + " is not a range-image file of version " + str(RANGE_IMAGE_VERSION))
+
+	record = np.dtype([
+		("magic",np.uint32),
+		("version",np.uint32),
+		("rows",np.uint32),
+		("cols",np.uint32),
+		("time",np.float64),
+		("position",np.float64,(3,)),
+		("dcm",np.float64,(3,3)),
+		("ranges",np.float32,(int(rows),int(cols))),
+		("incidences",np.float32,(int(rows),int(cols)))])
+
+	return np.memmap(path,dtype = record,mode = "r")
+
+
+def plot_range_image(path,index,field = "ranges",savepath = None):
+	"""
+	Plots one of the images stored in a binary range-image file
+	"""
+
+	records = load_range_images(path)
+	image = np.ma.masked_invalid(records[index][field])
+
+	plt.imshow(image,origin = "lower")
+	plt.colorbar()
+
+	plt.title(field + " at t = " + str(records[index]["time"]))
+	if savepath is None:
+		plt.show()
+	else:
+		plt.savefig(savepath)
+	plt.clf()
+
+
+
 # def plot_lidar(path_1,path_2,savepath = None):
 
 